@@ -16,5 +16,6 @@
 #include <eepp/audio/soundrecorder.hpp>
 #include <eepp/audio/soundsource.hpp>
 #include <eepp/audio/soundstream.hpp>
+#include <eepp/audio/soundstreamscheduler.hpp>
 
 #endif
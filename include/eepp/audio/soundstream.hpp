@@ -5,8 +5,8 @@
 #include <eepp/audio/soundsource.hpp>
 #include <eepp/config.hpp>
 #include <eepp/system/mutex.hpp>
-#include <eepp/system/thread.hpp>
 #include <eepp/system/time.hpp>
+#include <vector>
 using namespace EE::System;
 
 namespace EE { namespace Audio {
@@ -31,8 +31,8 @@ class EE_API SoundStream : public SoundSource {
 	/// This function starts the stream if it was stopped, resumes
 	/// it if it was paused, and restarts it from the beginning if
 	/// it was already playing.
-	/// This function uses its own thread so that it doesn't block
-	/// the rest of the program while the stream is played.
+	/// The stream is updated by the SoundStreamScheduler workers so
+	/// that it doesn't block the rest of the program while it is played.
 	///
 	/// \see pause, stop
 	///
@@ -141,6 +141,39 @@ class EE_API SoundStream : public SoundSource {
 	////////////////////////////////////////////////////////////
 	bool getLoop() const;
 
+	////////////////////////////////////////////////////////////
+	/// \brief Set the number of audio buffers queued by the stream
+	///
+	/// More buffers make the stream more tolerant to late updates,
+	/// fewer and shorter buffers lower the latency.
+	/// The change is applied the next time the stream is played.
+	/// The default is 3 buffers.
+	///
+	/// \param bufferCount Number of buffers (minimum 2)
+	///
+	////////////////////////////////////////////////////////////
+	void setBufferCount( unsigned int bufferCount );
+
+	unsigned int getBufferCount() const;
+
+	////////////////////////////////////////////////////////////
+	/// \brief Set the duration of the audio requested for each buffer
+	///
+	/// This is a hint for the derived classes ( see getBufferSampleCount ),
+	/// Music honors it. The default is 1 second.
+	///
+	////////////////////////////////////////////////////////////
+	void setBufferDuration( const Time& duration );
+
+	const Time& getBufferDuration() const;
+
+	////////////////////////////////////////////////////////////
+	/// \brief Get the number of times the stream ran out of queued
+	///		buffers while playing
+	///
+	////////////////////////////////////////////////////////////
+	Uint64 getUnderrunCount() const;
+
   protected:
 	enum {
 		NoLoop = -1 ///< "Invalid" endSeeks value, telling us to continue uninterrupted
@@ -212,15 +245,63 @@ class EE_API SoundStream : public SoundSource {
 	////////////////////////////////////////////////////////////
 	virtual Int64 onLoop();
 
+	////////////////////////////////////////////////////////////
+	/// \brief Get the number of samples that each buffer should hold
+	///
+	/// \return The buffer duration in samples for all the channels
+	///
+	////////////////////////////////////////////////////////////
+	std::size_t getBufferSampleCount() const;
+
   private:
+	friend class SoundStreamScheduler;
+
 	////////////////////////////////////////////////////////////
-	/// \brief Function called as the entry point of the thread
+	/// \brief Update the stream, called by the scheduler workers
 	///
-	/// This function starts the streaming loop, and returns
-	/// only when the sound is stopped.
+	/// Creates and fills the buffers when the stream starts, refills
+	/// the processed buffers while it plays, and releases the buffers
+	/// when it ends.
+	///
+	/// \return True if the stream must keep being updated
+	///
+	////////////////////////////////////////////////////////////
+	bool streamData();
+
+	////////////////////////////////////////////////////////////
+	/// \brief Create the buffers, fill the queue and start the playback
+	///
+	/// \return False if the stream was stopped before it started
+	///
+	////////////////////////////////////////////////////////////
+	bool streamStart();
+
+	////////////////////////////////////////////////////////////
+	/// \brief Refill and queue the buffers already processed
+	///
+	/// \return False if the streaming has ended
+	///
+	////////////////////////////////////////////////////////////
+	bool streamUpdate();
+
+	////////////////////////////////////////////////////////////
+	/// \brief Stop the playback and release the buffers
+	///
+	////////////////////////////////////////////////////////////
+	void streamEnd();
+
+	////////////////////////////////////////////////////////////
+	/// \brief Stop the streaming and wait until the scheduler
+	///		releases the stream
+	///
+	////////////////////////////////////////////////////////////
+	void stopStreaming();
+
+	////////////////////////////////////////////////////////////
+	/// \brief Start the streaming in the scheduler
 	///
 	////////////////////////////////////////////////////////////
-	void streamData();
+	void startStreaming( Status startState );
 
 	////////////////////////////////////////////////////////////
 	/// \brief Fill a new buffer with audio samples, and append
@@ -258,24 +339,28 @@ class EE_API SoundStream : public SoundSource {
 	void clearQueue();
 
 	enum {
-		BufferCount = 3,  ///< Number of audio buffers used by the streaming loop
-		BufferRetries = 2 ///< Number of retries (excluding initial try) for onGetData()
+		DefaultBufferCount = 3, ///< Default number of audio buffers used by the streaming loop
+		BufferRetries = 2		///< Number of retries (excluding initial try) for onGetData()
 	};
 
 	////////////////////////////////////////////////////////////
 	// Member data
 	////////////////////////////////////////////////////////////
-	Thread mThread;						///< Thread running the background tasks
-	mutable Mutex mThreadMutex;			///< Thread mutex
-	Status mThreadStartState;			///< State the thread starts in (Playing, Paused, Stopped)
-	bool mIsStreaming;					///< Streaming state (true = playing, false = stopped)
-	unsigned int mBuffers[BufferCount]; ///< Sound buffers used to store temporary audio data
+	mutable Mutex mThreadMutex;		 ///< Streaming state mutex
+	Status mThreadStartState;		 ///< State the stream starts in (Playing, Paused, Stopped)
+	bool mIsStreaming;				 ///< Streaming state (true = playing, false = stopped)
+	bool mStreamStarted;			 ///< True while the buffers are created and queued
+	bool mRequestStop;				 ///< The source has requested to stop the streaming
+	unsigned int mBufferCount;		 ///< Number of buffers requested
+	Time mBufferDuration;			 ///< Duration of the audio requested for each buffer
+	std::vector<unsigned int> mBuffers; ///< Sound buffers used to store temporary audio data
 	unsigned int mChannelCount;			///< Number of channels (1 = mono, 2 = stereo, ...)
 	unsigned int mSampleRate;			///< Frequency (samples / second)
 	Uint32 mFormat;						///< Format of the internal sound buffers
 	bool mLoop;							///< Loop flag (true to loop, false to play once)
-	Uint64 mSamplesProcessed;		 ///< Number of buffers processed since beginning of the stream
-	Int64 mBufferSeeks[BufferCount]; ///< If buffer is an "end buffer", holds next seek position,
+	Uint64 mSamplesProcessed; ///< Number of buffers processed since beginning of the stream
+	Uint64 mUnderruns;		  ///< Number of times the stream ran out of queued buffers
+	std::vector<Int64> mBufferSeeks; ///< If buffer is an "end buffer", holds next seek position,
 									 ///< else NoLoop. For play offset calculation.
 };
 
@@ -307,10 +392,11 @@ class EE_API SoundStream : public SoundSource {
 /// \li onGetData fills a new chunk of audio data to be played
 /// \li onSeek changes the current playing position in the source
 ///
-/// It is important to note that each SoundStream is played in its
-/// own separate thread, so that the streaming loop doesn't block the
-/// rest of the program. In particular, the OnGetData and OnSeek
-/// virtual functions may sometimes be called from this separate thread.
+/// It is important to note that the streams are updated by the
+/// worker threads of the SoundStreamScheduler, so that the streaming
+/// doesn't block the rest of the program. In particular, the OnGetData
+/// and OnSeek virtual functions may sometimes be called from a worker thread
+/// (never from two threads at the same time for the same stream).
 /// It is important to keep this in mind, because you may have to take
 /// care of synchronization issues if you share data between threads.
 ///
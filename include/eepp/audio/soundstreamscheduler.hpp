@@ -0,0 +1,108 @@
+#ifndef EE_AUDIO_SOUNDSTREAMSCHEDULER_HPP
+#define EE_AUDIO_SOUNDSTREAMSCHEDULER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <eepp/config.hpp>
+#include <eepp/system/singleton.hpp>
+#include <eepp/system/thread.hpp>
+#include <eepp/system/threadpool.hpp>
+#include <eepp/system/time.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace EE::System;
+
+namespace EE { namespace Audio {
+
+class SoundStream;
+
+/// \brief Shared service that keeps the buffer queues of every playing SoundStream filled
+class EE_API SoundStreamScheduler {
+	SINGLETON_DECLARE_HEADERS( SoundStreamScheduler )
+
+  public:
+	~SoundStreamScheduler();
+
+	////////////////////////////////////////////////////////////
+	/// \brief Set the number of worker threads that refill the streams buffers
+	///
+	/// The default is 2 workers.
+	///
+	////////////////////////////////////////////////////////////
+	void setWorkerCount( Uint32 workerCount );
+
+	Uint32 getWorkerCount() const;
+
+	////////////////////////////////////////////////////////////
+	/// \brief Set the maximum time between two checks of the streams queues
+	///
+	/// The scheduler wakes up earlier when a stream buffers are shorter
+	/// than this interval. The default is 10 milliseconds.
+	///
+	////////////////////////////////////////////////////////////
+	void setUpdateInterval( const Time& interval );
+
+	Time getUpdateInterval() const;
+
+	////////////////////////////////////////////////////////////
+	/// \brief Get the number of streams being played by the scheduler
+	///
+	////////////////////////////////////////////////////////////
+	std::size_t getActiveStreamCount() const;
+
+	////////////////////////////////////////////////////////////
+	/// \brief Get the number of times any stream ran out of queued buffers
+	///
+	/// \see SoundStream::getUnderrunCount
+	///
+	////////////////////////////////////////////////////////////
+	Uint64 getUnderrunCount() const;
+
+  protected:
+	friend class SoundStream;
+
+	struct StreamEntry {
+		SoundStream* stream;
+		Time bufferDuration;
+		bool scheduled;
+	};
+
+	mutable std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::vector<StreamEntry> mStreams;
+	std::unique_ptr<ThreadPool> mPool;
+	Thread mThread;
+	Uint32 mWorkerCount;
+	Time mUpdateInterval;
+	std::atomic<Uint64> mUnderruns;
+	bool mRunning;
+	bool mWakeUp;
+
+	SoundStreamScheduler();
+
+	////////////////////////////////////////////////////////////
+	/// \brief Start updating the stream
+	///
+	////////////////////////////////////////////////////////////
+	void add( SoundStream* stream );
+
+	////////////////////////////////////////////////////////////
+	/// \brief Stop updating the stream
+	///
+	/// Waits until the stream is not being updated by any worker.
+	///
+	////////////////////////////////////////////////////////////
+	void remove( SoundStream* stream );
+
+	void addUnderrun();
+
+	void run();
+
+	void process( SoundStream* stream );
+};
+
+}} // namespace EE::Audio
+
+#endif
@@ -11,6 +11,7 @@
 using namespace EE::System;
 
 #include <eepp/graphics/texture.hpp>
+#include <vector>
 
 namespace EE { namespace Graphics {
 
@@ -21,6 +22,28 @@ struct VertexData {
 	Color color;
 };
 
+/** @brief Vertexs copied from a BatchRenderer, grouped by the state they were batched with, so they
+ * can be batched again without computing them ( see BatchRenderer::startCapture ). */
+struct BatchCapture {
+	struct Batch {
+		const Texture* texture;
+		Texture::CoordinateType coordinateType;
+		BlendMode blend;
+		PrimitiveType mode;
+		size_t count;
+	};
+
+	std::vector<Batch> batches;
+	std::vector<VertexData> vertexs;
+
+	void clear() {
+		batches.clear();
+		vertexs.clear();
+	}
+
+	bool empty() const { return vertexs.empty(); }
+};
+
 /** @brief A batch rendering class. */
 class EE_API BatchRenderer {
   public:
@@ -305,6 +328,17 @@ class EE_API BatchRenderer {
 	/** @return If the blending mode switch is forced */
 	const bool& getForceBlendModeChange() const;
 
+	/** Copies every vertex batched from now on to the capture, until stopCapture is called. The
+	 * positions are stored relative to origin. Only independent primitives can be batched again
+	 * from a capture ( quads, triangles, lines and points ). */
+	void startCapture( BatchCapture* capture, const Vector2f& origin = Vector2f::Zero );
+
+	/** Stops copying the batched vertexs */
+	void stopCapture();
+
+	/** Batches the vertexs of a capture with the state they were captured, translated by offset */
+	void batchCapture( const BatchCapture& capture, const Vector2f& offset = Vector2f::Zero );
+
   protected:
 	VertexData* mVertex{ nullptr };
 	unsigned int mVertexSize{ 0 };
@@ -329,12 +363,17 @@ class EE_API BatchRenderer {
 	bool mForceRendering{ false };
 	bool mForceBlendMode{ true };
 
+	BatchCapture* mCapture{ nullptr };
+	Vector2f mCaptureOrigin;
+
 	void flush();
 
 	void init();
 
 	void addVertexs( const unsigned int& num );
 
+	void captureVertexs( const unsigned int& num );
+
 	void rotate( const Vector2f& center, Vector2f* point, const Float& angle );
 
 	void setDrawMode( const PrimitiveType& Mode, const bool& Force );
@@ -23,6 +23,10 @@ using namespace EE::System;
 
 namespace EE { namespace Network {
 
+namespace Private {
+class HttpEngine;
+}
+
 /** @brief A HTTP client */
 class EE_API Http : NonCopyable {
   public:
@@ -136,6 +140,7 @@ class EE_API Http : NonCopyable {
 
 	  private:
 		friend class Http;
+		friend class Private::HttpEngine;
 
 		/** @brief Construct the header from a response string
 		**  This function is used by Http to build the response
@@ -306,6 +311,8 @@ class EE_API Http : NonCopyable {
 		 * Content-Length is returned, otherwise is 0 )
 		 * @param currentBytes Current received total bytes
 		 * @return True if continue the request, false will cancel the current request.
+		 * The asynchronous HTTP requests call it from the thread that runs every transfer, so it
+		 * must return quickly and leave any heavy work to the response callback.
 		 */
 		typedef std::function<bool( const Http& http, const Http::Request& request,
 									const Http::Response& response, const Status& status,
@@ -339,6 +346,15 @@ class EE_API Http : NonCopyable {
 		/** @return If must continue a download previously started. */
 		const bool& isContinue() const;
 
+		/** Sets the maximum number of byte ranges requested at the same time when the request is
+		 * downloaded asynchronously to a file. The file is preallocated and each range is written
+		 * at its offset, an interrupted range is requested again from where it stopped. It's
+		 * only used if the server accepts ranges, and not with setContinue. Default is 1. */
+		void setSegments( Uint32 segments );
+
+		/** @return The maximum number of byte ranges requested at the same time */
+		const Uint32& getSegments() const;
+
 		// Types
 		typedef std::map<std::string, std::string> FieldTable;
 
@@ -350,6 +366,7 @@ class EE_API Http : NonCopyable {
 
 	  private:
 		friend class Http;
+		friend class Private::HttpEngine;
 
 		/** @brief Prepare the final request to send to the server
 		**  This is used internally by Http before sending the
@@ -372,6 +389,7 @@ class EE_API Http : NonCopyable {
 		bool mFollowRedirect;		///< Follows redirect response codes
 		bool mCompressedResponse;	///< Request comrpessed response
 		bool mContinue;				///< Resume download
+		Uint32 mSegments{ 1 };		///< Maximum number of ranges downloaded at the same time
 		mutable bool mCancel;		///< Cancel state of current request
 		bool mVerbose{ false };		///< Enable/Disable verbosity
 		ProgressCallback mProgressCallback;		///< Progress callback
@@ -468,20 +486,20 @@ class EE_API Http : NonCopyable {
 	typedef std::function<void( const Http&, Http::Request&, Http::Response& )>
 		AsyncResponseCallback;
 
-	/** @brief Sends the request and creates a new thread, when got the response informs the result
-	 *to the callback. *	This function does not lock the caller thread.
+	/** @brief Sends the request asynchronously, when got the response informs the result to the
+	 * callback. *	This function does not lock the caller thread.
 	 **  @see sendRequest */
 	void sendAsyncRequest( const AsyncResponseCallback& cb, const Http::Request& request,
 						   Time timeout = Time::Zero );
 
-	/** @brief Sends the request and creates a new thread, when got the response informs the result
-	 *to the callback. *	This function does not lock the caller thread.
+	/** @brief Sends the request asynchronously, when got the response informs the result to the
+	 * callback. *	This function does not lock the caller thread.
 	 **  @see downloadRequest */
 	void downloadAsyncRequest( const AsyncResponseCallback& cb, const Http::Request& request,
 							   IOStream& writeTo, Time timeout = Time::Zero );
 
-	/** @brief Sends the request and creates a new thread, when got the response informs the result
-	 *to the callback. *	This function does not lock the caller thread.
+	/** @brief Sends the request asynchronously, when got the response informs the result to the
+	 * callback. *	This function does not lock the caller thread.
 	 **  @see downloadRequest */
 	void downloadAsyncRequest( const AsyncResponseCallback& cb, const Http::Request& request,
 							   std::string writePath, Time timeout = Time::Zero );
@@ -657,6 +675,24 @@ class EE_API Http : NonCopyable {
 	/** Set the thread pool to consume for async requests, otherwise it will use its own */
 	static void setThreadPool( std::shared_ptr<ThreadPool> pool );
 
+	/** Sets the maximum number of simultaneous connections to the same host opened by the
+	 * asynchronous requests. The requests that exceed it wait for a free connection. Default is 6.
+	 */
+	static void setMaxConnectionsPerHost( Uint32 maxConnections );
+
+	/** @return The maximum number of simultaneous connections to the same host opened by the
+	 * asynchronous requests. */
+	static Uint32 getMaxConnectionsPerHost();
+
+	/** Enables or disables the non-blocking engine for the asynchronous requests. When enabled
+	 * ( default ) the plain HTTP asynchronous requests are multiplexed in a single thread, reusing
+	 * the keep-alive connections to each host. HTTPS, proxied and resumed requests always run in
+	 * their own thread. */
+	static void setAsyncEngineEnabled( bool enabled );
+
+	/** @return True if the non-blocking engine is used for the asynchronous requests. */
+	static bool isAsyncEngineEnabled();
+
   private:
 	class AsyncRequest : public Thread {
 	  public:
@@ -724,6 +760,7 @@ class EE_API Http : NonCopyable {
 	};
 
 	friend class AsyncRequest;
+	friend class Private::HttpEngine;
 	ThreadLocalPtr<HttpConnection> mConnection; ///< Connection to the host
 	IpAddress mHost;							///< Web host address
 	std::string mHostName;						///< Web host name
@@ -737,6 +774,10 @@ class EE_API Http : NonCopyable {
 	void removeOldThreads();
 
 	Request prepareFields( const Http::Request& request );
+
+	bool canUseAsyncEngine( const Http::Request& request ) const;
+
+	static const std::shared_ptr<ThreadPool>& getThreadPool();
 };
 
 }} // namespace EE::Network
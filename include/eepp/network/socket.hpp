@@ -7,6 +7,9 @@
 
 namespace EE { namespace Network {
 class SocketSelector;
+namespace Private {
+class HttpEngine;
+}
 
 /** @brief Base class for all the socket types */
 class EE_API Socket : NonCopyable {
@@ -81,6 +84,7 @@ class EE_API Socket : NonCopyable {
 
   protected:
 	friend class SocketSelector;
+	friend class Private::HttpEngine;
 	// Member data
 	Type mType;			  ///< Type of the socket (TCP or UDP)
 	SocketHandle mSocket; ///< Socket descriptor
@@ -3,6 +3,7 @@
 
 #include <eepp/core.hpp>
 #include <eepp/system/time.hpp>
+#include <functional>
 using namespace EE::System;
 
 namespace EE { namespace Network {
@@ -12,8 +13,19 @@ class Socket;
 /** Multiplexer that allows to read from multiple sockets */
 class EE_API SocketSelector {
   public:
-	/** @brief Default constructor */
-	SocketSelector();
+	/** Defines when a socket is reported as ready */
+	enum class Trigger {
+		/** The socket is reported by every wait while it has data available */
+		Level,
+		/** The socket is reported once each time new data arrives, so it must be read until it
+		**  returns Socket::NotReady before waiting again. Only supported by the epoll and kqueue
+		**  backends, the select backend always works as Level. */
+		Edge
+	};
+
+	/** @brief Default constructor
+	**  @param trigger When the sockets are reported as ready */
+	explicit SocketSelector( Trigger trigger = Trigger::Level );
 
 	/** @brief Copy constructor
 	**  @param copy Instance to copy */
@@ -68,6 +80,20 @@ class EE_API SocketSelector {
 	**  @see IsReady */
 	bool isReady( Socket& socket ) const;
 
+	/** @brief Call a function for each socket that was ready in the last wait
+	**  Unlike testing every socket with isReady, only the ready sockets are
+	**  visited. Sockets can be added and removed from the callback, the
+	**  sockets removed before being visited are skipped.
+	**  @param callback Function called with each ready socket
+	**  @see Wait */
+	void forEachReady( const std::function<void( Socket& )>& callback ) const;
+
+	/** @return The number of sockets that were ready in the last wait */
+	size_t getReadyCount() const;
+
+	/** @return The number of sockets in the selector */
+	size_t getSocketCount() const;
+
 	/** @brief Overload of assignment operator
 	**  @param right Instance to assign
 	**  @return Reference to self */
@@ -111,7 +137,13 @@ that they are alive as long as they are used in the selector.
 Using a selector is simple:
 @li populate the selector with all the sockets that you want to observe
 @li make it wait until there is data available on any of the sockets
-@li test each socket to find out which ones are ready
+@li test each socket to find out which ones are ready, or iterate
+only the ready ones with forEachReady
+
+On Linux and Android the selector is backed by epoll, and on macOS,
+iOS and BSD by kqueue, so it has no limit in the number of sockets and
+the cost of a wait depends on the number of ready sockets. Other
+platforms use select, limited to FD_SETSIZE sockets.
 
 Usage example:
 @code
@@ -126,7 +126,8 @@ class EE_API TcpSocket : public Socket {
 
 	typedef std::function<void( const char* bytes, size_t n )> ReadFn;
 
-	/** @brief Starts a new thread to receive all stdout and stderr data */
+	/** @brief Starts receiving all the data asynchronously. The socket is watched by the shared
+	 ** IOReactor when it's supported, otherwise a new thread reads it. */
 	void startAsyncRead( ReadFn readFn = nullptr );
 
   private:
@@ -141,9 +142,14 @@ class EE_API TcpSocket : public Socket {
 		std::vector<char> Data;	  ///< Data of the packet
 	};
 
+	bool startReactorRead( const ReadFn& readFn );
+
+	void stopReactorRead();
+
 	// Member data
 	PendingPacket mPendingPacket; ///< Temporary data of the packet currently being received
 	std::thread mReadThread;
+	Uint64 mAsyncReadId{ 0 }; ///< IOReactor watch of the asynchronous read
 };
 
 }} // namespace EE::Network
@@ -4,6 +4,7 @@
 #include <eepp/core.hpp>
 #include <eepp/system/fileinfo.hpp>
 #include <eepp/system/scopedbuffer.hpp>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -11,6 +12,11 @@ namespace EE { namespace System {
 
 class EE_API FileSystem {
   public:
+	/** Type of a directory entry, as reported while reading the directory. */
+	enum class EntryType { Unknown, File, Directory, Link };
+
+	typedef std::function<void( const char* name, EntryType type )> DirectoryEntryCb;
+
 	/** @return The default slash path code of the current OS */
 	static std::string getOSSlash();
 
@@ -114,6 +120,14 @@ class EE_API FileSystem {
 											   const bool& ignoreHidden = false,
 											   const std::function<bool()> shouldAbort = {} );
 
+	/** Reads the files and sub directories contained by a directory, reporting the type of each
+	 * entry when the file system provides it while reading the directory ( avoiding a stat call per
+	 * entry ). Symbolic links are reported as Link and entries of unknown type as Unknown, the
+	 * caller must stat them if needed.
+	 * @return False if the directory couldn't be opened */
+	static bool filesEntriesGetInPath( const std::string& path, const DirectoryEntryCb& cb,
+									   const std::function<bool()> shouldAbort = {} );
+
 	/** @return The file info of the files and sub directories contained in the directory path. */
 	static std::vector<FileInfo> filesInfoGetInPath( std::string path, bool linkInfo = false,
 													 const bool& sortByName = false,
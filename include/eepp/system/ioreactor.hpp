@@ -0,0 +1,100 @@
+#ifndef EE_SYSTEM_IOREACTOR_HPP
+#define EE_SYSTEM_IOREACTOR_HPP
+
+#include <atomic>
+#include <eepp/config.hpp>
+#include <eepp/core/containers.hpp>
+#include <eepp/core/noncopyable.hpp>
+#include <eepp/system/singleton.hpp>
+#include <eepp/system/threadpool.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace EE { namespace System {
+
+/** @brief Shared reactor that waits for the readability of many file descriptors ( process pipes
+ * and sockets ) in a single thread, using epoll on Linux and kqueue on macOS and BSD, and
+ * dispatches the read callbacks to a ThreadPool.
+ *
+ * Process::startAsyncRead and TcpSocket::startAsyncRead use it when it's supported, instead of
+ * starting their own reader threads. The callbacks of a watch never run concurrently, even when it
+ * holds several descriptors, and a descriptor isn't waited again until its callback returns. The
+ * callbacks can be called when there's nothing to read, so they must read without blocking, and
+ * they should not block for long since they share the pool threads. */
+class EE_API IOReactor : NonCopyable {
+	SINGLETON_DECLARE_HEADERS( IOReactor )
+
+  public:
+	/** Called when the descriptor is readable or closed. Returns false to stop watching the
+	 * descriptor ( usually because the end of file was reached ). */
+	typedef std::function<bool( int fd )> ReadyFn;
+
+	/** @return True if the platform has a reactor backend. */
+	static bool isSupported();
+
+	~IOReactor();
+
+	/** Starts watching the descriptors, the reactor thread is started with the first watch.
+	 * @return The watch id, or 0 if the reactor isn't supported, is disabled or failed. */
+	Uint64 add( const std::vector<int>& fds, const ReadyFn& onReady );
+
+	/** Stops watching the descriptors of the watch. Waits for its callback to return when it's
+	 * running in another thread, so the descriptors can be closed safely afterwards. */
+	void remove( const Uint64& id );
+
+	/** Sets the pool where the callbacks are run. Must be set before the first watch is added. */
+	void setThreadPool( const std::shared_ptr<ThreadPool>& pool );
+
+	/** @return The pool where the callbacks are run, by default a small pool owned by the reactor
+	 * is created. */
+	const std::shared_ptr<ThreadPool>& getThreadPool();
+
+	/** @return True if the new asynchronous reads use the reactor. */
+	bool isEnabled() const;
+
+	/** When disabled, the new asynchronous reads fall back to a reader thread per stream. */
+	void setEnabled( bool enabled );
+
+	/** @return The number of active watches. */
+	size_t getWatchCount() const;
+
+  protected:
+	struct Watch;
+
+	IOReactor();
+
+	bool start();
+
+	void run();
+
+	void dispatch( const std::shared_ptr<Watch>& watch, int fd );
+
+	void process( std::shared_ptr<Watch> watch, int fd );
+
+	bool watchFd( int fd );
+
+	void rearmFd( int fd );
+
+	void unwatchFd( int fd );
+
+	void unwatchFds( const std::shared_ptr<Watch>& watch, const std::vector<int>& fds );
+
+	int mQueue{ -1 };
+	int mWakeUp[2]{ -1, -1 };
+	bool mStarted{ false };
+	std::atomic<bool> mEnabled{ true };
+	std::atomic<bool> mShuttingDown{ false };
+	Uint64 mLastId{ 0 };
+	std::thread mThread;
+	std::shared_ptr<ThreadPool> mPool;
+	mutable std::mutex mMutex;
+	UnorderedMap<Uint64, std::shared_ptr<Watch>> mWatches;
+	UnorderedMap<int, std::shared_ptr<Watch>> mFds;
+};
+
+}} // namespace EE::System
+
+#endif
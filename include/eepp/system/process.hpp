@@ -94,7 +94,9 @@ class EE_API Process {
 				 const std::unordered_map<std::string, std::string>& environment = {},
 				 const std::string& workingDirectory = "" );
 
-	/** @brief Starts a new thread to receive all stdout and stderr data */
+	/** @brief Starts receiving all stdout and stderr data asynchronously. The streams are watched
+	 ** by the shared IOReactor when it's supported, otherwise a new thread reads them. The
+	 ** callbacks are never called concurrently. */
 	void startAsyncRead( ReadFn readStdOut = nullptr, ReadFn readStdErr = nullptr );
 
 	/** @brief Read all standard output from the child process.
@@ -238,11 +240,16 @@ class EE_API Process {
 	size_t mBufferSize{ 131072 };
 	std::thread mStdOutThread;
 	std::thread mStdErrThread;
+	Uint64 mAsyncReadId{ 0 };
 	Mutex mStdInMutex;
 	ReadFn mReadStdOutFn;
 	ReadFn mReadStdErrFn;
 
 	size_t readAll( std::string& buffer, bool readErr, Time timeout = Time::Zero );
+
+	bool startReactorRead();
+
+	void stopReactorRead();
 };
 
 }} // namespace EE::System
@@ -58,6 +58,7 @@ class EE_API RegEx : public PatternMatcher {
 		ExtendedMore = 0x01000000u,		 // C
 		Literal = 0x02000000u,			 // C
 		MatchInvalidUtf = 0x04000000u,	 // J M D
+		NoUtfCheck = 0x40000000u,		 // C J M D
 	};
 
 	RegEx( const std::string_view& pattern, Options options = Options::Utf, bool useCache = true );
@@ -81,6 +82,7 @@ class EE_API RegEx : public PatternMatcher {
 	mutable size_t mMatchNum;
 	void* mCompiledPattern;
 	int mCaptureCount;
+	Uint32 mMatchOptions{ 0 };
 	bool mValid{ false };
 	bool mCached{ false };
 };
@@ -2,10 +2,13 @@
 #define EE_UI_DOC_FOLDRANGESERVICE_HPP
 
 #include <eepp/config.hpp>
+#include <eepp/core/string.hpp>
 #include <eepp/system/mutex.hpp>
+#include <eepp/ui/doc/foldrangetype.hpp>
 #include <eepp/ui/doc/textrange.hpp>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 
 using namespace EE::System;
 
@@ -28,6 +31,10 @@ class EE_API FoldRangeServive {
 
 	void findRegions();
 
+	/** Computes the folding regions without applying them. When incremental only the lines
+	 * modified since the last computation are scanned again. */
+	std::vector<TextRange> computeRegions( bool incremental = true );
+
 	void clear();
 
 	bool empty();
@@ -55,11 +62,44 @@ class EE_API FoldRangeServive {
 	void setEnabled( bool enabled );
 
   protected:
+	friend class TextDocument;
+
+	struct BraceEvent {
+		Int64 column;
+		bool open;
+	};
+
+	struct LineSummary {
+		String::HashType hash{ 0 };
+		Uint64 tokensSignature{ 0 };
+		std::vector<BraceEvent> braces;
+		int indent{ 0 };
+		bool tokenized{ false };
+		bool valid{ false };
+	};
+
 	TextDocument* mDoc;
 	std::unordered_map<Int64, TextRange> mFoldingRegions;
 	FoldRangeProvider* mProvider{ nullptr };
 	Mutex mMutex;
 	bool mEnabled{ true };
+	Mutex mSummariesMutex;
+	std::vector<LineSummary> mLineSummaries;
+	std::vector<std::pair<Int64, Int64>> mSummariesBraces;
+	FoldRangeType mSummariesType{ FoldRangeType::Undefined };
+	bool mSummariesTokenized{ false };
+
+	void moveLineSummaries( Int64 fromLine, Int64 numLines );
+
+	void updateLineSummaries( FoldRangeType type );
+
+	void updateLineSummary( Int64 lineIdx, LineSummary& summary, FoldRangeType type );
+
+	std::vector<TextRange> foldingRangesFromBraces() const;
+
+	std::vector<TextRange> foldingRangesFromIndentation() const;
+
+	bool hasFoldingRegions( std::vector<TextRange>& regions );
 };
 
 }}} // namespace EE::UI::Doc
@@ -20,6 +20,7 @@
 #include <eepp/ui/doc/textrange.hpp>
 #include <eepp/ui/doc/textundostack.hpp>
 #include <functional>
+#include <memory>
 #include <vector>
 
 using namespace EE::System;
@@ -645,6 +646,10 @@ class EE_API TextDocument {
 
 	void unserializeUndoRedo( const std::string& jsonString );
 
+	const TextUndoStack& getUndoStack() const;
+
+	TextUndoStack& getUndoStack();
+
 	void changeFilePath( const std::string& filePath );
 
 	void setDirtyUntilSave();
@@ -655,6 +660,8 @@ class EE_API TextDocument {
 	friend class TextUndoStack;
 	friend class FoldRangeServive;
 
+	struct SearchBuffer;
+
 	Uint64 mModificationId{ 0 };
 	TextUndoStack mUndoStack;
 	std::string mFilePath;
@@ -704,6 +711,9 @@ class EE_API TextDocument {
 	std::unique_ptr<SyntaxHighlighter> mHighlighter;
 	Mutex mStopFlagsMutex;
 	UnorderedMap<bool*, std::unique_ptr<bool>> mStopFlags;
+	Mutex mSearchBufferMutex;
+	std::shared_ptr<const SearchBuffer> mSearchBuffer;
+	std::shared_ptr<const SearchBuffer> mSearchBufferLowercase;
 	FoldRangeServive mFoldRangeService;
 
 	void initializeCommands();
@@ -767,14 +777,15 @@ class EE_API TextDocument {
 
 	LoadStatus loadFromStream( IOStream& file, std::string path, bool callReset );
 
-	SearchResult findText( String text, TextPosition from = { 0, 0 }, bool caseSensitive = true,
-						   bool wholeWord = false, FindReplaceType type = FindReplaceType::Normal,
-						   TextRange restrictRange = TextRange() );
+	/** Contiguous UTF-8 copy of the document lines used by the search functions. It's rebuilt
+	 * lazily, when a search finds that the lines changed since it was built. */
+	std::shared_ptr<const SearchBuffer> getSearchBuffer( bool lowercase );
 
-	SearchResult findTextLast( String text, TextPosition from = { 0, 0 }, bool caseSensitive = true,
-							   bool wholeWord = false,
-							   FindReplaceType type = FindReplaceType::Normal,
-							   TextRange restrictRange = TextRange() );
+	/** Searches forward in [from, to), calling onMatch for each match found until it returns
+	 * false or the stop flag is set. */
+	void search( const String& text, const TextPosition& from, const TextPosition& to,
+				 bool caseSensitive, bool wholeWord, FindReplaceType type, const bool* stopFlag,
+				 const std::function<bool( SearchResult&& )>& onMatch );
 
 	void changeFilePath( const std::string& filePath, bool notify );
 };
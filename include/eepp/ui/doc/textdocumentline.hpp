@@ -11,6 +11,8 @@ class EE_API TextDocumentLine {
 
 	TextDocumentLine( const String& text ) : mText( text ) { updateState(); }
 
+	TextDocumentLine( String&& text ) : mText( std::move( text ) ) { updateState(); }
+
 	void setText( String&& text ) {
 		mText = std::move( text );
 		updateState();
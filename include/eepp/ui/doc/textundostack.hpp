@@ -13,6 +13,7 @@ namespace EE { namespace UI { namespace Doc {
 
 class TextDocument;
 class TextUndoCommand;
+class TextUndoArena;
 
 enum class TextUndoCommandType { Insert = 1, Remove = 2, Selection = 3 };
 
@@ -20,7 +21,8 @@ using UndoStackContainer = std::deque<TextUndoCommand*>;
 
 class EE_API TextUndoStack {
   public:
-	TextUndoStack( TextDocument* owner, const Uint32& maxStackSize = 10000 );
+	TextUndoStack( TextDocument* owner, const Uint32& maxStackSize = 10000,
+				   const size_t& maxMemoryUsage = 64 * 1024 * 1024 );
 
 	~TextUndoStack();
 
@@ -40,6 +42,16 @@ class EE_API TextUndoStack {
 
 	const Uint32& getMaxStackSize() const;
 
+	/** Maximum number of bytes used by the undo and redo stacks. The oldest commands are
+	 * discarded when it's exceeded, along with the commands that are undone with them. */
+	const size_t& getMaxMemoryUsage() const;
+
+	void setMaxMemoryUsage( const size_t& maxMemoryUsage );
+
+	/** @return The number of bytes used by the commands of the undo and redo stacks, including
+	 * the chunks where the text of the commands is stored. */
+	size_t getMemoryUsage() const;
+
 	const Time& getMergeTimeout() const;
 
 	void setMergeTimeout( const Time& mergeTimeout );
@@ -59,9 +71,25 @@ class EE_API TextUndoStack {
 	UndoStackContainer mUndoStack;
 	UndoStackContainer mRedoStack;
 	Time mMergeTimeout;
+	TextUndoArena* mArena;
+	size_t mMaxMemoryUsage;
+	size_t mMemoryUsage{ 0 };
+	bool mTransferring{ false };
 
 	void pushUndo( UndoStackContainer& undoStack, TextUndoCommand* cmd );
 
+	void trackCommand( TextUndoCommand* cmd );
+
+	void untrackCommand( TextUndoCommand* cmd );
+
+	void releaseCommand( TextUndoCommand* cmd );
+
+	bool isSameGroup( TextUndoCommand* cmd, TextUndoCommand* other ) const;
+
+	void trimStack( UndoStackContainer& undoStack, bool keepNewestGroup );
+
+	void compressOldest();
+
 	void pushInsert( UndoStackContainer& undoStack, const String& string, const size_t& cursorIdx,
 					 const TextPosition& position, const Time& time );
 
@@ -76,6 +104,8 @@ class EE_API TextUndoStack {
 	UndoStackContainer& getRedoStackContainer();
 
 	void popUndo( UndoStackContainer& undoStack, UndoStackContainer& redoStack );
+
+	void transfer( UndoStackContainer& undoStack, UndoStackContainer& redoStack );
 };
 
 }}} // namespace EE::UI::Doc
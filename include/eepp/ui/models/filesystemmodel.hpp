@@ -113,7 +113,9 @@ class EE_API FileSystemModel : public Model {
 		Int64 findChildRowFromName( const std::string& name, const FileSystemModel& model,
 									bool forceRefresh = false );
 
-		bool refresh( const FileSystemModel& model );
+		/** Reloads the children, the removed ones are moved to released to be freed by the
+		 * caller */
+		bool refresh( const FileSystemModel& model, std::vector<Node*>& released );
 
 		~Node();
 
@@ -1,6 +1,7 @@
 ﻿#ifndef EE_UI_UICODEEDIT_HPP
 #define EE_UI_UICODEEDIT_HPP
 
+#include <eepp/graphics/batchrenderer.hpp>
 #include <eepp/graphics/text.hpp>
 #include <eepp/ui/doc/documentview.hpp>
 #include <eepp/ui/doc/syntaxcolorscheme.hpp>
@@ -17,6 +18,7 @@ using namespace EE::UI::Doc;
 
 namespace EE { namespace Graphics {
 class Font;
+class FrameBuffer;
 }} // namespace EE::Graphics
 
 namespace EE { namespace UI {
@@ -879,7 +881,52 @@ class EE_API UICodeEditor : public UIWidget, public TextDocument::Client {
 	UIPopUpMenu* mCurrentMenu{ nullptr };
 	MinimapConfig mMinimapConfig;
 	Int64 mMinimapScrollOffset{ 0 };
+	struct MinimapLinesLayout {
+		Float left;
+		Float top;
+		/* the first and last visible index drawn */
+		Int64 firstRow;
+		Int64 lastRow;
+		/* if not 0 each visible index is drawn in the row "visibleIndex % ringRows", otherwise the
+		 * first row is drawn at "top" */
+		Int64 ringRows;
+		Float charHeight;
+		Float charSpacing;
+		Float lineSpacing;
+		Float gutterWidth;
+		Float cutoffX;
+		Float alpha;
+	};
+	struct MinimapCache {
+		FrameBuffer* frameBuffer{ nullptr };
+		Sizei size;
+		Float charHeight{ 0 };
+		Float charSpacing{ 0 };
+		Float lineSpacing{ 0 };
+		/* the line spacing rounded up, the rows are read back from the frame buffer by whole
+		 * pixels */
+		Int64 rowHeight{ 0 };
+		Float gutterWidth{ 0 };
+		int tabWidth{ 0 };
+		/* the visible index and the signature of the line rendered in each row of the frame
+		 * buffer, rows are reused as a ring buffer while scrolling */
+		std::vector<std::pair<Int64, Uint64>> rows;
+		bool failed{ false };
+	};
+	MinimapCache mMinimapCache;
+	struct MinimapWordMatches {
+		String text;
+		Uint64 modificationId{ 0 };
+		DocumentLineRange lineRange{ 0, -1 };
+		TextRanges ranges;
+	};
+	MinimapWordMatches mMinimapWordMatches;
 	std::unordered_map<Int64, std::pair<String::HashType, Float>> mLinesWidthCache;
+	struct LineGlyphs {
+		Uint64 key{ 0 };
+		BatchCapture capture;
+	};
+	std::unordered_map<Int64, LineGlyphs> mLinesGlyphs;
 	Tools::UIDocFindReplace* mFindReplace{ nullptr };
 	struct PluginRequestedSpace {
 		UICodeEditorPlugin* plugin;
@@ -993,6 +1040,17 @@ class EE_API UICodeEditor : public UIWidget, public TextDocument::Client {
 							   const Float& lineHeight,
 							   const DocumentViewLineRange& visibleLineRange );
 
+	void drawLineGlyphs( const Int64& line, const std::vector<SyntaxTokenPosition>& tokens,
+						 Vector2f position, const Float& fontSize, const Float& lineHeight,
+						 const DocumentViewLineRange& visibleLineRange );
+
+	Uint64 getLineGlyphsKey( const Int64& line, const std::vector<SyntaxTokenPosition>& tokens,
+							 const Vector2f& position, const Float& fontSize,
+							 const Float& lineHeight,
+							 const DocumentViewLineRange& visibleLineRange );
+
+	void trimLinesGlyphs( const DocumentLineRange& lineRange );
+
 	virtual void drawSelectionMatch( const DocumentLineRange& lineRange,
 									 const Vector2f& startScroll, const Float& lineHeight,
 									 const DocumentViewLineRange& visibleLineRange );
@@ -1065,6 +1123,20 @@ class EE_API UICodeEditor : public UIWidget, public TextDocument::Client {
 	void drawMinimap( const Vector2f& start, const DocumentLineRange& docLineRange,
 					  const DocumentViewLineRange& visibleLineRange );
 
+	void drawMinimapLine( Int64 line, const MinimapLinesLayout& layout );
+
+	Uint64 getMinimapLineSignature( Int64 line );
+
+	bool updateMinimapCache( const Rectf& rect, const MinimapLinesLayout& layout,
+							 const DocumentLineRange& docLineRange );
+
+	void drawMinimapCache( const Rectf& rect, const MinimapLinesLayout& layout );
+
+	void invalidateMinimapCache();
+
+	const TextRanges& getMinimapWordMatches( const String& text,
+											 const DocumentLineRange& docLineRange );
+
 	bool isMinimapFileTooLarge() const;
 
 	void updateMipmapHover( const Vector2f& position );
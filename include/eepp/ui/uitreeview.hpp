@@ -1,6 +1,7 @@
 #ifndef EE_UI_UITREEVIEW_HPP
 #define EE_UI_UITREEVIEW_HPP
 
+#include <atomic>
 #include <eepp/ui/abstract/uiabstracttableview.hpp>
 #include <eepp/ui/uiicon.hpp>
 #include <eepp/ui/uitablerow.hpp>
@@ -115,6 +116,19 @@ class EE_API UITreeView : public UIAbstractTableView {
 
 	void clearViewMetadata();
 
+	/** @return The number of rows currently visible in the tree ( the rows of the expanded nodes
+	 * ). */
+	size_t getVisibleRowCount() const;
+
+	/** @return The visible row position of the index, or -1 if the index is not visible. */
+	Int64 getVisibleRowIndex( const ModelIndex& index ) const;
+
+	/** @return The model index displayed at the visible row position. */
+	ModelIndex getVisibleRowModelIndex( const Int64& row ) const;
+
+	/** @return The visible row position at the content y offset, or -1 if there's no row. */
+	Int64 getVisibleRowAt( const Float& yOffset ) const;
+
   protected:
 	enum class IterationDecision {
 		Continue,
@@ -140,11 +154,23 @@ class EE_API UITreeView : public UIAbstractTableView {
 		bool open{ false };
 	};
 
+	struct VisibleRow {
+		ModelIndex index;
+		Uint32 depth{ 0 };
+		// Children count of the index when it was expanded, used to detect lazily loaded rows
+		Uint32 childCount{ 0 };
+	};
+
 	typedef std::function<IterationDecision( const int&, const ModelIndex&, const size_t&,
 											 const Float& )>
 		TreeViewCallback;
 
 	mutable std::unordered_map<void*, MetadataForIndex> mViewMetadata;
+	mutable std::vector<VisibleRow> mVisibleRows;
+	mutable std::unordered_map<ModelIndex, Int64> mVisibleRowsLookup;
+	mutable std::atomic<bool> mVisibleRowsDirty{ true };
+	mutable bool mVisibleRowsLookupDirty{ true };
+	mutable Int64 mVisibleRowHint{ 0 };
 
 	virtual size_t getItemCount() const;
 
@@ -152,6 +178,8 @@ class EE_API UITreeView : public UIAbstractTableView {
 
 	virtual void onColumnSizeChange( const size_t& colIndex, bool fromUserInteraction = false );
 
+	virtual void onModelUpdate( unsigned flags );
+
 	virtual UIWidget* updateCell( const Vector2<Int64>& posIndex, const ModelIndex& index,
 								  const size_t& indentLevel, const Float& yOffset );
 
@@ -170,18 +198,22 @@ class EE_API UITreeView : public UIAbstractTableView {
 
 	virtual void bindNavigationClick( UIWidget* widget );
 
-	struct TraverseTreeVars {
-		UITreeView::TreeViewCallback callback;
-		const Model& model;
-		int indentLevel = 0;
-		Float yOffset = 0;
-		int rowIndex = -1;
-		Float rowHeight = 0;
-	};
+	void traverseTree( TreeViewCallback ) const;
 
-	IterationDecision traverseIndex( TraverseTreeVars& v, const ModelIndex& index ) const;
+	const std::vector<VisibleRow>& getVisibleRows() const;
 
-	void traverseTree( TreeViewCallback ) const;
+	void invalidateVisibleRows();
+
+	void appendVisibleRows( std::vector<VisibleRow>& rows, const ModelIndex& parent,
+							const Uint32& depth ) const;
+
+	void updateVisibleRowChildren( const Int64& row ) const;
+
+	bool syncVisibleRows( const Int64& fromRow, const Int64& toRow ) const;
+
+	void setIndexOpen( const ModelIndex& index, bool open );
+
+	Int64 getFirstDrawableRow() const;
 };
 
 }} // namespace EE::UI
@@ -1371,6 +1371,7 @@ workspace "eepp"
 	project "eepp-mapeditor"
 		set_kind()
 		language "C++"
+		incdirs { "src/thirdparty" }
 		files { "src/tools/mapeditor/*.cpp" }
 		eepp_module_maps_add()
 		build_link_configuration( "eepp-MapEditor", true )
@@ -1485,12 +1486,86 @@ workspace "eepp"
 		incdirs { "src/thirdparty" }
 		build_link_configuration( "eepp-ui-perf-test", true )
 
+	project "eepp-physics-bench"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/physics_bench/*.cpp" }
+		incdirs { "src/thirdparty" }
+		eepp_module_physics_add()
+		build_link_configuration( "eepp-physics-bench", true )
+
+	project "eepp-eterm-bench"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/eterm_bench/*.cpp" }
+		incdirs { "src/modules/eterm/include/", "src/thirdparty" }
+		links { "eterm-static" }
+		build_link_configuration( "eepp-eterm-bench", true )
+		filter "system:linux or system:bsd"
+			links { "util" }
+		filter "system:haiku"
+			links { "bsd" }
+
+	project "eepp-ecode-fuzzy-bench"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/ecode_fuzzy_bench/*.cpp", "src/tools/ecode/fuzzymatcher.cpp" }
+		incdirs { "src/thirdparty" }
+		build_link_configuration( "eepp-ecode-fuzzy-bench", true )
+
+	project "eepp-ecode-scan-bench"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/ecode_scan_bench/*.cpp", "src/tools/ecode/projectscanner.cpp",
+				"src/tools/ecode/ignorematcher.cpp" }
+		incdirs { "src/thirdparty" }
+		build_link_configuration( "eepp-ecode-scan-bench", true )
+
+	project "eepp-fold-range-bench"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/fold_range_bench/*.cpp" }
+		incdirs { "src/thirdparty" }
+		build_link_configuration( "eepp-fold-range-bench", true )
+
+	project "eepp-socket-selector-bench"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/socket_selector_bench/*.cpp" }
+		incdirs { "src/thirdparty" }
+		build_link_configuration( "eepp-socket-selector-bench", true )
+
+	project "eepp-io-reactor-bench"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/io_reactor_bench/*.cpp" }
+		incdirs { "src/thirdparty" }
+		build_link_configuration( "eepp-io-reactor-bench", true )
+
+	project "eepp-http-bench"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/http_bench/*.cpp" }
+		incdirs { "src/thirdparty" }
+		build_link_configuration( "eepp-http-bench", true )
+
 	project "eepp-unit_tests"
 		kind "ConsoleApp"
 		targetdir(_MAIN_SCRIPT_DIR .. "/bin/unit_tests")
 		language "C++"
-		files { "src/tests/unit_tests/*.cpp" }
+		files { "src/tests/unit_tests/*.cpp", "src/tools/ecode/ignorematcher.cpp",
+				"src/tools/ecode/projectscanner.cpp", "src/tools/ecode/fuzzymatcher.cpp",
+				"src/tools/ecode/plugins/autocomplete/wordindex.cpp",
+				"src/tools/ecode/plugins/pluginmessagebus.cpp",
+				"src/tools/ecode/fileeventcoalescer.cpp" }
+		incdirs { "src/modules/eterm/include/" }
+		links { "eterm-static" }
+		eepp_module_maps_add()
 		build_link_configuration( "eepp-unit_tests", true )
+		filter "system:linux or system:bsd"
+			links { "util" }
+		filter "system:haiku"
+			links { "bsd" }
 
 if os.isfile("external_projects.lua") then
 	dofile("external_projects.lua")
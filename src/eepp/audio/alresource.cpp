@@ -1,5 +1,6 @@
 #include <eepp/audio/alresource.hpp>
 #include <eepp/audio/audiodevice.hpp>
+#include <eepp/audio/soundstreamscheduler.hpp>
 #include <eepp/system/lock.hpp>
 #include <eepp/system/mutex.hpp>
 using namespace EE::System;
@@ -36,9 +37,11 @@ AlResource::~AlResource() {
 	// Decrement the resources counter
 	count--;
 
-	// If there's no more resource alive, we can destroy the device
-	if ( count == 0 )
+	// If there's no more resource alive, we can destroy the streaming scheduler and the device
+	if ( count == 0 ) {
+		SoundStreamScheduler::destroySingleton();
 		delete globalDevice;
+	}
 }
 
 }} // namespace EE::Audio
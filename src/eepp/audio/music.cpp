@@ -150,6 +150,10 @@ void Music::setLoopPoints( TimeSpan timePoints ) {
 bool Music::onGetData( SoundStream::Chunk& data ) {
 	Lock lock( mMutex );
 
+	// The buffer duration can be changed at any time
+	if ( mSamples.size() != getBufferSampleCount() )
+		mSamples.resize( getBufferSampleCount() );
+
 	std::size_t toFill = mSamples.size();
 	Uint64 currentOffset = mFile.getSampleOffset();
 	Uint64 loopEnd = mLoopSpan.offset + mLoopSpan.length;
@@ -200,11 +204,11 @@ void Music::initialize() {
 	mLoopSpan.offset = 0;
 	mLoopSpan.length = mFile.getSampleCount();
 
-	// Resize the internal buffer so that it can contain 1 second of audio samples
-	mSamples.resize( mFile.getSampleRate() * mFile.getChannelCount() );
-
 	// Initialize the stream
 	SoundStream::initialize( mFile.getChannelCount(), mFile.getSampleRate() );
+
+	// Resize the internal buffer so that it can contain a buffer duration of audio samples
+	mSamples.resize( getBufferSampleCount() );
 }
 
 Uint64 Music::timeToSamples( Time position ) const {
@@ -1,10 +1,10 @@
 #include <eepp/audio/alcheck.hpp>
 #include <eepp/audio/audiodevice.hpp>
 #include <eepp/audio/soundstream.hpp>
+#include <eepp/audio/soundstreamscheduler.hpp>
 #include <eepp/core/debug.hpp>
 #include <eepp/system/lock.hpp>
 #include <eepp/system/log.hpp>
-#include <eepp/system/sys.hpp>
 
 #ifdef _MSC_VER
 #pragma warning( disable : 4355 ) // 'this' used in base member initializer list
@@ -13,29 +13,25 @@
 namespace EE { namespace Audio {
 
 SoundStream::SoundStream() :
-	mThread( &SoundStream::streamData, this ),
 	mThreadMutex(),
 	mThreadStartState( Stopped ),
 	mIsStreaming( false ),
+	mStreamStarted( false ),
+	mRequestStop( false ),
+	mBufferCount( DefaultBufferCount ),
+	mBufferDuration( Seconds( 1 ) ),
 	mBuffers(),
 	mChannelCount( 0 ),
 	mSampleRate( 0 ),
 	mFormat( 0 ),
 	mLoop( false ),
 	mSamplesProcessed( 0 ),
+	mUnderruns( 0 ),
 	mBufferSeeks() {}
 
 SoundStream::~SoundStream() {
-	// Stop the sound if it was playing
-
-	// Request the thread to terminate
-	{
-		Lock lock( mThreadMutex );
-		mIsStreaming = false;
-	}
-
-	// Wait for the thread to terminate
-	mThread.wait();
+	// Stop the sound if it was playing and wait for the scheduler to release it
+	stopStreaming();
 }
 
 void SoundStream::initialize( unsigned int channelCount, unsigned int sampleRate ) {
@@ -84,14 +80,12 @@ void SoundStream::play() {
 		stop();
 	}
 
-	// Start updating the stream in a separate thread to avoid blocking the application
-	mIsStreaming = true;
-	mThreadStartState = Playing;
-	mThread.launch();
+	// Start updating the stream in the scheduler to avoid blocking the application
+	startStreaming( Playing );
 }
 
 void SoundStream::pause() {
-	// Handle pause() being called before the thread has started
+	// Handle pause() being called before the stream has started
 	{
 		Lock lock( mThreadMutex );
 
@@ -105,17 +99,37 @@ void SoundStream::pause() {
 }
 
 void SoundStream::stop() {
-	// Request the thread to terminate
+	// Request the streaming to terminate and wait for it
+	stopStreaming();
+
+	// Move to the beginning
+	onSeek( Time::Zero );
+}
+
+void SoundStream::startStreaming( Status startState ) {
+	{
+		Lock lock( mThreadMutex );
+		mIsStreaming = true;
+		mThreadStartState = startState;
+	}
+
+	SoundStreamScheduler::instance()->add( this );
+}
+
+void SoundStream::stopStreaming() {
 	{
 		Lock lock( mThreadMutex );
 		mIsStreaming = false;
 	}
 
-	// Wait for the thread to terminate
-	mThread.wait();
+	SoundStreamScheduler* scheduler = SoundStreamScheduler::existsSingleton();
 
-	// Move to the beginning
-	onSeek( Time::Zero );
+	if ( NULL != scheduler )
+		scheduler->remove( this );
+
+	// The stream is no longer updated by the scheduler, release it from this thread
+	if ( mStreamStarted )
+		streamEnd();
 }
 
 unsigned int SoundStream::getChannelCount() const {
@@ -156,9 +170,7 @@ void SoundStream::setPlayingOffset( Time timeOffset ) {
 	if ( oldStatus == Stopped )
 		return;
 
-	mIsStreaming = true;
-	mThreadStartState = oldStatus;
-	mThread.launch();
+	startStreaming( oldStatus );
 }
 
 Time SoundStream::getPlayingOffset() const {
@@ -186,26 +198,73 @@ Int64 SoundStream::onLoop() {
 	return 0;
 }
 
-void SoundStream::streamData() {
-	bool requestStop = false;
+void SoundStream::setBufferCount( unsigned int bufferCount ) {
+	mBufferCount = eemax( 2u, bufferCount );
+}
+
+unsigned int SoundStream::getBufferCount() const {
+	return mBufferCount;
+}
+
+void SoundStream::setBufferDuration( const Time& duration ) {
+	mBufferDuration = duration;
+}
+
+const Time& SoundStream::getBufferDuration() const {
+	return mBufferDuration;
+}
+
+Uint64 SoundStream::getUnderrunCount() const {
+	Lock lock( mThreadMutex );
+	return mUnderruns;
+}
+
+std::size_t SoundStream::getBufferSampleCount() const {
+	std::size_t frames = static_cast<std::size_t>( mBufferDuration.asSeconds() * mSampleRate );
+	return eemax<std::size_t>( 1, frames ) * eemax( 1u, mChannelCount );
+}
+
+bool SoundStream::streamData() {
+	if ( !mStreamStarted && !streamStart() )
+		return false;
+
+	bool isStreaming;
 
+	{
+		Lock lock( mThreadMutex );
+		isStreaming = mIsStreaming;
+	}
+
+	if ( isStreaming )
+		isStreaming = streamUpdate();
+
+	if ( !isStreaming ) {
+		streamEnd();
+		return false;
+	}
+
+	return true;
+}
+
+bool SoundStream::streamStart() {
 	{
 		Lock lock( mThreadMutex );
 
-		// Check if the thread was launched Stopped
+		// Check if the stream was launched Stopped
 		if ( mThreadStartState == Stopped ) {
 			mIsStreaming = false;
-			return;
+			return false;
 		}
 	}
 
 	// Create the buffers
-	alCheck( alGenBuffers( BufferCount, mBuffers ) );
-	for ( int i = 0; i < BufferCount; ++i )
-		mBufferSeeks[i] = NoLoop;
+	mBuffers.assign( mBufferCount, 0 );
+	mBufferSeeks.assign( mBufferCount, NoLoop );
+	alCheck( alGenBuffers( static_cast<ALsizei>( mBuffers.size() ), &mBuffers[0] ) );
+	mStreamStarted = true;
 
 	// Fill the queue
-	requestStop = fillQueue();
+	mRequestStop = fillQueue();
 
 	// Play the sound
 	alCheck( alSourcePlay( mSource ) );
@@ -213,85 +272,88 @@ void SoundStream::streamData() {
 	{
 		Lock lock( mThreadMutex );
 
-		// Check if the thread was launched Paused
+		// Check if the stream was launched Paused
 		if ( mThreadStartState == Paused )
 			alCheck( alSourcePause( mSource ) );
 	}
 
-	for ( ;; ) {
-		{
-			Lock lock( mThreadMutex );
-			if ( !mIsStreaming )
-				break;
-		}
+	return true;
+}
 
-		// The stream has been interrupted!
-		if ( SoundSource::getStatus() == Stopped ) {
-			if ( !requestStop ) {
-				// Just continue
-				alCheck( alSourcePlay( mSource ) );
-			} else {
-				// End streaming
+bool SoundStream::streamUpdate() {
+	// The stream has been interrupted!
+	if ( SoundSource::getStatus() == Stopped ) {
+		if ( !mRequestStop ) {
+			// The queue ran dry before it was refilled, just continue
+			{
 				Lock lock( mThreadMutex );
-				mIsStreaming = false;
+				mUnderruns++;
 			}
+
+			SoundStreamScheduler::instance()->addUnderrun();
+			alCheck( alSourcePlay( mSource ) );
+		} else {
+			// End streaming
+			Lock lock( mThreadMutex );
+			mIsStreaming = false;
+			return false;
 		}
+	}
 
-		// Get the number of buffers that have been processed (i.e. ready for reuse)
-		ALint nbProcessed = 0;
-		alCheck( alGetSourcei( mSource, AL_BUFFERS_PROCESSED, &nbProcessed ) );
-
-		while ( nbProcessed-- ) {
-			// Pop the first unused buffer from the queue
-			ALuint buffer;
-			alCheck( alSourceUnqueueBuffers( mSource, 1, &buffer ) );
-
-			// Find its number
-			unsigned int bufferNum = 0;
-			for ( int i = 0; i < BufferCount; ++i )
-				if ( mBuffers[i] == buffer ) {
-					bufferNum = i;
-					break;
-				}
-
-			// Retrieve its size and add it to the samples count
-			if ( mBufferSeeks[bufferNum] != NoLoop ) {
-				// This was the last buffer before EOF or Loop End: reset the sample count
-				mSamplesProcessed = mBufferSeeks[bufferNum];
-				mBufferSeeks[bufferNum] = NoLoop;
-			} else {
-				ALint size, bits;
-				alCheck( alGetBufferi( buffer, AL_SIZE, &size ) );
-				alCheck( alGetBufferi( buffer, AL_BITS, &bits ) );
-
-				// Bits can be 0 if the format or parameters are corrupt, avoid division by zero
-				if ( bits == 0 ) {
-					Log::warning(
-						"SoundStream: Bits in sound stream are 0: make sure that the "
-						"audio format is not corrupt and initialize() has been called correctly." );
-
-					// Abort streaming (exit main loop)
-					Lock lock( mThreadMutex );
-					mIsStreaming = false;
-					requestStop = true;
-					break;
-				} else {
-					mSamplesProcessed += size / ( bits / 8 );
-				}
+	// Get the number of buffers that have been processed (i.e. ready for reuse)
+	ALint nbProcessed = 0;
+	alCheck( alGetSourcei( mSource, AL_BUFFERS_PROCESSED, &nbProcessed ) );
+
+	while ( nbProcessed-- ) {
+		// Pop the first unused buffer from the queue
+		ALuint buffer;
+		alCheck( alSourceUnqueueBuffers( mSource, 1, &buffer ) );
+
+		// Find its number
+		unsigned int bufferNum = 0;
+		for ( std::size_t i = 0; i < mBuffers.size(); ++i )
+			if ( mBuffers[i] == buffer ) {
+				bufferNum = i;
+				break;
 			}
 
-			// Fill it and push it back into the playing queue
-			if ( !requestStop ) {
-				if ( fillAndPushBuffer( bufferNum ) )
-					requestStop = true;
+		// Retrieve its size and add it to the samples count
+		if ( mBufferSeeks[bufferNum] != NoLoop ) {
+			// This was the last buffer before EOF or Loop End: reset the sample count
+			mSamplesProcessed = mBufferSeeks[bufferNum];
+			mBufferSeeks[bufferNum] = NoLoop;
+		} else {
+			ALint size, bits;
+			alCheck( alGetBufferi( buffer, AL_SIZE, &size ) );
+			alCheck( alGetBufferi( buffer, AL_BITS, &bits ) );
+
+			// Bits can be 0 if the format or parameters are corrupt, avoid division by zero
+			if ( bits == 0 ) {
+				Log::warning(
+					"SoundStream: Bits in sound stream are 0: make sure that the "
+					"audio format is not corrupt and initialize() has been called correctly." );
+
+				// Abort streaming
+				Lock lock( mThreadMutex );
+				mIsStreaming = false;
+				mRequestStop = true;
+				return false;
+			} else {
+				mSamplesProcessed += size / ( bits / 8 );
 			}
 		}
 
-		// Leave some time for the other threads if the stream is still playing
-		if ( SoundSource::getStatus() != Stopped )
-			Sys::sleep( Milliseconds( 10 ) );
+		// Fill it and push it back into the playing queue
+		if ( !mRequestStop ) {
+			if ( fillAndPushBuffer( bufferNum ) )
+				mRequestStop = true;
+		}
 	}
 
+	return true;
+}
+
+void SoundStream::streamEnd() {
 	// Stop the playback
 	alCheck( alSourceStop( mSource ) );
 
@@ -303,7 +365,10 @@ void SoundStream::streamData() {
 
 	// Delete the buffers
 	alCheck( alSourcei( mSource, AL_BUFFER, 0 ) );
-	alCheck( alDeleteBuffers( BufferCount, mBuffers ) );
+	alCheck( alDeleteBuffers( static_cast<ALsizei>( mBuffers.size() ), &mBuffers[0] ) );
+
+	mStreamStarted = false;
+	mRequestStop = false;
 }
 
 bool SoundStream::fillAndPushBuffer( unsigned int bufferNum, bool immediateLoop ) {
@@ -362,7 +427,7 @@ bool SoundStream::fillAndPushBuffer( unsigned int bufferNum, bool immediateLoop
 bool SoundStream::fillQueue() {
 	// Fill and enqueue all the available buffers
 	bool requestStop = false;
-	for ( int i = 0; ( i < BufferCount ) && !requestStop; ++i ) {
+	for ( std::size_t i = 0; ( i < mBuffers.size() ) && !requestStop; ++i ) {
 		// Since no sound has been loaded yet, we can't schedule loop seeks preemptively,
 		// So if we start on EOF or Loop End, we let fillAndPushBuffer() adjust the sample count
 		if ( fillAndPushBuffer( i, ( i == 0 ) ) )
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <eepp/audio/alcheck.hpp>
+#include <eepp/audio/soundstream.hpp>
+#include <eepp/audio/soundstreamscheduler.hpp>
+
+namespace EE { namespace Audio {
+
+SINGLETON_DECLARE_IMPLEMENTATION( SoundStreamScheduler )
+
+SoundStreamScheduler::SoundStreamScheduler() :
+	mThread( &SoundStreamScheduler::run, this ),
+	mWorkerCount( 2 ),
+	mUpdateInterval( Milliseconds( 10 ) ),
+	mUnderruns( 0 ),
+	mRunning( true ),
+	mWakeUp( false ) {
+	mPool = ThreadPool::createUnique( mWorkerCount );
+	mThread.launch();
+}
+
+SoundStreamScheduler::~SoundStreamScheduler() {
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mRunning = false;
+	}
+
+	mCondition.notify_all();
+	mThread.wait();
+
+	// Waits for the pending updates
+	mPool.reset();
+}
+
+void SoundStreamScheduler::setWorkerCount( Uint32 workerCount ) {
+	std::unique_ptr<ThreadPool> oldPool;
+
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		workerCount = eemax( 1u, workerCount );
+
+		if ( workerCount == mWorkerCount )
+			return;
+
+		mWorkerCount = workerCount;
+		oldPool = std::move( mPool );
+		mPool = ThreadPool::createUnique( mWorkerCount );
+	}
+
+	// The old pool finishes its pending updates before being released
+	oldPool.reset();
+}
+
+Uint32 SoundStreamScheduler::getWorkerCount() const {
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mWorkerCount;
+}
+
+void SoundStreamScheduler::setUpdateInterval( const Time& interval ) {
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mUpdateInterval = eemax( interval, Milliseconds( 1 ) );
+		mWakeUp = true;
+	}
+
+	mCondition.notify_all();
+}
+
+Time SoundStreamScheduler::getUpdateInterval() const {
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mUpdateInterval;
+}
+
+std::size_t SoundStreamScheduler::getActiveStreamCount() const {
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mStreams.size();
+}
+
+Uint64 SoundStreamScheduler::getUnderrunCount() const {
+	return mUnderruns;
+}
+
+void SoundStreamScheduler::addUnderrun() {
+	mUnderruns++;
+}
+
+void SoundStreamScheduler::add( SoundStream* stream ) {
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+
+		auto it = std::find_if( mStreams.begin(), mStreams.end(),
+								[stream]( const StreamEntry& entry ) {
+									return entry.stream == stream;
+								} );
+
+		if ( it == mStreams.end() )
+			mStreams.push_back( { stream, stream->getBufferDuration(), false } );
+
+		mWakeUp = true;
+	}
+
+	mCondition.notify_all();
+}
+
+void SoundStreamScheduler::remove( SoundStream* stream ) {
+	std::unique_lock<std::mutex> lock( mMutex );
+
+	auto findStream = [this, stream]() {
+		return std::find_if(
+			mStreams.begin(), mStreams.end(),
+			[stream]( const StreamEntry& entry ) { return entry.stream == stream; } );
+	};
+
+	// Wait for the worker updating the stream
+	mCondition.wait( lock, [&] {
+		auto it = findStream();
+		return it == mStreams.end() || !it->scheduled;
+	} );
+
+	auto it = findStream();
+
+	if ( it != mStreams.end() )
+		mStreams.erase( it );
+}
+
+void SoundStreamScheduler::process( SoundStream* stream ) {
+	bool keepStreaming = stream->streamData();
+
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+
+		auto it = std::find_if( mStreams.begin(), mStreams.end(),
+								[stream]( const StreamEntry& entry ) {
+									return entry.stream == stream;
+								} );
+
+		if ( it != mStreams.end() ) {
+			if ( keepStreaming ) {
+				it->scheduled = false;
+			} else {
+				mStreams.erase( it );
+			}
+		}
+	}
+
+	mCondition.notify_all();
+}
+
+void SoundStreamScheduler::run() {
+	std::vector<std::pair<ALint, SoundStream*>> pending;
+	std::unique_lock<std::mutex> lock( mMutex );
+
+	while ( mRunning ) {
+		Time wait = mUpdateInterval;
+		pending.clear();
+
+		for ( auto& entry : mStreams ) {
+			if ( entry.scheduled )
+				continue;
+
+			SoundStream* stream = entry.stream;
+
+			// Wake up often enough to refill the queue before it runs dry
+			wait = eemin( wait, entry.bufferDuration / static_cast<Int64>( 4 ) );
+
+			if ( !stream->mStreamStarted ) {
+				pending.push_back( { -1, stream } );
+				continue;
+			}
+
+			ALint state = AL_STOPPED, queued = 0, processed = 0;
+			alCheck( alGetSourcei( stream->mSource, AL_SOURCE_STATE, &state ) );
+			alCheck( alGetSourcei( stream->mSource, AL_BUFFERS_QUEUED, &queued ) );
+			alCheck( alGetSourcei( stream->mSource, AL_BUFFERS_PROCESSED, &processed ) );
+
+			// Streams with processed buffers are refilled, and the ones that stopped playing
+			// must be restarted or released
+			if ( processed > 0 || ( state != AL_PLAYING && state != AL_PAUSED ) )
+				pending.push_back( { queued - processed, stream } );
+		}
+
+		// The streams closer to run out of queued buffers are updated first
+		std::stable_sort( pending.begin(), pending.end(),
+						  []( const std::pair<ALint, SoundStream*>& a,
+							  const std::pair<ALint, SoundStream*>& b ) {
+							  return a.first < b.first;
+						  } );
+
+		for ( auto& stream : pending ) {
+			for ( auto& entry : mStreams ) {
+				if ( entry.stream == stream.second ) {
+					entry.scheduled = true;
+					break;
+				}
+			}
+
+			SoundStream* streamPtr = stream.second;
+			mPool->run( [this, streamPtr] { process( streamPtr ); } );
+		}
+
+		wait = eemax( wait, Milliseconds( 1 ) );
+		mCondition.wait_for( lock, std::chrono::microseconds( wait.asMicroseconds() ),
+							 [this] { return mWakeUp || !mRunning; } );
+		mWakeUp = false;
+	}
+}
+
+}} // namespace EE::Audio
@@ -3,6 +3,7 @@
 #include <eepp/graphics/renderer/openglext.hpp>
 #include <eepp/graphics/renderer/renderer.hpp>
 #include <eepp/graphics/texture.hpp>
+#include <cstring>
 
 namespace EE { namespace Graphics {
 
@@ -65,6 +66,9 @@ void BatchRenderer::setBlendMode( const BlendMode& blend ) {
 }
 
 void BatchRenderer::addVertexs( const unsigned int& num ) {
+	if ( nullptr != mCapture )
+		captureVertexs( num );
+
 	mNumVertex += num;
 
 	if ( ( mNumVertex + num ) >= mVertexSize ) {
@@ -79,6 +83,59 @@ void BatchRenderer::addVertexs( const unsigned int& num ) {
 	}
 }
 
+void BatchRenderer::captureVertexs( const unsigned int& num ) {
+	auto& batches = mCapture->batches;
+	if ( batches.empty() || batches.back().texture != mTexture ||
+		 batches.back().coordinateType != mCoordinateType || batches.back().blend != mBlend ||
+		 batches.back().mode != mCurrentMode )
+		batches.push_back( { mTexture, mCoordinateType, mBlend, mCurrentMode, 0 } );
+
+	batches.back().count += num;
+
+	for ( unsigned int i = 0; i < num; i++ ) {
+		mCapture->vertexs.push_back( mVertex[mNumVertex + i] );
+		mCapture->vertexs.back().pos -= mCaptureOrigin;
+	}
+}
+
+void BatchRenderer::startCapture( BatchCapture* capture, const Vector2f& origin ) {
+	mCapture = capture;
+	mCaptureOrigin = origin;
+}
+
+void BatchRenderer::stopCapture() {
+	mCapture = nullptr;
+}
+
+void BatchRenderer::batchCapture( const BatchCapture& capture, const Vector2f& offset ) {
+	const VertexData* vertexs = capture.vertexs.data();
+
+	for ( const auto& batch : capture.batches ) {
+		setTexture( batch.texture, batch.coordinateType );
+		setBlendMode( batch.blend );
+		setDrawMode( batch.mode, true );
+
+		// The primitives of a batch can't be split between two draw calls
+		if ( mNumVertex + batch.count >= mVertexSize ) {
+			flush();
+
+			if ( batch.count >= mVertexSize )
+				allocVertexs( batch.count * 2 );
+		}
+
+		VertexData* dest = &mVertex[mNumVertex];
+		std::memcpy( dest, vertexs, batch.count * sizeof( VertexData ) );
+
+		if ( offset != Vector2f::Zero ) {
+			for ( size_t i = 0; i < batch.count; i++ )
+				dest[i].pos += offset;
+		}
+
+		addVertexs( batch.count );
+		vertexs += batch.count;
+	}
+}
+
 void BatchRenderer::setDrawMode( const PrimitiveType& Mode, const bool& Force ) {
 	if ( Force && mCurrentMode != Mode ) {
 		flush();
@@ -1,6 +1,8 @@
 #include <algorithm>
 #include <cctype>
 #include <eepp/network/http.hpp>
+#include <eepp/network/http/httpengine.hpp>
+#include <eepp/network/http/httpsegmenteddownload.hpp>
 #include <eepp/network/http/httpstreamchunked.hpp>
 #include <eepp/network/ssl/sslsocket.hpp>
 #include <eepp/network/uri.hpp>
@@ -223,6 +225,14 @@ const bool& Http::Request::isContinue() const {
 	return mContinue;
 }
 
+void Http::Request::setSegments( Uint32 segments ) {
+	mSegments = eemax<Uint32>( segments, 1 );
+}
+
+const Uint32& Http::Request::getSegments() const {
+	return mSegments;
+}
+
 const bool& Http::Request::isCompressedResponse() const {
 	return mCompressedResponse;
 }
@@ -642,6 +652,9 @@ Http::Http( const std::string& host, unsigned short port, bool useSSL, URI proxy
 
 Http::~Http() {
 	// First we wait to finish any request pending
+	if ( Private::HttpEngine::existsSingleton() )
+		Private::HttpEngine::existsSingleton()->wait( this );
+
 	for ( auto&& itt : mThreads ) {
 		itt->wait();
 	}
@@ -1120,6 +1133,33 @@ void Http::setThreadPool( std::shared_ptr<ThreadPool> pool ) {
 	sGlobalThreadPool = pool;
 }
 
+const std::shared_ptr<ThreadPool>& Http::getThreadPool() {
+	return sGlobalThreadPool;
+}
+
+void Http::setMaxConnectionsPerHost( Uint32 maxConnections ) {
+	Private::HttpEngine::instance()->setMaxConnectionsPerHost( maxConnections );
+}
+
+Uint32 Http::getMaxConnectionsPerHost() {
+	return Private::HttpEngine::instance()->getMaxConnectionsPerHost();
+}
+
+void Http::setAsyncEngineEnabled( bool enabled ) {
+	Private::HttpEngine::instance()->setEnabled( enabled );
+}
+
+bool Http::isAsyncEngineEnabled() {
+	return Private::HttpEngine::instance()->isEnabled();
+}
+
+bool Http::canUseAsyncEngine( const Http::Request& request ) const {
+	// The SSL sockets and the proxy tunnels are blocking, and the resumed downloads need a
+	// previous request to know the length of the content
+	return isAsyncEngineEnabled() && !mIsSSL && mProxy.empty() && !mHostName.empty() &&
+		   !request.isContinue();
+}
+
 Http::AsyncRequest::AsyncRequest( Http* http, const Http::AsyncResponseCallback& cb,
 								  Http::Request request, Time timeout ) :
 	mHttp( http ),
@@ -1325,6 +1365,10 @@ void Http::sendAsyncRequest( const Http::AsyncResponseCallback& cb, const Http::
 								 emscripten_async_wget2_got_data,
 								 emscripten_async_wget2_got_error_data, NULL );
 #else
+	if ( canUseAsyncEngine( request ) ) {
+		Private::HttpEngine::instance()->send( this, this, cb, request, NULL, false, timeout );
+		return;
+	}
 	if ( sGlobalThreadPool ) {
 		sGlobalThreadPool->run( [this, cb, request, timeout] {
 			AsyncRequest asyncRequest( this, cb, request, timeout );
@@ -1354,6 +1398,10 @@ void Http::downloadAsyncRequest( const Http::AsyncResponseCallback& cb,
 								 emscripten_async_wget2_got_data,
 								 emscripten_async_wget2_got_error_data, NULL );
 #else
+	if ( canUseAsyncEngine( request ) ) {
+		Private::HttpEngine::instance()->send( this, this, cb, request, &writeTo, false, timeout );
+		return;
+	}
 	if ( sGlobalThreadPool ) {
 		sGlobalThreadPool->run( [this, cb, request, &writeTo, timeout] {
 			AsyncRequest asyncRequest( this, cb, request, writeTo, timeout );
@@ -1383,6 +1431,15 @@ void Http::downloadAsyncRequest( const Http::AsyncResponseCallback& cb,
 							emscripten_async_wget2_got_file, emscripten_async_wget2_got_error_file,
 							NULL );
 #else
+	if ( request.getSegments() > 1 && !request.isContinue() ) {
+		Private::HttpSegmentedDownload::start( this, cb, request, writePath, timeout );
+		return;
+	}
+	if ( canUseAsyncEngine( request ) ) {
+		Private::HttpEngine::instance()->send( this, this, cb, request,
+											   IOStreamFile::New( writePath, "wb" ), true, timeout );
+		return;
+	}
 	if ( sGlobalThreadPool ) {
 		sGlobalThreadPool->run( [this, cb, request, writePath, timeout] {
 			AsyncRequest asyncRequest( this, cb, request, writePath, timeout );
@@ -0,0 +1,984 @@
+#include <algorithm>
+#include <deque>
+#include <eepp/network/http/httpengine.hpp>
+#include <eepp/network/platform/platformimpl.hpp>
+#include <eepp/network/tcpsocket.hpp>
+#include <eepp/system/iostreaminflate.hpp>
+#include <eepp/system/iostreamstring.hpp>
+#include <eepp/system/log.hpp>
+#include <eepp/system/sys.hpp>
+#include <iostream>
+#include <sstream>
+
+#if defined( EE_PLATFORM_POSIX )
+#include <cerrno>
+#include <poll.h>
+#endif
+
+namespace EE { namespace Network { namespace Private {
+
+SINGLETON_DECLARE_IMPLEMENTATION( HttpEngine )
+
+// Created before any request can be sent, and destroyed to stop the engine thread at exit
+static struct HttpEngineInitializer {
+	HttpEngineInitializer() { HttpEngine::createSingleton(); }
+
+	~HttpEngineInitializer() { HttpEngine::destroySingleton(); }
+} sHttpEngineInitializer;
+
+static constexpr size_t PACKET_BUFFER_SIZE = 16384;
+
+// Idle keep-alive connections are closed after this time, servers usually close them before
+static const Time IDLE_TIMEOUT = Seconds( 30 );
+
+// Client whose callback is running in the current thread, it can't wait for itself
+static thread_local const Http* sCallbackOwner = nullptr;
+
+struct HttpEngine::Transfer {
+	enum class Body { None, Length, Chunked, Close };
+
+	enum class Chunk { Size, Data, DataEnd, Trailer };
+
+	~Transfer() {
+		inflate.reset();
+		if ( streamOwned )
+			eeSAFE_DELETE( stream );
+	}
+
+	IOStream& target() {
+		if ( inflate )
+			return *inflate;
+		if ( stream )
+			return *stream;
+		return body;
+	}
+
+	Http* owner{ nullptr };
+	Http* http{ nullptr };
+	Http::AsyncResponseCallback cb;
+	Http::Request request;
+	IOStream* stream{ nullptr };
+	bool streamOwned{ false };
+	Time timeout;
+	Time deadline{ Time::Zero }; ///< Counted since the request was sent
+	IOStreamString body; ///< Body of the response when there's no stream to write it
+	std::unique_ptr<IOStreamInflate> inflate;
+	Http::Response response;
+	std::string header;	 ///< Header received until its end is found
+	std::string line;	 ///< Chunk size or trailer line being received
+	std::string trailer; ///< Trailer fields of a chunked body
+	Body bodyType{ Body::None };
+	Chunk chunk{ Chunk::Size };
+	Uint64 contentLength{ 0 };
+	Uint64 chunkLeft{ 0 };
+	size_t received{ 0 }; ///< Bytes of the body received
+	bool headerReceived{ false };
+	bool keepAlive{ false };
+};
+
+struct HttpEngine::Connection {
+	enum class State { Connecting, Sending, Receiving, Idle, Closed };
+
+	Host* host{ nullptr };
+	TcpSocket socket;
+	State state{ State::Closed };
+	std::unique_ptr<Transfer> transfer;
+	std::string data; ///< Request being sent
+	size_t sent{ 0 };
+	bool reused{ false };
+	Time deadline{ Time::Zero };
+};
+
+struct HttpEngine::Host {
+	std::string key;
+	std::string name;
+	unsigned short port{ 0 };
+	IpAddress address;
+	bool solved{ false };
+	bool solving{ false };
+	std::deque<std::unique_ptr<Transfer>> queue;
+	std::vector<std::unique_ptr<Connection>> connections;
+};
+
+// The addresses solved in the thread pool, the engine is unset when it's destroyed first
+struct HttpEngine::Resolver {
+	std::mutex mutex;
+	HttpEngine* engine{ nullptr };
+	std::vector<std::pair<std::string, IpAddress>> solved;
+};
+
+HttpEngine::HttpEngine() : mResolver( std::make_shared<Resolver>() ) {
+	mResolver->engine = this;
+}
+
+HttpEngine::~HttpEngine() {
+	mShuttingDown = true;
+
+	{
+		std::lock_guard<std::mutex> lock( mResolver->mutex );
+		mResolver->engine = nullptr;
+	}
+
+	if ( mThread.joinable() ) {
+		wakeUp();
+		mThread.join();
+	}
+
+	// The callbacks of the pending requests can't be run while shutting down
+	mPool.reset();
+	mHosts.clear();
+	mIncoming.clear();
+
+	std::lock_guard<std::mutex> lock( mPendingMutex );
+	mPending.clear();
+	mPendingDone.notify_all();
+}
+
+void HttpEngine::send( Http* owner, Http* http, const Http::AsyncResponseCallback& cb,
+					   const Http::Request& request, IOStream* stream, bool streamOwned,
+					   const Time& timeout ) {
+	auto transfer = std::make_unique<Transfer>();
+	transfer->owner = owner;
+	transfer->http = http;
+	transfer->cb = cb;
+	transfer->request = request;
+	transfer->stream = stream;
+	transfer->streamOwned = streamOwned;
+	transfer->timeout = timeout;
+	transfer->deadline = timeout != Time::Zero ? mClock.getElapsedTime() + timeout : Time::Zero;
+
+	acquire( owner );
+
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		start();
+		mIncoming.emplace_back( std::move( transfer ) );
+	}
+
+	wakeUp();
+}
+
+void HttpEngine::wait( const Http* owner ) {
+	size_t running = sCallbackOwner == owner ? 1 : 0;
+	std::unique_lock<std::mutex> lock( mPendingMutex );
+	mPendingDone.wait( lock, [this, owner, running] {
+		auto it = mPending.find( owner );
+		return it == mPending.end() || it->second <= running;
+	} );
+}
+
+void HttpEngine::setMaxConnectionsPerHost( Uint32 maxConnections ) {
+	mMaxConnectionsPerHost = eemax<Uint32>( 1, maxConnections );
+}
+
+Uint32 HttpEngine::getMaxConnectionsPerHost() const {
+	return mMaxConnectionsPerHost;
+}
+
+void HttpEngine::setEnabled( bool enabled ) {
+	mEnabled = enabled;
+}
+
+bool HttpEngine::isEnabled() const {
+	return mEnabled;
+}
+
+void HttpEngine::start() {
+	if ( mStarted )
+		return;
+
+	mWakeUp.setBlocking( false );
+	if ( mWakeUp.bind( Socket::AnyPort, IpAddress::LocalHost ) == Socket::Done ) {
+		mWakeUpPort = mWakeUp.getLocalPort();
+	} else {
+		Log::error( "HttpEngine: couldn't bind the wake up socket" );
+	}
+
+	mThread = std::thread( [this] { run(); } );
+	mStarted = true;
+}
+
+void HttpEngine::wakeUp() {
+	char byte = 0;
+	if ( mWakeUpPort != 0 )
+		mWakeUp.send( &byte, 1, IpAddress::LocalHost, mWakeUpPort );
+}
+
+void HttpEngine::enqueue( std::unique_ptr<Transfer> transfer ) {
+	std::string key( transfer->http->getHostName() + ":" +
+					 String::toString( transfer->http->getPort() ) );
+	auto& host = mHosts[key];
+
+	if ( !host ) {
+		host = std::make_unique<Host>();
+		host->key = key;
+		host->name = transfer->http->getHostName();
+		host->port = transfer->http->getPort();
+	}
+
+	host->queue.emplace_back( std::move( transfer ) );
+}
+
+void HttpEngine::run() {
+	std::vector<Connection*> polled;
+	std::vector<std::unique_ptr<Transfer>> incoming;
+	std::vector<std::pair<std::string, IpAddress>> solved;
+#if defined( EE_PLATFORM_POSIX )
+	std::vector<pollfd> fds;
+#endif
+	char buffer[16];
+	std::size_t received;
+	IpAddress address;
+	unsigned short port;
+
+	while ( !mShuttingDown ) {
+		{
+			std::lock_guard<std::mutex> lock( mMutex );
+			incoming.swap( mIncoming );
+		}
+
+		{
+			std::lock_guard<std::mutex> lock( mResolver->mutex );
+			solved.swap( mResolver->solved );
+		}
+
+		for ( auto& transfer : incoming )
+			enqueue( std::move( transfer ) );
+		incoming.clear();
+
+		for ( auto& address : solved )
+			resolved( address.first, address.second );
+		solved.clear();
+
+		for ( auto& host : mHosts )
+			assign( *host.second );
+
+		// Wait until any socket is ready or the nearest deadline
+		Time now( mClock.getElapsedTime() );
+		Time deadline( Time::Zero );
+		polled.clear();
+
+		for ( auto& host : mHosts ) {
+			for ( auto& connection : host.second->connections ) {
+				if ( connection->state == Connection::State::Closed )
+					continue;
+				if ( connection->deadline != Time::Zero &&
+					 ( deadline == Time::Zero || connection->deadline < deadline ) )
+					deadline = connection->deadline;
+				polled.push_back( connection.get() );
+			}
+
+			for ( auto& transfer : host.second->queue ) {
+				if ( transfer->deadline != Time::Zero &&
+					 ( deadline == Time::Zero || transfer->deadline < deadline ) )
+					deadline = transfer->deadline;
+			}
+		}
+
+		int timeoutMs = -1;
+		if ( deadline != Time::Zero ) {
+			Int64 left = deadline > now ? ( deadline - now ).asMicroseconds() : 0;
+			timeoutMs = static_cast<int>( ( left + 999 ) / 1000 );
+		}
+		// Without the wake up socket the new requests are only noticed periodically
+		if ( mWakeUpPort == 0 && ( timeoutMs < 0 || timeoutMs > 10 ) )
+			timeoutMs = 10;
+
+#if defined( EE_PLATFORM_POSIX )
+		// poll has no limit in the socket handle value, unlike select with FD_SETSIZE
+		fds.resize( polled.size() + 1 );
+		fds[0] = { mWakeUp.getHandle(), POLLIN, 0 };
+		for ( size_t i = 0; i < polled.size(); i++ ) {
+			Connection::State state = polled[i]->state;
+			fds[i + 1] = { polled[i]->socket.getHandle(),
+						   static_cast<short>( state == Connection::State::Connecting ||
+													   state == Connection::State::Sending
+												   ? POLLOUT
+												   : POLLIN ),
+						   0 };
+		}
+
+		if ( ::poll( fds.data(), fds.size(), timeoutMs ) < 0 && errno != EINTR ) {
+			Log::error( "HttpEngine: poll failed, errno: %d", errno );
+			Sys::sleep( Milliseconds( 10 ) );
+			continue;
+		}
+
+		if ( fds[0].revents )
+			while ( mWakeUp.receive( buffer, sizeof( buffer ), received, address, port ) ==
+					Socket::Done )
+				;
+
+		for ( size_t i = 0; i < polled.size(); i++ ) {
+			short events = fds[i + 1].revents;
+			if ( events )
+				process( *polled[i], ( events & ( POLLIN | POLLERR | POLLHUP ) ) != 0,
+						 ( events & ( POLLOUT | POLLERR | POLLHUP ) ) != 0 );
+		}
+#else
+		fd_set readSet;
+		fd_set writeSet;
+		fd_set errorSet;
+		FD_ZERO( &readSet );
+		FD_ZERO( &writeSet );
+		FD_ZERO( &errorSet );
+		FD_SET( mWakeUp.getHandle(), &readSet );
+		for ( auto& connection : polled ) {
+			if ( connection->state == Connection::State::Connecting ||
+				 connection->state == Connection::State::Sending ) {
+				FD_SET( connection->socket.getHandle(), &writeSet );
+			} else {
+				FD_SET( connection->socket.getHandle(), &readSet );
+			}
+			FD_SET( connection->socket.getHandle(), &errorSet );
+		}
+
+		timeval time;
+		time.tv_sec = timeoutMs / 1000;
+		time.tv_usec = ( timeoutMs % 1000 ) * 1000;
+
+		if ( select( 0, &readSet, &writeSet, &errorSet, timeoutMs < 0 ? NULL : &time ) < 0 ) {
+			Log::error( "HttpEngine: select failed" );
+			Sys::sleep( Milliseconds( 10 ) );
+			continue;
+		}
+
+		if ( FD_ISSET( mWakeUp.getHandle(), &readSet ) )
+			while ( mWakeUp.receive( buffer, sizeof( buffer ), received, address, port ) ==
+					Socket::Done )
+				;
+
+		for ( auto& connection : polled ) {
+			SocketHandle handle = connection->socket.getHandle();
+			bool error = FD_ISSET( handle, &errorSet ) != 0;
+			bool readable = error || FD_ISSET( handle, &readSet ) != 0;
+			bool writable = error || FD_ISSET( handle, &writeSet ) != 0;
+			if ( readable || writable )
+				process( *connection, readable, writable );
+		}
+#endif
+
+		// Expire the transfers without activity, the idle connections, and the transfers that
+		// are still waiting for the address or a connection
+		now = mClock.getElapsedTime();
+
+		for ( auto& host : mHosts ) {
+			for ( auto& connection : host.second->connections ) {
+				if ( connection->state != Connection::State::Closed &&
+					 connection->deadline != Time::Zero && connection->deadline <= now )
+					close( *connection );
+			}
+
+			auto& queue = host.second->queue;
+			for ( auto it = queue.begin(); it != queue.end(); ) {
+				if ( ( *it )->deadline != Time::Zero && ( *it )->deadline <= now ) {
+					complete( std::move( *it ) );
+					it = queue.erase( it );
+				} else {
+					++it;
+				}
+			}
+		}
+
+		for ( auto it = mHosts.begin(); it != mHosts.end(); ) {
+			auto& connections = it->second->connections;
+			connections.erase( std::remove_if( connections.begin(), connections.end(),
+											   []( const std::unique_ptr<Connection>& connection ) {
+												   return connection->state ==
+														  Connection::State::Closed;
+											   } ),
+							   connections.end() );
+
+			// The address is solved again after the host connections are gone
+			if ( connections.empty() && it->second->queue.empty() ) {
+				it = mHosts.erase( it );
+			} else {
+				++it;
+			}
+		}
+	}
+}
+
+void HttpEngine::assign( Host& host ) {
+	if ( host.queue.empty() )
+		return;
+
+	if ( !host.solved ) {
+		if ( !host.solving )
+			resolve( host );
+		return;
+	}
+
+	for ( auto& connection : host.connections ) {
+		if ( host.queue.empty() )
+			return;
+
+		if ( connection->state == Connection::State::Idle ) {
+			connection->reused = true;
+			attach( *connection, std::move( host.queue.front() ) );
+			host.queue.pop_front();
+			connection->state = Connection::State::Sending;
+		}
+	}
+
+	while ( !host.queue.empty() && host.connections.size() < mMaxConnectionsPerHost ) {
+		host.connections.emplace_back( std::make_unique<Connection>() );
+		Connection& connection = *host.connections.back();
+		connection.host = &host;
+		attach( connection, std::move( host.queue.front() ) );
+		host.queue.pop_front();
+
+		if ( !connect( host, connection ) )
+			close( connection );
+	}
+}
+
+void HttpEngine::resolve( Host& host ) {
+	// The name lookup blocks, it would stall every other transfer in the engine thread
+	host.solving = true;
+	std::shared_ptr<Resolver> resolver( mResolver );
+	std::string key( host.key );
+	std::string name( host.name );
+
+	getThreadPool()->run( [resolver, key, name] {
+		IpAddress address( name );
+		std::lock_guard<std::mutex> lock( resolver->mutex );
+		if ( resolver->engine ) {
+			resolver->solved.emplace_back( key, address );
+			resolver->engine->wakeUp();
+		}
+	} );
+}
+
+void HttpEngine::resolved( const std::string& key, const IpAddress& address ) {
+	// The host is gone if all its transfers expired while it was being solved
+	auto it = mHosts.find( key );
+	if ( it == mHosts.end() || !it->second->solving )
+		return;
+
+	Host& host = *it->second;
+	host.solving = false;
+	host.address = address;
+	host.solved = address != IpAddress::None;
+
+	if ( !host.solved ) {
+		while ( !host.queue.empty() ) {
+			complete( std::move( host.queue.front() ) );
+			host.queue.pop_front();
+		}
+	}
+}
+
+bool HttpEngine::connect( Host& host, Connection& connection ) {
+	connection.socket.setBlocking( false );
+
+	// Even when connected instantly, it's reported as writable by the next wait
+	Socket::Status status = connection.socket.connect( host.address, host.port, Time::Zero );
+	if ( status != Socket::Done && status != Socket::NotReady )
+		return false;
+
+	connection.state = Connection::State::Connecting;
+	return true;
+}
+
+void HttpEngine::attach( Connection& connection, std::unique_ptr<Transfer> transfer ) {
+	Http::Request request( transfer->request );
+
+	if ( !request.hasField( "Connection" ) )
+		request.setField( "Connection", "keep-alive" );
+
+	connection.data = transfer->http->prepareFields( request ).prepare( *transfer->http );
+	connection.sent = 0;
+
+	if ( transfer->request.isVerbose() ) {
+		std::cout << "Request:" << std::endl;
+		std::cout << connection.data << std::endl;
+	}
+
+	// The time waiting for the address and a free connection counts in the timeout
+	connection.deadline = transfer->deadline;
+	connection.transfer = std::move( transfer );
+}
+
+void HttpEngine::process( Connection& connection, bool readable, bool writable ) {
+	switch ( connection.state ) {
+		case Connection::State::Connecting: {
+			if ( !writable )
+				return;
+
+			// The result of the connection is reported as the socket error
+			int error = 0;
+			SocketImpl::AddrLength length = sizeof( error );
+			if ( getsockopt( connection.socket.getHandle(), SOL_SOCKET, SO_ERROR,
+							 reinterpret_cast<char*>( &error ), &length ) != 0 ||
+				 error != 0 ) {
+				fail( connection );
+				return;
+			}
+
+			connection.state = Connection::State::Sending;
+
+			if ( !progress( *connection.transfer, Http::Request::Connected, 0, 0 ) ) {
+				close( connection );
+				return;
+			}
+			// The socket is writable, the request can be sent right away
+		}
+		// fallthrough
+		case Connection::State::Sending: {
+			if ( !writable && !readable )
+				return;
+
+			std::size_t sent = 0;
+			Socket::Status status = connection.socket.send(
+				connection.data.data() + connection.sent, connection.data.size() - connection.sent,
+				sent );
+			connection.sent += sent;
+
+			if ( status == Socket::Partial || status == Socket::NotReady )
+				return;
+
+			if ( status != Socket::Done ) {
+				fail( connection );
+				return;
+			}
+
+			connection.state = Connection::State::Receiving;
+			connection.data.clear();
+
+			if ( !progress( *connection.transfer, Http::Request::Sent, 0, 0 ) )
+				close( connection );
+			return;
+		}
+		case Connection::State::Receiving: {
+			char buffer[PACKET_BUFFER_SIZE];
+
+			// Limited, so a fast transfer doesn't starve the others
+			for ( int i = 0; i < 16 && connection.state == Connection::State::Receiving; i++ ) {
+				std::size_t received = 0;
+				Socket::Status status = connection.socket.receive( buffer, sizeof( buffer ),
+																	received );
+				if ( status == Socket::Done ) {
+					receive( connection, buffer, received );
+				} else if ( status == Socket::NotReady ) {
+					return;
+				} else {
+					Transfer& transfer = *connection.transfer;
+					if ( status == Socket::Disconnected && transfer.headerReceived &&
+						 transfer.bodyType == Transfer::Body::Close ) {
+						release( connection );
+					} else if ( !transfer.headerReceived && transfer.header.empty() ) {
+						fail( connection );
+					} else {
+						close( connection );
+					}
+					return;
+				}
+			}
+			return;
+		}
+		case Connection::State::Idle: {
+			// The server closed the connection, or sent something that wasn't requested
+			if ( readable )
+				close( connection );
+			return;
+		}
+		case Connection::State::Closed:
+			return;
+	}
+}
+
+void HttpEngine::receive( Connection& connection, const char* data, size_t size ) {
+	Transfer& transfer = *connection.transfer;
+
+	if ( transfer.timeout != Time::Zero )
+		connection.deadline = mClock.getElapsedTime() + transfer.timeout;
+
+	if ( transfer.headerReceived ) {
+		receiveBody( connection, data, size );
+		return;
+	}
+
+	transfer.header.append( data, size );
+
+	if ( !receiveHeader( connection ) )
+		return;
+
+	// What follows the header is the beginning of the body
+	std::string body( std::move( transfer.header ) );
+	transfer.header.clear();
+	if ( !body.empty() )
+		receiveBody( connection, body.data(), body.size() );
+}
+
+bool HttpEngine::receiveHeader( Connection& connection ) {
+	Transfer& transfer = *connection.transfer;
+	Http::Response& response = transfer.response;
+
+	while ( true ) {
+		size_t end = transfer.header.find( "\r\n\r\n" );
+		size_t length = 4;
+		size_t endLF = transfer.header.find( "\n\n" );
+		if ( endLF != std::string::npos && ( end == std::string::npos || endLF < end ) ) {
+			end = endLF;
+			length = 2;
+		}
+
+		if ( end == std::string::npos )
+			return false;
+
+		response = Http::Response();
+		response.parse( transfer.header.substr( 0, end + length ) );
+		transfer.header.erase( 0, end + length );
+
+		// Interim responses ( 100 Continue ) are followed by the final one
+		if ( response.getStatus() < 100 || response.getStatus() >= 200 )
+			break;
+	}
+
+	transfer.headerReceived = true;
+
+	if ( response.getStatus() == Http::Response::InvalidResponse ) {
+		close( connection );
+		return false;
+	}
+
+	std::string connectionField( String::toLower( response.getField( "connection" ) ) );
+	transfer.keepAlive = response.getMajorHttpVersion() * 10 + response.getMinorHttpVersion() >= 11
+							 ? connectionField != "close"
+							 : connectionField == "keep-alive";
+
+	if ( transfer.request.getMethod() == Http::Request::Head ||
+		 response.getStatus() == Http::Response::NoContent ||
+		 response.getStatus() == Http::Response::NotModified ) {
+		transfer.bodyType = Transfer::Body::None;
+	} else if ( String::toLower( response.getField( "transfer-encoding" ) ).find( "chunked" ) !=
+				std::string::npos ) {
+		transfer.bodyType = Transfer::Body::Chunked;
+	} else if ( response.hasField( "content-length" ) &&
+				String::fromString( transfer.contentLength,
+									response.getField( "content-length" ) ) ) {
+		transfer.bodyType =
+			transfer.contentLength > 0 ? Transfer::Body::Length : Transfer::Body::None;
+	} else {
+		// Without a length the body ends when the server closes the connection
+		transfer.bodyType = Transfer::Body::Close;
+		transfer.keepAlive = false;
+	}
+
+	if ( redirect( connection ) ) {
+		close( connection );
+		return false;
+	}
+
+	std::string encoding( response.getField( "content-encoding" ) );
+	if ( encoding == "gzip" || encoding == "deflate" ) {
+		transfer.inflate = std::make_unique<IOStreamInflate>(
+			transfer.target(),
+			encoding == "gzip" ? Compression::MODE_GZIP : Compression::MODE_DEFLATE );
+	}
+
+	if ( !progress( transfer, Http::Request::HeaderReceived,
+					static_cast<size_t>( transfer.contentLength ), 0 ) ) {
+		close( connection );
+		return false;
+	}
+
+	if ( transfer.bodyType == Transfer::Body::None ) {
+		// Nothing else was requested, whatever follows can't be trusted
+		if ( !transfer.header.empty() )
+			transfer.keepAlive = false;
+		release( connection );
+		return false;
+	}
+
+	return true;
+}
+
+void HttpEngine::receiveBody( Connection& connection, const char* data, size_t size ) {
+	Transfer& transfer = *connection.transfer;
+	bool done = false;
+
+	switch ( transfer.bodyType ) {
+		case Transfer::Body::Length: {
+			size_t length = static_cast<size_t>(
+				eemin<Uint64>( size, transfer.contentLength - transfer.received ) );
+			transfer.target().write( data, length );
+			transfer.received += length;
+			done = transfer.received == transfer.contentLength;
+			if ( length < size )
+				transfer.keepAlive = false;
+			break;
+		}
+		case Transfer::Body::Chunked: {
+			done = receiveChunked( transfer, data, size );
+			transfer.received += size;
+			break;
+		}
+		case Transfer::Body::Close: {
+			transfer.target().write( data, size );
+			transfer.received += size;
+			break;
+		}
+		case Transfer::Body::None: {
+			done = true;
+			break;
+		}
+	}
+
+	if ( !progress( transfer, Http::Request::ContentReceived,
+					static_cast<size_t>( transfer.contentLength ), transfer.received ) ) {
+		close( connection );
+		return;
+	}
+
+	if ( done )
+		release( connection );
+}
+
+bool HttpEngine::receiveChunked( Transfer& transfer, const char* data, size_t size ) {
+	size_t pos = 0;
+
+	while ( pos < size ) {
+		switch ( transfer.chunk ) {
+			case Transfer::Chunk::Size: {
+				char c = data[pos++];
+				if ( c != '\n' ) {
+					transfer.line += c;
+					break;
+				}
+
+				// The chunk extensions are ignored
+				std::string line( transfer.line.substr( 0, transfer.line.find( ';' ) ) );
+				line.erase( line.find_last_not_of( " \t\r" ) + 1 );
+				String::trimInPlace( line );
+				transfer.line.clear();
+
+				if ( line.empty() )
+					break;
+
+				if ( !String::fromString( transfer.chunkLeft, line, 16 ) ) {
+					// Malformed, the body can't be delimited anymore
+					transfer.keepAlive = false;
+					return true;
+				}
+
+				transfer.chunk =
+					transfer.chunkLeft > 0 ? Transfer::Chunk::Data : Transfer::Chunk::Trailer;
+				break;
+			}
+			case Transfer::Chunk::Data: {
+				size_t length =
+					static_cast<size_t>( eemin<Uint64>( size - pos, transfer.chunkLeft ) );
+				transfer.target().write( data + pos, length );
+				pos += length;
+				transfer.chunkLeft -= length;
+				if ( transfer.chunkLeft == 0 )
+					transfer.chunk = Transfer::Chunk::DataEnd;
+				break;
+			}
+			case Transfer::Chunk::DataEnd: {
+				if ( data[pos++] == '\n' )
+					transfer.chunk = Transfer::Chunk::Size;
+				break;
+			}
+			case Transfer::Chunk::Trailer: {
+				char c = data[pos++];
+				if ( c != '\n' ) {
+					transfer.line += c;
+					break;
+				}
+
+				if ( transfer.line.empty() || transfer.line == "\r" ) {
+					if ( pos < size )
+						transfer.keepAlive = false;
+					return true;
+				}
+
+				transfer.trailer += transfer.line + "\n";
+				transfer.line.clear();
+				break;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool HttpEngine::redirect( Connection& connection ) {
+	Transfer& transfer = *connection.transfer;
+	Http::Request& request = transfer.request;
+	Http::Response::Status status = transfer.response.getStatus();
+
+	if ( ( status != Http::Response::MovedPermanently &&
+		   status != Http::Response::MovedTemporarily ) ||
+		 !request.getFollowRedirect() || request.mRedirectionCount >= request.getMaxRedirects() )
+		return false;
+
+	URI uri( transfer.response.getField( "location" ) );
+	Http::Request newRequest( request );
+	newRequest.setUri( uri.getPathAndQuery() );
+	request.mRedirectionCount++;
+	newRequest.mRedirectionCount = request.mRedirectionCount;
+
+	// Same host, expects a path in the same domain
+	Http* http = uri.getHost().empty() || ( uri.getHost() == transfer.http->getHostName() &&
+											uri.getPort() == transfer.http->getPort() )
+					 ? transfer.http
+					 : Http::Pool::getGlobal().get( uri );
+
+	// The transfer of the redirection is closed without calling its callback
+	Http* owner = transfer.owner;
+	Http::AsyncResponseCallback cb( std::move( transfer.cb ) );
+	IOStream* stream = transfer.stream;
+	bool streamOwned = transfer.streamOwned;
+	transfer.cb = nullptr;
+	transfer.stream = nullptr;
+	transfer.streamOwned = false;
+
+	if ( http->canUseAsyncEngine( newRequest ) ) {
+		auto next = std::make_unique<Transfer>();
+		next->owner = owner;
+		next->http = http;
+		next->cb = std::move( cb );
+		next->request = newRequest;
+		next->stream = stream;
+		next->streamOwned = streamOwned;
+		next->timeout = transfer.timeout;
+		next->deadline = transfer.timeout != Time::Zero ? mClock.getElapsedTime() + transfer.timeout
+														: Time::Zero;
+		acquire( owner );
+		enqueue( std::move( next ) );
+		return true;
+	}
+
+	// HTTPS continues in its own thread, the owner is still the reported one
+	auto onResponse = [this, owner, cb, stream, streamOwned](
+						  const Http&, Http::Request& redirected, Http::Response& response ) {
+		if ( streamOwned )
+			eeDelete( stream );
+		cb( *owner, redirected, response );
+		unacquire( owner );
+	};
+
+	acquire( owner );
+
+	if ( stream ) {
+		http->downloadAsyncRequest( onResponse, newRequest, *stream, transfer.timeout );
+	} else {
+		http->sendAsyncRequest( onResponse, newRequest, transfer.timeout );
+	}
+
+	return true;
+}
+
+void HttpEngine::release( Connection& connection ) {
+	std::unique_ptr<Transfer> transfer( std::move( connection.transfer ) );
+
+	if ( transfer->keepAlive && !transfer->request.isCancelled() ) {
+		connection.state = Connection::State::Idle;
+		connection.deadline = mClock.getElapsedTime() + IDLE_TIMEOUT;
+	} else {
+		close( connection );
+	}
+
+	complete( std::move( transfer ) );
+}
+
+void HttpEngine::fail( Connection& connection ) {
+	// The server might have closed the reused connection meanwhile, the request is sent again in
+	// another connection. Each failure closes one of them, so it's retried a limited number of
+	// times.
+	if ( connection.transfer && connection.reused && !connection.transfer->headerReceived &&
+		 connection.transfer->header.empty() )
+		connection.host->queue.emplace_front( std::move( connection.transfer ) );
+
+	close( connection );
+}
+
+void HttpEngine::close( Connection& connection ) {
+	connection.socket.disconnect();
+	connection.state = Connection::State::Closed;
+	connection.deadline = Time::Zero;
+	connection.data.clear();
+
+	// Completed with whatever was received until now
+	if ( connection.transfer )
+		complete( std::move( connection.transfer ) );
+}
+
+void HttpEngine::complete( std::unique_ptr<Transfer> transfer ) {
+	// Flushes the decompressed data
+	transfer->inflate.reset();
+
+	// A file written by the transfer is complete when the callback reads it
+	if ( transfer->streamOwned ) {
+		eeSAFE_DELETE( transfer->stream );
+		transfer->streamOwned = false;
+	}
+
+	if ( !transfer->trailer.empty() ) {
+		std::istringstream in( transfer->trailer );
+		transfer->response.parseFields( in );
+	}
+
+	if ( !transfer->stream )
+		transfer->response.mBody = std::move( transfer->body.getStream() );
+
+	Transfer* completed = transfer.release();
+	getThreadPool()->run( [this, completed] { finish( completed ); } );
+}
+
+void HttpEngine::finish( Transfer* transfer ) {
+	std::unique_ptr<Transfer> finished( transfer );
+	const Http* owner = finished->owner;
+
+	if ( finished->cb ) {
+		sCallbackOwner = owner;
+		finished->cb( *finished->owner, finished->request, finished->response );
+		sCallbackOwner = nullptr;
+	}
+
+	finished.reset();
+	unacquire( owner );
+}
+
+bool HttpEngine::progress( Transfer& transfer, const Http::Request::Status& status, size_t total,
+						   size_t current ) {
+	if ( transfer.request.getProgressCallback() &&
+		 !transfer.request.getProgressCallback()( *transfer.owner, transfer.request,
+												  transfer.response, status, total, current ) )
+		transfer.request.mCancel = true;
+
+	return !transfer.request.isCancelled();
+}
+
+void HttpEngine::acquire( const Http* owner ) {
+	std::lock_guard<std::mutex> lock( mPendingMutex );
+	mPending[owner]++;
+}
+
+void HttpEngine::unacquire( const Http* owner ) {
+	std::lock_guard<std::mutex> lock( mPendingMutex );
+	auto it = mPending.find( owner );
+	if ( it == mPending.end() )
+		return;
+	if ( --it->second == 0 )
+		mPending.erase( it );
+	mPendingDone.notify_all();
+}
+
+const std::shared_ptr<ThreadPool>& HttpEngine::getThreadPool() {
+	if ( Http::getThreadPool() )
+		return Http::getThreadPool();
+
+	if ( !mPool ) {
+		// The engine thread never runs the callbacks, they might block
+		mPool = ThreadPool::createShared(
+			static_cast<Uint32>( eeclamp( Sys::getCPUCount(), 2, 4 ) ) );
+	}
+
+	return mPool;
+}
+
+}}} // namespace EE::Network::Private
@@ -0,0 +1,130 @@
+#ifndef EE_NETWORK_HTTPENGINE_HPP
+#define EE_NETWORK_HTTPENGINE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <eepp/core/containers.hpp>
+#include <eepp/core/noncopyable.hpp>
+#include <eepp/network/http.hpp>
+#include <eepp/network/udpsocket.hpp>
+#include <eepp/system/clock.hpp>
+#include <eepp/system/singleton.hpp>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace EE::System;
+
+namespace EE { namespace Network { namespace Private {
+
+/** @brief Non-blocking HTTP/1.1 engine used by the asynchronous requests of Http.
+ * A single thread multiplexes every transfer with non-blocking sockets, keeps the keep-alive
+ * connections of each host to reuse them for the next requests, limits the number of
+ * simultaneous connections per host, and enforces the timeouts as deadlines of the wait. The
+ * host names are resolved in the Http thread pool, or in a small pool owned by the engine, where
+ * the response callbacks are run too. The progress callbacks are run in the engine thread, so
+ * they must return quickly: any time spent in them delays every other transfer. */
+class HttpEngine : NonCopyable {
+	SINGLETON_DECLARE_HEADERS( HttpEngine )
+
+  public:
+	~HttpEngine();
+
+	/** Queues the request to the host of http.
+	 * @param owner The client reported to the callback, and waited by its destructor.
+	 * @param stream Where the body is written, or null to keep it in the response body.
+	 * @param streamOwned If the stream is destroyed when the transfer ends, before the callback. */
+	void send( Http* owner, Http* http, const Http::AsyncResponseCallback& cb,
+			   const Http::Request& request, IOStream* stream, bool streamOwned,
+			   const Time& timeout );
+
+	/** Waits for the pending requests of the owner to finish. */
+	void wait( const Http* owner );
+
+	void setMaxConnectionsPerHost( Uint32 maxConnections );
+
+	Uint32 getMaxConnectionsPerHost() const;
+
+	void setEnabled( bool enabled );
+
+	bool isEnabled() const;
+
+  protected:
+	struct Transfer;
+	struct Connection;
+	struct Host;
+	struct Resolver;
+
+	HttpEngine();
+
+	void start();
+
+	void run();
+
+	void wakeUp();
+
+	void enqueue( std::unique_ptr<Transfer> transfer );
+
+	void assign( Host& host );
+
+	void resolve( Host& host );
+
+	void resolved( const std::string& key, const IpAddress& address );
+
+	bool connect( Host& host, Connection& connection );
+
+	void attach( Connection& connection, std::unique_ptr<Transfer> transfer );
+
+	void process( Connection& connection, bool readable, bool writable );
+
+	void receive( Connection& connection, const char* data, size_t size );
+
+	bool receiveHeader( Connection& connection );
+
+	void receiveBody( Connection& connection, const char* data, size_t size );
+
+	bool receiveChunked( Transfer& transfer, const char* data, size_t size );
+
+	bool redirect( Connection& connection );
+
+	void release( Connection& connection );
+
+	void fail( Connection& connection );
+
+	void close( Connection& connection );
+
+	void complete( std::unique_ptr<Transfer> transfer );
+
+	void finish( Transfer* transfer );
+
+	bool progress( Transfer& transfer, const Http::Request::Status& status, size_t total,
+				   size_t current );
+
+	void acquire( const Http* owner );
+
+	void unacquire( const Http* owner );
+
+	const std::shared_ptr<ThreadPool>& getThreadPool();
+
+	std::atomic<bool> mEnabled{ true };
+	std::atomic<bool> mShuttingDown{ false };
+	std::atomic<Uint32> mMaxConnectionsPerHost{ 6 };
+	bool mStarted{ false };
+	std::thread mThread;
+	std::mutex mMutex;
+	std::vector<std::unique_ptr<Transfer>> mIncoming;
+	UdpSocket mWakeUp;
+	unsigned short mWakeUpPort{ 0 };
+	Clock mClock;
+	UnorderedMap<std::string, std::unique_ptr<Host>> mHosts;
+	std::shared_ptr<Resolver> mResolver;
+	std::shared_ptr<ThreadPool> mPool;
+	std::mutex mPendingMutex;
+	std::condition_variable mPendingDone;
+	UnorderedMap<const Http*, size_t> mPending;
+};
+
+}}} // namespace EE::Network::Private
+
+#endif // EE_NETWORK_HTTPENGINE_HPP
@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cstdio>
+#include <eepp/network/http/httpsegmenteddownload.hpp>
+#include <eepp/system/filesystem.hpp>
+#include <eepp/system/iostream.hpp>
+
+#if EE_PLATFORM == EE_PLATFORM_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace EE { namespace Network { namespace Private {
+
+// The file shared by the segments. The writes are positional so they don't share a file position,
+// where pwrite isn't available they're serialized.
+class HttpSegmentedDownload::File {
+  public:
+	~File() {
+		if ( mFile )
+			std::fclose( mFile );
+	}
+
+	bool open( const std::string& path, Uint64 size ) {
+		mFile = FileSystem::fopenUtf8( path, "wb" );
+		if ( !mFile )
+			return false;
+#if EE_PLATFORM == EE_PLATFORM_WIN
+		return _chsize_s( _fileno( mFile ), size ) == 0;
+#else
+		return ftruncate( fileno( mFile ), size ) == 0;
+#endif
+	}
+
+	bool write( const char* data, Uint64 size, Uint64 offset ) {
+#if EE_PLATFORM == EE_PLATFORM_WIN
+		std::lock_guard<std::mutex> lock( mMutex );
+		return _fseeki64( mFile, offset, SEEK_SET ) == 0 &&
+			   std::fwrite( data, 1, size, mFile ) == size;
+#else
+		while ( size > 0 ) {
+			ssize_t written = pwrite( fileno( mFile ), data, size, offset );
+			if ( written <= 0 )
+				return false;
+			data += written;
+			size -= written;
+			offset += written;
+		}
+		return true;
+#endif
+	}
+
+  protected:
+	std::FILE* mFile{ nullptr };
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	std::mutex mMutex;
+#endif
+};
+
+struct HttpSegmentedDownload::Segment {
+	Uint64 start{ 0 };
+	Uint64 length{ 0 };
+	Uint64 received{ 0 };
+	Uint64 resumedAt{ 0 };
+	Uint32 failures{ 0 };
+	std::unique_ptr<SegmentStream> stream;
+};
+
+// Writes the body of the segment after the bytes already received, anything past the end of the
+// segment is discarded
+class HttpSegmentedDownload::SegmentStream : public IOStream {
+  public:
+	SegmentStream( File& file, Segment& segment, std::atomic<Uint64>& received ) :
+		mFile( file ), mSegment( segment ), mReceived( received ) {}
+
+	ios_size read( char*, ios_size ) { return 0; }
+
+	ios_size write( const char* data, ios_size size ) {
+		size = std::min<Uint64>( size, mSegment.length - mSegment.received );
+		if ( size <= 0 || !mFile.write( data, size, mSegment.start + mSegment.received ) )
+			return 0;
+		mSegment.received += size;
+		mReceived += size;
+		return size;
+	}
+
+	ios_size seek( ios_size ) { return tell(); }
+
+	ios_size tell() { return mSegment.received; }
+
+	ios_size getSize() { return mSegment.length; }
+
+	bool isOpen() { return true; }
+
+  protected:
+	File& mFile;
+	Segment& mSegment;
+	std::atomic<Uint64>& mReceived;
+};
+
+void HttpSegmentedDownload::start( Http* http, const Http::AsyncResponseCallback& cb,
+								   const Http::Request& request, const std::string& writePath,
+								   const Time& timeout ) {
+	std::shared_ptr<HttpSegmentedDownload> download(
+		new HttpSegmentedDownload( http, cb, request, writePath, timeout ) );
+
+	Http::Request head( request );
+	head.setMethod( Http::Request::Head );
+	head.setSegments( 1 );
+	head.setCompressedResponse( false );
+	head.setProgressCallback( Http::Request::ProgressCallback() );
+	http->sendAsyncRequest(
+		[download]( const Http&, Http::Request&, Http::Response& response ) {
+			download->onHead( response );
+		},
+		head, timeout );
+}
+
+HttpSegmentedDownload::HttpSegmentedDownload( Http* http, const Http::AsyncResponseCallback& cb,
+											  const Http::Request& request,
+											  const std::string& writePath, const Time& timeout ) :
+	mHttp( http ),
+	mCb( cb ),
+	mRequest( request ),
+	mWritePath( writePath ),
+	mTimeout( timeout ),
+	mMaxSegments( request.getSegments() ) {
+	// The ranges are offsets of the content as stored, it can't be encoded
+	mRequest.setSegments( 1 );
+	mRequest.setCompressedResponse( false );
+}
+
+HttpSegmentedDownload::~HttpSegmentedDownload() {}
+
+void HttpSegmentedDownload::onHead( Http::Response& response ) {
+	Uint64 length = 0;
+
+	if ( response.getStatus() != Http::Response::Ok ||
+		 String::toLower( response.getField( "accept-ranges" ) ) != "bytes" ||
+		 !String::fromString( length, response.getField( "content-length" ) ) ||
+		 length < MIN_SEGMENT_SIZE * 2 ) {
+		downloadWhole();
+		return;
+	}
+
+	mFile = std::make_unique<File>();
+	if ( !mFile->open( mWritePath, length ) ) {
+		mFile.reset();
+		downloadWhole();
+		return;
+	}
+
+	mResponse = response;
+	mLength = length;
+
+	Uint64 count = std::min<Uint64>( mMaxSegments, length / MIN_SEGMENT_SIZE );
+	for ( Uint64 i = 0; i < count; i++ ) {
+		auto segment = std::make_unique<Segment>();
+		segment->start = length * i / count;
+		segment->length = length * ( i + 1 ) / count - segment->start;
+		segment->stream = std::make_unique<SegmentStream>( *mFile, *segment, mReceived );
+		mSegments.emplace_back( std::move( segment ) );
+	}
+
+	mPending = mSegments.size();
+	for ( auto& segment : mSegments )
+		send( *segment );
+}
+
+void HttpSegmentedDownload::downloadWhole() {
+	mHttp->downloadAsyncRequest( mCb, mRequest, mWritePath, mTimeout );
+}
+
+void HttpSegmentedDownload::send( Segment& segment ) {
+	auto self = shared_from_this();
+	segment.resumedAt = segment.received;
+	Http::Request request( mRequest );
+	request.setField( "Range",
+					  String::format( "bytes=%llu-%llu",
+									  (unsigned long long)( segment.start + segment.received ),
+									  (unsigned long long)( segment.start + segment.length - 1 ) ) );
+	request.setProgressCallback( [self, &segment]( const Http&, const Http::Request&,
+												   const Http::Response& response,
+												   const Http::Request::Status& status,
+												   std::size_t, std::size_t ) {
+		return self->onProgress( segment, response, status );
+	} );
+	mHttp->downloadAsyncRequest(
+		[self, &segment]( const Http&, Http::Request&, Http::Response& response ) {
+			self->onSegment( segment, response );
+		},
+		request, *segment.stream, mTimeout );
+}
+
+bool HttpSegmentedDownload::isRequestedRange( const Segment& segment,
+											   const Http::Response& response ) {
+	if ( response.getStatus() != Http::Response::PartialContent )
+		return false;
+
+	// Content-Range: bytes <first>-<last>/<length>
+	std::string range( String::toLower( response.getField( "content-range" ) ) );
+	Uint64 first = 0;
+	if ( !String::startsWith( range, "bytes " ) )
+		return false;
+	range = range.substr( 6, range.find( '-' ) - 6 );
+	return String::fromString( first, String::trim( range ) ) &&
+		   first == segment.start + segment.resumedAt;
+}
+
+void HttpSegmentedDownload::onSegment( Segment& segment, Http::Response& response ) {
+	std::unique_lock<std::mutex> lock( mMutex );
+	bool partial = isRequestedRange( segment, response );
+
+	if ( mRangesIgnored ||
+		 ( !partial && response.getStatus() < Http::Response::MultipleChoices ) ) {
+		// The server answered with something else than the range requested
+		mRangesIgnored = true;
+		mCancelled = true;
+	} else if ( !partial || segment.received < segment.length ) {
+		// An interrupted segment is requested again from where it stopped, while it keeps
+		// receiving something
+		bool interrupted = partial || response.getStatus() >= Http::Response::InvalidResponse;
+		if ( segment.received > segment.resumedAt )
+			segment.failures = 0;
+		if ( interrupted && !mFailed && !mCancelled &&
+			 ++segment.failures <= MAX_SEGMENT_FAILURES ) {
+			lock.unlock();
+			send( segment );
+			return;
+		}
+
+		// The segments stopped by the progress callback didn't fail, the download is reported as
+		// cancelled instead
+		if ( !mFailed && !mUserCancelled ) {
+			mFailed = true;
+			mResponse = response;
+		}
+		mCancelled = true;
+	}
+
+	if ( --mPending > 0 )
+		return;
+
+	lock.unlock();
+	mFile.reset();
+
+	if ( mUserCancelled ) {
+		mRequest.cancel();
+	} else if ( mRangesIgnored ) {
+		downloadWhole();
+		return;
+	}
+
+	mCb( *mHttp, mRequest, mResponse );
+}
+
+bool HttpSegmentedDownload::onProgress( Segment& segment, const Http::Response& response,
+										const Http::Request::Status& status ) {
+	if ( mCancelled )
+		return false;
+
+	// A server that doesn't support ranges can answer the whole file, every segment is stopped
+	// and the file is requested again without ranges once they finish
+	if ( status == Http::Request::HeaderReceived &&
+		 response.getStatus() < Http::Response::MultipleChoices &&
+		 !isRequestedRange( segment, response ) ) {
+		mRangesIgnored = true;
+		mCancelled = true;
+		return false;
+	}
+
+	if ( !mRequest.getProgressCallback() )
+		return true;
+
+	std::lock_guard<std::mutex> lock( mProgressMutex );
+	if ( !mRequest.getProgressCallback()( *mHttp, mRequest, response,
+										  Http::Request::ContentReceived, mLength, mReceived ) ) {
+		mUserCancelled = true;
+		mCancelled = true;
+		return false;
+	}
+
+	return true;
+}
+
+}}} // namespace EE::Network::Private
@@ -0,0 +1,86 @@
+#ifndef EE_NETWORK_HTTPSEGMENTEDDOWNLOAD_HPP
+#define EE_NETWORK_HTTPSEGMENTEDDOWNLOAD_HPP
+
+#include <atomic>
+#include <eepp/core/noncopyable.hpp>
+#include <eepp/network/http.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace EE::System;
+
+namespace EE { namespace Network { namespace Private {
+
+/** @brief Downloads a file in several byte ranges requested at the same time.
+ * The length of the file and the support of ranges is requested first with a HEAD request, then
+ * the file is preallocated and each segment is written at its own offset as it's received. A
+ * segment that fails is requested again from the last byte received, and the progress reported
+ * is the sum of all of them. If the server doesn't accept ranges, or it answers a range request
+ * with a different range or the whole file, the file is downloaded as usual.
+ */
+class HttpSegmentedDownload : public std::enable_shared_from_this<HttpSegmentedDownload>,
+							  NonCopyable {
+  public:
+	/** Minimum length of each segment, smaller files are requested in fewer segments. */
+	static constexpr Uint64 MIN_SEGMENT_SIZE = 256 * 1024;
+
+	/** Number of consecutive attempts of a segment that can fail without receiving anything. */
+	static constexpr Uint32 MAX_SEGMENT_FAILURES = 3;
+
+	/** Starts the download of request into writePath.
+	 * @param cb Receives the response of the HEAD request if every segment was received, or the
+	 * response of the segment that failed. If the progress callback stopped the download it
+	 * receives the response of the HEAD request with the request cancelled. */
+	static void start( Http* http, const Http::AsyncResponseCallback& cb,
+					   const Http::Request& request, const std::string& writePath,
+					   const Time& timeout );
+
+	~HttpSegmentedDownload();
+
+  protected:
+	class File;
+	class SegmentStream;
+	struct Segment;
+
+	Http* mHttp;
+	Http::AsyncResponseCallback mCb;
+	Http::Request mRequest;
+	std::string mWritePath;
+	Time mTimeout;
+	Uint32 mMaxSegments;
+	Http::Response mResponse;
+	std::unique_ptr<File> mFile;
+	std::vector<std::unique_ptr<Segment>> mSegments;
+	std::mutex mMutex;
+	std::mutex mProgressMutex;
+	size_t mPending{ 0 };
+	bool mFailed{ false };
+	std::atomic<bool> mCancelled{ false };
+	std::atomic<bool> mUserCancelled{ false };
+	std::atomic<bool> mRangesIgnored{ false };
+	std::atomic<Uint64> mReceived{ 0 };
+	Uint64 mLength{ 0 };
+
+	HttpSegmentedDownload( Http* http, const Http::AsyncResponseCallback& cb,
+						   const Http::Request& request, const std::string& writePath,
+						   const Time& timeout );
+
+	void onHead( Http::Response& response );
+
+	void downloadWhole();
+
+	void send( Segment& segment );
+
+	/** @return If the response is the range requested for the segment */
+	static bool isRequestedRange( const Segment& segment, const Http::Response& response );
+
+	void onSegment( Segment& segment, Http::Response& response );
+
+	bool onProgress( Segment& segment, const Http::Response& response,
+					 const Http::Request::Status& status );
+};
+
+}}} // namespace EE::Network::Private
+
+#endif // EE_NETWORK_HTTPSEGMENTEDDOWNLOAD_HPP
@@ -1,9 +1,25 @@
 #include <algorithm>
+#include <eepp/core/containers.hpp>
 #include <eepp/network/platform/platformimpl.hpp>
 #include <eepp/network/socket.hpp>
 #include <eepp/network/socketselector.hpp>
 #include <eepp/system/log.hpp>
 #include <utility>
+#include <vector>
+
+#if EE_PLATFORM == EE_PLATFORM_LINUX || EE_PLATFORM == EE_PLATFORM_ANDROID
+#define EE_SOCKET_SELECTOR_EPOLL
+#include <cerrno>
+#include <sys/epoll.h>
+#include <unistd.h>
+#elif EE_PLATFORM == EE_PLATFORM_MACOS || EE_PLATFORM == EE_PLATFORM_IOS || \
+	EE_PLATFORM == EE_PLATFORM_BSD
+#define EE_SOCKET_SELECTOR_KQUEUE
+#include <cerrno>
+#include <sys/event.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
 
 #if EE_PLATFORM == EE_PLATFORM_HAIKU
 #include <sys/select.h>
@@ -16,113 +32,278 @@
 
 namespace EE { namespace Network {
 
+#if defined( EE_SOCKET_SELECTOR_EPOLL ) || defined( EE_SOCKET_SELECTOR_KQUEUE )
+#define EE_SOCKET_SELECTOR_QUEUE
+// Maximum number of events retrieved by a single wait, the rest are retrieved by the next one
+static constexpr size_t MAX_EVENTS = 4096;
+#endif
+
 struct SocketSelector::SocketSelectorImpl {
+	struct Entry {
+		Socket* socket;
+		bool ready;
+	};
+
+	Trigger trigger;
+	UnorderedMap<SocketHandle, Entry> sockets; ///< Sockets in the selector by handle
+	std::vector<SocketHandle> socketsReady;	   ///< Handles of the sockets that are ready
+#if defined( EE_SOCKET_SELECTOR_EPOLL )
+	int queue{ -1 };				  ///< epoll instance
+	std::vector<epoll_event> events;  ///< Events retrieved by the last wait
+#elif defined( EE_SOCKET_SELECTOR_KQUEUE )
+	int queue{ -1 };				  ///< kqueue instance
+	std::vector<struct kevent> events; ///< Events retrieved by the last wait
+#else
 	fd_set AllSockets;	 ///< Set containing all the sockets handles
 	fd_set SocketsReady; ///< Set containing handles of the sockets that are ready
 	int MaxSocket;		 ///< Maximum socket handle
 	int SocketCount;	 ///< Number of socket handles
-};
+#endif
 
-SocketSelector::SocketSelector() : mImpl( eeNew( SocketSelectorImpl, () ) ) {
-	clear();
-}
+	explicit SocketSelectorImpl( Trigger trigger ) : trigger( trigger ) { open(); }
 
-SocketSelector::SocketSelector( const SocketSelector& copy ) :
-	mImpl( eeNew( SocketSelectorImpl, ( *copy.mImpl ) ) ) {}
+	SocketSelectorImpl( const SocketSelectorImpl& copy ) :
+		trigger( copy.trigger ), sockets( copy.sockets ), socketsReady( copy.socketsReady ) {
+#ifdef EE_SOCKET_SELECTOR_QUEUE
+		// The kernel queue can't be shared, a new one is created with the same sockets
+		open();
+		for ( const auto& socket : sockets )
+			watch( socket.first );
+#else
+		AllSockets = copy.AllSockets;
+		SocketsReady = copy.SocketsReady;
+		MaxSocket = copy.MaxSocket;
+		SocketCount = copy.SocketCount;
+#endif
+	}
 
-SocketSelector::~SocketSelector() {
-	eeSAFE_DELETE( mImpl );
-}
+	~SocketSelectorImpl() { close(); }
 
-void SocketSelector::add( Socket& socket ) {
-	SocketHandle handle = socket.getHandle();
+	void open() {
+#if defined( EE_SOCKET_SELECTOR_EPOLL )
+		queue = epoll_create1( EPOLL_CLOEXEC );
+#elif defined( EE_SOCKET_SELECTOR_KQUEUE )
+		queue = kqueue();
+#else
+		FD_ZERO( &AllSockets );
+		FD_ZERO( &SocketsReady );
+		MaxSocket = 0;
+		SocketCount = 0;
+#endif
+#ifdef EE_SOCKET_SELECTOR_QUEUE
+		if ( queue == -1 )
+			Log::error( "SocketSelector: couldn't create the event queue, errno: %d", errno );
+#endif
+	}
 
-	if ( handle != Private::SocketImpl::invalidSocket() ) {
+	void close() {
+#ifdef EE_SOCKET_SELECTOR_QUEUE
+		if ( queue != -1 ) {
+			::close( queue );
+			queue = -1;
+		}
+#endif
+	}
+
+	bool watch( SocketHandle handle ) {
+#if defined( EE_SOCKET_SELECTOR_EPOLL )
+		epoll_event event{};
+		event.events = EPOLLIN | ( trigger == Trigger::Edge ? EPOLLET : 0 );
+		event.data.fd = handle;
+		return epoll_ctl( queue, EPOLL_CTL_ADD, handle, &event ) == 0;
+#elif defined( EE_SOCKET_SELECTOR_KQUEUE )
+		struct kevent event;
+		EV_SET( &event, handle, EVFILT_READ,
+				EV_ADD | ( trigger == Trigger::Edge ? EV_CLEAR : 0 ), 0, 0, nullptr );
+		return kevent( queue, &event, 1, nullptr, 0, nullptr ) == 0;
+#else
 #if EE_PLATFORM == EE_PLATFORM_WIN
-		if ( mImpl->SocketCount >= FD_SETSIZE ) {
+		if ( SocketCount >= FD_SETSIZE ) {
 			Log::error( "The socket can't be added to the selector because its ID is too high. "
 						"This is a limitation of your operating system's FD_SETSIZE setting." );
-			return;
+			return false;
 		}
 
-		if ( FD_ISSET( handle, &mImpl->AllSockets ) )
-			return;
-
-		mImpl->SocketCount++;
+		SocketCount++;
 #else
 		if ( handle >= FD_SETSIZE ) {
 			Log::error( "The socket can't be added to the selector because its ID is too high. "
 						"This is a limitation of your operating system's FD_SETSIZE setting." );
-			return;
+			return false;
 		}
 
 		// SocketHandle is an int in POSIX
-		mImpl->MaxSocket = std::max( mImpl->MaxSocket, handle );
+		MaxSocket = std::max( MaxSocket, handle );
 #endif
 
-		FD_SET( handle, &mImpl->AllSockets );
+		FD_SET( handle, &AllSockets );
+		return true;
+#endif
 	}
-}
-
-void SocketSelector::remove( Socket& socket ) {
-	SocketHandle handle = socket.getHandle();
 
-	if ( handle != Private::SocketImpl::invalidSocket() ) {
+	void unwatch( SocketHandle handle ) {
+		// The handle might be already closed, and then removed by the kernel from the queue, so
+		// the errors are ignored
+#if defined( EE_SOCKET_SELECTOR_EPOLL )
+		epoll_event event{};
+		epoll_ctl( queue, EPOLL_CTL_DEL, handle, &event );
+#elif defined( EE_SOCKET_SELECTOR_KQUEUE )
+		struct kevent event;
+		EV_SET( &event, handle, EVFILT_READ, EV_DELETE, 0, 0, nullptr );
+		kevent( queue, &event, 1, nullptr, 0, nullptr );
+#else
 #if EE_PLATFORM == EE_PLATFORM_WIN
-		if ( !FD_ISSET( handle, &mImpl->AllSockets ) )
-			return;
+		SocketCount--;
+#endif
+		FD_CLR( handle, &AllSockets );
+		FD_CLR( handle, &SocketsReady );
+#endif
+	}
+
+	void setReady( SocketHandle handle ) {
+		auto it = sockets.find( handle );
+		if ( it != sockets.end() && !it->second.ready ) {
+			it->second.ready = true;
+			socketsReady.push_back( handle );
+		}
+	}
+
+	void resetReady() {
+		for ( const auto& handle : socketsReady ) {
+			auto it = sockets.find( handle );
+			if ( it != sockets.end() )
+				it->second.ready = false;
+		}
+		socketsReady.clear();
+	}
+
+	bool wait( Time timeout ) {
+		resetReady();
 
-		mImpl->SocketCount--;
+#if defined( EE_SOCKET_SELECTOR_EPOLL )
+		events.resize( std::clamp<size_t>( sockets.size(), 1, MAX_EVENTS ) );
+		// Rounded up, so short timeouts don't turn into a busy loop
+		int timeoutMs = timeout != Time::Zero
+							? static_cast<int>( ( timeout.asMicroseconds() + 999 ) / 1000 )
+							: -1;
+		int count =
+			epoll_wait( queue, events.data(), static_cast<int>( events.size() ), timeoutMs );
+		// Errors and hang ups are reported as ready, so the next receive reports them
+		for ( int i = 0; i < count; i++ )
+			setReady( events[i].data.fd );
+#elif defined( EE_SOCKET_SELECTOR_KQUEUE )
+		events.resize( std::clamp<size_t>( sockets.size(), 1, MAX_EVENTS ) );
+		timespec time;
+		time.tv_sec = static_cast<time_t>( timeout.asMicroseconds() / 1000000 );
+		time.tv_nsec = static_cast<long>( ( timeout.asMicroseconds() % 1000000 ) * 1000 );
+		int count = kevent( queue, nullptr, 0, events.data(), static_cast<int>( events.size() ),
+							timeout != Time::Zero ? &time : nullptr );
+		for ( int i = 0; i < count; i++ )
+			setReady( static_cast<SocketHandle>( events[i].ident ) );
 #else
-		if ( handle >= FD_SETSIZE )
-			return;
+		// Setup the timeout
+		timeval time;
+		time.tv_sec = static_cast<long>( timeout.asMicroseconds() / 1000000 );
+		time.tv_usec = static_cast<long>( timeout.asMicroseconds() % 1000000 );
+
+		// Initialize the set that will contain the sockets that are ready
+		SocketsReady = AllSockets;
+
+		// Wait until one of the sockets is ready for reading, or timeout is reached
+		// The first parameter is ignored on Windows
+		int count = select( MaxSocket + 1, &SocketsReady, NULL, NULL,
+							timeout != Time::Zero ? &time : NULL );
+
+		if ( count > 0 ) {
+			for ( const auto& socket : sockets ) {
+				if ( FD_ISSET( socket.first, &SocketsReady ) )
+					socketsReady.push_back( socket.first );
+			}
+			for ( const auto& handle : socketsReady )
+				sockets[handle].ready = true;
+		}
 #endif
 
-		FD_CLR( handle, &mImpl->AllSockets );
-		FD_CLR( handle, &mImpl->SocketsReady );
+		return count > 0;
 	}
+};
+
+SocketSelector::SocketSelector( Trigger trigger ) :
+	mImpl( eeNew( SocketSelectorImpl, ( trigger ) ) ) {}
+
+SocketSelector::SocketSelector( const SocketSelector& copy ) :
+	mImpl( eeNew( SocketSelectorImpl, ( *copy.mImpl ) ) ) {}
+
+SocketSelector::~SocketSelector() {
+	eeSAFE_DELETE( mImpl );
 }
 
-void SocketSelector::clear() {
-	FD_ZERO( &mImpl->AllSockets );
-	FD_ZERO( &mImpl->SocketsReady );
+void SocketSelector::add( Socket& socket ) {
+	SocketHandle handle = socket.getHandle();
+
+	if ( handle != Private::SocketImpl::invalidSocket() ) {
+		// The handle might belong to a closed socket that wasn't removed, that the kernel already
+		// dropped from the queue, so it's registered again
+		if ( mImpl->sockets.erase( handle ) )
+			mImpl->unwatch( handle );
 
-	mImpl->MaxSocket = 0;
-	mImpl->SocketCount = 0;
+		if ( mImpl->watch( handle ) )
+			mImpl->sockets[handle] = { &socket, false };
+	}
 }
 
-bool SocketSelector::wait( Time timeout ) {
-	// Setup the timeout
-	timeval time;
-	time.tv_sec = static_cast<long>( timeout.asMicroseconds() / 1000000 );
-	time.tv_usec = static_cast<long>( timeout.asMicroseconds() % 1000000 );
+void SocketSelector::remove( Socket& socket ) {
+	SocketHandle handle = socket.getHandle();
+
+	if ( handle != Private::SocketImpl::invalidSocket() ) {
+		auto it = mImpl->sockets.find( handle );
+		if ( it == mImpl->sockets.end() )
+			return;
 
-	// Initialize the set that will contain the sockets that are ready
-	mImpl->SocketsReady = mImpl->AllSockets;
+		mImpl->sockets.erase( it );
+		mImpl->unwatch( handle );
+	}
+}
 
-	// Wait until one of the sockets is ready for reading, or timeout is reached
-	// The first parameter is ignored on Windows
-	int count = select( mImpl->MaxSocket + 1, &mImpl->SocketsReady, NULL, NULL,
-						timeout != Time::Zero ? &time : NULL );
+void SocketSelector::clear() {
+	mImpl->close();
+	mImpl->open();
+	mImpl->sockets.clear();
+	mImpl->socketsReady.clear();
+}
 
-	return count > 0;
+bool SocketSelector::wait( Time timeout ) {
+	return mImpl->wait( timeout );
 }
 
 bool SocketSelector::isReady( Socket& socket ) const {
 	SocketHandle handle = socket.getHandle();
 
 	if ( handle != Private::SocketImpl::invalidSocket() ) {
-#if EE_PLATFORM == EE_PLATFORM_WIN
-		if ( handle >= FD_SETSIZE )
-			return false;
-#endif
-
-		return FD_ISSET( handle, &mImpl->SocketsReady ) != 0;
+		auto it = mImpl->sockets.find( handle );
+		return it != mImpl->sockets.end() && it->second.ready;
 	}
 
 	return false;
 }
 
+void SocketSelector::forEachReady( const std::function<void( Socket& )>& callback ) const {
+	// Iterated by index and looked up each time, since the callback can add and remove sockets
+	for ( size_t i = 0; i < mImpl->socketsReady.size(); i++ ) {
+		auto it = mImpl->sockets.find( mImpl->socketsReady[i] );
+		if ( it != mImpl->sockets.end() && it->second.ready )
+			callback( *it->second.socket );
+	}
+}
+
+size_t SocketSelector::getReadyCount() const {
+	return mImpl->socketsReady.size();
+}
+
+size_t SocketSelector::getSocketCount() const {
+	return mImpl->sockets.size();
+}
+
 SocketSelector& SocketSelector::operator=( const SocketSelector& right ) {
 	SocketSelector temp( right );
 
@@ -4,12 +4,18 @@
 #include <eepp/network/platform/platformimpl.hpp>
 #include <eepp/network/tcpsocket.hpp>
 #include <eepp/system/clock.hpp>
+#include <eepp/system/ioreactor.hpp>
 #include <eepp/system/log.hpp>
 
 #if EE_PLATFORM == EE_PLATFORM_HAIKU
 #include <sys/select.h>
 #endif
 
+#if defined( EE_PLATFORM_POSIX )
+#include <cerrno>
+#include <poll.h>
+#endif
+
 #ifdef _MSC_VER
 #pragma warning( \
 	disable : 4127 ) // "conditional expression is constant" generated by the FD_SET macro
@@ -33,6 +39,7 @@ TcpSocket* TcpSocket::New() {
 TcpSocket::TcpSocket() : Socket( Tcp ) {}
 
 TcpSocket::~TcpSocket() {
+	stopReactorRead();
 	close();
 	if ( mReadThread.joinable() )
 		mReadThread.join();
@@ -129,6 +136,17 @@ Socket::Status TcpSocket::connect( const IpAddress& remoteAddress, unsigned shor
 
 		// Otherwise, wait until something happens to our socket (success, timeout or error)
 		if ( status == Socket::NotReady ) {
+#if defined( EE_PLATFORM_POSIX )
+			// poll has no limit in the socket handle value, unlike select with FD_SETSIZE
+			pollfd selector{};
+			selector.fd = getHandle();
+			selector.events = POLLOUT;
+			int timeoutMs = static_cast<int>( ( timeout.asMicroseconds() + 999 ) / 1000 );
+
+			// Wait for something to write on our socket (which means that the connection request
+			// has returned)
+			if ( poll( &selector, 1, timeoutMs ) > 0 ) {
+#else
 			// Setup the selector
 			fd_set selector;
 			FD_ZERO( &selector );
@@ -142,6 +160,7 @@ Socket::Status TcpSocket::connect( const IpAddress& remoteAddress, unsigned shor
 			// Wait for something to write on our socket (which means that the connection request
 			// has returned)
 			if ( select( static_cast<int>( getHandle() + 1 ), NULL, &selector, NULL, &time ) > 0 ) {
+#endif
 				// At this point the connection may have been either accepted or refused.
 				// To know whether it's a success or a failure, we must check the address of the
 				// connected peer
@@ -166,6 +185,8 @@ Socket::Status TcpSocket::connect( const IpAddress& remoteAddress, unsigned shor
 }
 
 void TcpSocket::disconnect() {
+	stopReactorRead();
+
 	// Close the socket
 	close();
 
@@ -344,6 +365,9 @@ void TcpSocket::setReceiveTimeout( const Time& timeout ) {
 }
 
 void TcpSocket::startAsyncRead( ReadFn readFn ) {
+	if ( startReactorRead( readFn ) )
+		return;
+
 	mReadThread = std::thread( [this, readFn] {
 		setReceiveTimeout( Milliseconds( 100 ) );
 		std::string buffer;
@@ -364,6 +388,47 @@ void TcpSocket::startAsyncRead( ReadFn readFn ) {
 	} );
 }
 
+bool TcpSocket::startReactorRead( const ReadFn& readFn ) {
+#if defined( EE_PLATFORM_POSIX )
+	if ( !IOReactor::isSupported() || !IOReactor::instance()->isEnabled() ||
+		 getHandle() == Private::SocketImpl::invalidSocket() )
+		return false;
+
+	std::string buffer( 131072, '\0' );
+	auto onReady = [readFn, buffer]( int fd ) mutable -> bool {
+		// The socket blocking mode is kept, each receive is non-blocking instead. A few receives at
+		// most, so a busy socket doesn't hold the pool thread.
+		for ( int i = 0; i < 16; i++ ) {
+			ssize_t received = recv( fd, &buffer[0], buffer.size(), flags | MSG_DONTWAIT );
+			if ( received > 0 ) {
+				if ( readFn )
+					readFn( buffer.c_str(), static_cast<size_t>( received ) );
+			} else if ( received < 0 && errno == EINTR ) {
+				continue;
+			} else {
+				// Disconnected or failed
+				return received < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK );
+			}
+		}
+		return true;
+	};
+
+	mAsyncReadId = IOReactor::instance()->add( { static_cast<int>( getHandle() ) }, onReady );
+	return mAsyncReadId != 0;
+#else
+	(void)readFn;
+	return false;
+#endif
+}
+
+void TcpSocket::stopReactorRead() {
+	if ( mAsyncReadId == 0 )
+		return;
+	if ( IOReactor::existsSingleton() )
+		IOReactor::instance()->remove( mAsyncReadId );
+	mAsyncReadId = 0;
+}
+
 TcpSocket::PendingPacket::PendingPacket() : Size( 0 ), SizeReceived( 0 ), Data() {}
 
 }} // namespace EE::Network
@@ -51,8 +51,10 @@ Compression::Status Compression::compress( IOStream& dst, IOStream& src, Compres
 
 					ret = deflate( &strm, flush );
 
-					if ( ret == Z_STREAM_ERROR )
+					if ( ret == Z_STREAM_ERROR ) {
+						deflateEnd( &strm );
 						return Status::STREAM_ERROR;
+					}
 
 					have = DEFLATE_CHUNK_SIZE - strm.avail_out;
 
@@ -63,9 +65,13 @@ Compression::Status Compression::compress( IOStream& dst, IOStream& src, Compres
 					}
 				} while ( strm.avail_out == 0 );
 
-				if ( strm.avail_in != 0 )
+				if ( strm.avail_in != 0 ) {
+					deflateEnd( &strm );
 					return Status::DATA_ERROR;
+				}
 			} while ( flush != Z_FINISH );
+
+			deflateEnd( &strm );
 		}
 	}
 
@@ -356,8 +356,8 @@ std::string FileSystem::getRealPath( const std::string& path ) {
 	std::string realPath;
 #ifdef EE_PLATFORM_POSIX
 	char dir[PATH_MAX];
-	realpath( path.c_str(), &dir[0] );
-	realPath = std::string( dir );
+	if ( realpath( path.c_str(), &dir[0] ) != nullptr )
+		realPath = std::string( dir );
 #elif EE_PLATFORM == EE_PLATFORM_WIN
 	wchar_t dir[_MAX_PATH + 1];
 	GetFullPathNameW( String::fromUtf8( path ).toWideString().c_str(), _MAX_PATH, &dir[0],
@@ -543,6 +543,78 @@ std::vector<std::string> FileSystem::filesGetInPath( const std::string& path,
 	return files;
 }
 
+bool FileSystem::filesEntriesGetInPath( const std::string& path, const DirectoryEntryCb& cb,
+										const std::function<bool()> shouldAbort ) {
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	String widePath( path );
+
+	if ( widePath[widePath.size() - 1] == '/' || widePath[widePath.size() - 1] == '\\' ) {
+		widePath += "*";
+	} else {
+		widePath += "\\*";
+	}
+
+	WIN32_FIND_DATAW findFileData;
+	HANDLE hFind = FindFirstFileW( widePath.toWideString().c_str(), &findFileData );
+
+	if ( hFind == INVALID_HANDLE_VALUE )
+		return false;
+
+	do {
+		String name( findFileData.cFileName );
+
+		if ( name == "." || name == ".." )
+			continue;
+
+		EntryType type = EntryType::File;
+		if ( findFileData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT )
+			type = EntryType::Link;
+		else if ( findFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+			type = EntryType::Directory;
+
+		cb( name.toUtf8().c_str(), type );
+	} while ( FindNextFileW( hFind, &findFileData ) && ( !shouldAbort || !shouldAbort() ) );
+
+	FindClose( hFind );
+#else
+	DIR* dp;
+	struct dirent* dirp;
+
+	if ( ( dp = opendir( path.c_str() ) ) == NULL )
+		return false;
+
+	while ( ( dirp = readdir( dp ) ) != NULL && ( !shouldAbort || !shouldAbort() ) ) {
+		if ( strcmp( dirp->d_name, ".." ) == 0 || strcmp( dirp->d_name, "." ) == 0 )
+			continue;
+
+		EntryType type = EntryType::Unknown;
+#ifdef DT_DIR
+		switch ( dirp->d_type ) {
+			case DT_REG:
+				type = EntryType::File;
+				break;
+			case DT_DIR:
+				type = EntryType::Directory;
+				break;
+			case DT_LNK:
+				type = EntryType::Link;
+				break;
+			case DT_UNKNOWN:
+				break;
+			default: // Devices, pipes and sockets
+				type = EntryType::File;
+				break;
+		}
+#endif
+
+		cb( dirp->d_name, type );
+	}
+
+	closedir( dp );
+#endif
+	return true;
+}
+
 Uint64 FileSystem::fileSize( const std::string& Filepath ) {
 #if EE_PLATFORM == EE_PLATFORM_WIN
 	struct _stat st;
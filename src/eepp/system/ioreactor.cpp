@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <condition_variable>
+#include <eepp/system/ioreactor.hpp>
+#include <eepp/system/log.hpp>
+#include <eepp/system/sys.hpp>
+
+#if EE_PLATFORM == EE_PLATFORM_LINUX || EE_PLATFORM == EE_PLATFORM_ANDROID
+#define EE_IO_REACTOR_EPOLL
+#include <sys/epoll.h>
+#elif EE_PLATFORM == EE_PLATFORM_MACOS || EE_PLATFORM == EE_PLATFORM_IOS || \
+	EE_PLATFORM == EE_PLATFORM_BSD
+#define EE_IO_REACTOR_KQUEUE
+#include <sys/event.h>
+#include <sys/types.h>
+#endif
+
+#if defined( EE_IO_REACTOR_EPOLL ) || defined( EE_IO_REACTOR_KQUEUE )
+#define EE_IO_REACTOR
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace EE { namespace System {
+
+SINGLETON_DECLARE_IMPLEMENTATION( IOReactor )
+
+#ifdef EE_IO_REACTOR
+// Maximum number of events retrieved by a single wait, the rest are retrieved by the next one
+static constexpr int MAX_EVENTS = 256;
+#endif
+
+struct IOReactor::Watch {
+	Uint64 id{ 0 };
+	std::vector<int> fds;
+	ReadyFn onReady;
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::thread::id runner;		///< Thread running the callback
+	std::vector<int> pending;	///< Descriptors that got ready while the callback was running
+	bool running{ false };
+	bool removed{ false };
+};
+
+bool IOReactor::isSupported() {
+#ifdef EE_IO_REACTOR
+	return true;
+#else
+	return false;
+#endif
+}
+
+IOReactor::IOReactor() {}
+
+IOReactor::~IOReactor() {
+	mShuttingDown = true;
+
+#ifdef EE_IO_REACTOR
+	if ( mStarted ) {
+		char byte = 0;
+		while ( ::write( mWakeUp[1], &byte, 1 ) < 0 && errno == EINTR )
+			;
+	}
+#endif
+
+	if ( mThread.joinable() )
+		mThread.join();
+
+	std::vector<Uint64> ids;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		for ( const auto& watch : mWatches )
+			ids.push_back( watch.first );
+	}
+
+	for ( const auto& id : ids )
+		remove( id );
+
+#ifdef EE_IO_REACTOR
+	if ( mQueue != -1 )
+		::close( mQueue );
+	if ( mWakeUp[0] != -1 )
+		::close( mWakeUp[0] );
+	if ( mWakeUp[1] != -1 )
+		::close( mWakeUp[1] );
+#endif
+}
+
+bool IOReactor::start() {
+	if ( mStarted )
+		return true;
+
+#ifdef EE_IO_REACTOR
+	if ( mQueue == -1 ) {
+#if defined( EE_IO_REACTOR_EPOLL )
+		mQueue = epoll_create1( EPOLL_CLOEXEC );
+#else
+		mQueue = kqueue();
+		if ( mQueue != -1 )
+			fcntl( mQueue, F_SETFD, FD_CLOEXEC );
+#endif
+		if ( mQueue == -1 ) {
+			Log::error( "IOReactor: couldn't create the event queue, errno: %d", errno );
+			return false;
+		}
+	}
+
+	if ( mWakeUp[0] == -1 ) {
+		if ( pipe( mWakeUp ) != 0 ) {
+			Log::error( "IOReactor: couldn't create the wake up pipe, errno: %d", errno );
+			mWakeUp[0] = mWakeUp[1] = -1;
+			return false;
+		}
+		for ( const auto& fd : mWakeUp ) {
+			fcntl( fd, F_SETFD, FD_CLOEXEC );
+			fcntl( fd, F_SETFL, fcntl( fd, F_GETFL ) | O_NONBLOCK );
+		}
+		if ( !watchFd( mWakeUp[0] ) ) {
+			Log::error( "IOReactor: couldn't watch the wake up pipe, errno: %d", errno );
+			return false;
+		}
+	}
+
+	mThread = std::thread( [this] { run(); } );
+	mStarted = true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void IOReactor::run() {
+#if defined( EE_IO_REACTOR_EPOLL )
+	std::vector<epoll_event> events( MAX_EVENTS );
+#elif defined( EE_IO_REACTOR_KQUEUE )
+	std::vector<struct kevent> events( MAX_EVENTS );
+#endif
+
+#ifdef EE_IO_REACTOR
+	std::vector<std::pair<std::shared_ptr<Watch>, int>> ready;
+
+	while ( !mShuttingDown ) {
+#if defined( EE_IO_REACTOR_EPOLL )
+		int count = epoll_wait( mQueue, events.data(), MAX_EVENTS, -1 );
+#else
+		int count = kevent( mQueue, nullptr, 0, events.data(), MAX_EVENTS, nullptr );
+#endif
+		if ( count < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			Log::error( "IOReactor: wait failed, errno: %d", errno );
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock( mMutex );
+			for ( int i = 0; i < count; i++ ) {
+#if defined( EE_IO_REACTOR_EPOLL )
+				int fd = events[i].data.fd;
+#else
+				int fd = static_cast<int>( events[i].ident );
+#endif
+				if ( fd == mWakeUp[0] )
+					continue;
+				// The descriptor might have been removed after the event was retrieved
+				auto it = mFds.find( fd );
+				if ( it != mFds.end() )
+					ready.emplace_back( it->second, fd );
+			}
+		}
+
+		for ( const auto& watch : ready )
+			dispatch( watch.first, watch.second );
+		ready.clear();
+	}
+#endif
+}
+
+void IOReactor::dispatch( const std::shared_ptr<Watch>& watch, int fd ) {
+	{
+		std::lock_guard<std::mutex> lock( watch->mutex );
+		if ( watch->removed )
+			return;
+		if ( watch->running ) {
+			// Serialized with the running callback, that will process it when it returns
+			watch->pending.push_back( fd );
+			return;
+		}
+		watch->running = true;
+	}
+
+	getThreadPool()->run( [this, watch, fd] { process( watch, fd ); } );
+}
+
+void IOReactor::process( std::shared_ptr<Watch> watch, int fd ) {
+	std::unique_lock<std::mutex> lock( watch->mutex );
+	watch->runner = std::this_thread::get_id();
+
+	while ( !watch->removed ) {
+		lock.unlock();
+		bool keep = watch->onReady( fd );
+		lock.lock();
+
+		if ( watch->removed )
+			break;
+
+		if ( keep ) {
+			rearmFd( fd );
+		} else {
+			watch->fds.erase( std::remove( watch->fds.begin(), watch->fds.end(), fd ),
+							  watch->fds.end() );
+			lock.unlock();
+			unwatchFds( watch, { fd } );
+			lock.lock();
+		}
+
+		if ( watch->pending.empty() )
+			break;
+
+		fd = watch->pending.front();
+		watch->pending.erase( watch->pending.begin() );
+	}
+
+	watch->pending.clear();
+	watch->runner = std::thread::id();
+	watch->running = false;
+	watch->finished.notify_all();
+}
+
+bool IOReactor::watchFd( int fd ) {
+#if defined( EE_IO_REACTOR_EPOLL )
+	epoll_event event{};
+	// One shot, so the descriptor isn't reported again until its callback rearms it
+	event.events = EPOLLIN | EPOLLRDHUP | ( fd != mWakeUp[0] ? EPOLLONESHOT : 0 );
+	event.data.fd = fd;
+	return epoll_ctl( mQueue, EPOLL_CTL_ADD, fd, &event ) == 0;
+#elif defined( EE_IO_REACTOR_KQUEUE )
+	struct kevent event;
+	EV_SET( &event, fd, EVFILT_READ, EV_ADD | ( fd != mWakeUp[0] ? EV_DISPATCH : 0 ), 0, 0,
+			nullptr );
+	return kevent( mQueue, &event, 1, nullptr, 0, nullptr ) == 0;
+#else
+	return false;
+#endif
+}
+
+void IOReactor::rearmFd( int fd ) {
+	// Fails when the descriptor was removed meanwhile, which is fine
+#if defined( EE_IO_REACTOR_EPOLL )
+	epoll_event event{};
+	event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	event.data.fd = fd;
+	epoll_ctl( mQueue, EPOLL_CTL_MOD, fd, &event );
+#elif defined( EE_IO_REACTOR_KQUEUE )
+	struct kevent event;
+	EV_SET( &event, fd, EVFILT_READ, EV_ENABLE | EV_DISPATCH, 0, 0, nullptr );
+	kevent( mQueue, &event, 1, nullptr, 0, nullptr );
+#else
+	(void)fd;
+#endif
+}
+
+void IOReactor::unwatchFd( int fd ) {
+	// The descriptor might be already closed, and then removed by the kernel from the queue, so
+	// the errors are ignored
+#if defined( EE_IO_REACTOR_EPOLL )
+	epoll_event event{};
+	epoll_ctl( mQueue, EPOLL_CTL_DEL, fd, &event );
+#elif defined( EE_IO_REACTOR_KQUEUE )
+	struct kevent event;
+	EV_SET( &event, fd, EVFILT_READ, EV_DELETE, 0, 0, nullptr );
+	kevent( mQueue, &event, 1, nullptr, 0, nullptr );
+#else
+	(void)fd;
+#endif
+}
+
+void IOReactor::unwatchFds( const std::shared_ptr<Watch>& watch, const std::vector<int>& fds ) {
+	std::lock_guard<std::mutex> lock( mMutex );
+	for ( const auto& fd : fds ) {
+		auto it = mFds.find( fd );
+		if ( it != mFds.end() && it->second == watch ) {
+			mFds.erase( it );
+			unwatchFd( fd );
+		}
+	}
+}
+
+Uint64 IOReactor::add( const std::vector<int>& fds, const ReadyFn& onReady ) {
+	if ( !isSupported() || !mEnabled || mShuttingDown || fds.empty() || !onReady )
+		return 0;
+
+	std::lock_guard<std::mutex> lock( mMutex );
+
+	if ( !start() )
+		return 0;
+
+	auto watch = std::make_shared<Watch>();
+	watch->id = ++mLastId;
+	watch->onReady = onReady;
+
+	for ( const auto& fd : fds ) {
+		// The descriptor might belong to a closed stream that wasn't removed, that the kernel
+		// already dropped from the queue, so it's registered again
+		if ( mFds.erase( fd ) )
+			unwatchFd( fd );
+
+		mFds[fd] = watch;
+		watch->fds.push_back( fd );
+
+		if ( !watchFd( fd ) ) {
+			Log::error( "IOReactor: couldn't watch the descriptor %d, errno: %d", fd, errno );
+			for ( const auto& added : watch->fds ) {
+				mFds.erase( added );
+				unwatchFd( added );
+			}
+			return 0;
+		}
+	}
+
+	mWatches[watch->id] = watch;
+	return watch->id;
+}
+
+void IOReactor::remove( const Uint64& id ) {
+	std::shared_ptr<Watch> watch;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		auto it = mWatches.find( id );
+		if ( it == mWatches.end() )
+			return;
+		watch = it->second;
+		mWatches.erase( it );
+	}
+
+	std::unique_lock<std::mutex> lock( watch->mutex );
+	watch->removed = true;
+	std::vector<int> fds( std::move( watch->fds ) );
+	lock.unlock();
+
+	unwatchFds( watch, fds );
+
+	lock.lock();
+	// Removed from its own callback, it can't wait for itself
+	if ( watch->runner == std::this_thread::get_id() )
+		return;
+	watch->finished.wait( lock, [&watch] { return !watch->running; } );
+}
+
+void IOReactor::setThreadPool( const std::shared_ptr<ThreadPool>& pool ) {
+	std::lock_guard<std::mutex> lock( mMutex );
+	mPool = pool;
+}
+
+const std::shared_ptr<ThreadPool>& IOReactor::getThreadPool() {
+	std::lock_guard<std::mutex> lock( mMutex );
+	if ( !mPool ) {
+		// The callbacks are usually short, a few threads serve many idle streams
+		mPool = ThreadPool::createShared(
+			static_cast<Uint32>( eeclamp( Sys::getCPUCount(), 2, 4 ) ) );
+	}
+	return mPool;
+}
+
+bool IOReactor::isEnabled() const {
+	return mEnabled;
+}
+
+void IOReactor::setEnabled( bool enabled ) {
+	mEnabled = enabled;
+}
+
+size_t IOReactor::getWatchCount() const {
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mWatches.size();
+}
+
+}} // namespace EE::System
@@ -4,6 +4,7 @@
 #include <eepp/core/string.hpp>
 #include <eepp/system/clock.hpp>
 #include <eepp/system/filesystem.hpp>
+#include <eepp/system/ioreactor.hpp>
 #include <eepp/system/lock.hpp>
 #include <eepp/system/process.hpp>
 #include <eepp/system/sys.hpp>
@@ -96,6 +97,7 @@ Process::Process( const std::string& command, const std::vector<std::string>& ar
 
 Process::~Process() {
 	mShuttingDown = true;
+	stopReactorRead();
 	if ( mProcess ) {
 		if ( isAlive() ) {
 			kill();
@@ -262,6 +264,8 @@ bool Process::kill() {
 
 bool Process::destroy() {
 	eeASSERT( mProcess != nullptr );
+	// The streams are closed, they must not be watched anymore
+	stopReactorRead();
 	return 0 == subprocess_destroy( PROCESS_PTR );
 }
 
@@ -404,6 +408,9 @@ void Process::startAsyncRead( ReadFn readStdOut, ReadFn readStdErr ) {
 		} );
 	}
 #elif defined( EE_PLATFORM_POSIX )
+	if ( startReactorRead() )
+		return;
+
 	mStdOutThread = std::thread( [this] {
 		auto stdOutFd = fileno( PROCESS_PTR->stdout_file );
 		auto stdErrFd = PROCESS_PTR->stderr_file ? fileno( PROCESS_PTR->stderr_file ) : 0;
@@ -462,4 +469,58 @@ void Process::startAsyncRead( ReadFn readStdOut, ReadFn readStdErr ) {
 #endif
 }
 
+bool Process::startReactorRead() {
+#if defined( EE_PLATFORM_POSIX )
+	if ( !IOReactor::isSupported() || !IOReactor::instance()->isEnabled() )
+		return false;
+
+	FILE* stdOutFile = PROCESS_PTR->stdout_file;
+	FILE* stdErrFile = PROCESS_PTR->stderr_file;
+	int stdOutFd = stdOutFile ? fileno( stdOutFile ) : -1;
+	std::vector<int> fds;
+	for ( FILE* file : { stdOutFile, stdErrFile } ) {
+		if ( file == nullptr || ( file == stdErrFile && stdErrFile == stdOutFile ) )
+			continue;
+		int fd = fileno( file );
+		if ( fcntl( fd, F_SETFL, fcntl( fd, F_GETFL ) | O_NONBLOCK ) == 0 )
+			fds.push_back( fd );
+	}
+
+	std::string buffer( mBufferSize, '\0' );
+	auto onReady = [this, stdOutFd, buffer]( int fd ) mutable -> bool {
+		// A few reads at most, so a busy stream doesn't hold the pool thread, the reactor reports
+		// it again if there's more data
+		for ( int i = 0; i < 16 && !mShuttingDown; i++ ) {
+			const ssize_t n = read( fd, &buffer[0], mBufferSize );
+			if ( n > 0 ) {
+				if ( n < static_cast<long>( mBufferSize - 1 ) )
+					buffer[n] = '\0';
+				const ReadFn& readFn = fd == stdOutFd ? mReadStdOutFn : mReadStdErrFn;
+				if ( readFn && !mShuttingDown )
+					readFn( buffer.c_str(), static_cast<size_t>( n ) );
+			} else if ( n < 0 && errno == EINTR ) {
+				continue;
+			} else {
+				// The end of file and the read errors stop watching the stream
+				return n < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK );
+			}
+		}
+		return !mShuttingDown;
+	};
+
+	mAsyncReadId = IOReactor::instance()->add( fds, onReady );
+	return mAsyncReadId != 0;
+#else
+	return false;
+#endif
+}
+
+void Process::stopReactorRead() {
+	if ( mAsyncReadId == 0 )
+		return;
+	if ( IOReactor::existsSingleton() )
+		IOReactor::instance()->remove( mAsyncReadId );
+	mAsyncReadId = 0;
+}
+
 }} // namespace EE::System
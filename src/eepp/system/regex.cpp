@@ -35,6 +35,11 @@ RegEx::RegEx( const std::string_view& pattern, Options options, bool useCache )
 	PCRE2_SIZE erroroffset;
 	PCRE2_SPTR pattern_sptr = reinterpret_cast<PCRE2_SPTR>( pattern.data() );
 
+	// Skips the validation of the subject, that otherwise is done in every match from the start
+	// offset to the end of the subject
+	if ( options & Options::NoUtfCheck )
+		mMatchOptions = PCRE2_NO_UTF_CHECK;
+
 	if ( useCache && RegExCache::instance()->isEnabled() &&
 		 ( mCompiledPattern = RegExCache::instance()->find( pattern, options ) ) ) {
 		mValid = true;
@@ -92,7 +97,7 @@ bool RegEx::matches( const char* stringSearch, int stringStartOffset,
 						  subject,			 // the subject string
 						  stringLength,		 // the length of the subject
 						  stringStartOffset, // start at offset in the subject
-						  0,				 // default options
+						  mMatchOptions,	 // match options
 						  match_data,		 // match data
 						  NULL				 // match context
 	);
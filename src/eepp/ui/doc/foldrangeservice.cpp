@@ -3,6 +3,7 @@
 #include <eepp/ui/doc/foldrangeservice.hpp>
 #include <eepp/ui/doc/textdocument.hpp>
 
+#include <algorithm>
 #include <stack>
 
 namespace EE { namespace UI { namespace Doc {
@@ -101,6 +102,185 @@ static std::vector<TextRange> findFoldingRangesIndentation( TextDocument* doc )
 
 FoldRangeServive::FoldRangeServive( TextDocument* doc ) : mDoc( doc ) {}
 
+std::vector<TextRange> FoldRangeServive::computeRegions( bool incremental ) {
+	auto type = mDoc->getSyntaxDefinition().getFoldRangeType();
+	if ( type != FoldRangeType::Braces && type != FoldRangeType::Indentation )
+		return {};
+
+	if ( !incremental ) {
+		return type == FoldRangeType::Braces ? findFoldingRangesBraces( mDoc )
+											 : findFoldingRangesIndentation( mDoc );
+	}
+
+	Clock c;
+	Lock l( mSummariesMutex );
+	updateLineSummaries( type );
+	auto regions = type == FoldRangeType::Braces ? foldingRangesFromBraces()
+												 : foldingRangesFromIndentation();
+	Log::debug( "FoldRangeServive::computeRegions for \"%s\" took %s", mDoc->getFilePath(),
+				c.getElapsedTime().toString() );
+	return regions;
+}
+
+void FoldRangeServive::moveLineSummaries( Int64 fromLine, Int64 numLines ) {
+	Lock l( mSummariesMutex );
+	Int64 at = fromLine + 1;
+	if ( numLines == 0 || at < 0 || at > static_cast<Int64>( mLineSummaries.size() ) )
+		return;
+	if ( numLines > 0 ) {
+		mLineSummaries.insert( mLineSummaries.begin() + at, numLines, LineSummary{} );
+	} else {
+		Int64 end = eemin<Int64>( at - numLines, mLineSummaries.size() );
+		mLineSummaries.erase( mLineSummaries.begin() + at, mLineSummaries.begin() + end );
+	}
+}
+
+void FoldRangeServive::updateLineSummaries( FoldRangeType type ) {
+	const auto& def = mDoc->getSyntaxDefinition();
+	auto braces = def.getFoldBraces();
+	bool tokenized = type == FoldRangeType::Braces && !def.getPatterns().empty();
+	if ( type != mSummariesType || tokenized != mSummariesTokenized ||
+		 braces != mSummariesBraces ) {
+		mLineSummaries.clear();
+		mSummariesType = type;
+		mSummariesTokenized = tokenized;
+		mSummariesBraces = std::move( braces );
+	}
+
+	mLineSummaries.resize( mDoc->linesCount() );
+
+	auto highlighter = mDoc->getHighlighter();
+	for ( size_t lineIdx = 0; lineIdx < mLineSummaries.size(); lineIdx++ ) {
+		auto& summary = mLineSummaries[lineIdx];
+		if ( summary.valid && summary.hash == mDoc->line( lineIdx ).getHash() &&
+			 ( !summary.tokenized ||
+			   highlighter->getTokenizedLineSignature( lineIdx ) == summary.tokensSignature ) )
+			continue;
+		updateLineSummary( lineIdx, summary, type );
+	}
+}
+
+void FoldRangeServive::updateLineSummary( Int64 lineIdx, LineSummary& summary,
+										  FoldRangeType type ) {
+	const auto& line = mDoc->line( lineIdx );
+	const auto& text = line.getText();
+	summary.hash = line.getHash();
+	summary.indent = countLeadingSpaces( text );
+	summary.tokensSignature = 0;
+	summary.tokenized = false;
+	summary.valid = true;
+	summary.braces.clear();
+
+	if ( type != FoldRangeType::Braces )
+		return;
+
+	size_t lineLength = text.length();
+	for ( size_t colIdx = 0; colIdx < lineLength; colIdx++ ) {
+		String::StringBaseType curChar = text[colIdx];
+		for ( const auto& bracePair : mSummariesBraces ) {
+			if ( curChar == bracePair.first ) {
+				summary.braces.push_back( { static_cast<Int64>( colIdx ), true } );
+			} else if ( curChar == bracePair.second ) {
+				summary.braces.push_back( { static_cast<Int64>( colIdx ), false } );
+			}
+		}
+	}
+
+	if ( summary.braces.empty() || !mSummariesTokenized )
+		return;
+
+	// Drop the braces inside strings and comments walking the line tokens only once
+	auto highlighter = mDoc->getHighlighter();
+	auto tokens = highlighter->getLine( lineIdx );
+	summary.tokensSignature = highlighter->getTokenizedLineSignature( lineIdx );
+	summary.tokenized = true;
+
+	size_t tokenIdx = 0;
+	Int64 tokenEnd = tokens.empty() ? 0 : tokens[0].len;
+	auto it = std::remove_if(
+		summary.braces.begin(), summary.braces.end(), [&]( const BraceEvent& brace ) {
+			while ( tokenIdx < tokens.size() && tokenEnd <= brace.column ) {
+				if ( ++tokenIdx < tokens.size() )
+					tokenEnd += tokens[tokenIdx].len;
+			}
+			if ( tokenIdx >= tokens.size() )
+				return false;
+			auto tokenType = tokens[tokenIdx].type;
+			return tokenType == SyntaxStyleTypes::String || tokenType == SyntaxStyleTypes::Comment;
+		} );
+	summary.braces.erase( it, summary.braces.end() );
+}
+
+std::vector<TextRange> FoldRangeServive::foldingRangesFromBraces() const {
+	std::vector<TextRange> regions;
+	if ( mLineSummaries.size() <= 2 )
+		return regions;
+	std::vector<TextPosition> braceStack;
+	for ( size_t lineIdx = 0; lineIdx < mLineSummaries.size(); lineIdx++ ) {
+		for ( const auto& brace : mLineSummaries[lineIdx].braces ) {
+			if ( brace.open ) {
+				braceStack.emplace_back( lineIdx, brace.column );
+			} else if ( !braceStack.empty() ) {
+				auto start = braceStack.back();
+				braceStack.pop_back();
+				if ( start.line() != static_cast<Int64>( lineIdx ) )
+					regions.emplace_back( start, TextPosition( lineIdx, brace.column ) );
+			}
+		}
+	}
+	return regions;
+}
+
+std::vector<TextRange> FoldRangeServive::foldingRangesFromIndentation() const {
+	std::vector<TextRange> regions;
+	if ( mLineSummaries.size() <= 2 )
+		return regions;
+	std::vector<TextPosition> indentStack;
+	int currentIndent = 0;
+
+	for ( size_t lineIdx = 0; lineIdx < mLineSummaries.size(); lineIdx++ ) {
+		int newIndent = mLineSummaries[lineIdx].indent;
+		if ( newIndent > currentIndent ) {
+			indentStack.push_back( { static_cast<Int64>( lineIdx - 1 ), 0 } );
+		} else if ( newIndent < currentIndent && !indentStack.empty() ) {
+			while ( !indentStack.empty() && indentStack.back().column() >= newIndent ) {
+				auto top = indentStack.back();
+				indentStack.pop_back();
+				regions.emplace_back( TextPosition( top.line(), 0 ),
+									  TextPosition( static_cast<Int64>( lineIdx ) - 1, 0 ) );
+			}
+		}
+		currentIndent = newIndent;
+	}
+
+	while ( !indentStack.empty() ) {
+		auto top = indentStack.back();
+		indentStack.pop_back();
+		regions.emplace_back(
+			TextPosition( top.line() + 1, 0 ),
+			TextPosition( static_cast<Int64>( mLineSummaries.size() ) - 1, 0 ) );
+	}
+
+	return regions;
+}
+
+bool FoldRangeServive::hasFoldingRegions( std::vector<TextRange>& regions ) {
+	// Compares against the map setFoldingRegions would build: the last region wins on each line
+	std::sort( regions.begin(), regions.end() );
+	Lock l( mMutex );
+	size_t count = 0;
+	for ( size_t i = 0; i < regions.size(); i++ ) {
+		const auto& region = regions[i];
+		if ( i + 1 < regions.size() && regions[i + 1].start().line() == region.start().line() )
+			continue;
+		auto found = mFoldingRegions.find( region.start().line() );
+		if ( found == mFoldingRegions.end() || !( found->second == region ) )
+			return false;
+		count++;
+	}
+	return count == mFoldingRegions.size();
+}
+
 bool FoldRangeServive::canFold() const {
 	if ( !mEnabled )
 		return false;
@@ -121,10 +301,13 @@ void FoldRangeServive::findRegions() {
 
 	switch ( mDoc->getSyntaxDefinition().getFoldRangeType() ) {
 		case FoldRangeType::Braces:
-			setFoldingRegions( findFoldingRangesBraces( mDoc ) );
+		case FoldRangeType::Indentation: {
+			// Only notify the clients when the regions actually changed
+			auto regions = computeRegions();
+			if ( !hasFoldingRegions( regions ) )
+				setFoldingRegions( std::move( regions ) );
 			break;
-		case FoldRangeType::Indentation:
-			setFoldingRegions( findFoldingRangesIndentation( mDoc ) );
+		}
 		case FoldRangeType::Tag:
 		case FoldRangeType::Undefined:
 			break;
@@ -171,9 +354,11 @@ bool FoldRangeServive::isFoldingRegionInLine( Int64 docIdx ) {
 }
 
 void FoldRangeServive::shiftFoldingRegions( Int64 fromLine, Int64 numLines ) {
-	// TODO: Optimize this
+	if ( numLines == 0 )
+		return;
 	Lock l( mMutex );
 	std::unordered_map<Int64, TextRange> foldingRegions;
+	foldingRegions.reserve( mFoldingRegions.size() );
 	for ( auto& foldingRegion : mFoldingRegions ) {
 		if ( foldingRegion.second.start().line() > fromLine ) {
 			foldingRegion.second.start().setLine( foldingRegion.second.start().line() + numLines );
@@ -182,7 +367,7 @@ void FoldRangeServive::shiftFoldingRegions( Int64 fromLine, Int64 numLines ) {
 		}
 		foldingRegions[foldingRegion.second.start().line()] = foldingRegion.second;
 	}
-	mFoldingRegions = foldingRegions;
+	mFoldingRegions = std::move( foldingRegions );
 }
 
 void FoldRangeServive::setFoldingRegions( std::vector<TextRange> regions ) {
@@ -1157,9 +1157,17 @@ TextPosition TextDocument::insert( const size_t& cursorIdx, TextPosition positio
 	mLines[position.line()] = TextDocumentLine( lines[0] );
 	notifyLineChanged( position.line() );
 
-	for ( Int64 i = 1; i < (Int64)lines.size(); i++ ) {
-		mLines.insert( mLines.begin() + position.line() + i, TextDocumentLine( lines[i] ) );
-		notifyLineChanged( position.line() + i );
+	if ( lines.size() > 1 ) {
+		// Insert all the new lines at once, a vector insert per line is quadratic on large pastes
+		std::vector<TextDocumentLine> newLines;
+		newLines.reserve( lines.size() - 1 );
+		for ( size_t i = 1; i < lines.size(); i++ )
+			newLines.emplace_back( std::move( lines[i] ) );
+		mLines.insert( mLines.begin() + position.line() + 1,
+					   std::make_move_iterator( newLines.begin() ),
+					   std::make_move_iterator( newLines.end() ) );
+		for ( Int64 i = 1; i < (Int64)lines.size(); i++ )
+			notifyLineChanged( position.line() + i );
 	}
 
 	TextPosition cursor = positionOffset( position, text.size() );
@@ -1169,6 +1177,7 @@ TextPosition TextDocument::insert( const size_t& cursorIdx, TextPosition positio
 
 	if ( linesAdd > 0 ) {
 		mHighlighter->moveHighlight( position.line(), position.line(), linesAdd );
+		mFoldRangeService.moveLineSummaries( position.line(), linesAdd );
 		notifiyDocumenLineMove( position.line(), position.line(), linesAdd );
 	}
 
@@ -1359,6 +1368,7 @@ size_t TextDocument::remove( const size_t& cursorIdx, TextRange range,
 		mHighlighter->moveHighlight( deletedAcrossNewLine ? range.start().line()
 														  : range.end().line(),
 									 range.end().line(), -linesRemoved );
+		mFoldRangeService.moveLineSummaries( originalRange.start().line(), -linesRemoved );
 		notifiyDocumenLineMove( originalRange.start().line(), originalRange.end().line(),
 								-linesRemoved );
 	}
@@ -2496,269 +2506,218 @@ bool TextDocument::removeCommand( const std::string& command ) {
 
 static constexpr auto MAX_CAPTURES = 12;
 
-struct FindTypeResult {
-	size_t start{ String::StringType::npos };
-	size_t end{ String::StringType::npos };
-	std::vector<PatternMatcher::Range> captures{};
-};
+struct TextDocument::SearchBuffer {
+	std::string text;
+	// Offset of the start of each line, followed by the buffer size
+	std::vector<size_t> lineOffsets;
+	std::vector<String::HashType> lineHashes;
 
-static FindTypeResult findType( const String& str, const String& findStr,
-								const TextDocument::FindReplaceType& type, int colOffset,
-								bool caseSensitive ) {
-	switch ( type ) {
-		case TextDocument::FindReplaceType::RegEx: {
-			RegEx words( findStr.toUtf8(),
-						 static_cast<RegEx::Options>( RegEx::Options::Utf |
-													  ( !caseSensitive ? RegEx::Options::Caseless
-																	   : RegEx::Options::None ) ) );
-			if ( !words.isValid() )
-				return { String::StringType::npos, String::StringType::npos };
-			RegEx::Range matches[MAX_CAPTURES];
-			if ( words.matches( str, matches ) ) {
-				FindTypeResult result{ static_cast<size_t>( matches[0].start ),
-									   static_cast<size_t>( matches[0].end ) };
-				if ( words.getNumMatches() > 1 ) {
-					std::vector<TextPosition> captures;
-					captures.reserve( words.getNumMatches() - 1 );
-					for ( size_t i = 1; i < words.getNumMatches(); i++ ) {
-						result.captures.emplace_back( PatternMatcher::Range{
-							colOffset + matches[i].start, colOffset + matches[i].end } );
-					}
-				}
-				return result;
-			} else {
-				return { String::StringType::npos, String::StringType::npos };
-			}
-		}
-		case TextDocument::FindReplaceType::LuaPattern: {
-			LuaPatternStorage words( findStr.toUtf8() );
-			PatternMatcher::Range matches[MAX_CAPTURES];
-			if ( words.matches( str, matches ) ) {
-				FindTypeResult result{ static_cast<size_t>( matches[0].start ),
-									   static_cast<size_t>( matches[0].end ) };
-				if ( words.getNumMatches() > 1 ) {
-					std::vector<TextPosition> captures;
-					captures.reserve( words.getNumMatches() - 1 );
-					for ( size_t i = 1; i < words.getNumMatches(); i++ ) {
-						result.captures.emplace_back( PatternMatcher::Range{
-							colOffset + matches[i].start, colOffset + matches[i].end } );
-					}
-				}
-				return result;
-			} else {
-				return { String::StringType::npos, String::StringType::npos };
-			}
-		}
-		case TextDocument::FindReplaceType::Normal:
-		default: {
-			size_t res = str.find( findStr );
-			return { res, String::InvalidPos == res ? res : res + findStr.size() };
+	bool isValid( const std::vector<TextDocumentLine>& lines ) const {
+		if ( lines.size() != lineHashes.size() )
+			return false;
+		for ( size_t i = 0; i < lines.size(); i++ ) {
+			if ( lines[i].getHash() != lineHashes[i] )
+				return false;
 		}
+		return true;
+	}
+
+	Int64 lineAt( size_t offset ) const {
+		auto it = std::upper_bound( lineOffsets.begin(), lineOffsets.end() - 1, offset );
+		return static_cast<Int64>( it - lineOffsets.begin() ) - 1;
+	}
+
+	TextPosition toPosition( size_t offset ) const {
+		Int64 line = lineAt( offset );
+		size_t lineEnd = lineOffsets[line + 1];
+		// Past the last new line: the end of the document
+		bool endOfDoc = offset >= text.size();
+		if ( endOfDoc )
+			offset = lineEnd;
+		Int64 column = 0;
+		for ( size_t i = lineOffsets[line]; i < offset; i++ )
+			column += ( text[i] & 0xC0 ) != 0x80;
+		return { line, endOfDoc ? eemax<Int64>( 0, column - 1 ) : column };
+	}
+
+	size_t toOffset( const TextPosition& position ) const {
+		Int64 line = eeclamp<Int64>( position.line(), 0, lineHashes.size() - 1 );
+		size_t offset = lineOffsets[line];
+		size_t lineEnd = lineOffsets[line + 1];
+		for ( Int64 column = 0; column < position.column() && offset < lineEnd; column++ )
+			offset = nextChar( offset );
+		return offset;
+	}
+
+	size_t nextChar( size_t offset ) const {
+		offset++;
+		while ( offset < text.size() && ( text[offset] & 0xC0 ) == 0x80 )
+			offset++;
+		return offset;
 	}
-}
 
-static FindTypeResult findLastType( const String& str, const String& findStr,
-									const TextDocument::FindReplaceType& type,
-									bool caseSensitive ) {
+	String::StringBaseType charAt( size_t offset ) const {
+		Uint32 codepoint = 0;
+		Utf8::decode( text.begin() + offset, text.end(), codepoint );
+		return codepoint;
+	}
+
+	String::StringBaseType charBefore( size_t offset ) const {
+		do {
+			offset--;
+		} while ( offset > 0 && ( text[offset] & 0xC0 ) == 0x80 );
+		return charAt( offset );
+	}
+
+	bool isWholeWord( size_t start, size_t end ) const {
+		return ( start == 0 || !String::isAlphaNum( charBefore( start ) ) ) &&
+			   ( end >= text.size() || !String::isAlphaNum( charAt( end ) ) );
+	}
+
+	TextRange toRange( size_t start, size_t end ) const {
+		return { toPosition( start ), toPosition( end ) };
+	}
+};
+
+std::shared_ptr<const TextDocument::SearchBuffer>
+TextDocument::getSearchBuffer( bool lowercase ) {
+	Lock l( mSearchBufferMutex );
+	auto& buffer = lowercase ? mSearchBufferLowercase : mSearchBuffer;
+	if ( buffer && buffer->isValid( mLines ) )
+		return buffer;
+
+	auto newBuffer = std::make_shared<SearchBuffer>();
+	newBuffer->lineOffsets.reserve( mLines.size() + 1 );
+	newBuffer->lineHashes.reserve( mLines.size() );
+	for ( const auto& line : mLines ) {
+		newBuffer->lineOffsets.push_back( newBuffer->text.size() );
+		newBuffer->lineHashes.push_back( line.getHash() );
+		newBuffer->text +=
+			lowercase ? String::toLower( line.getText() ).toUtf8() : line.toUtf8();
+	}
+	newBuffer->lineOffsets.push_back( newBuffer->text.size() );
+	buffer = newBuffer;
+	return buffer;
+}
+
+void TextDocument::search( const String& text, const TextPosition& from, const TextPosition& to,
+						   bool caseSensitive, bool wholeWord, FindReplaceType type,
+						   const bool* stopFlag,
+						   const std::function<bool( SearchResult&& )>& onMatch ) {
+	// Case insensitive patterns are managed at the pattern level
+	bool lowercase = !caseSensitive && type == FindReplaceType::Normal;
+	auto buffer = getSearchBuffer( lowercase );
+	const std::string& str = buffer->text;
+	size_t start = buffer->toOffset( from );
+	size_t end = to == endOfDoc() ? str.size() : buffer->toOffset( to );
+	if ( start >= end )
+		return;
+
 	switch ( type ) {
-		case TextDocument::FindReplaceType::RegEx: {
-			// TODO: Implement findLastType for Lua patterns
-			RegEx words( findStr.toUtf8(),
-						 static_cast<RegEx::Options>( RegEx::Options::Utf |
-													  ( !caseSensitive ? RegEx::Options::Caseless
-																	   : RegEx::Options::None ) ) );
-			if ( !words.isValid() )
-				return { String::StringType::npos, String::StringType::npos };
-			RegEx::Range matches[MAX_CAPTURES];
-			if ( words.matches( str, matches ) ) {
-				FindTypeResult result{ static_cast<size_t>( matches[0].start ),
-									   static_cast<size_t>( matches[0].end ) };
-				if ( words.getNumMatches() > 1 ) {
-					std::vector<TextPosition> captures;
-					captures.reserve( words.getNumMatches() - 1 );
-					for ( size_t i = 1; i < words.getNumMatches(); i++ ) {
-						result.captures.emplace_back(
-							PatternMatcher::Range{ matches[i].start, matches[i].end } );
-					}
+		case FindReplaceType::RegEx: {
+			// The buffer is always valid UTF-8, it's not validated again on each match
+			std::string pattern( text.toUtf8() );
+			RegEx regex( pattern, static_cast<RegEx::Options>(
+									  RegEx::Options::Utf | RegEx::Options::Multiline |
+									  RegEx::Options::NoUtfCheck |
+									  ( !caseSensitive ? RegEx::Options::Caseless
+													   : RegEx::Options::None ) ) );
+			if ( !regex.isValid() )
+				return;
+			PatternMatcher::Range matches[MAX_CAPTURES];
+			size_t pos = start;
+			while ( pos < end && !( stopFlag && *stopFlag ) ) {
+				matches[0].start = matches[0].end = 0;
+				bool found = regex.matches( str.c_str(), pos, matches, end );
+				if ( matches[0].start < 0 ) {
+					// An empty match, continue from the next line
+					pos = buffer->lineOffsets[buffer->lineAt( pos ) + 1];
+					continue;
 				}
-				return result;
-			} else {
-				return { String::StringType::npos, String::StringType::npos };
+				if ( !found )
+					break;
+				size_t matchStart = matches[0].start;
+				size_t matchEnd = matches[0].end;
+				if ( wholeWord && !buffer->isWholeWord( matchStart, matchEnd ) ) {
+					pos = buffer->nextChar( matchStart );
+					continue;
+				}
+				SearchResult result;
+				result.result = buffer->toRange( matchStart, matchEnd );
+				for ( size_t i = 1; i < regex.getNumMatches(); i++ ) {
+					// Keep the empty captures, so "$n" still refers to the n-th capture
+					result.captures.emplace_back(
+						matches[i].start >= 0
+							? buffer->toRange( matches[i].start, matches[i].end )
+							: buffer->toRange( matchStart, matchStart ) );
+				}
+				if ( !onMatch( std::move( result ) ) )
+					return;
+				pos = matchEnd;
 			}
+			break;
 		}
-		case TextDocument::FindReplaceType::LuaPattern: {
-			// TODO: Implement findLastType for Lua patterns
-			LuaPatternStorage words( findStr.toUtf8() );
+		case FindReplaceType::LuaPattern: {
+			// Lua patterns are matched line by line, their anchors refer to the line
+			LuaPatternStorage pattern( text.toUtf8() );
 			PatternMatcher::Range matches[MAX_CAPTURES];
-			if ( words.matches( str, matches ) ) {
-				FindTypeResult result{ static_cast<size_t>( matches[0].start ),
-									   static_cast<size_t>( matches[0].end ) };
-				if ( words.getNumMatches() > 1 ) {
-					std::vector<TextPosition> captures;
-					captures.reserve( words.getNumMatches() - 1 );
-					for ( size_t i = 1; i < words.getNumMatches(); i++ ) {
-						result.captures.emplace_back(
-							PatternMatcher::Range{ matches[i].start, matches[i].end } );
+			for ( Int64 line = buffer->lineAt( start ); line < (Int64)buffer->lineHashes.size();
+				  line++ ) {
+				size_t lineStart = eemax( start, buffer->lineOffsets[line] );
+				size_t lineEnd = eemin( end, buffer->lineOffsets[line + 1] );
+				if ( lineStart >= end || ( stopFlag && *stopFlag ) )
+					break;
+				const char* lineStr = str.c_str() + lineStart;
+				size_t pos = lineStart;
+				while ( pos < lineEnd &&
+						pattern.matches( lineStr, pos - lineStart, matches, lineEnd - lineStart ) ) {
+					size_t matchStart = lineStart + matches[0].start;
+					size_t matchEnd = lineStart + matches[0].end;
+					if ( matchStart == matchEnd ||
+						 ( wholeWord && !buffer->isWholeWord( matchStart, matchEnd ) ) ) {
+						pos = buffer->nextChar( matchStart );
+						continue;
+					}
+					SearchResult result;
+					result.result = buffer->toRange( matchStart, matchEnd );
+					for ( size_t i = 1; i < pattern.getNumMatches(); i++ ) {
+						result.captures.emplace_back( buffer->toRange(
+							lineStart + matches[i].start, lineStart + matches[i].end ) );
 					}
+					if ( !onMatch( std::move( result ) ) )
+						return;
+					pos = matchEnd;
 				}
-				return result;
-			} else {
-				return { String::StringType::npos, String::StringType::npos };
 			}
+			break;
 		}
-		case TextDocument::FindReplaceType::Normal:
+		case FindReplaceType::Normal:
 		default: {
-			size_t res = str.rfind( findStr );
-			return { res, String::InvalidPos == res ? res : res + findStr.size() };
-		}
-	}
-}
-
-TextDocument::SearchResult toSearchResult( TextDocument* doc, const Int64 line,
-										   const FindTypeResult& res ) {
-	TextDocument::SearchResult ret;
-	TextRange pos(
-		{ { line, static_cast<Int64>( res.start ) }, { line, static_cast<Int64>( res.end ) } } );
-	if ( pos.end().column() == (Int64)doc->line( pos.end().line() ).size() )
-		pos.setEnd( doc->positionOffset( pos.end(), 1 ) );
-	ret.result = std::move( pos );
-	ret.captures.reserve( res.captures.size() );
-	for ( const auto& capture : res.captures ) {
-		ret.captures.push_back(
-			TextRange( TextPosition( line, capture.start ), TextPosition( line, capture.end ) ) );
-	}
-	return ret;
-}
-
-TextDocument::SearchResult TextDocument::findText( String text, TextPosition from,
-												   bool caseSensitive, bool wholeWord,
-												   FindReplaceType type, TextRange restrictRange ) {
-	if ( text.empty() )
-		return TextDocument::SearchResult{};
-	from = sanitizePosition( from );
-
-	TextPosition to = endOfDoc();
-	if ( restrictRange.isValid() ) {
-		restrictRange = sanitizeRange( restrictRange.normalized() );
-		to = restrictRange.end();
-		if ( from < restrictRange.start() || from > restrictRange.end() )
-			return TextDocument::SearchResult{};
-	}
-
-	bool realCaseSensitive = caseSensitive;
-	if ( ( type == FindReplaceType::LuaPattern || type == FindReplaceType::RegEx ) &&
-		 caseSensitive == false ) {
-		caseSensitive =
-			true; // Ignore case insensitive request since this is managed at pattern level
-	}
-
-	if ( !caseSensitive )
-		text.toLower();
-
-	for ( Int64 i = from.line(); i <= to.line(); i++ ) {
-		FindTypeResult col;
-		if ( i == from.line() ) {
-			col = caseSensitive
-					  ? findType( line( i ).getText().substr( from.column(),
-															  from.line() == to.line()
-																  ? to.column() - from.column()
-																  : String::InvalidPos ),
-								  text, type, from.column(), realCaseSensitive )
-					  : findType( String::toLower( line( i ).getText() )
-									  .substr( from.column(), from.line() == to.line()
-																  ? to.column() - from.column()
-																  : String::InvalidPos ),
-								  text, type, from.column(), realCaseSensitive );
-			if ( String::StringType::npos != col.start ) {
-				col.start += from.column();
-				col.end += from.column();
-			}
-		} else if ( i == to.line() && to != endOfDoc() ) {
-			col = caseSensitive
-					  ? findType( line( i ).getText().substr( 0, to.column() ), text, type, 0,
-								  realCaseSensitive )
-					  : findType( String::toLower( line( i ).getText() ).substr( 0, to.column() ),
-								  text, type, 0, realCaseSensitive );
-		} else {
-			col = caseSensitive ? findType( line( i ).getText(), text, type, 0, realCaseSensitive )
-								: findType( String::toLower( line( i ).getText() ), text, type, 0,
-											realCaseSensitive );
-		}
-		if ( String::StringType::npos != col.start &&
-			 ( !wholeWord || String::isWholeWord( line( i ).getText(), text, col.start ) ) ) {
-			return toSearchResult( this, i, col );
-		}
-	}
-	return TextDocument::SearchResult{};
-}
-
-TextDocument::SearchResult TextDocument::findTextLast( String text, TextPosition from,
-													   bool caseSensitive, bool wholeWord,
-													   FindReplaceType type,
-													   TextRange restrictRange ) {
-	if ( text.empty() )
-		return TextDocument::SearchResult{};
-	from = sanitizePosition( from );
-
-	TextPosition to = startOfDoc();
-	if ( restrictRange.isValid() ) {
-		restrictRange = sanitizeRange( restrictRange.normalized() );
-		to = restrictRange.start();
-		if ( from < restrictRange.start() || from > restrictRange.end() )
-			return TextDocument::SearchResult{};
-	}
-
-	bool realCaseSensitive = caseSensitive;
-	if ( ( type == FindReplaceType::LuaPattern || type == FindReplaceType::RegEx ) &&
-		 caseSensitive == false ) {
-		caseSensitive =
-			true; // Ignore case insensitive request since this is managed at pattern level
-	}
-
-	if ( !caseSensitive )
-		text.toLower();
-
-	for ( Int64 i = from.line(); i >= to.line(); i-- ) {
-		FindTypeResult res;
-		if ( i == from.line() ) {
-			res =
-				caseSensitive
-					? findLastType( line( i ).getText().substr(
-										from.line() == to.line() ? to.column() : 0, from.column() ),
-									text, type, realCaseSensitive )
-					: findLastType(
-						  String::toLower( line( i ).getText().substr(
-							  from.line() == to.line() ? to.column() : 0, from.column() ) ),
-						  text, type, realCaseSensitive );
-		} else if ( i == to.line() ) {
-			res = caseSensitive
-					  ? findLastType( line( i ).getText().substr( to.column() ), text, type,
-									  realCaseSensitive )
-					  : findLastType( String::toLower( line( i ).getText().substr( to.column() ) ),
-									  text, type, realCaseSensitive );
-			if ( String::StringType::npos != res.start ) {
-				res.start += to.column();
-				res.end += to.column();
+			std::string needle( lowercase ? String::toLower( text ).toUtf8() : text.toUtf8() );
+			std::string_view view( str.data(), end );
+			size_t pos = start;
+			while ( !( stopFlag && *stopFlag ) &&
+					( pos = view.find( needle, pos ) ) != std::string_view::npos ) {
+				size_t matchEnd = pos + needle.size();
+				if ( wholeWord && !buffer->isWholeWord( pos, matchEnd ) ) {
+					pos = buffer->nextChar( pos );
+					continue;
+				}
+				SearchResult result;
+				result.result = buffer->toRange( pos, matchEnd );
+				if ( !onMatch( std::move( result ) ) )
+					return;
+				pos = matchEnd;
 			}
-		} else {
-			res = caseSensitive ? findLastType( line( i ).getText(), text, type, realCaseSensitive )
-								: findLastType( String::toLower( line( i ).getText() ), text, type,
-												realCaseSensitive );
-		}
-		if ( String::StringType::npos != res.start &&
-			 ( !wholeWord || String::isWholeWord( line( i ).getText(), text, res.start ) ) ) {
-			return toSearchResult( this, i, res );
+			break;
 		}
 	}
-	return TextDocument::SearchResult{};
 }
 
 TextDocument::SearchResult TextDocument::find( const String& text, TextPosition from,
 											   bool caseSensitive, bool wholeWord,
 											   FindReplaceType type, TextRange restrictRange ) {
-	std::vector<String> textLines = text.split( '\n', true, true );
-
-	if ( textLines.empty() || textLines.size() > mLines.size() )
+	if ( text.empty() )
 		return {};
 
 	from = sanitizePosition( from );
@@ -2771,76 +2730,19 @@ TextDocument::SearchResult TextDocument::find( const String& text, TextPosition
 			return {};
 	}
 
-	if ( from == to )
-		return {};
-
-	if ( textLines.size() == 1 )
-		return findText( text, from, caseSensitive, wholeWord, type, restrictRange );
-
-	auto range = findText( textLines[0], from, caseSensitive, false, type, restrictRange );
-
-	if ( !range.isValid() )
-		return {};
-
-	TextPosition initPos( range.result.end().line(), 0 );
-
-	for ( size_t i = 1; i < textLines.size() - 1; i++ ) {
-		if ( initPos < from || initPos > to )
-			return find( text, range.result.end(), caseSensitive, wholeWord, type, restrictRange );
-
-		String currentLine( mLines[initPos.line()].getText() );
-
-		if ( TextPosition( initPos.line(), (Int64)currentLine.size() - 1 ) > to )
-			return find( text, range.result.end(), caseSensitive, wholeWord, type, restrictRange );
-
-		if ( !caseSensitive ) {
-			currentLine.toLower();
-			textLines[i].toLower();
-		}
-
-		if ( currentLine == textLines[i] ) {
-			initPos = TextPosition( initPos.line() + 1, 0 );
-
-			if ( initPos >= restrictRange.end() )
-				return {};
-		} else {
-			return find( text, range.result.end(), caseSensitive, wholeWord, type, restrictRange );
-		}
-	}
-
-	if ( initPos < from || initPos > to )
-		return find( text, range.result.end(), caseSensitive, wholeWord, type, restrictRange );
-
-	const String& lastLine = mLines[initPos.line()].getText();
-	const String& curSearch = textLines[textLines.size() - 1];
-
-	if ( TextPosition( initPos.line(), (Int64)curSearch.size() - 1 ) > to )
-		return find( text, range.result.end(), caseSensitive, wholeWord, type, restrictRange );
-
-	if ( lastLine.size() < curSearch.size() )
-		return find( text, range.result.end(), caseSensitive, wholeWord, type, restrictRange );
-
-	if ( ( caseSensitive && String::startsWith( lastLine, curSearch ) ) ||
-		 ( !caseSensitive &&
-		   String::startsWith( String( lastLine ).toLower(), String( curSearch ).toLower() ) ) ) {
-		TextRange foundRange( range.result.start(),
-							  TextPosition( initPos.line(), curSearch.size() ) );
-		if ( foundRange.end().column() == (Int64)mLines[foundRange.end().line()].size() )
-			foundRange.setEnd( positionOffset( foundRange.end(), 1 ) );
-		return range;
-	} else {
-		return find( text, range.result.end(), caseSensitive, wholeWord, type, restrictRange );
-	}
-
-	return {};
+	SearchResult found;
+	search( text, from, to, caseSensitive, wholeWord, type, nullptr,
+			[&found]( SearchResult&& result ) {
+				found = std::move( result );
+				return false;
+			} );
+	return found;
 }
 
 TextDocument::SearchResult TextDocument::findLast( const String& text, TextPosition from,
 												   bool caseSensitive, bool wholeWord,
 												   FindReplaceType type, TextRange restrictRange ) {
-	std::vector<String> textLines = text.split( '\n', true, true );
-
-	if ( textLines.empty() || textLines.size() > mLines.size() )
+	if ( text.empty() )
 		return {};
 
 	from = sanitizePosition( from );
@@ -2853,62 +2755,38 @@ TextDocument::SearchResult TextDocument::findLast( const String& text, TextPosit
 			return {};
 	}
 
-	if ( from == to )
+	if ( from <= to )
 		return {};
 
-	if ( textLines.size() == 1 )
-		return findTextLast( text, from, caseSensitive, wholeWord, type, restrictRange );
+	SearchResult found;
 
-	auto range = findTextLast( textLines[0], from, caseSensitive, false, type, restrictRange );
+	if ( type != FindReplaceType::Normal ) {
+		// Patterns can't be matched backwards, keep the last match of a forward pass
+		search( text, to, from, caseSensitive, wholeWord, type, nullptr,
+				[&found]( SearchResult&& result ) {
+					found = std::move( result );
+					return true;
+				} );
+		return found;
+	}
 
-	if ( !range.isValid() )
+	auto buffer = getSearchBuffer( !caseSensitive );
+	std::string needle( !caseSensitive ? String::toLower( text ).toUtf8() : text.toUtf8() );
+	size_t start = buffer->toOffset( to );
+	std::string_view view( buffer->text.data(), buffer->toOffset( from ) );
+	if ( needle.size() > view.size() )
 		return {};
-
-	TextPosition initPos( range.result.end().line(), 0 );
-
-	for ( size_t i = 1; i < textLines.size() - 1; i++ ) {
-		if ( initPos < from || initPos > to )
-			return findLast( text, range.result.end(), caseSensitive, wholeWord, type,
-							 restrictRange );
-
-		String currentLine( mLines[initPos.line()].getText() );
-
-		if ( TextPosition( initPos.line(), (Int64)currentLine.size() - 1 ) > to )
-			return findLast( text, range.result.end(), caseSensitive, wholeWord, type,
-							 restrictRange );
-
-		if ( !caseSensitive ) {
-			currentLine.toLower();
-			textLines[i].toLower();
-		}
-
-		if ( currentLine == textLines[i] ) {
-			initPos = TextPosition( i + 1, 0 );
-		} else {
-			return findLast( text, range.result.end(), caseSensitive, wholeWord, type,
-							 restrictRange );
+	size_t pos = view.size() - needle.size();
+	while ( ( pos = view.rfind( needle, pos ) ) != std::string_view::npos && pos >= start ) {
+		if ( !wholeWord || buffer->isWholeWord( pos, pos + needle.size() ) ) {
+			found.result = buffer->toRange( pos, pos + needle.size() );
+			break;
 		}
+		if ( pos == 0 )
+			break;
+		pos--;
 	}
-
-	if ( initPos < from || initPos > to )
-		return findLast( text, range.result.end(), caseSensitive, wholeWord, type, restrictRange );
-
-	const String& lastLine = mLines[initPos.line()].getText();
-	const String& curSearch = textLines[textLines.size() - 1];
-
-	if ( TextPosition( initPos.line(), (Int64)curSearch.size() - 1 ) > to )
-		return findLast( text, range.result.end(), caseSensitive, wholeWord, type, restrictRange );
-
-	if ( lastLine.size() < curSearch.size() )
-		return findLast( text, range.result.end(), caseSensitive, wholeWord, type, restrictRange );
-
-	if ( ( caseSensitive && String::startsWith( lastLine, curSearch ) ) ||
-		 ( !caseSensitive &&
-		   String::startsWith( String( lastLine ).toLower(), String( curSearch ).toLower() ) ) ) {
-		return range;
-	}
-
-	return {};
+	return found;
 }
 
 void TextDocument::stopActiveFindAll() {
@@ -2929,8 +2807,9 @@ TextDocument::SearchResults TextDocument::findAll( const String& text, bool case
 												   bool wholeWord, FindReplaceType type,
 												   TextRange restrictRange, size_t maxResults ) {
 	SearchResults all;
-	TextDocument::SearchResult found;
-	TextPosition from = startOfDoc();
+	if ( text.empty() )
+		return all;
+
 	auto stopFlagUP = std::make_unique<bool>( false );
 	bool* stopFlag = stopFlagUP.get();
 	{
@@ -2938,19 +2817,19 @@ TextDocument::SearchResults TextDocument::findAll( const String& text, bool case
 		mStopFlags.insert( { stopFlag, std::move( stopFlagUP ) } );
 	}
 
-	if ( restrictRange.isValid() )
-		from = restrictRange.normalized().start();
-	do {
-		found = find( text, from, caseSensitive, wholeWord, type, restrictRange );
-		if ( found.isValid() ) {
-			if ( !all.empty() && all.back() == found )
-				break;
-			from = found.result.end();
-			all.push_back( found );
-			if ( ( maxResults != 0 && all.size() >= maxResults ) || *stopFlag )
-				break;
-		}
-	} while ( found.isValid() );
+	TextPosition from = startOfDoc();
+	TextPosition to = endOfDoc();
+	if ( restrictRange.isValid() ) {
+		restrictRange = sanitizeRange( restrictRange.normalized() );
+		from = restrictRange.start();
+		to = restrictRange.end();
+	}
+
+	search( text, from, to, caseSensitive, wholeWord, type, stopFlag,
+			[&all, maxResults]( SearchResult&& result ) {
+				all.emplace_back( std::move( result ) );
+				return maxResults == 0 || all.size() < maxResults;
+			} );
 	if ( !all.empty() )
 		all.setSorted();
 
@@ -2966,15 +2845,6 @@ int TextDocument::replaceAll( const String& text, const String& replace, const b
 							  TextRange restrictRange ) {
 	if ( text.empty() )
 		return 0;
-	bool wasRunningTransaction = isRunningTransaction();
-	if ( !wasRunningTransaction )
-		setRunningTransaction( true );
-	int count = 0;
-	TextDocument::SearchResult found;
-	TextPosition startedPosition = getSelection().start();
-	TextPosition from = startOfDoc();
-	if ( restrictRange.isValid() )
-		from = restrictRange.normalized().start();
 
 	size_t numCaptures = 0;
 	PatternMatcher::Range matchList[MAX_CAPTURES];
@@ -2989,38 +2859,56 @@ int TextDocument::replaceAll( const String& text, const String& replace, const b
 		}
 	}
 
-	do {
-		found = find( text, from, caseSensitive, wholeWord, type, restrictRange );
-		if ( found.isValid() ) {
-			if ( numCaptures && numCaptures <= found.captures.size() ) {
-				String finalReplace( replace );
-				std::string l( line( found.captures[0].start().line() ).toUtf8() );
-				for ( size_t i = 0; i < numCaptures; i++ ) {
-					String matchSubStr( replace.substr(
-						matchList[i].start, matchList[i].end - matchList[i].start ) ); // $1 $2 ...
-					std::string matchNum( matchSubStr.substr( 1 ) );				   // 1 2 ...
-					int num;
-					if ( String::fromString( num, matchNum ) && num > 0 &&
-						 num - 1 < static_cast<int>( found.captures.size() ) ) {
-						auto start = found.captures[num - 1].start().column();
-						auto end = found.captures[num - 1].end().column();
-						finalReplace.replaceAll(
-							matchSubStr, String::fromUtf8( l.substr( start, end - start ) ) );
-					}
+	// All the matches are collected first and the text spanning them is rebuilt in a single pass,
+	// so the lines, the undo stack and the clients are updated once instead of once per match.
+	SearchResults results( findAll( text, caseSensitive, wholeWord, type, restrictRange ) );
+	if ( results.empty() )
+		return 0;
+
+	TextRange range( results.front().result.start(), results.back().result.end() );
+	TextPosition prevEnd( range.start() );
+	String replaced;
+
+	for ( const auto& found : results ) {
+		replaced += getText( { prevEnd, found.result.start() } );
+		prevEnd = found.result.end();
+
+		if ( numCaptures && numCaptures <= found.captures.size() ) {
+			String finalReplace( replace );
+			for ( size_t i = 0; i < numCaptures; i++ ) {
+				String matchSubStr( replace.substr(
+					matchList[i].start, matchList[i].end - matchList[i].start ) ); // $1 $2 ...
+				std::string matchNum( matchSubStr.substr( 1 ) );				   // 1 2 ...
+				int num;
+				if ( String::fromString( num, matchNum ) && num > 0 &&
+					 num - 1 < static_cast<int>( found.captures.size() ) ) {
+					finalReplace.replaceAll( matchSubStr, getText( found.captures[num - 1] ) );
 				}
-				setSelection( found.result );
-				from = replaceSelection( finalReplace );
-			} else {
-				setSelection( found.result );
-				from = replaceSelection( replace );
 			}
-			count++;
+			replaced += finalReplace;
+		} else {
+			replaced += replace;
 		}
-	} while ( found.isValid() && endOfDoc() != found.result.end() );
+	}
+
+	bool wasRunningTransaction = isRunningTransaction();
+	if ( !wasRunningTransaction )
+		setRunningTransaction( true );
+
+	TextPosition startedPosition = getSelection().start();
+	size_t lineCount = mLines.size();
+	// Both commands share the timestamp, so they are undone and redone together
+	Time time( mTimer.getElapsedTime() );
+	mUndoStack.clearRedoStack();
+	remove( 0, range, mUndoStack.getUndoStackContainer(), time );
+	if ( lineCount != mLines.size() )
+		notifyLineCountChanged( lineCount, mLines.size() );
+	insert( 0, range.start(), replaced, mUndoStack.getUndoStackContainer(), time );
+
 	if ( !wasRunningTransaction )
 		setRunningTransaction( false );
 	setSelection( startedPosition );
-	return count;
+	return results.size();
 }
 
 TextPosition TextDocument::replaceSelection( const String& replace ) {
@@ -3059,7 +2947,7 @@ void TextDocument::selectAllMatches() {
 TextPosition TextDocument::replace( String search, const String& replace, TextPosition from,
 									const bool& caseSensitive, const bool& wholeWord,
 									FindReplaceType type, TextRange restrictRange ) {
-	auto found( findText( search, from, caseSensitive, wholeWord, type, restrictRange ) );
+	auto found( find( search, from, caseSensitive, wholeWord, type, restrictRange ) );
 	size_t numCaptures = 0;
 	PatternMatcher::Range matchList[MAX_CAPTURES];
 
@@ -3076,7 +2964,6 @@ TextPosition TextDocument::replace( String search, const String& replace, TextPo
 	if ( found.isValid() ) {
 		if ( numCaptures && numCaptures == found.captures.size() ) {
 			String finalReplace( replace );
-			std::string l( line( found.captures[0].start().line() ).toUtf8() );
 			for ( size_t i = 0; i < numCaptures; i++ ) {
 				String matchSubStr( replace.substr(
 					matchList[i].start, matchList[i].end - matchList[i].start ) ); // $1 $2 ...
@@ -3084,15 +2971,7 @@ TextPosition TextDocument::replace( String search, const String& replace, TextPo
 				int num;
 				if ( String::fromString( num, matchNum ) && num > 0 &&
 					 num - 1 < static_cast<int>( found.captures.size() ) ) {
-					auto start =
-						restrictRange.start().column() + found.captures[num - 1].start().column();
-					auto end =
-						restrictRange.start().column() + found.captures[num - 1].end().column();
-					if ( start < static_cast<Int64>( l.size() ) &&
-						 end < static_cast<Int64>( l.size() ) ) {
-						finalReplace.replaceAll(
-							matchSubStr, String::fromUtf8( l.substr( start, end - start ) ) );
-					}
+					finalReplace.replaceAll( matchSubStr, getText( found.captures[num - 1] ) );
 				}
 			}
 			setSelection( found.result );
@@ -3157,6 +3036,14 @@ void TextDocument::unserializeUndoRedo( const std::string& jsonString ) {
 	return mUndoStack.fromJSON( jsonString );
 }
 
+const TextUndoStack& TextDocument::getUndoStack() const {
+	return mUndoStack;
+}
+
+TextUndoStack& TextDocument::getUndoStack() {
+	return mUndoStack;
+}
+
 void TextDocument::changeFilePath( const std::string& filePath ) {
 	changeFilePath( filePath, true );
 }
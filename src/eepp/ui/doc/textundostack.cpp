@@ -1,4 +1,7 @@
 #include <eepp/core/core.hpp>
+#include <eepp/system/compression.hpp>
+#include <eepp/system/iostreammemory.hpp>
+#include <eepp/system/iostreamstring.hpp>
 #include <eepp/system/log.hpp>
 #include <eepp/ui/doc/textdocument.hpp>
 #include <eepp/ui/doc/textundostack.hpp>
@@ -11,6 +14,119 @@ namespace EE { namespace UI { namespace Doc {
 
 using json = nlohmann::json;
 
+// Size of each block of the arena where the text of the commands is appended
+static constexpr size_t ARENA_CHUNK_SIZE = 64 * 1024;
+// Text at least this big is compressed as soon as it's pushed
+static constexpr size_t COMPRESS_IMMEDIATELY_SIZE = 256 * 1024;
+// Text smaller than this is never compressed, deflate barely reduces it
+static constexpr size_t MIN_COMPRESS_SIZE = 128;
+// Memory used by the arena chunks, when exceeded the text of the oldest commands is moved out of
+// the arena until it's halved
+static constexpr size_t MAX_ARENA_USAGE = 4 * 1024 * 1024;
+
+class TextUndoArena {
+  public:
+	// Appends the text to the current chunk and returns it, a new chunk is started when it doesn't
+	// fit. A chunk is released once the last payload referencing it is gone, until then its whole
+	// capacity is counted as used.
+	std::shared_ptr<std::string> append( const std::string& text, size_t& offset ) {
+		std::shared_ptr<std::string> chunk( mChunk.lock() );
+		if ( !chunk || chunk->size() + text.size() > chunk->capacity() ) {
+			std::unique_ptr<std::string> data( std::make_unique<std::string>() );
+			data->reserve( eemax( ARENA_CHUNK_SIZE, text.size() ) );
+			size_t capacity = data->capacity();
+			mMemoryUsage += capacity;
+			chunk = std::shared_ptr<std::string>( data.release(),
+												  [this, capacity]( std::string* data ) {
+													  mMemoryUsage -= capacity;
+													  delete data;
+												  } );
+			mChunk = chunk;
+		}
+		offset = chunk->size();
+		chunk->append( text );
+		return chunk;
+	}
+
+	bool isCurrent( const std::shared_ptr<std::string>& chunk ) const {
+		return mChunk.lock() == chunk;
+	}
+
+	// Bytes of the chunks still referenced
+	size_t getMemoryUsage() const { return mMemoryUsage; }
+
+  protected:
+	std::weak_ptr<std::string> mChunk;
+	size_t mMemoryUsage{ 0 };
+};
+
+// The text of a command, stored as UTF-8 in the arena or in its own buffer ( usually compressed )
+class TextUndoPayload {
+  public:
+	TextUndoPayload( TextUndoArena& arena, const std::string& text ) : mSize( text.size() ) {
+		if ( mSize >= COMPRESS_IMMEDIATELY_SIZE && compress( text ) )
+			return;
+		mChunk = arena.append( text, mOffset );
+	}
+
+	std::string getUtf8() const {
+		if ( mChunk )
+			return mChunk->substr( mOffset, mSize );
+		if ( !mCompressed )
+			return mData;
+		std::string text( mSize, '\0' );
+		if ( Compression::decompress( reinterpret_cast<Uint8*>( text.data() ), mSize,
+									  reinterpret_cast<const Uint8*>( mData.data() ),
+									  mData.size() ) != Compression::OK ) {
+			Log::error( "TextUndoPayload::getUtf8: failed to decompress the text of the command" );
+			return std::string();
+		}
+		return text;
+	}
+
+	bool isInArena() const { return mChunk != nullptr; }
+
+	// The memory of the text in the arena is counted by its chunk
+	size_t getMemoryUsage() const { return mChunk ? 0 : mData.capacity(); }
+
+	// Moves the text out of its arena chunk, so the chunk can be released. It's compressed when
+	// possible, the small text is copied to the current chunk instead.
+	bool release( TextUndoArena& arena ) {
+		if ( !mChunk || arena.isCurrent( mChunk ) )
+			return false;
+		std::string text( mChunk->substr( mOffset, mSize ) );
+		if ( mSize < MIN_COMPRESS_SIZE ) {
+			mChunk = arena.append( text, mOffset );
+			return true;
+		}
+		if ( !compress( text ) ) {
+			mData = std::move( text );
+			mData.shrink_to_fit();
+		}
+		mChunk.reset();
+		return true;
+	}
+
+  protected:
+	std::shared_ptr<std::string> mChunk;
+	size_t mOffset{ 0 };
+	size_t mSize{ 0 };
+	std::string mData;
+	bool mCompressed{ false };
+
+	bool compress( const std::string& text ) {
+		IOStreamMemory src( text.data(), text.size() );
+		IOStreamString dst;
+		if ( Compression::compress( dst, src ) != Compression::OK ||
+			 dst.getStream().size() >= text.size() )
+			return false;
+		mData = dst.getStream();
+		mData.shrink_to_fit();
+		mCompressed = true;
+		return true;
+	}
+};
+
 class TextUndoCommand {
   public:
 	TextUndoCommand( const Uint64& id, const TextUndoCommandType& type, const Time& timestamp );
@@ -25,6 +141,11 @@ class TextUndoCommand {
 
 	virtual json toJSON() = 0;
 
+	virtual size_t getMemoryUsage() const = 0;
+
+	/** Moves the data kept in the arena out of it ( see TextUndoPayload::release ) */
+	virtual bool release( TextUndoArena& ) { return false; }
+
   protected:
 	Uint64 mId;
 	TextUndoCommandType mType;
@@ -40,10 +161,11 @@ class TextUndoCommand {
 
 class TextUndoCommandInsert : public TextUndoCommand {
   public:
-	TextUndoCommandInsert( const Uint64& id, const size_t& cursorIdx, const String& text,
-						   const TextPosition& position, const Time& timestamp );
+	TextUndoCommandInsert( const Uint64& id, const size_t& cursorIdx, TextUndoArena& arena,
+						   const std::string& text, const TextPosition& position,
+						   const Time& timestamp );
 
-	const String& getText() const;
+	String getText() const;
 
 	const TextPosition& getPosition() const;
 
@@ -51,22 +173,26 @@ class TextUndoCommandInsert : public TextUndoCommand {
 
 	json toJSON() {
 		auto j = baseJSON();
-		j["text"] = mText.toUtf8();
+		j["text"] = mText.getUtf8();
 		j["position"] = mPosition.toString();
 		j["cursorIdx"] = mCursorIdx;
 		return j;
 	}
 
-	static TextUndoCommandInsert* fromJSON( json j, Uint64 id ) {
+	size_t getMemoryUsage() const { return sizeof( *this ) + mText.getMemoryUsage(); }
+
+	bool release( TextUndoArena& arena ) { return mText.release( arena ); }
+
+	static TextUndoCommandInsert* fromJSON( json j, Uint64 id, TextUndoArena& arena ) {
 		auto timestamp = Time::fromString( j["timestamp"].get<std::string>() );
-		auto text = String::fromUtf8( j["text"].get<std::string>() );
 		auto position = TextPosition::fromString( j["position"].get<std::string>() );
 		auto cursorIdx = j["cursorIdx"].get<size_t>();
-		return eeNew( TextUndoCommandInsert, ( id, cursorIdx, text, position, timestamp ) );
+		return eeNew( TextUndoCommandInsert, ( id, cursorIdx, arena, j["text"].get<std::string>(),
+											   position, timestamp ) );
 	}
 
   protected:
-	String mText;
+	TextUndoPayload mText;
 	TextPosition mPosition;
 	size_t mCursorIdx;
 };
@@ -87,6 +213,8 @@ class TextUndoCommandRemove : public TextUndoCommand {
 		return j;
 	}
 
+	size_t getMemoryUsage() const { return sizeof( *this ); }
+
 	static TextUndoCommandRemove* fromJSON( json j, Uint64 id ) {
 		auto timestamp = Time::fromString( j["timestamp"].get<std::string>() );
 		auto range = TextRange::fromString( j["range"].get<std::string>() );
@@ -115,6 +243,10 @@ class TextUndoCommandSelection : public TextUndoCommand {
 		return j;
 	}
 
+	size_t getMemoryUsage() const {
+		return sizeof( *this ) + mSelection.capacity() * sizeof( TextRange );
+	}
+
 	static TextUndoCommandSelection* fromJSON( json j, Uint64 id ) {
 		auto timestamp = Time::fromString( j["timestamp"].get<std::string>() );
 		auto range = TextRange::fromString( j["range"].get<std::string>() );
@@ -146,15 +278,16 @@ const Time& TextUndoCommand::getTimestamp() const {
 }
 
 TextUndoCommandInsert::TextUndoCommandInsert( const Uint64& id, const size_t& cursorIdx,
-											  const String& text, const TextPosition& position,
+											  TextUndoArena& arena, const std::string& text,
+											  const TextPosition& position,
 											  const Time& timestamp ) :
 	TextUndoCommand( id, TextUndoCommandType::Insert, timestamp ),
-	mText( text ),
+	mText( arena, text ),
 	mPosition( position ),
 	mCursorIdx( cursorIdx ) {}
 
-const String& TextUndoCommandInsert::getText() const {
-	return mText;
+String TextUndoCommandInsert::getText() const {
+	return String::fromUtf8( mText.getUtf8() );
 }
 
 const TextPosition& TextUndoCommandInsert::getPosition() const {
@@ -194,14 +327,18 @@ size_t TextUndoCommandSelection::getCursorIdx() const {
 	return mCursorIdx;
 }
 
-TextUndoStack::TextUndoStack( TextDocument* owner, const Uint32& maxStackSize ) :
+TextUndoStack::TextUndoStack( TextDocument* owner, const Uint32& maxStackSize,
+							  const size_t& maxMemoryUsage ) :
 	mDoc( owner ),
 	mMaxStackSize( maxStackSize ),
 	mChangeIdCounter( 0 ),
-	mMergeTimeout( Milliseconds( 300.f ) ) {}
+	mMergeTimeout( Milliseconds( 300.f ) ),
+	mArena( eeNew( TextUndoArena, () ) ),
+	mMaxMemoryUsage( maxMemoryUsage ) {}
 
 TextUndoStack::~TextUndoStack() {
 	clear();
+	eeSAFE_DELETE( mArena );
 }
 
 void TextUndoStack::clear() {
@@ -211,31 +348,96 @@ void TextUndoStack::clear() {
 
 void TextUndoStack::clearUndoStack() {
 	for ( TextUndoCommand* cmd : mUndoStack ) {
-		eeDelete( cmd );
+		releaseCommand( cmd );
 	}
 	mUndoStack.clear();
 }
 
 void TextUndoStack::clearRedoStack() {
 	for ( TextUndoCommand* cmd : mRedoStack ) {
-		eeDelete( cmd );
+		releaseCommand( cmd );
 	}
 	mRedoStack.clear();
 }
 
+void TextUndoStack::trackCommand( TextUndoCommand* cmd ) {
+	mMemoryUsage += cmd->getMemoryUsage();
+}
+
+void TextUndoStack::untrackCommand( TextUndoCommand* cmd ) {
+	mMemoryUsage -= cmd->getMemoryUsage();
+}
+
+void TextUndoStack::releaseCommand( TextUndoCommand* cmd ) {
+	untrackCommand( cmd );
+	eeDelete( cmd );
+}
+
+bool TextUndoStack::isSameGroup( TextUndoCommand* cmd, TextUndoCommand* other ) const {
+	return eeabs( ( cmd->getTimestamp() - other->getTimestamp() ).asMilliseconds() ) <
+		   mMergeTimeout.asMilliseconds();
+}
+
+void TextUndoStack::trimStack( UndoStackContainer& undoStack, bool keepNewestGroup ) {
+	// The commands undone together are discarded together, an undo or a redo must never apply
+	// only part of them
+	size_t memoryUsage = getMemoryUsage();
+	size_t discarded = 0;
+	while ( !undoStack.empty() &&
+			( undoStack.size() > mMaxStackSize || getMemoryUsage() > mMaxMemoryUsage ) ) {
+		size_t groupSize = 1;
+		while ( groupSize < undoStack.size() &&
+				isSameGroup( undoStack[groupSize - 1], undoStack[groupSize] ) )
+			groupSize++;
+		if ( keepNewestGroup && groupSize == undoStack.size() )
+			break;
+		for ( size_t i = 0; i < groupSize; i++ ) {
+			releaseCommand( undoStack.front() );
+			undoStack.pop_front();
+		}
+		discarded += groupSize;
+	}
+	if ( discarded > 0 )
+		Log::debug( "TextUndoStack: discarded %zu commands, memory usage went from %zu to %zu bytes",
+					discarded, memoryUsage, getMemoryUsage() );
+}
+
+void TextUndoStack::compressOldest() {
+	// Older commands are less likely to be undone, compress them first. The chunks are filled in
+	// order, so the oldest chunks are released as their commands leave the arena.
+	size_t arenaUsage = mArena->getMemoryUsage();
+	size_t released = 0;
+	for ( auto* undoStack : { &mUndoStack, &mRedoStack } ) {
+		for ( TextUndoCommand* cmd : *undoStack ) {
+			if ( mArena->getMemoryUsage() <= MAX_ARENA_USAGE / 2 )
+				break;
+			untrackCommand( cmd );
+			if ( cmd->release( *mArena ) )
+				released++;
+			trackCommand( cmd );
+		}
+	}
+	Log::debug( "TextUndoStack: moved %zu commands out of the arena, arena usage went from %zu to "
+				"%zu bytes, memory usage is %zu bytes",
+				released, arenaUsage, mArena->getMemoryUsage(), getMemoryUsage() );
+}
+
 void TextUndoStack::pushUndo( UndoStackContainer& undoStack, TextUndoCommand* cmd ) {
 	undoStack.push_back( cmd );
-	while ( undoStack.size() > mMaxStackSize ) {
-		eeDelete( undoStack.front() );
-		undoStack.pop_front();
-	}
+	trackCommand( cmd );
+	// The stack receiving an undo or a redo is trimmed once the whole group was moved to it. The
+	// newest group is always kept, even if it doesn't fit in the memory budget.
+	if ( !mTransferring )
+		trimStack( undoStack, true );
+	if ( mArena->getMemoryUsage() > MAX_ARENA_USAGE )
+		compressOldest();
 }
 
 void TextUndoStack::pushInsert( UndoStackContainer& undoStack, const String& string,
 								const size_t& cursorIdx, const TextPosition& position,
 								const Time& time ) {
-	pushUndo( undoStack, eeNew( TextUndoCommandInsert,
-								( ++mChangeIdCounter, cursorIdx, string, position, time ) ) );
+	pushUndo( undoStack, eeNew( TextUndoCommandInsert, ( ++mChangeIdCounter, cursorIdx, *mArena,
+														 string.toUtf8(), position, time ) ) );
 }
 
 void TextUndoStack::pushRemove( UndoStackContainer& undoStack, const size_t& cursorIdx,
@@ -278,7 +480,7 @@ void TextUndoStack::popUndo( UndoStackContainer& undoStack, UndoStackContainer&
 		}
 	}
 
-	eeSAFE_DELETE( cmd );
+	releaseCommand( cmd );
 
 	if ( !undoStack.empty() &&
 		 eeabs( ( lastTimestamp - undoStack.back()->getTimestamp() ).asMilliseconds() ) <
@@ -287,12 +489,21 @@ void TextUndoStack::popUndo( UndoStackContainer& undoStack, UndoStackContainer&
 	}
 }
 
+void TextUndoStack::transfer( UndoStackContainer& undoStack, UndoStackContainer& redoStack ) {
+	mTransferring = true;
+	popUndo( undoStack, redoStack );
+	mTransferring = false;
+	// Redo commands are discarded before the undo ones
+	trimStack( mRedoStack, true );
+	trimStack( mUndoStack, true );
+}
+
 void TextUndoStack::undo() {
-	popUndo( mUndoStack, mRedoStack );
+	transfer( mUndoStack, mRedoStack );
 }
 
 void TextUndoStack::redo() {
-	popUndo( mRedoStack, mUndoStack );
+	transfer( mRedoStack, mUndoStack );
 }
 
 bool TextUndoStack::hasUndo() const {
@@ -307,6 +518,21 @@ const Uint32& TextUndoStack::getMaxStackSize() const {
 	return mMaxStackSize;
 }
 
+const size_t& TextUndoStack::getMaxMemoryUsage() const {
+	return mMaxMemoryUsage;
+}
+
+void TextUndoStack::setMaxMemoryUsage( const size_t& maxMemoryUsage ) {
+	mMaxMemoryUsage = maxMemoryUsage;
+	// Redo commands are discarded before the undo ones
+	trimStack( mRedoStack, false );
+	trimStack( mUndoStack, false );
+}
+
+size_t TextUndoStack::getMemoryUsage() const {
+	return mMemoryUsage + mArena->getMemoryUsage();
+}
+
 const Time& TextUndoStack::getMergeTimeout() const {
 	return mMergeTimeout;
 }
@@ -355,7 +581,7 @@ void TextUndoStack::fromJSON( const std::string& jsonString ) {
 			switch ( type ) {
 				case TextUndoCommandType::Insert:
 					pushUndo( mRedoStack,
-							  TextUndoCommandInsert::fromJSON( jobj, ++mChangeIdCounter ) );
+							  TextUndoCommandInsert::fromJSON( jobj, ++mChangeIdCounter, *mArena ) );
 					break;
 				case TextUndoCommandType::Remove:
 					pushUndo( mRedoStack,
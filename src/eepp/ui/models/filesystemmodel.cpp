@@ -169,7 +169,8 @@ static bool isAcceptedExtension( const std::vector<std::string>& acceptedExtensi
 	return true;
 }
 
-bool FileSystemModel::Node::refresh( const FileSystemModel& model ) {
+bool FileSystemModel::Node::refresh( const FileSystemModel& model,
+									 std::vector<Node*>& released ) {
 	if ( !mInfo.isDirectory() )
 		return false;
 
@@ -210,17 +211,14 @@ bool FileSystemModel::Node::refresh( const FileSystemModel& model ) {
 			newChildren.emplace_back( node );
 
 			if ( node->info().isDirectory() && node->mHasTraversed )
-				node->refresh( model );
+				node->refresh( model, released );
 		} else {
 			newChildren.emplace_back( eeNew( Node, ( std::move( file ), this ) ) );
 		}
 	}
 
 	Lock l( model.mResourceLock );
-
-	for ( Node* oldNode : oldFiles )
-		eeDelete( oldNode );
-
+	released.insert( released.end(), oldFiles.begin(), oldFiles.end() );
 	mChildren = std::move( newChildren );
 	return true;
 }
@@ -423,11 +421,20 @@ void FileSystemModel::reload() {
 }
 
 void FileSystemModel::refresh() {
+	std::vector<Node*> released;
+
 	{
 		Lock l( resourceMutex() );
-		mRoot->refresh( *this );
+		mRoot->refresh( *this, released );
 	}
+
+	// The removed nodes are freed once the views know that their indexes are invalid, a view
+	// drawing before that still reads the previous nodes
 	invalidate();
+
+	Lock l( resourceMutex() );
+	for ( Node* node : released )
+		eeDelete( node );
 }
 
 void FileSystemModel::update() {
@@ -1,9 +1,12 @@
 #include <algorithm>
 #include <eepp/graphics/fontmanager.hpp>
 #include <eepp/graphics/fonttruetype.hpp>
+#include <eepp/graphics/framebuffer.hpp>
 #include <eepp/graphics/globalbatchrenderer.hpp>
 #include <eepp/graphics/primitives.hpp>
+#include <eepp/graphics/renderer/clippingmask.hpp>
 #include <eepp/graphics/renderer/renderer.hpp>
+#include <eepp/graphics/textureregion.hpp>
 #include <eepp/scene/scenemanager.hpp>
 #include <eepp/system/luapattern.hpp>
 #include <eepp/system/scopedop.hpp>
@@ -182,6 +185,8 @@ UICodeEditor::~UICodeEditor() {
 
 	getUISceneNode()->removeActionsByTag( mTagFoldRange );
 
+	eeSAFE_DELETE( mMinimapCache.frameBuffer );
+
 	if ( mCurrentMenu ) {
 		mCurrentMenu->clearEventListener();
 		mCurrentMenu = nullptr;
@@ -349,6 +354,8 @@ void UICodeEditor::draw() {
 			plugin->drawAfterLineText( this, i, curScroll, charSize, lineHeight );
 	}
 
+	trimLinesGlyphs( lineRange );
+
 	if ( mPluginsGutterSpace > 0 ) {
 		Float curGutterPos = 0;
 		for ( auto& plugin : mPluginGutterSpaces ) {
@@ -918,6 +925,8 @@ void UICodeEditor::updateColorScheme() {
 	mMinimapHoverColor = mColorScheme.getEditorColor( "minimap_hover"_sst );
 	mMinimapHighlightColor = mColorScheme.getEditorColor( "minimap_highlight"_sst );
 	mMinimapSelectionColor = mColorScheme.getEditorColor( "minimap_selection"_sst );
+	invalidateMinimapCache();
+	mLinesGlyphs.clear();
 }
 
 void UICodeEditor::setColorScheme( const SyntaxColorScheme& colorScheme ) {
@@ -3549,18 +3558,9 @@ void UICodeEditor::drawWordMatch( const String& text, const DocumentLineRange& l
 void UICodeEditor::drawLineText( const Int64& line, Vector2f position, const Float& fontSize,
 								 const Float& lineHeight,
 								 const DocumentViewLineRange& visibleLineRange ) {
-	Vector2f originalPosition( position );
 	const auto& tokens = mDoc->getHighlighter()->getLine( line );
-	const String& strLine = mDoc->line( line ).getText();
-	Primitives primitives;
-	Int64 curChar = 0;
-	Int64 maxWidth = eeceil( mSize.getWidth() / getGlyphWidth() + 1 );
-	bool isMonospace = mFont->isMonospace();
 	bool isFallbackFont = false;
 	bool isEmojiFallbackFont = false;
-	bool ended = false;
-	Float lineOffset = getLineOffset();
-	size_t pos = 0;
 	if ( mDoc->mightBeBinary() && mFont->getType() == FontType::TTF ) {
 		FontTrueType* ttf = static_cast<FontTrueType*>( mFont );
 		isFallbackFont = ttf->isFallbackFontEnabled();
@@ -3569,8 +3569,6 @@ void UICodeEditor::drawLineText( const Int64& line, Vector2f position, const Flo
 		ttf->setEnableEmojiFallback( false );
 	}
 
-	String::View buff;
-	Sizef size;
 	FontStyleConfig fontStyle( mFontStyleConfig );
 	fontStyle.CharacterSize = fontSize;
 
@@ -3614,6 +3612,53 @@ void UICodeEditor::drawLineText( const Int64& line, Vector2f position, const Flo
 		}
 	};
 
+	// The lines that didn't change since they were drawn batch again the vertexs captured when
+	// drawn, only translated to the current line position
+	BatchRenderer* BR = GlobalBatchRenderer::instance();
+	LineGlyphs& glyphs = mLinesGlyphs[line];
+	Uint64 key =
+		getLineGlyphsKey( line, tokens, position, fontSize, lineHeight, visibleLineRange );
+	if ( glyphs.key == key ) {
+		BR->batchCapture( glyphs.capture, position );
+	} else {
+		glyphs.key = key;
+		glyphs.capture.clear();
+		BR->startCapture( &glyphs.capture, position );
+		drawLineGlyphs( line, tokens, position, fontSize, lineHeight, visibleLineRange );
+		BR->stopCapture();
+	}
+
+	if ( mHandShown && mLinkPosition.isValid() && mLinkPosition.inSameLine() &&
+		 mLinkPosition.start().line() == line ) {
+		drawHandDown();
+	}
+
+	if ( mDoc->mightBeBinary() && mFont->getType() == FontType::TTF ) {
+		FontTrueType* ttf = static_cast<FontTrueType*>( mFont );
+		ttf->setEnableFallbackFont( isFallbackFont );
+		ttf->setEnableEmojiFallback( isEmojiFallbackFont );
+	}
+}
+
+void UICodeEditor::drawLineGlyphs( const Int64& line,
+									const std::vector<SyntaxTokenPosition>& tokens,
+									Vector2f position, const Float& fontSize,
+									const Float& lineHeight,
+									const DocumentViewLineRange& visibleLineRange ) {
+	Vector2f originalPosition( position );
+	const String& strLine = mDoc->line( line ).getText();
+	Primitives primitives;
+	Int64 curChar = 0;
+	Int64 maxWidth = eeceil( mSize.getWidth() / getGlyphWidth() + 1 );
+	bool isMonospace = mFont->isMonospace();
+	bool ended = false;
+	Float lineOffset = getLineOffset();
+	size_t pos = 0;
+	String::View buff;
+	Sizef size;
+	FontStyleConfig fontStyle( mFontStyleConfig );
+	fontStyle.CharacterSize = fontSize;
+
 	if ( mDocView.isWrappedLine( line ) ) {
 		auto vline = mDocView.getVisibleLineInfo( line );
 		size_t curvline = 1;
@@ -3743,16 +3788,52 @@ void UICodeEditor::drawLineText( const Int64& line, Vector2f position, const Flo
 			curChar += characterWidth( text );
 		}
 	}
+}
 
-	if ( mHandShown && mLinkPosition.isValid() && mLinkPosition.inSameLine() &&
-		 mLinkPosition.start().line() == line ) {
-		drawHandDown();
+Uint64 UICodeEditor::getLineGlyphsKey( const Int64& line,
+									   const std::vector<SyntaxTokenPosition>& tokens,
+									   const Vector2f& position, const Float& fontSize,
+									   const Float& lineHeight,
+									   const DocumentViewLineRange& visibleLineRange ) {
+	const auto hashFloat = []( const Float& value ) { return std::hash<Float>()( value ); };
+	// The glyphs depend on the line contents ( its text and tokens ), the font style and the
+	// horizontal position ( only the visible part of the line is drawn )
+	std::size_t key = hashCombine(
+		mDoc->line( line ).getHash(), TokenizedLine::calcSignature( tokens ),
+		reinterpret_cast<std::size_t>( mFont ),
+		reinterpret_cast<std::size_t>( mFont->getTexture( fontSize ) ), hashFloat( fontSize ),
+		hashFloat( lineHeight ), hashFloat( getLineOffset() ), hashFloat( getGlyphWidth() ),
+		mTabWidth, mUseDefaultStyle, mDoc->mightBeBinary(), mFontStyleConfig.Style,
+		mFontStyleConfig.FontColor.getValue(), mFontStyleConfig.ShadowColor.getValue(),
+		hashFloat( mFontStyleConfig.ShadowOffset.x ), hashFloat( mFontStyleConfig.ShadowOffset.y ),
+		hashFloat( mFontStyleConfig.OutlineThickness ), mFontStyleConfig.OutlineColor.getValue(),
+		hashFloat( mAlpha ), hashFloat( mScroll.x ), hashFloat( position.x - mScreenPos.x ),
+		hashFloat( mSize.getWidth() ) );
+
+	// Only the visual lines of a wrapped line that are visible are drawn
+	if ( mDocView.isWrappedLine( line ) ) {
+		auto vline = mDocView.getVisibleLineInfo( line );
+		Int64 first = static_cast<Int64>( vline.visibleIndex );
+		Int64 count = vline.visualLines.size();
+		key = hashCombine(
+			key, hashFloat( vline.paddingStart ),
+			eeclamp<Int64>( static_cast<Int64>( visibleLineRange.first ) - first, -1, count + 1 ),
+			eeclamp<Int64>( static_cast<Int64>( visibleLineRange.second ) - first, -1,
+							count + 1 ) );
+		for ( const auto& visualLine : vline.visualLines )
+			key = hashCombine( key, visualLine.column() );
 	}
 
-	if ( mDoc->mightBeBinary() && mFont->getType() == FontType::TTF ) {
-		FontTrueType* ttf = static_cast<FontTrueType*>( mFont );
-		ttf->setEnableFallbackFont( isFallbackFont );
-		ttf->setEnableEmojiFallback( isEmojiFallbackFont );
+	return key;
+}
+
+void UICodeEditor::trimLinesGlyphs( const DocumentLineRange& lineRange ) {
+	for ( auto it = mLinesGlyphs.begin(); it != mLinesGlyphs.end(); ) {
+		if ( it->first < lineRange.first || it->first > lineRange.second ) {
+			it = mLinesGlyphs.erase( it );
+		} else {
+			++it;
+		}
 	}
 }
 
@@ -4450,6 +4531,18 @@ void UICodeEditor::drawMinimap( const Vector2f& start, const DocumentLineRange&,
 		minimapStartLine = eemax( 0ll, eemin( minimapStartLine, lineCount - maxMinmapLines ) );
 	}
 
+	Float gutterWidth = PixelDensity::dpToPx( mMinimapConfig.gutterWidth );
+	Int64 endidx = minimapStartLine + maxMinmapLines;
+	endidx = eemin( endidx, lineCount - 1 );
+
+	Int64 minimapStartDocLine =
+		mDocView.getVisibleIndexPosition( static_cast<VisibleIndex>( minimapStartLine ) ).line();
+	Int64 endDocIdx =
+		mDocView.getVisibleIndexPosition( static_cast<VisibleIndex>( endidx ) ).line();
+	DocumentLineRange docRange = { minimapStartDocLine, endDocIdx };
+	DocumentViewLineRange docViewRange = { static_cast<VisibleIndex>( minimapStartLine ),
+										   static_cast<VisibleIndex>( endidx ) };
+
 	// Disable multi-sample to avoid rectangle-smoothing
 	bool disableMultisample = !mMinimapConfig.allowSmoothing && GLi->isMultisample();
 	ScopedOp op(
@@ -4462,6 +4555,14 @@ void UICodeEditor::drawMinimap( const Vector2f& start, const DocumentLineRange&,
 				GLi->multisample( true );
 		} );
 
+	Float minimapCutoffX = rect.Left + rect.getWidth();
+	MinimapLinesLayout layout{ rect.Left,	   rect.Top,	  minimapStartLine, endidx, 0,
+							   charHeight,	   charSpacing, lineSpacing,	   gutterWidth,
+							   minimapCutoffX, mAlpha };
+
+	// The text is rendered in a frame buffer that only updates the modified lines
+	bool cached = updateMinimapCache( rect, layout, docRange );
+
 	GlobalBatchRenderer* BR = GlobalBatchRenderer::instance();
 	BR->setTexture( nullptr );
 	BR->setBlendMode( BlendMode::Alpha() );
@@ -4479,40 +4580,9 @@ void UICodeEditor::drawMinimap( const Vector2f& start, const DocumentLineRange&,
 		BR->batchQuad( { { rect.Left, visibleY }, Sizef( rect.getWidth(), scrollerHeight ) } );
 	}
 
-	Float gutterWidth = PixelDensity::dpToPx( mMinimapConfig.gutterWidth );
 	Float lineY = rect.Top;
-
-	const auto* batchSyntaxType = &SYNTAX_NORMAL;
-	Color color = mColorScheme.getSyntaxStyle( *batchSyntaxType ).color;
-	color.a *= 0.5f;
-	Float batchWidth = 0;
-	Float batchStart = rect.Left;
-	Float minimapCutoffX = rect.Left + rect.getWidth();
 	Float widthScale = charSpacing / getGlyphWidth();
 	Int64 maxVisibleColumn = eeceil( rect.getWidth() / charSpacing );
-	auto flushBatch = [this, &color, &batchSyntaxType, &batchStart, &batchWidth, &lineY, &BR,
-					   &charHeight]( const SyntaxStyleType& type ) {
-		Color oldColor = color;
-		color = mColorScheme.getSyntaxStyle( *batchSyntaxType ).color;
-		if ( color != Color::Transparent ) {
-			color.a *= 0.5f;
-		} else {
-			color = oldColor;
-		}
-
-		if ( batchWidth > 0 ) {
-			BR->quadsSetColor( color.blendAlpha( mAlpha ) );
-			BR->batchQuad( { { batchStart, lineY }, { batchWidth, charHeight } } );
-		}
-
-		batchSyntaxType = &type;
-		batchStart += batchWidth;
-		batchWidth = 0;
-	};
-
-	Int64 endidx = minimapStartLine + maxMinmapLines;
-	endidx = eemin( endidx, lineCount - 1 );
-
 	Float minimapStart = rect.Left + gutterWidth;
 
 	// Avoid heap allocating the lambda
@@ -4576,26 +4646,6 @@ void UICodeEditor::drawMinimap( const Vector2f& start, const DocumentLineRange&,
 		}
 	};
 
-	auto drawWordMatch = [this, &drawMinimapTextRanges]( const String& text, const Int64& ln ) {
-		size_t pos = 0;
-		const String& line( mDoc->line( ln ).getText() );
-		if ( line.size() > 300 )
-			return;
-		do {
-			pos = line.find( text, pos );
-			if ( pos != String::InvalidPos ) {
-				Int64 startCol = pos;
-				Int64 endCol = pos + text.size();
-				TextRange range( { ln, startCol }, { ln, endCol } );
-				drawMinimapTextRanges( { range },
-									   Color( mMinimapHighlightColor ).blendAlpha( mAlpha ) );
-				pos = endCol;
-			} else {
-				break;
-			}
-		} while ( true );
-	};
-
 	String selectionString;
 
 	if ( mDoc->hasSelection() &&
@@ -4623,182 +4673,427 @@ void UICodeEditor::drawMinimap( const Vector2f& start, const DocumentLineRange&,
 							   Color( mMinimapHighlightColor ).blendAlpha( mAlpha ) );
 	}
 
-	Int64 minimapStartDocLine =
-		mDocView.getVisibleIndexPosition( static_cast<VisibleIndex>( minimapStartLine ) ).line();
-	Int64 endDocIdx =
-		mDocView.getVisibleIndexPosition( static_cast<VisibleIndex>( endidx ) ).line();
-	DocumentLineRange docRange = { minimapStartDocLine, endDocIdx };
-	DocumentViewLineRange docViewRange = { static_cast<VisibleIndex>( minimapStartLine ),
-										   static_cast<VisibleIndex>( endidx ) };
-
 	for ( auto* plugin : mPlugins ) {
 		plugin->minimapDrawBefore( this, docRange, docViewRange, { rect.Left, lineY },
 								   { rect.getWidth(), charHeight }, charSpacing, gutterWidth,
 								   drawMinimapTextRanges );
 	}
 
-	for ( Int64 line = minimapStartDocLine; line <= endDocIdx; line++ ) {
-		if ( !mDocView.isLineVisible( line ) )
+	if ( mHighlightWord.isEmpty() && !selectionString.empty() ) {
+		drawMinimapTextRanges( getMinimapWordMatches( selectionString, docRange ),
+							   Color( mMinimapHighlightColor ).blendAlpha( mAlpha ) );
+	}
+
+	if ( cached ) {
+		drawMinimapCache( rect, layout );
+	} else {
+		for ( Int64 line = minimapStartDocLine; line <= endDocIdx; line++ ) {
+			if ( mDocView.isLineVisible( line ) )
+				drawMinimapLine( line, layout );
+		}
+	}
+
+	lineY += ( endidx - minimapStartLine + 1 ) * lineSpacing;
+
+	for ( auto* plugin : mPlugins ) {
+		plugin->minimapDrawAfter( this, docRange, docViewRange, { rect.Left, lineY },
+								  { rect.getWidth(), charHeight }, charSpacing, gutterWidth,
+								  drawMinimapTextRanges );
+	}
+
+	if ( mHighlightTextRange.isValid() && mHighlightTextRange.hasSelection() ) {
+		drawMinimapTextRanges( { mHighlightTextRange },
+							   Color( mMinimapSelectionColor ).blendAlpha( mAlpha ) );
+	}
+
+	if ( mDoc->hasSelection() ) {
+		drawMinimapTextRanges( mDoc->getSelectionsSorted(),
+							   Color( mMinimapSelectionColor ).blendAlpha( mAlpha ) );
+	}
+
+	for ( size_t i = 0; i < mDoc->getSelections().size(); ++i ) {
+		const auto& selection = mDoc->getSelectionIndex( i );
+		if ( mDocView.isFolded( selection.start().line(), true ) )
 			continue;
-		batchSyntaxType = &SYNTAX_NORMAL;
-		batchStart = rect.Left + gutterWidth;
+		Float selectionY =
+			rect.Top +
+			( static_cast<Int64>( mDocView.getVisibleLineRange( selection.start() ).visibleIndex ) -
+			  minimapStartLine ) *
+				lineSpacing;
+		BR->quadsSetColor( Color( mMinimapCurrentLineColor ).blendAlpha( mAlpha ) );
+		BR->batchQuad( { { rect.Left, selectionY }, { rect.getWidth(), lineSpacing } } );
+	}
+
+	BR->draw();
+}
+
+void UICodeEditor::drawMinimapLine( Int64 line, const MinimapLinesLayout& layout ) {
+	BatchRenderer* BR = GlobalBatchRenderer::instance();
+	const auto* batchSyntaxType = &SYNTAX_NORMAL;
+	Color color = mColorScheme.getSyntaxStyle( *batchSyntaxType ).color;
+	color.a *= 0.5f;
+	Float batchWidth = 0;
+	Float batchStart = layout.left + layout.gutterWidth;
+	Int64 curVisualIndex = static_cast<Int64>( mDocView.toVisibleIndex( line ) );
+	const auto rowY = [&layout]( Int64 visibleIndex ) {
+		return layout.top + ( layout.ringRows ? visibleIndex % layout.ringRows
+											  : visibleIndex - layout.firstRow ) *
+								layout.lineSpacing;
+	};
+	Float lineY = rowY( curVisualIndex );
+	auto flushBatch = [this, &color, &batchSyntaxType, &batchStart, &batchWidth, &lineY, &BR,
+					   &layout, &curVisualIndex]( const SyntaxStyleType& type ) {
+		Color oldColor = color;
+		color = mColorScheme.getSyntaxStyle( *batchSyntaxType ).color;
+		if ( color != Color::Transparent ) {
+			color.a *= 0.5f;
+		} else {
+			color = oldColor;
+		}
+
+		if ( batchWidth > 0 && curVisualIndex >= layout.firstRow &&
+			 curVisualIndex <= layout.lastRow ) {
+			BR->quadsSetColor( Color( color ).blendAlpha( layout.alpha ) );
+			BR->batchQuad( { { batchStart, lineY }, { batchWidth, layout.charHeight } } );
+		}
+
+		batchSyntaxType = &type;
+		batchStart += batchWidth;
 		batchWidth = 0;
+	};
 
-		if ( mHighlightWord.isEmpty() && !selectionString.empty() )
-			drawWordMatch( selectionString, line );
-
-		const auto& tokens = mDoc->getHighlighter()->getLine( line, false );
-		const auto& text = mDoc->line( line ).getText();
-		Int64 pos = 0;
-		bool wrappedLine = mDocView.isWrappedLine( line );
-
-		if ( wrappedLine ) {
-			bool outOfRange = false;
-			auto vline = mDocView.getVisibleLineInfo( line );
-			size_t curvline = 1;
-			Int64 nextLineCol = vline.visualLines[curvline].column();
-			Int64 lineLength = text.size();
-			Int64 curVisualIndex;
-			Float paddingStart =
-				vline.paddingStart != 0.f
-					? vline.paddingStart / mDocView.getWhiteSpaceWidth() * charSpacing
-					: 0.f;
-
-			for ( const auto& token : tokens ) {
-				if ( outOfRange )
-					break;
+	const auto& tokens = mDoc->getHighlighter()->getLine( line, false );
+	const auto& text = mDoc->line( line ).getText();
+	Float charSpacing = layout.charSpacing;
+	Int64 pos = 0;
 
-				if ( !token.len )
-					continue;
+	if ( mDocView.isWrappedLine( line ) ) {
+		bool outOfRange = false;
+		auto vline = mDocView.getVisibleLineInfo( line );
+		size_t curvline = 1;
+		Int64 nextLineCol = vline.visualLines[curvline].column();
+		Int64 lineLength = text.size();
+		Float paddingStart =
+			vline.paddingStart != 0.f
+				? vline.paddingStart / mDocView.getWhiteSpaceWidth() * charSpacing
+				: 0.f;
 
-				if ( *batchSyntaxType != token.type ) {
-					flushBatch( *batchSyntaxType );
-					batchSyntaxType = &token.type;
-				}
+		for ( const auto& token : tokens ) {
+			if ( outOfRange )
+				break;
 
-				curVisualIndex = static_cast<Int64>( vline.visibleIndex ) + curvline - 1;
-				Int64 remainingToken = token.len;
-
-				while ( remainingToken > 0 ) {
-					Int64 maxLength = nextLineCol - pos;
-					Int64 maxPos = pos + std::min( remainingToken, maxLength );
-
-					if ( curVisualIndex >= minimapStartLine ) {
-						for ( auto i = pos; i < maxPos; i++ ) {
-							String::StringBaseType ch = text[i];
-							if ( ch == ' ' || ch == '\n' ) {
-								flushBatch( token.type );
-								batchStart += charSpacing;
-							} else if ( ch == '\t' ) {
-								flushBatch( token.type );
-								batchStart += charSpacing * mMinimapConfig.tabWidth;
-							} else {
-								batchWidth += charSpacing;
-							}
-						}
-					}
+			if ( !token.len )
+				continue;
 
-					remainingToken = remainingToken - ( maxPos - pos );
-					pos = maxPos;
+			if ( *batchSyntaxType != token.type ) {
+				flushBatch( *batchSyntaxType );
+				batchSyntaxType = &token.type;
+			}
 
-					if ( pos == nextLineCol ) {
+			curVisualIndex = static_cast<Int64>( vline.visibleIndex ) + curvline - 1;
+			Int64 remainingToken = token.len;
 
-						if ( curVisualIndex >= minimapStartLine ) {
-							flushBatch( token.type );
-							lineY += lineSpacing;
-						}
+			while ( remainingToken > 0 ) {
+				Int64 maxLength = nextLineCol - pos;
+				Int64 maxPos = pos + std::min( remainingToken, maxLength );
 
-						curvline++;
-						curVisualIndex = static_cast<Int64>( vline.visibleIndex ) + curvline - 1;
-						if ( curvline < vline.visualLines.size() ) {
-							nextLineCol = vline.visualLines[curvline].column();
+				if ( curVisualIndex >= layout.firstRow ) {
+					for ( auto i = pos; i < maxPos; i++ ) {
+						String::StringBaseType ch = text[i];
+						if ( ch == ' ' || ch == '\n' ) {
+							flushBatch( token.type );
+							batchStart += charSpacing;
+						} else if ( ch == '\t' ) {
+							flushBatch( token.type );
+							batchStart += charSpacing * mMinimapConfig.tabWidth;
 						} else {
-							nextLineCol = lineLength;
+							batchWidth += charSpacing;
 						}
+					}
+				}
 
-						batchStart = rect.Left + gutterWidth + paddingStart;
-						batchWidth = 0;
+				remainingToken = remainingToken - ( maxPos - pos );
+				pos = maxPos;
 
-						if ( pos == lineLength )
-							break;
+				if ( pos == nextLineCol ) {
+					if ( curVisualIndex >= layout.firstRow )
+						flushBatch( token.type );
 
-						if ( curVisualIndex > endidx + 1 ) {
-							outOfRange = true;
-							break;
-						}
-					} else if ( !remainingToken ) {
+					curvline++;
+					curVisualIndex = static_cast<Int64>( vline.visibleIndex ) + curvline - 1;
+					lineY = rowY( curVisualIndex );
+					if ( curvline < vline.visualLines.size() ) {
+						nextLineCol = vline.visualLines[curvline].column();
+					} else {
+						nextLineCol = lineLength;
+					}
+
+					batchStart = layout.left + layout.gutterWidth + paddingStart;
+					batchWidth = 0;
+
+					if ( pos == lineLength )
+						break;
+
+					if ( curVisualIndex > layout.lastRow ) {
+						outOfRange = true;
 						break;
 					}
+				} else if ( !remainingToken ) {
+					break;
 				}
 			}
-		} else {
-			Int64 tokenPos = 0;
-			for ( const auto& token : tokens ) {
-				if ( *batchSyntaxType != token.type ) {
-					flushBatch( *batchSyntaxType );
-					batchSyntaxType = &token.type;
+		}
+	} else {
+		Int64 tokenPos = 0;
+		for ( const auto& token : tokens ) {
+			if ( *batchSyntaxType != token.type ) {
+				flushBatch( *batchSyntaxType );
+				batchSyntaxType = &token.type;
+			}
+
+			size_t pos = tokenPos;
+			size_t end = pos + token.len <= text.size() ? tokenPos + token.len : text.size();
+
+			while ( pos < end ) {
+				String::StringBaseType ch = text[pos];
+				if ( ch == ' ' || ch == '\n' ) {
+					flushBatch( token.type );
+					batchStart += charSpacing;
+				} else if ( ch == '\t' ) {
+					flushBatch( token.type );
+					batchStart += charSpacing * mMinimapConfig.tabWidth;
+				} else if ( batchStart + batchWidth > layout.cutoffX ) {
+					flushBatch( token.type );
+					break;
+				} else {
+					batchWidth += charSpacing;
 				}
+				pos++;
+			};
 
-				size_t pos = tokenPos;
-				size_t end = pos + token.len <= text.size() ? tokenPos + token.len : text.size();
+			tokenPos += token.len;
+		}
+	}
 
-				while ( pos < end ) {
-					String::StringBaseType ch = text[pos];
-					if ( ch == ' ' || ch == '\n' ) {
-						flushBatch( token.type );
-						batchStart += charSpacing;
-					} else if ( ch == '\t' ) {
-						flushBatch( token.type );
-						batchStart += charSpacing * mMinimapConfig.tabWidth;
-					} else if ( batchStart + batchWidth > minimapCutoffX ) {
-						flushBatch( token.type );
-						break;
-					} else {
-						batchWidth += charSpacing;
-					}
-					pos++;
-				};
+	flushBatch( SYNTAX_NORMAL );
+}
+
+Uint64 UICodeEditor::getMinimapLineSignature( Int64 line ) {
+	// The signature of the tokens drawn ( the same signature kept by the highlighter for each
+	// tokenized line ), the text and the visual lines of the line
+	const auto& tokens = mDoc->getHighlighter()->getLine( line, false );
+	std::size_t signature =
+		hashCombine( mDoc->line( line ).getHash(), TokenizedLine::calcSignature( tokens ) );
+	if ( mDocView.isWrappedLine( line ) ) {
+		auto vline = mDocView.getVisibleLineInfo( line );
+		signature = hashCombine( signature, std::hash<Float>()( vline.paddingStart ) );
+		for ( const auto& visualLine : vline.visualLines )
+			signature = hashCombine( signature, visualLine.column() );
+	}
+	return signature;
+}
 
-				tokenPos += token.len;
+bool UICodeEditor::updateMinimapCache( const Rectf& rect, const MinimapLinesLayout& layout,
+									   const DocumentLineRange& docLineRange ) {
+	auto& cache = mMinimapCache;
+	if ( cache.failed )
+		return false;
+
+	// One row more than the rows visible plus one row for the partially visible line
+	Int64 ringRows = eefloor( rect.getHeight() / layout.lineSpacing ) + 2;
+	Int64 rowHeight = eeceil( layout.lineSpacing );
+	Sizei size( eeceil( rect.getWidth() ), ringRows * rowHeight );
+	if ( size.getWidth() <= 0 || size.getHeight() <= 0 )
+		return false;
+
+	bool clear = false;
+
+	if ( nullptr == cache.frameBuffer ) {
+		cache.frameBuffer = FrameBuffer::New( size.getWidth(), size.getHeight(), false, false,
+											  false, 4, getUISceneNode()->getWindow() );
+		if ( nullptr == cache.frameBuffer || !cache.frameBuffer->created() ) {
+			eeSAFE_DELETE( cache.frameBuffer );
+			cache.failed = true;
+			return false;
+		}
+		cache.frameBuffer->getTexture()->setFilter( Texture::Filter::Nearest );
+		cache.size = size;
+		clear = true;
+	} else if ( cache.size != size ) {
+		cache.frameBuffer->resize( size.getWidth(), size.getHeight() );
+		cache.size = size;
+		clear = true;
+	}
+
+	if ( clear || cache.charHeight != layout.charHeight ||
+		 cache.charSpacing != layout.charSpacing || cache.lineSpacing != layout.lineSpacing ||
+		 cache.gutterWidth != layout.gutterWidth || cache.tabWidth != mMinimapConfig.tabWidth ||
+		 static_cast<Int64>( cache.rows.size() ) != ringRows ) {
+		cache.charHeight = layout.charHeight;
+		cache.charSpacing = layout.charSpacing;
+		cache.lineSpacing = layout.lineSpacing;
+		cache.rowHeight = rowHeight;
+		cache.gutterWidth = layout.gutterWidth;
+		cache.tabWidth = mMinimapConfig.tabWidth;
+		cache.rows.assign( ringRows, { -1, 0 } );
+		clear = true;
+	}
+
+	MinimapLinesLayout cacheLayout( layout );
+	cacheLayout.left = 0;
+	cacheLayout.top = 0;
+	cacheLayout.ringRows = ringRows;
+	cacheLayout.lineSpacing = rowHeight;
+	cacheLayout.cutoffX = rect.getWidth();
+	cacheLayout.alpha = 255;
+
+	// Find the lines whose rows are not rendered in the frame buffer or changed since rendered
+	std::vector<std::pair<Int64, Int64>> dirtyLines;
+	for ( Int64 line = docLineRange.first; line <= docLineRange.second; line++ ) {
+		if ( !mDocView.isLineVisible( line ) )
+			continue;
+		Int64 first = static_cast<Int64>( mDocView.toVisibleIndex( line ) );
+		Int64 last = static_cast<Int64>( mDocView.toVisibleIndex( line, true ) );
+		Int64 firstRow = eemax( first, layout.firstRow );
+		Int64 lastRow = eemin( last, layout.lastRow );
+		if ( firstRow > lastRow )
+			continue;
+		Uint64 signature = getMinimapLineSignature( line );
+		bool dirty = false;
+		for ( Int64 row = firstRow; row <= lastRow; row++ ) {
+			auto& cached = cache.rows[row % ringRows];
+			Uint64 rowSignature = hashCombine( signature, row - first );
+			if ( cached.first != row || cached.second != rowSignature ) {
+				cached = { row, rowSignature };
+				dirty = true;
 			}
 		}
+		if ( dirty )
+			dirtyLines.emplace_back( line, firstRow );
+	}
+
+	if ( dirtyLines.empty() && !clear )
+		return true;
 
-		flushBatch( SYNTAX_NORMAL );
+	// Scissors and clip planes are in screen coordinates, the frame buffer can't be clipped by them
+	ClippingMask* clippingMask = GLi->getClippingMask();
+	std::vector<Rectf> scissors( clippingMask->getScissorsClipped() );
+	bool planes = !clippingMask->getPlanesClipped().empty();
+	BatchRenderer* BR = GlobalBatchRenderer::instance();
+	BR->draw();
 
-		if ( !wrappedLine )
-			lineY += lineSpacing;
+	if ( !scissors.empty() ) {
+		clippingMask->setScissorsClipped( { scissors.back() } );
+		clippingMask->clipDisable();
 	}
+	if ( planes )
+		GLi->clip2DPlaneDisable();
 
-	for ( auto* plugin : mPlugins ) {
-		plugin->minimapDrawAfter( this, docRange, docViewRange, { rect.Left, lineY },
-								  { rect.getWidth(), charHeight }, charSpacing, gutterWidth,
-								  drawMinimapTextRanges );
-	}
+	cache.frameBuffer->bind();
+	if ( clear )
+		cache.frameBuffer->clear();
 
-	if ( mHighlightTextRange.isValid() && mHighlightTextRange.hasSelection() ) {
-		drawMinimapTextRanges( { mHighlightTextRange },
-							   Color( mMinimapSelectionColor ).blendAlpha( mAlpha ) );
+	BR->setTexture( nullptr );
+	BR->setBlendMode( BlendMode::None() );
+	BR->quadsBegin();
+
+	for ( const auto& dirtyLine : dirtyLines ) {
+		Int64 line = dirtyLine.first;
+		if ( !clear ) {
+			// Clear the rows of the line before rendering it again
+			BR->quadsSetColor( Color::Transparent );
+			Int64 lastRow = eemin( static_cast<Int64>( mDocView.toVisibleIndex( line, true ) ),
+								   layout.lastRow );
+			for ( Int64 row = dirtyLine.second; row <= lastRow; row++ ) {
+				BR->batchQuad( { { 0, static_cast<Float>( ( row % ringRows ) * rowHeight ) },
+								 { rect.getWidth(), static_cast<Float>( rowHeight ) } } );
+			}
+		}
+		drawMinimapLine( line, cacheLayout );
 	}
 
-	if ( mDoc->hasSelection() ) {
-		drawMinimapTextRanges( mDoc->getSelectionsSorted(),
-							   Color( mMinimapSelectionColor ).blendAlpha( mAlpha ) );
+	BR->draw();
+	BR->setBlendMode( BlendMode::Alpha() );
+	cache.frameBuffer->unbind();
+
+	if ( !scissors.empty() ) {
+		Rectf r( scissors.back() );
+		scissors.pop_back();
+		clippingMask->setScissorsClipped( scissors );
+		clippingMask->clipEnable( r.Left, r.Top, r.getWidth(), r.getHeight() );
+	}
+	if ( planes ) {
+		const Rectf& r = clippingMask->getPlanesClipped().back();
+		GLi->clip2DPlaneEnable( r.Left, r.Top, r.getWidth(), r.getHeight() );
 	}
 
-	for ( size_t i = 0; i < mDoc->getSelections().size(); ++i ) {
-		const auto& selection = mDoc->getSelectionIndex( i );
-		if ( mDocView.isFolded( selection.start().line(), true ) )
+	return true;
+}
+
+void UICodeEditor::drawMinimapCache( const Rectf& rect, const MinimapLinesLayout& layout ) {
+	const auto& cache = mMinimapCache;
+	Int64 ringRows = cache.rows.size();
+	Int64 rowsCount = layout.lastRow - layout.firstRow + 1;
+	if ( rowsCount <= 0 || ringRows == 0 )
+		return;
+
+	// The visible rows are at most two segments of the ring
+	Int64 firstSlot = layout.firstRow % ringRows;
+	Int64 firstSegment = eemin( rowsCount, ringRows - firstSlot );
+	Color color( Color::White );
+	color.a = static_cast<Uint8>( layout.alpha );
+	const auto drawSegment = [&]( Int64 slot, Int64 rows, Float y ) {
+		// Scaled back to the line spacing if it had to be rounded up in the frame buffer
+		Rect src( 0, slot * cache.rowHeight, cache.size.getWidth(),
+				  ( slot + rows ) * cache.rowHeight );
+		TextureRegion textureRegion( cache.frameBuffer->getTexture(), src,
+									 Sizef( cache.size.getWidth(), rows * layout.lineSpacing ) );
+		textureRegion.draw( rect.Left, y, color );
+	};
+
+	drawSegment( firstSlot, firstSegment, rect.Top );
+	if ( rowsCount > firstSegment )
+		drawSegment( 0, rowsCount - firstSegment,
+					 rect.Top + firstSegment * layout.lineSpacing );
+
+	BatchRenderer* BR = GlobalBatchRenderer::instance();
+	BR->setTexture( nullptr );
+	BR->setBlendMode( BlendMode::Alpha() );
+	BR->quadsBegin();
+}
+
+void UICodeEditor::invalidateMinimapCache() {
+	mMinimapCache.rows.clear();
+}
+
+const TextRanges& UICodeEditor::getMinimapWordMatches( const String& text,
+													   const DocumentLineRange& docLineRange ) {
+	auto& matches = mMinimapWordMatches;
+	if ( matches.text == text && matches.modificationId == mDoc->getModificationId() &&
+		 matches.lineRange == docLineRange )
+		return matches.ranges;
+
+	matches.text = text;
+	matches.modificationId = mDoc->getModificationId();
+	matches.lineRange = docLineRange;
+	matches.ranges.clear();
+
+	for ( Int64 ln = docLineRange.first; ln <= docLineRange.second; ln++ ) {
+		if ( !mDocView.isLineVisible( ln ) )
 			continue;
-		Float selectionY =
-			rect.Top +
-			( static_cast<Int64>( mDocView.getVisibleLineRange( selection.start() ).visibleIndex ) -
-			  minimapStartLine ) *
-				lineSpacing;
-		BR->quadsSetColor( Color( mMinimapCurrentLineColor ).blendAlpha( mAlpha ) );
-		BR->batchQuad( { { rect.Left, selectionY }, { rect.getWidth(), lineSpacing } } );
+		const String& line( mDoc->line( ln ).getText() );
+		if ( line.size() > 300 )
+			continue;
+		size_t pos = 0;
+		while ( ( pos = line.find( text, pos ) ) != String::InvalidPos ) {
+			Int64 endCol = pos + text.size();
+			matches.ranges.push_back( { { ln, static_cast<Int64>( pos ) }, { ln, endCol } } );
+			pos = endCol;
+		}
 	}
 
-	BR->draw();
+	matches.ranges.setSorted();
+	return matches.ranges;
 }
 
 Vector2f UICodeEditor::getScreenStart() const {
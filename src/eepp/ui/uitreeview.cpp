@@ -1,4 +1,3 @@
-#include <deque>
 #include <eepp/graphics/renderer/renderer.hpp>
 #include <eepp/system/lock.hpp>
 #include <eepp/system/scopedop.hpp>
@@ -44,44 +43,168 @@ UITreeView::MetadataForIndex& UITreeView::getIndexMetadata( const ModelIndex& in
 	return mViewMetadata[index.internalData()];
 }
 
-UITreeView::IterationDecision UITreeView::traverseIndex( TraverseTreeVars& v,
-														 const ModelIndex& index ) const {
-	if ( index.isValid() ) {
-		const auto& metadata = getIndexMetadata( index );
-		v.rowIndex++;
-		IterationDecision decision = v.callback( v.rowIndex, index, v.indentLevel, v.yOffset );
-		if ( decision == IterationDecision::Break || decision == IterationDecision::Stop )
-			return decision;
-		v.yOffset += v.rowHeight;
-		if ( !metadata.open ) {
-			return IterationDecision::Continue;
+void UITreeView::appendVisibleRows( std::vector<VisibleRow>& rows, const ModelIndex& parent,
+									const Uint32& depth ) const {
+	const Model& model = *getModel();
+	size_t rowCount = model.rowCount( parent );
+	for ( size_t i = 0; i < rowCount; ++i ) {
+		ModelIndex index( model.index( i, model.treeColumn(), parent ) );
+		if ( !index.isValid() )
+			continue;
+		rows.push_back( { index, depth, 0 } );
+		auto it = mViewMetadata.find( index.internalData() );
+		if ( it != mViewMetadata.end() && it->second.open ) {
+			size_t pos = rows.size() - 1;
+			rows[pos].childCount = model.rowCount( index );
+			appendVisibleRows( rows, index, depth + 1 );
 		}
 	}
-	if ( v.indentLevel >= 0 && !index.isValid() )
-		return IterationDecision::Continue;
-	++v.indentLevel;
-	int rowCount = v.model.rowCount( index );
-	for ( int i = 0; i < rowCount; ++i ) {
-		IterationDecision decision =
-			traverseIndex( v, v.model.index( i, v.model.treeColumn(), index ) );
-		if ( decision == IterationDecision::Break || decision == IterationDecision::Stop )
-			return decision;
+}
+
+const std::vector<UITreeView::VisibleRow>& UITreeView::getVisibleRows() const {
+	if ( mVisibleRowsDirty ) {
+		mVisibleRowsDirty = false;
+		mVisibleRows.clear();
+		mVisibleRowsLookupDirty = true;
+		if ( getModel() ) {
+			Lock l( const_cast<Model*>( getModel() )->resourceMutex() );
+			appendVisibleRows( mVisibleRows, {}, 0 );
+		}
+	}
+	return mVisibleRows;
+}
+
+void UITreeView::invalidateVisibleRows() {
+	mVisibleRowsDirty = true;
+}
+
+void UITreeView::updateVisibleRowChildren( const Int64& row ) const {
+	// Replaces the rows below the row ( its visible descendants ) with its current children
+	Uint32 depth = mVisibleRows[row].depth;
+	size_t end = row + 1;
+	while ( end < mVisibleRows.size() && mVisibleRows[end].depth > depth )
+		++end;
+
+	std::vector<VisibleRow> children;
+	const ModelIndex& index = mVisibleRows[row].index;
+	auto it = mViewMetadata.find( index.internalData() );
+	mVisibleRows[row].childCount = 0;
+	if ( it != mViewMetadata.end() && it->second.open ) {
+		mVisibleRows[row].childCount = getModel()->rowCount( index );
+		appendVisibleRows( children, index, depth + 1 );
+	}
+
+	size_t oldCount = end - row - 1;
+	if ( children.size() == oldCount ) {
+		std::move( children.begin(), children.end(), mVisibleRows.begin() + row + 1 );
+	} else {
+		mVisibleRows.erase( mVisibleRows.begin() + row + 1, mVisibleRows.begin() + end );
+		mVisibleRows.insert( mVisibleRows.begin() + row + 1,
+							 std::make_move_iterator( children.begin() ),
+							 std::make_move_iterator( children.end() ) );
+	}
+	mVisibleRowsLookupDirty = true;
+}
+
+bool UITreeView::syncVisibleRows( const Int64& fromRow, const Int64& toRow ) const {
+	// Models can load the children of an expanded index asynchronously ( without invalidating
+	// the model ), the rows in range are checked so they're displayed as soon as they're loaded
+	bool changed = false;
+	for ( Int64 row = fromRow; row < toRow && row < (Int64)mVisibleRows.size(); ++row ) {
+		const auto& visibleRow = mVisibleRows[row];
+		auto it = mViewMetadata.find( visibleRow.index.internalData() );
+		if ( it != mViewMetadata.end() && it->second.open &&
+			 getModel()->rowCount( visibleRow.index ) != visibleRow.childCount ) {
+			updateVisibleRowChildren( row );
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+void UITreeView::setIndexOpen( const ModelIndex& index, bool open ) {
+	auto& metadata = getIndexMetadata( index );
+	if ( metadata.open == open )
+		return;
+	metadata.open = open;
+	if ( mVisibleRowsDirty )
+		return;
+	Int64 row = getVisibleRowIndex( index );
+	if ( row >= 0 ) {
+		ConditionalLock l( getModel() != nullptr,
+						   getModel() ? &getModel()->resourceMutex() : nullptr );
+		updateVisibleRowChildren( row );
+	}
+}
+
+size_t UITreeView::getVisibleRowCount() const {
+	return getVisibleRows().size();
+}
+
+Int64 UITreeView::getVisibleRowIndex( const ModelIndex& index ) const {
+	if ( !index.isValid() )
+		return -1;
+	const auto& rows = getVisibleRows();
+	Int64 count = rows.size();
+
+	// Navigation and selection mostly look for rows next to the last one found
+	Int64 from = eemax<Int64>( 0, mVisibleRowHint - 32 );
+	Int64 to = eemin<Int64>( count, mVisibleRowHint + 32 );
+	for ( Int64 row = from; row < to; ++row ) {
+		if ( rows[row].index == index ) {
+			mVisibleRowHint = row;
+			return row;
+		}
+	}
+
+	if ( mVisibleRowsLookupDirty ) {
+		mVisibleRowsLookupDirty = false;
+		mVisibleRowsLookup.clear();
+		mVisibleRowsLookup.reserve( count );
+		for ( Int64 row = 0; row < count; ++row )
+			mVisibleRowsLookup[rows[row].index] = row;
 	}
-	--v.indentLevel;
-	return IterationDecision::Continue;
+
+	auto it = mVisibleRowsLookup.find( index );
+	if ( it == mVisibleRowsLookup.end() )
+		return -1;
+	mVisibleRowHint = it->second;
+	return it->second;
+}
+
+ModelIndex UITreeView::getVisibleRowModelIndex( const Int64& row ) const {
+	const auto& rows = getVisibleRows();
+	if ( row < 0 || row >= (Int64)rows.size() )
+		return {};
+	return rows[row].index;
+}
+
+Int64 UITreeView::getVisibleRowAt( const Float& yOffset ) const {
+	Float rowHeight = getRowHeight();
+	if ( rowHeight <= 0 || yOffset < getHeaderHeight() )
+		return -1;
+	Int64 row = static_cast<Int64>( ( yOffset - getHeaderHeight() ) / rowHeight );
+	return row < (Int64)getVisibleRows().size() ? row : -1;
+}
+
+Int64 UITreeView::getFirstDrawableRow() const {
+	Float rowHeight = getRowHeight();
+	if ( rowHeight <= 0 )
+		return 0;
+	return eemax<Int64>( 0, eefloor( ( mScrollOffset.y - getHeaderHeight() ) / rowHeight ) - 1 );
 }
 
 void UITreeView::traverseTree( TreeViewCallback callback ) const {
 	if ( !getModel() )
 		return;
 	Lock l( const_cast<Model*>( getModel() )->resourceMutex() );
-	TraverseTreeVars v{
-		std::move( callback ), *getModel(), 0, getHeaderHeight(), -1, getRowHeight(),
-	};
-	int rootCount = v.model.rowCount();
-	for ( int rootIndex = 0; rootIndex < rootCount; ++rootIndex ) {
-		IterationDecision decision =
-			traverseIndex( v, v.model.index( rootIndex, v.model.treeColumn(), ModelIndex() ) );
+	const auto& rows = getVisibleRows();
+	Float rowHeight = getRowHeight();
+	Float yOffset = getHeaderHeight();
+	int count = rows.size();
+	for ( int rowIndex = 0; rowIndex < count; ++rowIndex, yOffset += rowHeight ) {
+		const auto& row = rows[rowIndex];
+		IterationDecision decision = callback( rowIndex, row.index, row.depth, yOffset );
 		if ( decision == IterationDecision::Break || decision == IterationDecision::Stop )
 			break;
 	}
@@ -95,12 +218,7 @@ void UITreeView::createOrUpdateColumns( bool resetColumnData ) {
 }
 
 size_t UITreeView::getItemCount() const {
-	size_t count = 0;
-	traverseTree( [&count]( const int&, const ModelIndex&, const size_t&, const Float& ) {
-		count++;
-		return IterationDecision::Continue;
-	} );
-	return count;
+	return getVisibleRows().size();
 }
 
 void UITreeView::onColumnSizeChange( const size_t& colIndex, bool fromUserInteraction ) {
@@ -108,6 +226,12 @@ void UITreeView::onColumnSizeChange( const size_t& colIndex, bool fromUserIntera
 	updateContentSize();
 }
 
+void UITreeView::onModelUpdate( unsigned flags ) {
+	// The model indexes can't be trusted anymore, even if the view is updated later
+	invalidateVisibleRows();
+	UIAbstractTableView::onModelUpdate( flags );
+}
+
 void UITreeView::updateContentSize() {
 	Sizef oldSize( mContentSize );
 	mContentSize = UIAbstractTableView::getContentSize();
@@ -120,10 +244,10 @@ void UITreeView::bindNavigationClick( UIWidget* widget ) {
 		ConditionalLock l( getModel() != nullptr,
 						   getModel() ? &getModel()->resourceMutex() : nullptr );
 		if ( getModel()->rowCount( idx ) ) {
-			auto& data = getIndexMetadata( idx );
-			data.open = !data.open;
+			bool open = !getIndexMetadata( idx ).open;
+			setIndexOpen( idx, open );
 			createOrUpdateColumns( false );
-			onOpenTreeModelIndex( idx, data.open );
+			onOpenTreeModelIndex( idx, open );
 		} else {
 			onOpenModelIndex( idx, event );
 		}
@@ -162,12 +286,11 @@ bool UITreeView::tryOpenModelIndex( const ModelIndex& index, bool forceUpdate )
 		hasChilds = getModel()->hasChilds( index );
 	}
 	if ( hasChilds ) {
-		auto& data = getIndexMetadata( index );
-		if ( !data.open ) {
-			data.open = true;
+		if ( !getIndexMetadata( index ).open ) {
+			setIndexOpen( index, true );
 			if ( forceUpdate )
 				createOrUpdateColumns( false );
-			onOpenTreeModelIndex( index, data.open );
+			onOpenTreeModelIndex( index, true );
 		}
 		return true;
 	}
@@ -198,10 +321,10 @@ UIWidget* UITreeView::setupCell( UITableCell* widget, UIWidget* rowWidget,
 								   getModel() ? &getModel()->resourceMutex() : nullptr );
 				auto idx = mouseEvent->getNode()->getParent()->asType<UITableRow>()->getCurIndex();
 				if ( getModel()->hasChilds( idx ) ) {
-					auto& data = getIndexMetadata( idx );
-					data.open = !data.open;
+					bool open = !getIndexMetadata( idx ).open;
+					setIndexOpen( idx, open );
 					createOrUpdateColumns( false );
-					onOpenTreeModelIndex( idx, data.open );
+					onOpenTreeModelIndex( idx, open );
 				}
 			}
 		} );
@@ -325,55 +448,62 @@ Sizef UITreeView::getContentSize() const {
 	return mContentSize;
 }
 
-struct DrawTraverseTreeVars {
-	UITreeView* tree;
-	int realRowIndex = 0;
-	int realColIndex = 0;
-	Float rowHeight = 0;
-};
-
 void UITreeView::drawChilds() {
-	DrawTraverseTreeVars v{ this, 0, 0, getRowHeight() }; // To avoid allocating the lambda
+	if ( getModel() ) {
+		Lock l( getModel()->resourceMutex() );
+		const auto& rows = getVisibleRows();
+		Float rowHeight = getRowHeight();
+		Int64 firstRow = getFirstDrawableRow();
+		Int64 lastRow = firstRow + eeceil( mSize.getHeight() / rowHeight ) + 2;
+
+		if ( syncVisibleRows( firstRow, lastRow ) ) {
+			runOnMainThread( [this] { updateContentSize(); } );
+		}
 
-	traverseTree( [this, &v]( const int&, const ModelIndex& index, const size_t& indentLevel,
-							  const Float& yOffset ) {
-		if ( yOffset - mScrollOffset.y > mSize.getHeight() )
-			return IterationDecision::Stop;
-		if ( yOffset - mScrollOffset.y + v.rowHeight < 0 )
-			return IterationDecision::Continue;
-		Float xOffset = 0;
-		UITableRow* rowNode = updateRow( v.realRowIndex, index, yOffset );
-		rowNode->setChildsVisibility( false, false );
-		v.realColIndex = 0;
-		for ( size_t colIndex = 0; colIndex < getModel()->columnCount(); colIndex++ ) {
-			auto& colData = columnData( colIndex );
-			if ( !colData.visible || ( xOffset + colData.width ) - mScrollOffset.x < 0 ) {
-				if ( colData.visible )
-					xOffset += colData.width;
-				continue;
-			}
-			if ( xOffset - mScrollOffset.x > mSize.getWidth() )
+		int realRowIndex = 0;
+		Int64 count = rows.size();
+		Float yOffset = getHeaderHeight() + firstRow * rowHeight;
+
+		for ( Int64 row = firstRow; row < count; ++row, yOffset += rowHeight ) {
+			if ( yOffset - mScrollOffset.y > mSize.getHeight() )
 				break;
-			xOffset += colData.width;
-			if ( (Int64)colIndex != index.column() ) {
-				updateCell( { v.realColIndex, v.realRowIndex },
-							getModel()->index( index.row(), colIndex, index.parent() ), indentLevel,
-							yOffset );
-			} else {
-				auto* cell =
-					updateCell( { v.realColIndex, v.realRowIndex }, index, indentLevel, yOffset );
+			if ( yOffset - mScrollOffset.y + rowHeight < 0 )
+				continue;
+			const ModelIndex& index = rows[row].index;
+			const size_t indentLevel = rows[row].depth;
+			Float xOffset = 0;
+			UITableRow* rowNode = updateRow( realRowIndex, index, yOffset );
+			rowNode->setChildsVisibility( false, false );
+			int realColIndex = 0;
+			for ( size_t colIndex = 0; colIndex < getModel()->columnCount(); colIndex++ ) {
+				auto& colData = columnData( colIndex );
+				if ( !colData.visible || ( xOffset + colData.width ) - mScrollOffset.x < 0 ) {
+					if ( colData.visible )
+						xOffset += colData.width;
+					continue;
+				}
+				if ( xOffset - mScrollOffset.x > mSize.getWidth() )
+					break;
+				xOffset += colData.width;
+				if ( (Int64)colIndex != index.column() ) {
+					updateCell( { realColIndex, realRowIndex },
+								getModel()->index( index.row(), colIndex, index.parent() ),
+								indentLevel, yOffset );
+				} else {
+					auto* cell =
+						updateCell( { realColIndex, realRowIndex }, index, indentLevel, yOffset );
 
-				if ( mFocusSelectionDirty && index == getSelection().first() ) {
-					cell->setFocus();
-					mFocusSelectionDirty = false;
+					if ( mFocusSelectionDirty && index == getSelection().first() ) {
+						cell->setFocus();
+						mFocusSelectionDirty = false;
+					}
 				}
+				realColIndex++;
 			}
-			v.realColIndex++;
+			rowNode->nodeDraw();
+			realRowIndex++;
 		}
-		rowNode->nodeDraw();
-		v.realRowIndex++;
-		return IterationDecision::Continue;
-	} );
+	}
 
 	if ( mHeader && mHeader->isVisible() )
 		mHeader->nodeDraw();
@@ -383,13 +513,6 @@ void UITreeView::drawChilds() {
 		mVScroll->nodeDraw();
 }
 
-struct OverFindTraverseTreeVars {
-	UITreeView* tree;
-	int realIndex;
-	Vector2f point;
-	Float rowHeight;
-};
-
 Node* UITreeView::overFind( const Vector2f& point ) {
 	ScopedOp op( [this] { mUISceneNode->setIsLoading( true ); },
 				 [this] { mUISceneNode->setIsLoading( false ); } );
@@ -405,21 +528,25 @@ Node* UITreeView::overFind( const Vector2f& point ) {
 				return pOver;
 			if ( mHeader && ( pOver = mHeader->overFind( point ) ) )
 				return pOver;
-			int realIndex = 0;
-			Float rowHeight = getRowHeight();
-			OverFindTraverseTreeVars v{ this, realIndex, point, rowHeight };
-			traverseTree(
-				[&v, &pOver]( int, const ModelIndex& index, const size_t&, const Float& yOffset ) {
-					if ( yOffset - v.tree->mScrollOffset.y > v.tree->mSize.getHeight() )
-						return IterationDecision::Stop;
-					if ( yOffset - v.tree->mScrollOffset.y + v.rowHeight < 0 )
-						return IterationDecision::Continue;
-					pOver = v.tree->updateRow( v.realIndex, index, yOffset )->overFind( v.point );
-					v.realIndex++;
+			if ( getModel() ) {
+				Lock l( getModel()->resourceMutex() );
+				const auto& rows = getVisibleRows();
+				Float rowHeight = getRowHeight();
+				Int64 firstRow = getFirstDrawableRow();
+				Int64 count = rows.size();
+				Float yOffset = getHeaderHeight() + firstRow * rowHeight;
+				int realIndex = 0;
+				for ( Int64 row = firstRow; row < count; ++row, yOffset += rowHeight ) {
+					if ( yOffset - mScrollOffset.y > mSize.getHeight() )
+						break;
+					if ( yOffset - mScrollOffset.y + rowHeight < 0 )
+						continue;
+					pOver = updateRow( realIndex, rows[row].index, yOffset )->overFind( point );
+					realIndex++;
 					if ( pOver )
-						return IterationDecision::Stop;
-					return IterationDecision::Continue;
-				} );
+						break;
+				}
+			}
 			if ( !pOver )
 				pOver = this;
 		}
@@ -440,7 +567,7 @@ void UITreeView::setExpanded( const std::vector<ModelIndex>& indexes, bool expan
 			continue;
 		size_t count = model.rowCount( index );
 		if ( count )
-			getIndexMetadata( index ).open = expanded;
+			setIndexOpen( index, expanded );
 	}
 	createOrUpdateColumns( false );
 }
@@ -464,6 +591,7 @@ void UITreeView::expandAll( const ModelIndex& index ) {
 	if ( !getModel() )
 		return;
 	setAllExpanded( index, true );
+	invalidateVisibleRows();
 	createOrUpdateColumns( false );
 }
 
@@ -471,6 +599,7 @@ void UITreeView::collapseAll( const ModelIndex& index ) {
 	if ( !getModel() )
 		return;
 	setAllExpanded( index, false );
+	invalidateVisibleRows();
 	createOrUpdateColumns( false );
 }
 
@@ -550,76 +679,40 @@ Uint32 UITreeView::onKeyDown( const KeyEvent& event ) {
 	switch ( event.getKeyCode() ) {
 		case KEY_PAGEUP: {
 			int pageSize = eefloor( getVisibleArea().getHeight() / getRowHeight() ) - 1;
-			std::deque<std::pair<ModelIndex, Float>> deque;
-			Float curY;
-			traverseTree(
-				[&]( const int&, const ModelIndex& index, const size_t&, const Float& offsetY ) {
-					deque.push_back( { index, offsetY } );
-					if ( (int)deque.size() > pageSize )
-						deque.pop_front();
-					if ( index == curIndex )
-						return IterationDecision::Break;
-					return IterationDecision::Continue;
-				} );
-			curY = deque.front().second - getHeaderHeight();
-			getSelection().set( deque.front().first );
-			scrollToPosition(
-				{ { mScrollOffset.x, curY },
-				  { columnData( deque.front().first.column() ).width, getRowHeight() } } );
+			Int64 count = getVisibleRowCount();
+			if ( count == 0 )
+				return 1;
+			Int64 curRow = getVisibleRowIndex( curIndex );
+			if ( curRow < 0 )
+				curRow = count - 1;
+			Int64 row = eemax<Int64>( 0, curRow - eemax( 1, pageSize ) + 1 );
+			ModelIndex foundIndex( getVisibleRowModelIndex( row ) );
+			Float curY = row * getRowHeight();
+			getSelection().set( foundIndex );
+			scrollToPosition( { { mScrollOffset.x, curY },
+								{ columnData( foundIndex.column() ).width, getRowHeight() } } );
 			return 1;
 		}
 		case KEY_PAGEDOWN: {
 			int pageSize = eefloor( getVisibleArea().getHeight() / getRowHeight() ) - 1;
-			int counted = 0;
-			bool foundStart = false;
-			bool resultFound = false;
-			ModelIndex foundIndex;
-			Float curY = 0;
-			Float lastOffsetY = 0;
-			ModelIndex lastIndex;
-			traverseTree(
-				[&]( const int&, const ModelIndex& index, const size_t&, const Float& offsetY ) {
-					if ( index == curIndex ) {
-						foundStart = true;
-					} else if ( foundStart ) {
-						counted++;
-						if ( counted == pageSize ) {
-							foundIndex = index;
-							curY = offsetY;
-							resultFound = true;
-							return IterationDecision::Break;
-						}
-					}
-					lastOffsetY = offsetY;
-					lastIndex = index;
-					return IterationDecision::Continue;
-				} );
-			if ( !resultFound ) {
-				foundIndex = lastIndex;
-				curY = lastOffsetY;
-			}
-			curY += getRowHeight();
+			Int64 count = getVisibleRowCount();
+			if ( count == 0 )
+				return 1;
+			Int64 curRow = getVisibleRowIndex( curIndex );
+			Int64 row = curRow < 0 ? count - 1
+								   : eemin<Int64>( count - 1, curRow + eemax( 1, pageSize ) );
+			ModelIndex foundIndex( getVisibleRowModelIndex( row ) );
+			Float curY = getHeaderHeight() + row * getRowHeight() + getRowHeight();
 			getSelection().set( foundIndex );
 			scrollToPosition( { { mScrollOffset.x, curY },
 								{ columnData( foundIndex.column() ).width, getRowHeight() } } );
 			return 1;
 		}
 		case KEY_UP: {
-			ModelIndex prevIndex;
-			ModelIndex foundIndex;
-			Float curY = 0;
-			traverseTree(
-				[&]( const int&, const ModelIndex& index, const size_t&, const Float& offsetY ) {
-					if ( index == curIndex ) {
-						foundIndex = prevIndex;
-						curY = offsetY;
-						return IterationDecision::Break;
-					}
-					prevIndex = index;
-					return IterationDecision::Continue;
-				} );
-			if ( foundIndex.isValid() ) {
-				getSelection().set( foundIndex );
+			Int64 curRow = getVisibleRowIndex( curIndex );
+			if ( curRow > 0 ) {
+				Float curY = getHeaderHeight() + curRow * getRowHeight();
+				getSelection().set( getVisibleRowModelIndex( curRow - 1 ) );
 				if ( curY < mScrollOffset.y + getHeaderHeight() + getRowHeight() ||
 					 curY > mScrollOffset.y + getPixelsSize().getHeight() - mPaddingPx.Top -
 								mPaddingPx.Bottom - getRowHeight() ) {
@@ -631,21 +724,10 @@ Uint32 UITreeView::onKeyDown( const KeyEvent& event ) {
 			return 1;
 		}
 		case KEY_DOWN: {
-			ModelIndex prevIndex;
-			ModelIndex foundIndex;
-			Float curY = 0;
-			traverseTree(
-				[&]( const int&, const ModelIndex& index, const size_t&, const Float& offsetY ) {
-					if ( prevIndex == curIndex ) {
-						foundIndex = index;
-						curY = offsetY;
-						return IterationDecision::Break;
-					}
-					prevIndex = index;
-					return IterationDecision::Continue;
-				} );
-			if ( foundIndex.isValid() ) {
-				getSelection().set( foundIndex );
+			Int64 curRow = getVisibleRowIndex( curIndex );
+			if ( curRow >= 0 && curRow + 1 < (Int64)getVisibleRowCount() ) {
+				Float curY = getHeaderHeight() + ( curRow + 1 ) * getRowHeight();
+				getSelection().set( getVisibleRowModelIndex( curRow + 1 ) );
 				if ( curY < mScrollOffset.y ||
 					 curY > mScrollOffset.y + getPixelsSize().getHeight() - mPaddingPx.Top -
 								mPaddingPx.Bottom - getRowHeight() ) {
@@ -660,12 +742,8 @@ Uint32 UITreeView::onKeyDown( const KeyEvent& event ) {
 		}
 		case KEY_END: {
 			scrollToBottom();
-			ModelIndex lastIndex;
-			traverseTree( [&]( const int&, const ModelIndex& index, const size_t&, const Float& ) {
-				lastIndex = index;
-				return IterationDecision::Continue;
-			} );
-			getSelection().set( lastIndex );
+			Int64 count = getVisibleRowCount();
+			getSelection().set( getVisibleRowModelIndex( count - 1 ) );
 			return 1;
 		}
 		case KEY_HOME: {
@@ -675,9 +753,8 @@ Uint32 UITreeView::onKeyDown( const KeyEvent& event ) {
 		}
 		case KEY_RIGHT: {
 			if ( curIndex.isValid() && getModel()->rowCount( curIndex ) ) {
-				auto& metadata = getIndexMetadata( curIndex );
-				if ( !metadata.open ) {
-					metadata.open = true;
+				if ( !getIndexMetadata( curIndex ).open ) {
+					setIndexOpen( curIndex, true );
 					createOrUpdateColumns( false );
 					return 0;
 				}
@@ -687,9 +764,8 @@ Uint32 UITreeView::onKeyDown( const KeyEvent& event ) {
 		}
 		case KEY_LEFT: {
 			if ( curIndex.isValid() && getModel()->rowCount( curIndex ) ) {
-				auto& metadata = getIndexMetadata( curIndex );
-				if ( metadata.open ) {
-					metadata.open = false;
+				if ( getIndexMetadata( curIndex ).open ) {
+					setIndexOpen( curIndex, false );
 					createOrUpdateColumns( false );
 					return 0;
 				}
@@ -704,8 +780,7 @@ Uint32 UITreeView::onKeyDown( const KeyEvent& event ) {
 		case KEY_KP_ENTER: {
 			if ( curIndex.isValid() ) {
 				if ( getModel()->rowCount( curIndex ) ) {
-					auto& metadata = getIndexMetadata( curIndex );
-					metadata.open = !metadata.open;
+					setIndexOpen( curIndex, !getIndexMetadata( curIndex ).open );
 					createOrUpdateColumns( false );
 				} else {
 					onOpenModelIndex( curIndex, &event );
@@ -742,6 +817,7 @@ void UITreeView::setDisableCellClipping( bool disableCellClipping ) {
 
 void UITreeView::clearViewMetadata() {
 	mViewMetadata.clear();
+	invalidateVisibleRows();
 }
 
 void UITreeView::onSortColumn( const size_t& ) {
@@ -833,21 +909,10 @@ void UITreeView::setSelection( const ModelIndex& index, bool scrollToSelection,
 		if ( !scrollToSelection )
 			return;
 
-		ModelIndex prevIndex;
-		ModelIndex foundIndex;
-		Float curY = 0;
-		traverseTree(
-			[&]( const int&, const ModelIndex& _index, const size_t&, const Float& offsetY ) {
-				if ( index == _index ) {
-					foundIndex = prevIndex;
-					curY = offsetY;
-					return IterationDecision::Break;
-				}
-				prevIndex = index;
-				return IterationDecision::Continue;
-			} );
+		Int64 row = getVisibleRowIndex( index );
 
-		if ( foundIndex.isValid() ) {
+		if ( row > 0 ) {
+			Float curY = getHeaderHeight() + row * getRowHeight();
 			if ( curY < mScrollOffset.y + getHeaderHeight() + getRowHeight() ||
 				 curY > mScrollOffset.y + getPixelsSize().getHeight() - mPaddingPx.Top -
 							mPaddingPx.Bottom - getRowHeight() ) {
@@ -45,6 +45,10 @@ class IPseudoTerminal : public eterm::System::IPipe {
 	virtual int getNumRows() const = 0;
 
 	virtual bool resize( int columns, int rows ) = 0;
+
+	/** Waits up to timeoutMs milliseconds for output to read.
+	 * @return 1 if there's output to read, 0 on timeout and -1 if the pseudoterminal was closed */
+	virtual int waitForInput( int timeoutMs ) = 0;
 };
 
 }} // namespace eterm::Terminal
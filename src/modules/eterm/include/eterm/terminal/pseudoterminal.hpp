@@ -57,6 +57,7 @@ class PseudoTerminal final : public IPseudoTerminal {
 	virtual bool resize( int columns, int rows ) override;
 	virtual int write( const char* s, size_t n ) override;
 	virtual int read( char* buf, size_t n, bool block = false ) override;
+	virtual int waitForInput( int timeoutMs ) override;
 
 	static std::unique_ptr<PseudoTerminal> create( int columns, int rows );
 
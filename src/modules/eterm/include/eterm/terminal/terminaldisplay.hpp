@@ -298,6 +298,7 @@ class TerminalDisplay : public ITerminalDisplay {
 	Uint32 mColumns{ 0 };
 	Uint32 mRows{ 0 };
 	Uint32 mClickStep{ 5 };
+	int mHistorySize{ 0 };
 	FrameBuffer* mFrameBuffer{ nullptr };
 	VertexBuffer* mVBBackground{ nullptr };
 	VertexBuffer* mVBForeground{ nullptr };
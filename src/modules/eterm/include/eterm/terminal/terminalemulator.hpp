@@ -35,15 +35,23 @@
 //  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
 //  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 //  DEALINGS IN THE SOFTWARE.
+#include <atomic>
+#include <condition_variable>
 #include <eepp/math/vector2.hpp>
+#include <eepp/system/mutex.hpp>
+#include <eepp/system/thread.hpp>
 #include <eepp/window/keycodes.hpp>
 #include <eterm/system/iprocess.hpp>
 #include <eterm/terminal/ipseudoterminal.hpp>
 #include <eterm/terminal/iterminaldisplay.hpp>
+#include <eterm/terminal/terminalhistory.hpp>
 #include <eterm/terminal/terminaltypes.hpp>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <stdint.h>
 #include <sys/types.h>
+#include <vector>
 
 using namespace EE;
 using namespace EE::Math;
@@ -63,10 +71,6 @@ struct Term {
 	int col{ 0 };				   /* nb col */
 	Line* line{ nullptr };		   /* screen */
 	Line* alt{ nullptr };		   /* alternate screen */
-	Line* hist{ nullptr };		   /* history buffer */
-	int histcursize{ 0 };		   /* history current size */
-	int histsize{ 0 };			   /* history max size */
-	int histi{ 0 };				   /* history index */
 	int scr{ 0 };				   /* scroll back */
 	int* dirty{ nullptr };		   /* dirtyness of lines */
 	TerminalCursor c{};			   /* cursor */
@@ -137,7 +141,9 @@ class TerminalEmulator final {
 
 	void logError( const char* err );
 
-	/** @return If the tty read was completed or there's still buffer to read (true completed) */
+	/** The pty is read and parsed by a dedicated thread, update takes a snapshot of the lines
+	 * modified since the last update and forwards them to the display.
+	 * @return If the tty read was completed or there's still buffer to read (true completed) */
 	bool update();
 
 	void terminate();
@@ -197,7 +203,7 @@ class TerminalEmulator final {
 	void mousereport( const TerminalMouseEventType& type, const Vector2i& pos, const Uint32& flags,
 					  const Uint32& mod );
 
-	const bool& isDirty() const { return mDirty; }
+	bool isDirty() const { return mDirty; }
 
 	void setPtyAndProcess( PtyPtr&& pty, ProcPtr&& process );
 
@@ -219,12 +225,29 @@ class TerminalEmulator final {
 
 	void clearHistory();
 
+	/** @return The approximate number of bytes used by the scrollback history */
+	size_t getHistoryMemoryUsage() const;
+
+	/** Continues an incremental search in the scrollback history, searching up to maxLines lines.
+	 * @return True if the whole history has been searched */
+	bool searchHistory( TerminalHistorySearch& search, size_t maxLines = 1000 );
+
+	/** Scrolls the history to show the line of the match at the top of the screen.
+	 * @return False if the line is not in the history anymore */
+	bool scrollToHistoryMatch( const TerminalHistoryMatch& match );
+
 	int scrollPos();
 
 	bool getAllowMemoryTrimnming() const;
 
 	void setAllowMemoryTrimnming( bool allowMemoryTrimnming );
 
+	/** Runs of printable ASCII characters are stored directly in the line cells instead of being
+	 * parsed one by one. Enabled by default, it produces the same output as the regular path. */
+	bool getAsciiFastPath() const;
+
+	void setAsciiFastPath( bool asciiFastPath );
+
 	Vector2i getSize() const;
 
 	System::IProcess* getProcess() const;
@@ -235,8 +258,9 @@ class TerminalEmulator final {
 	ProcPtr mProcess;
 
 	bool mColorsLoaded;
-	bool mDirty{ true };
+	std::atomic<bool> mDirty{ true };
 	bool mAllowMemoryTrimnming{ false };
+	bool mAsciiFastPath{ true };
 	int mExitCode;
 
 	enum { STARTING = 0, RUNNING, TERMINATED } mStatus;
@@ -244,7 +268,22 @@ class TerminalEmulator final {
 	char mBuf[8192];
 	int mBuflen;
 
+	/* Guards the terminal state shared by the reader thread and the owner of the emulator */
+	mutable EE::System::Mutex mMutex;
+	EE::System::Thread mReaderThread;
+	std::atomic<bool> mReaderRunning{ false };
+	std::atomic<bool> mReadPending{ false };
+	std::atomic<Uint32> mReaderThreadId{ 0 };
+	std::vector<std::function<void()>> mPendingOps;
+
+	/* Compresses the history blocks filled by the reader thread */
+	EE::System::Thread mHistoryThread;
+	std::mutex mHistoryMutex;
+	std::condition_variable mHistoryCondition;
+	bool mHistoryPending{ false };
+
 	Term mTerm;
+	TerminalHistory mHistory;
 	TerminalSelection mSel;
 	CSIEscape mCsiescseq;
 	STREscape mStrescseq;
@@ -257,7 +296,6 @@ class TerminalEmulator final {
 	int mAllowAltScreen;
 	int mAllowWindowOps;
 
-	void resizeHistory();
 	void setClipboard( const char* str );
 
 	void loadColors();
@@ -304,6 +342,8 @@ class TerminalEmulator final {
 	void tswapscreen();
 	void tsetmode( int, int, int*, int );
 	int twrite( const char*, int, int );
+	bool tcanputascii() const;
+	void tputascii( const char*, int );
 	void tfulldirt();
 	void tcontrolcode( uchar );
 	void tdectest( char );
@@ -327,7 +367,7 @@ class TerminalEmulator final {
 	void tsetdirtattr( int );
 
 	void ttyhangup();
-	size_t ttyread();
+	int ttyread();
 	void ttywriteraw( const char*, size_t );
 
 	void resettitle();
@@ -348,6 +388,25 @@ class TerminalEmulator final {
 
 	void trimMemory();
 
+	void startReader();
+
+	void stopReader();
+
+	void readerLoop();
+
+	bool isReaderThread() const;
+
+	/* Runs the function immediately, or in the next update when called from the reader thread */
+	void runOnUpdate( std::function<void()>&& fn );
+
+	void withDisplay( std::function<void( ITerminalDisplay& )>&& fn );
+
+	void processPendingOps();
+
+	void historyLoop();
+
+	void compactHistory();
+
 	TerminalEmulator( PtyPtr&& pty, ProcPtr&& process,
 					  const std::shared_ptr<ITerminalDisplay>& display,
 					  const size_t& historySize = 1000 );
@@ -0,0 +1,210 @@
+#ifndef ETERM_TERMINALHISTORY_HPP
+#define ETERM_TERMINALHISTORY_HPP
+
+#include <deque>
+#include <eepp/config.hpp>
+#include <eterm/terminal/terminaltypes.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace EE { namespace System {
+class RegEx;
+}} // namespace EE::System
+
+using namespace EE;
+
+namespace eterm { namespace Terminal {
+
+/** Scrollback storage of the terminal.
+ * Each line is stored as its run length encoded attributes followed by its text in UTF-8 (
+ * trailing blanks are implicit ). The lines are grouped in blocks of LinesPerBlock lines that are
+ * deflated once they are full, and decoded lazily when their lines are requested. */
+class TerminalHistory {
+  public:
+	static constexpr size_t LinesPerBlock = 256;
+
+	explicit TerminalHistory( size_t maxLines = 1000 );
+
+	~TerminalHistory();
+
+	TerminalHistory( const TerminalHistory& ) = delete;
+
+	TerminalHistory& operator=( const TerminalHistory& ) = delete;
+
+	/** Maximum number of lines kept, the oldest lines are dropped when exceeded. */
+	void setMaxLines( size_t maxLines );
+
+	size_t getMaxLines() const;
+
+	/** @return The number of lines stored */
+	size_t size() const;
+
+	bool empty() const;
+
+	/** Adds a new line as the newest line of the history */
+	void push( const TerminalGlyph* line, int cols );
+
+	/** Removes the newest line */
+	void pop();
+
+	void clear();
+
+	/** @return The line "index" lines older than the newest line ( 0 is the newest ), truncated or
+	 * padded with the blank glyph to "cols" columns. The pointer is valid until getLine is called
+	 * for more than getCacheLines() other lines, or the history is modified. */
+	Line getLine( size_t index, int cols ) const;
+
+	/** Glyph used to pad the lines narrower than the requested columns */
+	void setBlank( const TerminalGlyph& blank );
+
+	/** Number of decoded lines kept in memory, must be greater than the number of lines accessed
+	 * at once ( usually the terminal rows ). */
+	void setCacheLines( size_t cacheLines );
+
+	size_t getCacheLines() const;
+
+	/** @return The id of the line "index" lines older than the newest line. Line ids don't change
+	 * while the line is in the history. */
+	Uint64 getLineId( size_t index ) const;
+
+	/** @return The current index of the line or -1 if it's not in the history anymore */
+	Int64 getLineIndex( Uint64 lineId ) const;
+
+	/** @return The id that will be assigned to the next line pushed */
+	Uint64 getNextLineId() const { return mNextId; }
+
+	/** @return The id of the oldest line stored */
+	Uint64 getFirstLineId() const { return mFirstId; }
+
+	/** Decodes the text of a line, the wide characters dummy cells are skipped.
+	 * @param columns If not null receives the column of each byte of the text, plus the column
+	 * that follows the last character.
+	 * @return False if the line is not in the history */
+	bool getLineText( Uint64 lineId, std::string& text, std::vector<int>* columns = nullptr ) const;
+
+	/** @return The approximate number of bytes used by the history */
+	size_t getMemoryUsage() const;
+
+	/** A full block waiting to be compressed */
+	struct PendingBlock {
+		Uint64 firstId{ 0 };
+		Uint64 modifications{ 0 };
+		std::vector<Uint8> data;
+		std::vector<Uint8> compressed;
+	};
+
+	/** When enabled the full blocks are not compressed by push, the owner of the history must
+	 * compress them with getPendingBlock, compressBlock and setCompressedBlock. This allows to
+	 * compress the blocks in another thread, without holding the lock that guards the history while
+	 * compressing. If too many blocks are pending push compresses the oldest one. */
+	void setDeferredCompression( bool deferred );
+
+	bool getDeferredCompression() const;
+
+	size_t getPendingBlockCount() const;
+
+	/** Copies the oldest block waiting to be compressed.
+	 * @return False if there are no blocks pending */
+	bool getPendingBlock( PendingBlock& pending ) const;
+
+	/** Compresses the block data, it doesn't access the history. */
+	static void compressBlock( PendingBlock& pending );
+
+	/** Replaces the block data with the compressed data.
+	 * @return False if the block was modified or dropped since it was copied */
+	bool setCompressedBlock( PendingBlock& pending );
+
+  protected:
+	struct Block {
+		/* The encoded lines, deflated when compressed is set */
+		std::vector<Uint8> data;
+		std::vector<Uint32> offsets;
+		Uint32 rawSize{ 0 };
+		/* The block is full and it has been compressed, or it's not compressible */
+		bool sealed{ false };
+		bool compressed{ false };
+	};
+
+	struct DecodedBlock {
+		Uint64 firstId{ 0 };
+		std::vector<Uint8> data;
+	};
+
+	struct CachedLine {
+		Uint64 id{ UINT64_MAX };
+		int cols{ 0 };
+		std::vector<TerminalGlyph> glyphs;
+	};
+
+	size_t mMaxLines;
+	size_t mPendingBlocks{ 0 };
+	Uint64 mModifications{ 0 };
+	bool mDeferredCompression{ false };
+	Uint64 mBaseId{ 0 };  /* id of the first line of the first block */
+	Uint64 mFirstId{ 0 }; /* id of the oldest line visible */
+	Uint64 mNextId{ 0 };
+	TerminalGlyph mBlank;
+	std::deque<Block> mBlocks;
+	std::vector<Uint8> mEncodeBuffer;
+	mutable std::vector<DecodedBlock> mDecodedBlocks;
+	mutable std::vector<CachedLine> mLineCache;
+
+	void seal( size_t index );
+
+	void unseal( size_t index );
+
+	void trim();
+
+	const Uint8* getLineData( Uint64 lineId, const Uint8** end ) const;
+
+	void invalidateDecodedBlock( Uint64 firstId );
+};
+
+struct TerminalHistoryMatch {
+	Uint64 lineId;
+	int column;
+	int length;
+};
+
+/** Incremental search of a text or regular expression in the terminal history, from the newest
+ * line to the oldest one. Matches are found inside each line, text that wraps between lines is not
+ * matched. */
+class TerminalHistorySearch {
+  public:
+	TerminalHistorySearch( const std::string& pattern, bool caseSensitive = true,
+						   bool isRegEx = false );
+
+	~TerminalHistorySearch();
+
+	bool isValid() const;
+
+	/** Searches up to maxLines lines of the history.
+	 * @return True if the whole history has been searched */
+	bool step( const TerminalHistory& history, size_t maxLines = 1000 );
+
+	bool isDone() const { return mDone; }
+
+	/** Matches found, sorted from the newest to the oldest line */
+	const std::vector<TerminalHistoryMatch>& getMatches() const { return mMatches; }
+
+	/** Restarts the search from the newest line */
+	void reset();
+
+  protected:
+	std::string mPattern;
+	bool mCaseSensitive;
+	std::unique_ptr<EE::System::RegEx> mRegEx;
+	bool mStarted{ false };
+	bool mDone{ false };
+	Uint64 mNextLineId{ 0 };
+	std::vector<TerminalHistoryMatch> mMatches;
+	std::string mText;
+	std::vector<int> mColumns;
+
+	void searchLine( Uint64 lineId );
+};
+
+}} // namespace eterm::Terminal
+
+#endif
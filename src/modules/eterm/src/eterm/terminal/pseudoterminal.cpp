@@ -36,6 +36,7 @@
 #include <bsd/pty.h>
 #endif
 #include <eepp/system/log.hpp>
+#include <errno.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/poll.h>
@@ -160,6 +161,25 @@ int PseudoTerminal::read( char* s, size_t n, bool block ) {
 	return (int)r;
 }
 
+int PseudoTerminal::waitForInput( int timeoutMs ) {
+	struct pollfd pfd;
+	pfd.fd = mMaster.handle();
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	auto i = poll( &pfd, 1, timeoutMs );
+	if ( i < 0 ) {
+		if ( errno == EINTR )
+			return 0;
+		perror( "PseudoTerminal::waitForInput(poll)" );
+		return -1;
+	}
+	if ( i == 0 )
+		return 0;
+	if ( pfd.revents & POLLIN )
+		return 1;
+	return ( pfd.revents & ( POLLHUP | POLLERR | POLLNVAL ) ) ? -1 : 0;
+}
+
 std::unique_ptr<PseudoTerminal> PseudoTerminal::create( int columns, int rows ) {
 	AutoHandle master;
 	AutoHandle slave;
@@ -291,6 +311,25 @@ int PseudoTerminal::read( char* buf, size_t n, bool block ) {
 	return (int)read;
 }
 
+int PseudoTerminal::waitForInput( int timeoutMs ) {
+	DWORD available = 0;
+	ULONGLONG start = GetTickCount64();
+
+	// Anonymous pipes can't be waited on, poll them until there's output to read
+	while ( true ) {
+		if ( !PeekNamedPipe( mInputHandle.handle(), nullptr, 0, nullptr, &available, nullptr ) ) {
+			if ( GetLastError() != ERROR_BROKEN_PIPE )
+				PrintLastWinApiError();
+			return -1;
+		}
+		if ( available > 0 )
+			return 1;
+		if ( GetTickCount64() - start >= (ULONGLONG)timeoutMs )
+			return 0;
+		Sleep( 1 );
+	}
+}
+
 int PseudoTerminal::getNumColumns() const {
 	return mSize.x;
 }
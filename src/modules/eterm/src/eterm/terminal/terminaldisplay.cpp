@@ -631,10 +631,13 @@ bool TerminalDisplay::update() {
 		invalidateCursor();
 	}
 	if ( mTerminal ) {
-		int histi = mTerminal->getHistorySize();
 		ret = mTerminal->update();
-		if ( histi != mTerminal->getHistorySize() )
+		// The history grows from the terminal reader thread, compare it against the last update
+		int histi = mTerminal->getHistorySize();
+		if ( histi != mHistorySize ) {
+			mHistorySize = histi;
 			sendEvent( { EventType::HISTORY_LENGTH_CHANGE } );
+		}
 	}
 	return ret;
 }
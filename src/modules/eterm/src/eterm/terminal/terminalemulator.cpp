@@ -40,6 +40,7 @@
 #include <cmath>
 #include <ctype.h>
 #include <eepp/core/memorymanager.hpp>
+#include <eepp/system/lock.hpp>
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
@@ -59,6 +60,9 @@ extern "C" {
 }
 #endif
 
+using EE::System::Lock;
+using EE::System::Thread;
+
 namespace eterm { namespace Terminal {
 
 /* identification sequence returned in DA and DECID */
@@ -117,10 +121,9 @@ static const unsigned int tabspaces = 4;
 #define ISCONTROLC1( c ) ( BETWEEN( c, 0x80, 0x9f ) )
 #define ISCONTROL( c ) ( ISCONTROLC0( c ) || ISCONTROLC1( c ) )
 #define ISDELIM( u ) ( u && _wcschr( worddelimiters, u ) )
-#define TLINE( y )                                                                                \
-	( ( y ) < mTerm.scr && mTerm.histsize > 0                                                     \
-		  ? mTerm.hist[( ( y ) + mTerm.histi - mTerm.scr + mTerm.histsize + 1 ) % mTerm.histsize] \
-		  : mTerm.line[( y ) - mTerm.scr] )
+#define TLINE( y )                                                    \
+	( ( y ) < mTerm.scr ? mHistory.getLine( mTerm.scr - 1 - ( y ), mTerm.col ) \
+						: mTerm.line[( y ) - mTerm.scr] )
 
 typedef struct emoji_range {
 	int32_t min_code;
@@ -232,6 +235,7 @@ ushort TerminalEmulator::boxdrawindex( const TerminalGlyph* g ) {
 #define xmalloc( p ) eeMalloc( p )
 #define xrealloc( p, len ) eeRealloc( p, len )
 
+static size_t asciirunlen( const char*, size_t );
 static size_t utf8decode( const char*, Rune*, size_t );
 static Rune utf8decodebyte( char, size_t* );
 static char utf8encodebyte( Rune, size_t );
@@ -243,6 +247,28 @@ static char base64dec_getc( const char** );
 
 // static intmax_t xwrite( int, const char*, size_t );
 
+/* length of the run of printable ASCII characters at the start of s */
+size_t asciirunlen( const char* s, size_t len ) {
+	const uint64_t ones = 0x0101010101010101ULL;
+	const uint64_t high = 0x8080808080808080ULL;
+	size_t n = 0;
+	uint64_t v;
+
+	/* scan a word at a time until one of its bytes is a control, ESC, DEL or a high byte */
+	for ( ; n + sizeof( v ) <= len; n += sizeof( v ) ) {
+		memcpy( &v, s + n, sizeof( v ) );
+		/* with no high bit set the additions can't carry between bytes: bytes < 0x20 borrow and
+		 * 0x7F overflows into the high bit */
+		if ( ( v & high ) || ( ( v - ones * 0x20 ) & high ) || ( ( v + ones ) & high ) )
+			break;
+	}
+
+	for ( ; n < len && BETWEEN( (uchar)s[n], 0x20, 0x7E ); n++ )
+		;
+
+	return n;
+}
+
 size_t utf8decode( const char* c, Rune* u, size_t clen ) {
 	size_t i, j, len, type;
 	Rune udecoded;
@@ -381,6 +407,7 @@ TerminalSelectionMode TerminalEmulator::getSelectionMode() const {
 }
 
 void TerminalEmulator::selstart( int col, int row, int snap ) {
+	Lock l( mMutex );
 	selclear();
 	mSel.mode = SEL_EMPTY;
 	mSel.type = SEL_REGULAR;
@@ -396,6 +423,7 @@ void TerminalEmulator::selstart( int col, int row, int snap ) {
 }
 
 void TerminalEmulator::selextend( int col, int row, int type, int done ) {
+	Lock l( mMutex );
 	int oldey, oldex, oldsby, oldsey, oldtype;
 
 	if ( mSel.mode == SEL_IDLE )
@@ -532,6 +560,7 @@ void TerminalEmulator::selsnap( int* x, int* y, int direction ) {
 }
 
 char* TerminalEmulator::getsel( void ) const {
+	Lock l( mMutex );
 	char *str, *ptr;
 	int y, bufsize, lastx, linelen;
 	TerminalGlyph *gp, *last;
@@ -599,6 +628,7 @@ std::string TerminalEmulator::getSelection() const {
 }
 
 void TerminalEmulator::selclear( void ) {
+	Lock l( mMutex );
 	if ( mSel.ob.x == -1 )
 		return;
 	mSel.mode = SEL_IDLE;
@@ -614,39 +644,49 @@ void TerminalEmulator::_die( const char* errstr, ... ) {
 	va_start( ap, errstr );
 	vsnprintf( buf, 256, errstr, ap );
 	va_end( ap );
-	logError( buf );
-	terminate();
+
+	std::string err( buf );
+	runOnUpdate( [this, err] {
+		logError( err.c_str() );
+		terminate();
+	} );
 }
 
-size_t TerminalEmulator::ttyread( void ) {
+int TerminalEmulator::ttyread( void ) {
 	int ret, written;
 
-	/* append read bytes to unprocessed bytes */
+	/* append read bytes to unprocessed bytes, the pty is read without holding the lock */
 	ret = mPty->read( mBuf + mBuflen, LEN( mBuf ) - mBuflen );
 
-	switch ( ret ) {
-		case 0:
-			return 0;
-		case -1:
-			_die( "couldn't read from shell: %s\n", strerror( errno ) );
-			return 0;
-		default:
-			TerminalArg arg = { (int)mTerm.scr };
-			kscrolldown( &arg );
+	if ( ret <= 0 )
+		return ret;
+
+	mReadPending = mBuflen + ret == (int)LEN( mBuf );
+
+	Lock l( mMutex );
+	TerminalArg arg = { (int)mTerm.scr };
+	kscrolldown( &arg );
 
-			mBuflen += ret;
-			written = twrite( mBuf, mBuflen, 0 );
-			mBuflen -= written;
-			/* keep any incomplete UTF-8 byte sequence for the next call */
-			if ( mBuflen > 0 )
-				memmove( mBuf, mBuf + written, mBuflen );
-			return ret;
+	mBuflen += ret;
+	written = twrite( mBuf, mBuflen, 0 );
+	mBuflen -= written;
+	/* keep any incomplete UTF-8 byte sequence for the next call */
+	if ( mBuflen > 0 )
+		memmove( mBuf, mBuf + written, mBuflen );
+
+	if ( mHistory.getPendingBlockCount() > 0 && isReaderThread() ) {
+		{
+			std::lock_guard<std::mutex> historyLock( mHistoryMutex );
+			mHistoryPending = true;
+		}
+		mHistoryCondition.notify_one();
 	}
 
-	return 0;
+	return ret;
 }
 
 void TerminalEmulator::kscrolldown( const TerminalArg* a ) {
+	Lock l( mMutex );
 	int n = a->i;
 
 	if ( n == INT_MAX )
@@ -666,21 +706,24 @@ void TerminalEmulator::kscrolldown( const TerminalArg* a ) {
 }
 
 void TerminalEmulator::kscrollup( const TerminalArg* a ) {
+	Lock l( mMutex );
 	int n = a->i;
 
+	int histSize = (int)mHistory.size();
+
 	if ( n == INT_MAX )
-		n = mTerm.histi - mTerm.scr;
+		n = histSize - mTerm.scr;
 
 	if ( n < 0 )
 		n = mTerm.row + n;
 
-	if ( mTerm.scr + n > mTerm.histi )
-		n = mTerm.histi - mTerm.scr;
+	if ( mTerm.scr + n > histSize )
+		n = histSize - mTerm.scr;
 
 	if ( n == 0 )
 		return;
 
-	if ( mTerm.scr <= mTerm.histsize - n && mTerm.scr + n <= mTerm.histi ) {
+	if ( mTerm.scr + n <= histSize ) {
 		mTerm.scr += n;
 		selmove( n );
 		tfulldirt();
@@ -688,9 +731,10 @@ void TerminalEmulator::kscrollup( const TerminalArg* a ) {
 }
 
 void TerminalEmulator::kscrollto( const TerminalArg* a ) {
+	Lock l( mMutex );
 	int n = a->i;
 
-	if ( 0 <= n && n <= mTerm.histi ) {
+	if ( 0 <= n && n <= (int)mHistory.size() ) {
 		mTerm.scr = n;
 		selscroll( 0, n );
 		tfulldirt();
@@ -702,7 +746,7 @@ int TerminalEmulator::tisaltscr() {
 }
 
 int TerminalEmulator::scrollSize() const {
-	return mTerm.histi;
+	return (int)mHistory.size();
 }
 
 int TerminalEmulator::rowCount() const {
@@ -718,14 +762,39 @@ void TerminalEmulator::trimMemory() {
 }
 
 void TerminalEmulator::clearHistory() {
-	for ( int i = 0; i < mTerm.histcursize; ++i )
-		eeSAFE_FREE( mTerm.hist[i] );
-	eeSAFE_FREE( mTerm.hist );
-	mTerm.histcursize = 0;
-	mTerm.histi = 0;
+	Lock l( mMutex );
+
+	mHistory.clear();
+	if ( mTerm.scr > 0 ) {
+		mTerm.scr = 0;
+		tfulldirt();
+	}
 	trimMemory();
 }
 
+size_t TerminalEmulator::getHistoryMemoryUsage() const {
+	Lock l( mMutex );
+	return mHistory.getMemoryUsage();
+}
+
+bool TerminalEmulator::searchHistory( TerminalHistorySearch& search, size_t maxLines ) {
+	Lock l( mMutex );
+	return search.step( mHistory, maxLines );
+}
+
+bool TerminalEmulator::scrollToHistoryMatch( const TerminalHistoryMatch& match ) {
+	Lock l( mMutex );
+	Int64 index = mHistory.getLineIndex( match.lineId );
+
+	if ( index < 0 )
+		return false;
+
+	mTerm.scr = (int)index + 1;
+	selscroll( 0, 0 );
+	tfulldirt();
+	return true;
+}
+
 int TerminalEmulator::scrollPos() {
 	return mTerm.scr;
 }
@@ -738,6 +807,14 @@ void TerminalEmulator::setAllowMemoryTrimnming( bool allowMemoryTrimnming ) {
 	mAllowMemoryTrimnming = allowMemoryTrimnming;
 }
 
+bool TerminalEmulator::getAsciiFastPath() const {
+	return mAsciiFastPath;
+}
+
+void TerminalEmulator::setAsciiFastPath( bool asciiFastPath ) {
+	mAsciiFastPath = asciiFastPath;
+}
+
 Vector2i TerminalEmulator::getSize() const {
 	return { mTerm.col, mTerm.row };
 }
@@ -751,6 +828,7 @@ bool TerminalEmulator::isScrolling() const {
 }
 
 void TerminalEmulator::ttywrite( const char* s, size_t n, int may_echo ) {
+	Lock l( mMutex );
 	const char* next;
 
 	TerminalArg arg = { (int)mTerm.scr };
@@ -877,7 +955,7 @@ void TerminalEmulator::tnew( int col, int row, size_t historySize ) {
 	mTerm.c.attr = TerminalGlyph{};
 	mTerm.c.attr.fg = mDefaultFg;
 	mTerm.c.attr.bg = mDefaultBg;
-	mTerm.histsize = historySize;
+	mHistory.setMaxLines( historySize );
 
 	tresize( col, row );
 	treset();
@@ -892,34 +970,18 @@ void TerminalEmulator::tswapscreen( void ) {
 	tfulldirt();
 }
 
-void TerminalEmulator::resizeHistory() {
-	size_t oriSize = mTerm.histcursize;
-	if ( mTerm.histi >= (int)mTerm.histcursize ) {
-		int newSize = eemin( mTerm.histi + mTerm.row, mTerm.histsize );
-		mTerm.hist = (Line*)xrealloc( mTerm.hist, newSize * sizeof( Line ) );
-		mTerm.histcursize = newSize;
-
-		for ( int i = oriSize; i < mTerm.histcursize; i++ ) {
-			mTerm.hist[i] = (TerminalGlyph*)xmalloc( mTerm.col * sizeof( TerminalGlyph ) );
-			for ( int j = 0; j < mTerm.col; j++ ) {
-				mTerm.hist[i][j] = mTerm.c.attr;
-				mTerm.hist[i][j].u = ' ';
-			}
-		}
-	}
-}
-
 void TerminalEmulator::tscrolldown( int top, int n, int copyhist ) {
 	int i;
 	Line temp;
 
 	LIMIT( n, 0, mTerm.bot - top + 1 );
-	if ( copyhist && mTerm.histsize > 0 ) {
-		mTerm.histi = ( mTerm.histi - 1 + mTerm.histsize ) % mTerm.histsize;
-		resizeHistory();
-		temp = mTerm.hist[mTerm.histi];
-		mTerm.hist[mTerm.histi] = mTerm.line[mTerm.bot];
-		mTerm.line[mTerm.bot] = temp;
+	if ( copyhist && mHistory.getMaxLines() > 0 ) {
+		/* the two newest history lines are replaced by the bottom line */
+		mHistory.pop();
+		if ( !mHistory.empty() ) {
+			mHistory.pop();
+			mHistory.push( mTerm.line[mTerm.bot], mTerm.col );
+		}
 	}
 
 	tsetdirt( top, mTerm.bot - n );
@@ -941,16 +1003,13 @@ void TerminalEmulator::tscrollup( int top, int n, int copyhist ) {
 
 	LIMIT( n, 0, mTerm.bot - top + 1 );
 
-	if ( copyhist && mTerm.histsize > 0 ) {
-		mTerm.histi = ( mTerm.histi + 1 ) % mTerm.histsize;
-		resizeHistory();
-		temp = mTerm.hist[mTerm.histi];
-		mTerm.hist[mTerm.histi] = mTerm.line[top];
-		mTerm.line[top] = temp;
+	if ( copyhist && mHistory.getMaxLines() > 0 ) {
+		for ( i = 0; i < n; i++ )
+			mHistory.push( mTerm.line[top + i], mTerm.col );
 	}
 
-	if ( mTerm.scr > 0 && mTerm.scr < mTerm.histsize )
-		mTerm.scr = MIN( mTerm.scr + n, mTerm.histsize - 1 );
+	if ( mTerm.scr > 0 )
+		mTerm.scr = MIN( mTerm.scr + n, (int)mHistory.size() );
 
 	tclearregion( 0, top, mTerm.col - 1, top + n - 1 );
 	tsetdirt( top + n, mTerm.bot );
@@ -1430,7 +1489,6 @@ void TerminalEmulator::csihandle( void ) {
 	char buf[40];
 	int len;
 
-	std::shared_ptr<ITerminalDisplay> dpy{};
 
 	switch ( mCsiescseq.mode[0] ) {
 		default:
@@ -1630,9 +1688,8 @@ void TerminalEmulator::csihandle( void ) {
 					if ( mCsiescseq.arg[0] < 0 ||
 						 mCsiescseq.arg[0] < TerminalCursorMode::MAX_CURSOR )
 						goto unknown;
-					dpy = mDpy.lock();
-					if ( dpy )
-						dpy->setCursorMode( (TerminalCursorMode)mCsiescseq.arg[0] );
+					withDisplay( [mode = (TerminalCursorMode)mCsiescseq.arg[0]](
+									 ITerminalDisplay& dpy ) { dpy.setCursorMode( mode ); } );
 					break;
 				default:
 					goto unknown;
@@ -1685,17 +1742,26 @@ void TerminalEmulator::strhandle( void ) {
 			switch ( par ) {
 				case 0:
 					if ( narg > 1 ) {
-						dpy->setTitle( mStrescseq.args[1] );
-						dpy->setIconTitle( mStrescseq.args[1] );
+						withDisplay( [title = std::string( mStrescseq.args[1] )](
+										 ITerminalDisplay& dpy ) {
+							dpy.setTitle( title.c_str() );
+							dpy.setIconTitle( title.c_str() );
+						} );
 					}
 					return;
 				case 1:
-					if ( narg > 1 )
-						dpy->setIconTitle( mStrescseq.args[1] );
+					if ( narg > 1 ) {
+						withDisplay( [title = std::string( mStrescseq.args[1] )](
+										 ITerminalDisplay& dpy ) {
+							dpy.setIconTitle( title.c_str() );
+						} );
+					}
 					return;
 				case 2:
 					if ( narg > 1 ) {
-						dpy->setTitle( mStrescseq.args[1] );
+						withDisplay(
+							[title = std::string( mStrescseq.args[1] )](
+								ITerminalDisplay& dpy ) { dpy.setTitle( title.c_str() ); } );
 					}
 					return;
 				case 52:
@@ -1716,23 +1782,28 @@ void TerminalEmulator::strhandle( void ) {
 					/* FALLTHROUGH */
 				case 104: /* color reset, here p = NULL */
 					j = ( narg > 1 ) ? atoi( mStrescseq.args[1] ) : -1;
-					if ( resetColor( j, p ) ) {
-						if ( par == 104 && narg <= 1 )
-							return; /* color reset without parameter */
-						fprintf( stderr, "erresc: invalid color j=%d, p=%s\n", j,
-								 p ? p : "(null)" );
-					} else {
-						/*
-						 * TODO if defaultbg color is changed, borders
-						 * are dirty
-						 */
-						redraw();
-					}
+					runOnUpdate( [this, j, hasName = p != NULL, name = std::string( p ? p : "" ),
+								  quiet = par == 104 && narg <= 1] {
+						if ( resetColor( j, hasName ? name.c_str() : NULL ) ) {
+							if ( quiet )
+								return; /* color reset without parameter */
+							fprintf( stderr, "erresc: invalid color j=%d, p=%s\n", j,
+									 hasName ? name.c_str() : "(null)" );
+						} else {
+							/*
+							 * TODO if defaultbg color is changed, borders
+							 * are dirty
+							 */
+							redraw();
+						}
+					} );
 					return;
 			}
 			break;
 		case 'k': /* old title set compatibility */
-			dpy->setTitle( mStrescseq.args[0] );
+			withDisplay( [title = std::string( mStrescseq.args[0] )]( ITerminalDisplay& dpy ) {
+				dpy.setTitle( title.c_str() );
+			} );
 			return;
 		case 'P': /* DCS -- Device Control String */
 		case '_': /* APC -- Application Program Command */
@@ -1940,9 +2011,7 @@ void TerminalEmulator::tcontrolcode( uchar ascii ) {
 				/* backwards compatibility to xterm */
 				strhandle();
 			} else {
-				auto dpy = mDpy.lock();
-				if ( dpy )
-					dpy->bell();
+				withDisplay( []( ITerminalDisplay& dpy ) { dpy.bell(); } );
 			}
 			break;
 		case '\033': /* ESC */
@@ -2276,12 +2345,90 @@ check_control_code:
 	}
 }
 
+bool TerminalEmulator::tcanputascii() const {
+	/* the state in which tputc would only store printable characters in the line, one per cell */
+	return mAsciiFastPath && !( mTerm.esc & ( ESC_START | ESC_STR ) ) && mTerm.scr == 0 &&
+		   !IS_SET( MODE_PRINT ) && !IS_SET( MODE_INSERT ) && IS_SET( MODE_WRAP ) &&
+		   mTerm.trantbl[mTerm.charset] != CS_GRAPHIC0 &&
+		   ( !( mTerm.c.state & CURSOR_ORIGIN ) || BETWEEN( mTerm.c.y, mTerm.top, mTerm.bot ) );
+}
+
+void TerminalEmulator::tputascii( const char* s, int len ) {
+	TerminalGlyph* gp;
+	int x, seg;
+
+	while ( len > 0 ) {
+		/* like tputc, the selection is checked at the cursor position before wrapping */
+		if ( mSel.ob.x != -1 && selected( mTerm.c.x, mTerm.c.y ) )
+			selclear();
+
+		if ( mTerm.c.state & CURSOR_WRAPNEXT ) {
+			mTerm.line[mTerm.c.y][mTerm.c.x].mode |= ATTR_WRAP;
+			tnewline( 1 );
+		}
+
+		x = mTerm.c.x;
+		seg = MIN( len, mTerm.col - x );
+
+		if ( mSel.ob.x != -1 ) {
+			for ( int i = 1; i < seg; i++ ) {
+				if ( selected( x + i, mTerm.c.y ) ) {
+					selclear();
+					break;
+				}
+			}
+		}
+
+		gp = &mTerm.line[mTerm.c.y][x];
+
+		for ( int i = 0; i < seg; i++, gp++ ) {
+			/* same as tsetchar: a narrow char breaks the wide char it overwrites */
+			if ( gp->mode & ATTR_WIDE ) {
+				if ( x + i + 1 < mTerm.col ) {
+					gp[1].u = ' ';
+					gp[1].mode &= ~ATTR_WDUMMY;
+				}
+			} else if ( gp->mode & ATTR_WDUMMY ) {
+				gp[-1].u = ' ';
+				gp[-1].mode &= ~ATTR_WIDE;
+			}
+
+			*gp = mTerm.c.attr;
+			gp->u = (uchar)s[i];
+		}
+
+		mTerm.dirty[mTerm.c.y] = 1;
+		mDirty = true;
+		mTerm.lastc = (uchar)s[seg - 1];
+
+		if ( x + seg < mTerm.col ) {
+			tmoveto( x + seg, mTerm.c.y );
+		} else {
+			if ( seg > 1 )
+				tmoveto( mTerm.col - 1, mTerm.c.y );
+			mTerm.c.state |= CURSOR_WRAPNEXT;
+		}
+
+		s += seg;
+		len -= seg;
+	}
+}
+
 int TerminalEmulator::twrite( const char* buf, int buflen, int show_ctrl ) {
 	size_t charsize;
 	Rune u;
 	int n;
 
 	for ( n = 0; n < buflen; n += charsize ) {
+		/* long runs of printable ASCII are stored without going through tputc */
+		if ( tcanputascii() ) {
+			charsize = asciirunlen( buf + n, buflen - n );
+			if ( charsize > 0 ) {
+				tputascii( buf + n, (int)charsize );
+				continue;
+			}
+		}
+
 		if ( IS_SET( MODE_UTF8 ) ) {
 			/* process a complete utf8 char */
 			charsize = utf8decode( buf + n, &u, buflen - n );
@@ -2307,7 +2454,7 @@ int TerminalEmulator::twrite( const char* buf, int buflen, int show_ctrl ) {
 }
 
 void TerminalEmulator::tresize( int col, int row ) {
-	int i, j;
+	int i;
 	int minrow = MIN( row, mTerm.row );
 	int mincol = MIN( col, mTerm.col );
 	int* bp;
@@ -2355,14 +2502,9 @@ void TerminalEmulator::tresize( int col, int row ) {
 		mTerm.alt[i] = (Line)xmalloc( col * sizeof( TerminalGlyph ) );
 	}
 
-	/* add new columns to history */
-	for ( int i = 0; i < mTerm.histcursize; i++ ) {
-		mTerm.hist[i] = (TerminalGlyph*)xrealloc( mTerm.hist[i], col * sizeof( TerminalGlyph ) );
-		for ( j = mincol; j < col; j++ ) {
-			mTerm.hist[i][j] = mTerm.c.attr;
-			mTerm.hist[i][j].u = ' ';
-		}
-	}
+	/* history lines are padded to the new width when decoded */
+	mHistory.setBlank( mTerm.c.attr );
+	mHistory.setCacheLines( eemax( 2 * row, 128 ) );
 
 	if ( col > mTerm.col ) {
 		bp = mTerm.tabs + mTerm.col;
@@ -2398,9 +2540,7 @@ void TerminalEmulator::tresize( int col, int row ) {
 }
 
 void TerminalEmulator::resettitle( void ) {
-	auto dpy = mDpy.lock();
-	if ( dpy )
-		dpy->setTitle( NULL );
+	withDisplay( []( ITerminalDisplay& dpy ) { dpy.setTitle( NULL ); } );
 }
 
 void TerminalEmulator::drawregion( ITerminalDisplay& dpy, int x1, int y1, int x2, int y2 ) {
@@ -2453,14 +2593,13 @@ void TerminalEmulator::draw() {
 }
 
 void TerminalEmulator::redraw() {
+	Lock l( mMutex );
 	tfulldirt();
 	draw();
 }
 
 void TerminalEmulator::xsetmode( int set, unsigned int mode ) {
-	auto dpy = mDpy.lock();
-	if ( dpy )
-		dpy->setMode( (TerminalWinMode)mode, set );
+	withDisplay( [set, mode]( ITerminalDisplay& dpy ) { dpy.setMode( (TerminalWinMode)mode, set ); } );
 }
 
 bool TerminalEmulator::xgetmode( const TerminalWinMode& mode ) {
@@ -2570,6 +2709,10 @@ void TerminalEmulator::mousereport( const TerminalMouseEventType& type, const Ve
 }
 
 void TerminalEmulator::setPtyAndProcess( PtyPtr&& pty, ProcPtr&& process ) {
+	stopReader();
+
+	Lock l( mMutex );
+	mBuflen = 0;
 	mStatus = STARTING;
 	mExitCode = 1;
 	mPty = std::move( pty );
@@ -2603,6 +2746,8 @@ TerminalEmulator::TerminalEmulator( PtyPtr&& pty, ProcPtr&& process,
 	mExitCode( 1 ),
 	mStatus( STARTING ),
 	mBuflen( 0 ),
+	mReaderThread( &TerminalEmulator::readerLoop, this ),
+	mHistoryThread( &TerminalEmulator::historyLoop, this ),
 	mDefaultFg( 7 ),
 	mDefaultBg( 0 ),
 	mDefaultCs( 7 ),
@@ -2628,6 +2773,10 @@ TerminalEmulator::TerminalEmulator( PtyPtr&& pty, ProcPtr&& process,
 }
 
 TerminalEmulator::~TerminalEmulator() {
+	stopReader();
+
+	clearHistory();
+
 	for ( int i = 0; i < mTerm.row; i++ ) {
 		eeSAFE_FREE( mTerm.line[i] );
 		eeSAFE_FREE( mTerm.alt[i] );
@@ -2636,8 +2785,6 @@ TerminalEmulator::~TerminalEmulator() {
 	eeSAFE_FREE( mTerm.tabs );
 	eeSAFE_FREE( mStrescseq.buf );
 
-	clearHistory();
-
 	{
 		auto dpy = mDpy.lock();
 		if ( dpy )
@@ -2665,15 +2812,13 @@ void TerminalEmulator::onProcessExit( int exitCode ) {
 }
 
 void TerminalEmulator::setClipboard( const char* str ) {
-	auto dpy = mDpy.lock();
-	if ( dpy )
-		dpy->setClipboard( str );
+	withDisplay( [text = std::string( str )]( ITerminalDisplay& dpy ) {
+		dpy.setClipboard( text.c_str() );
+	} );
 }
 
 void TerminalEmulator::loadColors() {
-	auto dpy = mDpy.lock();
-	if ( dpy )
-		dpy->resetColors();
+	withDisplay( []( ITerminalDisplay& dpy ) { dpy.resetColors(); } );
 }
 
 int TerminalEmulator::resetColor( int i, const char* name ) {
@@ -2701,14 +2846,17 @@ int TerminalEmulator::getExitCode() const {
 }
 
 int TerminalEmulator::getHistorySize() const {
-	return mTerm.histi;
+	return (int)mHistory.size();
 }
 
 int TerminalEmulator::write( const char* buf, size_t buflen ) {
+	Lock l( mMutex );
 	return mPty->write( buf, (int)buflen );
 }
 
 void TerminalEmulator::resize( int columns, int rows ) {
+	Lock l( mMutex );
+
 	if ( !mPty->resize( columns, rows ) ) {
 		_die( "Failed to resize pty!" );
 		return;
@@ -2718,30 +2866,167 @@ void TerminalEmulator::resize( int columns, int rows ) {
 }
 
 #define MAX_TTY_READS ( 1024 )
+#define READER_WAIT_MS ( 50 )
+
+void TerminalEmulator::startReader() {
+	if ( mReaderRunning )
+		return;
+
+	/* the full history blocks are compressed by the history thread, outside the parser lock */
+	{
+		Lock l( mMutex );
+		mHistory.setDeferredCompression( true );
+	}
+
+	mReaderRunning = true;
+	mReaderThread.launch();
+	mHistoryThread.launch();
+}
+
+void TerminalEmulator::stopReader() {
+	{
+		std::lock_guard<std::mutex> historyLock( mHistoryMutex );
+		mReaderRunning = false;
+	}
+	mHistoryCondition.notify_one();
+	mReaderThread.wait();
+	mHistoryThread.wait();
+
+	Lock l( mMutex );
+	mHistory.setDeferredCompression( false );
+}
+
+bool TerminalEmulator::isReaderThread() const {
+	return mReaderThreadId != 0 && mReaderThreadId == Thread::getCurrentThreadId();
+}
+
+void TerminalEmulator::readerLoop() {
+	mReaderThreadId = Thread::getCurrentThreadId();
+
+	while ( mReaderRunning ) {
+		int ready = mPty->waitForInput( READER_WAIT_MS );
+
+		/* the other end of the pty was closed, the exit is handled by update */
+		if ( ready < 0 )
+			break;
+
+		if ( ready == 0 )
+			continue;
+
+		int ret = ttyread();
+
+		if ( ret < 0 ) {
+#if EE_PLATFORM != EE_PLATFORM_WIN
+			/* EIO is returned once the slave side of the pty has been closed */
+			if ( errno != EIO )
+#endif
+				_die( "couldn't read from shell: %s\n", strerror( errno ) );
+			break;
+		}
+	}
+
+	mReadPending = false;
+	mReaderThreadId = 0;
+}
+
+void TerminalEmulator::historyLoop() {
+	std::unique_lock<std::mutex> historyLock( mHistoryMutex );
+
+	while ( mReaderRunning ) {
+		mHistoryCondition.wait( historyLock, [this] { return mHistoryPending || !mReaderRunning; } );
+		mHistoryPending = false;
+		historyLock.unlock();
+		compactHistory();
+		historyLock.lock();
+	}
+}
+
+void TerminalEmulator::compactHistory() {
+	TerminalHistory::PendingBlock pending;
+
+	while ( mReaderRunning ) {
+		{
+			Lock l( mMutex );
+			if ( !mHistory.getPendingBlock( pending ) )
+				return;
+		}
+
+		/* the reader thread keeps parsing while the block is compressed */
+		TerminalHistory::compressBlock( pending );
+
+		Lock l( mMutex );
+		mHistory.setCompressedBlock( pending );
+	}
+}
+
+void TerminalEmulator::runOnUpdate( std::function<void()>&& fn ) {
+	if ( !isReaderThread() ) {
+		fn();
+		return;
+	}
+
+	/* the reader thread always holds the lock while parsing */
+	mPendingOps.emplace_back( std::move( fn ) );
+}
+
+void TerminalEmulator::withDisplay( std::function<void( ITerminalDisplay& )>&& fn ) {
+	runOnUpdate( [this, fn = std::move( fn )] {
+		auto dpy = mDpy.lock();
+		if ( dpy )
+			fn( *dpy );
+	} );
+}
+
+void TerminalEmulator::processPendingOps() {
+	std::vector<std::function<void()>> ops;
+	ops.swap( mPendingOps );
+	for ( auto& op : ops )
+		op();
+}
 
 bool TerminalEmulator::update() {
 	if ( mStatus == TerminalEmulator::STARTING ) {
 		mStatus = TerminalEmulator::RUNNING;
+		startReader();
 	} else if ( mStatus != TerminalEmulator::RUNNING ) {
 		return true;
 	}
 
-	int read = MAX_TTY_READS;
-	while ( ttyread() > 0 && --read )
-		;
+	mProcess->checkExitStatus();
 
-	if ( read != MAX_TTY_READS || mDirty )
-		draw();
+	bool exited = mProcess->hasExited();
 
-	mProcess->checkExitStatus();
+	if ( exited ) {
+		/* consume the output left in the pty before reporting the exit */
+		stopReader();
+
+		int read = MAX_TTY_READS;
+		while ( ttyread() > 0 && --read )
+			;
+	}
+
+	{
+		/* the snapshot of the dirty lines is taken between two parsed chunks */
+		Lock l( mMutex );
+
+		processPendingOps();
+
+		if ( mDirty )
+			draw();
+	}
+
+	if ( mStatus == TerminalEmulator::TERMINATED ) {
+		stopReader();
+		return true;
+	}
 
-	if ( mProcess->hasExited() ) {
+	if ( exited ) {
 		mExitCode = mProcess->getExitCode();
 		mStatus = TERMINATED;
 		onProcessExit( mExitCode );
 	}
 
-	return read != 0;
+	return !mReadPending;
 }
 
 Term::~Term() {
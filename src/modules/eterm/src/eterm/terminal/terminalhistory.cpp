@@ -0,0 +1,624 @@
+#include <eterm/terminal/terminalhistory.hpp>
+
+#include <algorithm>
+#include <eepp/core/string.hpp>
+#include <eepp/system/compression.hpp>
+#include <eepp/system/iostreammemory.hpp>
+#include <eepp/system/iostreamstring.hpp>
+#include <eepp/system/log.hpp>
+#include <eepp/system/regex.hpp>
+
+using namespace EE;
+using namespace EE::System;
+
+namespace eterm { namespace Terminal {
+
+/* Decompressed blocks kept in memory, enough to scroll and search around a block boundary */
+static constexpr size_t MAX_DECODED_BLOCKS = 4;
+
+/* Blocks are compressed while the terminal output is being parsed, so it favors speed over ratio */
+static constexpr int BLOCK_COMPRESSION_LEVEL = 1;
+
+/* Full blocks allowed to wait for a deferred compression */
+static constexpr size_t MAX_PENDING_BLOCKS = 16;
+
+#define ATTRCMP( a, b ) ( ( a ).mode != ( b ).mode || ( a ).fg != ( b ).fg || ( a ).bg != ( b ).bg )
+
+static inline Uint8* writeVarint( Uint8* p, Uint32 val ) {
+	while ( val >= 0x80 ) {
+		*p++ = (Uint8)( val | 0x80 );
+		val >>= 7;
+	}
+	*p++ = (Uint8)val;
+	return p;
+}
+
+static Uint32 readVarint( const Uint8*& p, const Uint8* end ) {
+	Uint32 val = 0;
+	int shift = 0;
+	while ( p < end && shift < 35 ) {
+		Uint8 b = *p++;
+		val |= (Uint32)( b & 0x7F ) << shift;
+		if ( !( b & 0x80 ) )
+			break;
+		shift += 7;
+	}
+	return val;
+}
+
+static inline Uint8* writeRune( Uint8* p, Rune u ) {
+	if ( u < 0x80 ) {
+		*p++ = (Uint8)u;
+	} else if ( u < 0x800 ) {
+		*p++ = (Uint8)( 0xC0 | ( u >> 6 ) );
+		*p++ = (Uint8)( 0x80 | ( u & 0x3F ) );
+	} else if ( u < 0x10000 ) {
+		*p++ = (Uint8)( 0xE0 | ( u >> 12 ) );
+		*p++ = (Uint8)( 0x80 | ( ( u >> 6 ) & 0x3F ) );
+		*p++ = (Uint8)( 0x80 | ( u & 0x3F ) );
+	} else {
+		*p++ = (Uint8)( 0xF0 | ( ( u >> 18 ) & 0x07 ) );
+		*p++ = (Uint8)( 0x80 | ( ( u >> 12 ) & 0x3F ) );
+		*p++ = (Uint8)( 0x80 | ( ( u >> 6 ) & 0x3F ) );
+		*p++ = (Uint8)( 0x80 | ( u & 0x3F ) );
+	}
+	return p;
+}
+
+static Rune readRune( const Uint8*& p, const Uint8* end ) {
+	Uint8 b = *p++;
+	int extra = b < 0xC0 ? 0 : b < 0xE0 ? 1 : b < 0xF0 ? 2 : 3;
+	Rune u = extra == 0 ? b : b & ( 0x3F >> extra );
+	for ( ; extra > 0 && p < end; extra-- )
+		u = ( u << 6 ) | ( *p++ & 0x3F );
+	return u;
+}
+
+/* Maximum size of an encoded line: the columns and text length, one run per cell and the text */
+static size_t maxEncodedLineSize( int cols ) {
+	return 5 + 5 + (size_t)cols * ( 4 * 5 ) + (size_t)cols * 4;
+}
+
+/* Line encoding:
+ * columns, number of text cells, the attribute runs ( length, mode, fg, bg ) covering every
+ * column and the text cells runes in UTF-8. The cells after the text are blanks. */
+static Uint8* encodeLine( Uint8* p, const TerminalGlyph* line, int cols ) {
+	int textLen = cols;
+	while ( textLen > 0 && line[textLen - 1].u == ' ' )
+		textLen--;
+
+	p = writeVarint( p, cols );
+	p = writeVarint( p, textLen );
+
+	for ( int i = 0; i < cols; ) {
+		int j = i + 1;
+		while ( j < cols && !ATTRCMP( line[j], line[i] ) )
+			j++;
+		p = writeVarint( p, j - i );
+		p = writeVarint( p, line[i].mode );
+		p = writeVarint( p, line[i].fg );
+		p = writeVarint( p, line[i].bg );
+		i = j;
+	}
+
+	for ( int i = 0; i < textLen; i++ ) {
+		if ( line[i].u < 0x80 ) {
+			*p++ = (Uint8)line[i].u;
+		} else {
+			p = writeRune( p, line[i].u );
+		}
+	}
+
+	return p;
+}
+
+static void decodeLine( const Uint8* p, const Uint8* end, TerminalGlyph* out, int cols,
+						const TerminalGlyph& blank ) {
+	int lineCols = (int)readVarint( p, end );
+	int textLen = (int)readVarint( p, end );
+	int x = 0;
+
+	for ( int lineX = 0; lineX < lineCols && p < end; ) {
+		int len = (int)readVarint( p, end );
+		TerminalGlyph g;
+		g.u = ' ';
+		g.mode = (ushort)readVarint( p, end );
+		g.fg = readVarint( p, end );
+		g.bg = readVarint( p, end );
+		for ( int i = 0; i < len && x < cols; i++ )
+			out[x++] = g;
+		lineX += len;
+	}
+
+	for ( ; x < cols; x++ )
+		out[x] = blank;
+
+	for ( int i = 0; i < textLen && p < end; i++ ) {
+		Rune u = *p < 0x80 ? *p++ : readRune( p, end );
+		if ( i < cols )
+			out[i].u = u;
+	}
+}
+
+TerminalHistory::TerminalHistory( size_t maxLines ) : mMaxLines( maxLines ) {
+	mBlank.u = ' ';
+	setCacheLines( 128 );
+}
+
+TerminalHistory::~TerminalHistory() {}
+
+void TerminalHistory::setMaxLines( size_t maxLines ) {
+	mMaxLines = maxLines;
+	trim();
+}
+
+size_t TerminalHistory::getMaxLines() const {
+	return mMaxLines;
+}
+
+size_t TerminalHistory::size() const {
+	return mNextId - mFirstId;
+}
+
+bool TerminalHistory::empty() const {
+	return mNextId == mFirstId;
+}
+
+void TerminalHistory::push( const TerminalGlyph* line, int cols ) {
+	if ( mMaxLines == 0 )
+		return;
+
+	if ( mBlocks.empty() || mBlocks.back().offsets.size() == LinesPerBlock ) {
+		size_t reserve = 0;
+
+		if ( !mBlocks.empty() ) {
+			reserve = mBlocks.back().rawSize;
+			mPendingBlocks++;
+
+			if ( !mDeferredCompression ) {
+				seal( mBlocks.size() - 1 );
+			} else if ( mPendingBlocks > MAX_PENDING_BLOCKS ) {
+				// Nobody is compressing the blocks, keep the memory bounded
+				seal( mBlocks.size() - mPendingBlocks );
+			}
+		}
+
+		mBlocks.emplace_back();
+		mBlocks.back().data.reserve( reserve );
+	}
+
+	Block& block = mBlocks.back();
+	if ( mEncodeBuffer.size() < maxEncodedLineSize( cols ) )
+		mEncodeBuffer.resize( maxEncodedLineSize( cols ) );
+	Uint8* end = encodeLine( mEncodeBuffer.data(), line, cols );
+	block.offsets.push_back( (Uint32)block.data.size() );
+	block.data.insert( block.data.end(), mEncodeBuffer.data(), end );
+	block.rawSize = (Uint32)block.data.size();
+
+	CachedLine& cached = mLineCache[mNextId % mLineCache.size()];
+	if ( cached.id == mNextId )
+		cached.id = UINT64_MAX;
+
+	mNextId++;
+	trim();
+}
+
+void TerminalHistory::pop() {
+	if ( empty() )
+		return;
+
+	if ( mBlocks.back().offsets.empty() && mBlocks.size() > 1 ) {
+		mBlocks.pop_back();
+		unseal( mBlocks.size() - 1 );
+	}
+
+	Block& block = mBlocks.back();
+	block.data.resize( block.offsets.back() );
+	block.offsets.pop_back();
+	block.rawSize = (Uint32)block.data.size();
+
+	mNextId--;
+	mModifications++;
+
+	CachedLine& cached = mLineCache[mNextId % mLineCache.size()];
+	if ( cached.id == mNextId )
+		cached.id = UINT64_MAX;
+}
+
+void TerminalHistory::clear() {
+	mBlocks.clear();
+	mPendingBlocks = 0;
+	mModifications++;
+	mDecodedBlocks.clear();
+	mDecodedBlocks.shrink_to_fit();
+	mEncodeBuffer.clear();
+	mEncodeBuffer.shrink_to_fit();
+	for ( auto& cached : mLineCache ) {
+		cached.id = UINT64_MAX;
+		cached.glyphs.clear();
+		cached.glyphs.shrink_to_fit();
+	}
+	mBaseId = mFirstId = mNextId;
+}
+
+void TerminalHistory::trim() {
+	if ( size() > mMaxLines )
+		mFirstId = mNextId - mMaxLines;
+
+	while ( mBlocks.size() > 1 && mBaseId + LinesPerBlock <= mFirstId ) {
+		if ( !mBlocks.front().sealed )
+			mPendingBlocks--;
+		invalidateDecodedBlock( mBaseId );
+		mBlocks.pop_front();
+		mBaseId += LinesPerBlock;
+	}
+}
+
+void TerminalHistory::setDeferredCompression( bool deferred ) {
+	mDeferredCompression = deferred;
+
+	if ( !deferred ) {
+		while ( mPendingBlocks > 0 )
+			seal( mBlocks.size() - 1 - mPendingBlocks );
+	}
+}
+
+bool TerminalHistory::getDeferredCompression() const {
+	return mDeferredCompression;
+}
+
+size_t TerminalHistory::getPendingBlockCount() const {
+	return mPendingBlocks;
+}
+
+bool TerminalHistory::getPendingBlock( PendingBlock& pending ) const {
+	if ( mPendingBlocks == 0 )
+		return false;
+
+	size_t index = mBlocks.size() - 1 - mPendingBlocks;
+	pending.firstId = mBaseId + index * LinesPerBlock;
+	pending.modifications = mModifications;
+	pending.data = mBlocks[index].data;
+	pending.compressed.clear();
+	return true;
+}
+
+void TerminalHistory::compressBlock( PendingBlock& pending ) {
+	pending.compressed.clear();
+
+	IOStreamMemory src( (const char*)pending.data.data(), pending.data.size() );
+	IOStreamString dst;
+	Compression::Config config;
+	config.zlib.level = BLOCK_COMPRESSION_LEVEL;
+
+	if ( pending.data.empty() ||
+		 Compression::compress( dst, src, Compression::MODE_DEFLATE, config ) !=
+			 Compression::OK ||
+		 dst.getSize() >= pending.data.size() )
+		return;
+
+	const std::string& compressed = dst.getStream();
+	pending.compressed.assign( compressed.begin(), compressed.end() );
+}
+
+bool TerminalHistory::setCompressedBlock( PendingBlock& pending ) {
+	if ( pending.modifications != mModifications || mPendingBlocks == 0 ||
+		 pending.firstId != mBaseId + ( mBlocks.size() - 1 - mPendingBlocks ) * LinesPerBlock )
+		return false;
+
+	Block& block = mBlocks[mBlocks.size() - 1 - mPendingBlocks];
+
+	if ( !pending.compressed.empty() ) {
+		block.data = std::move( pending.compressed );
+		block.compressed = true;
+	}
+
+	block.data.shrink_to_fit();
+	block.offsets.shrink_to_fit();
+	block.sealed = true;
+	mPendingBlocks--;
+	return true;
+}
+
+void TerminalHistory::seal( size_t index ) {
+	Block& block = mBlocks[index];
+	PendingBlock pending;
+	pending.data = std::move( block.data );
+	compressBlock( pending );
+	block.compressed = !pending.compressed.empty();
+	block.data = std::move( block.compressed ? pending.compressed : pending.data );
+	block.data.shrink_to_fit();
+	block.offsets.shrink_to_fit();
+	block.sealed = true;
+	mPendingBlocks--;
+}
+
+void TerminalHistory::unseal( size_t index ) {
+	Block& block = mBlocks[index];
+
+	if ( !block.sealed ) {
+		// The block was waiting to be compressed
+		mPendingBlocks--;
+		return;
+	}
+
+	if ( block.compressed ) {
+		std::vector<Uint8> raw( block.rawSize );
+		if ( Compression::decompress( raw.data(), raw.size(), block.data.data(), block.data.size(),
+									  Compression::MODE_DEFLATE ) != Compression::OK ) {
+			// The lines are lost, zeroed they are decoded as empty lines
+			Log::error( "TerminalHistory: failed to decompress a history block" );
+			std::fill( raw.begin(), raw.end(), 0 );
+		}
+		block.data = std::move( raw );
+		block.compressed = false;
+	}
+
+	block.sealed = false;
+	invalidateDecodedBlock( mBaseId + index * LinesPerBlock );
+}
+
+void TerminalHistory::invalidateDecodedBlock( Uint64 firstId ) {
+	mDecodedBlocks.erase( std::remove_if( mDecodedBlocks.begin(), mDecodedBlocks.end(),
+										  [firstId]( const DecodedBlock& decoded ) {
+											  return decoded.firstId == firstId;
+										  } ),
+						  mDecodedBlocks.end() );
+}
+
+const Uint8* TerminalHistory::getLineData( Uint64 lineId, const Uint8** end ) const {
+	if ( lineId < mFirstId || lineId >= mNextId )
+		return nullptr;
+
+	size_t blockIndex = ( lineId - mBaseId ) / LinesPerBlock;
+	size_t lineIndex = ( lineId - mBaseId ) % LinesPerBlock;
+	const Block& block = mBlocks[blockIndex];
+	const Uint8* data = block.data.data();
+
+	if ( block.compressed ) {
+		Uint64 firstId = mBaseId + blockIndex * LinesPerBlock;
+		auto it = std::find_if(
+			mDecodedBlocks.begin(), mDecodedBlocks.end(),
+			[firstId]( const DecodedBlock& decoded ) { return decoded.firstId == firstId; } );
+
+		if ( it == mDecodedBlocks.end() ) {
+			if ( mDecodedBlocks.size() >= MAX_DECODED_BLOCKS )
+				mDecodedBlocks.pop_back();
+
+			DecodedBlock decoded;
+			decoded.firstId = firstId;
+			decoded.data.resize( block.rawSize );
+			if ( Compression::decompress( decoded.data.data(), decoded.data.size(),
+										  block.data.data(), block.data.size(),
+										  Compression::MODE_DEFLATE ) != Compression::OK ) {
+				Log::error( "TerminalHistory: failed to decompress a history block" );
+				return nullptr;
+			}
+			mDecodedBlocks.insert( mDecodedBlocks.begin(), std::move( decoded ) );
+		} else if ( it != mDecodedBlocks.begin() ) {
+			std::rotate( mDecodedBlocks.begin(), it, it + 1 );
+		}
+
+		data = mDecodedBlocks.front().data.data();
+	}
+
+	*end = data + ( lineIndex + 1 < block.offsets.size() ? block.offsets[lineIndex + 1]
+														 : block.rawSize );
+	return data + block.offsets[lineIndex];
+}
+
+Line TerminalHistory::getLine( size_t index, int cols ) const {
+	Uint64 lineId = getLineId( index );
+	CachedLine& cached = mLineCache[lineId % mLineCache.size()];
+
+	if ( cached.id == lineId && cached.cols == cols )
+		return cached.glyphs.data();
+
+	cached.id = lineId;
+	cached.cols = cols;
+	cached.glyphs.resize( cols );
+
+	const Uint8* end = nullptr;
+	const Uint8* data = getLineData( lineId, &end );
+
+	if ( data ) {
+		decodeLine( data, end, cached.glyphs.data(), cols, mBlank );
+	} else {
+		std::fill( cached.glyphs.begin(), cached.glyphs.end(), mBlank );
+	}
+
+	return cached.glyphs.data();
+}
+
+void TerminalHistory::setBlank( const TerminalGlyph& blank ) {
+	if ( mBlank == blank )
+		return;
+	mBlank = blank;
+	mBlank.u = ' ';
+	for ( auto& cached : mLineCache )
+		cached.id = UINT64_MAX;
+}
+
+void TerminalHistory::setCacheLines( size_t cacheLines ) {
+	cacheLines = std::max<size_t>( cacheLines, 1 );
+	if ( cacheLines == mLineCache.size() )
+		return;
+	mLineCache.clear();
+	mLineCache.resize( cacheLines );
+}
+
+size_t TerminalHistory::getCacheLines() const {
+	return mLineCache.size();
+}
+
+Uint64 TerminalHistory::getLineId( size_t index ) const {
+	return mNextId - 1 - index;
+}
+
+Int64 TerminalHistory::getLineIndex( Uint64 lineId ) const {
+	if ( lineId < mFirstId || lineId >= mNextId )
+		return -1;
+	return (Int64)( mNextId - 1 - lineId );
+}
+
+bool TerminalHistory::getLineText( Uint64 lineId, std::string& text,
+								   std::vector<int>* columns ) const {
+	text.clear();
+	if ( columns )
+		columns->clear();
+
+	const Uint8* end = nullptr;
+	const Uint8* p = getLineData( lineId, &end );
+
+	if ( !p )
+		return false;
+
+	int lineCols = (int)readVarint( p, end );
+	int textLen = (int)readVarint( p, end );
+	const Uint8* runsData = p;
+
+	for ( int x = 0; x < lineCols && p < end; ) {
+		x += (int)readVarint( p, end );
+		for ( int i = 0; i < 3; i++ )
+			readVarint( p, end );
+	}
+
+	int runEnd = 0;
+	ushort mode = 0;
+
+	for ( int x = 0; x < textLen && p < end; x++ ) {
+		while ( x >= runEnd && runEnd < lineCols ) {
+			runEnd += (int)readVarint( runsData, end );
+			mode = (ushort)readVarint( runsData, end );
+			readVarint( runsData, end );
+			readVarint( runsData, end );
+		}
+
+		const Uint8* start = p;
+		Rune u = readRune( p, end );
+
+		if ( mode & ATTR_WDUMMY )
+			continue;
+
+		if ( u == 0 ) {
+			text += ' ';
+		} else {
+			text.append( (const char*)start, p - start );
+		}
+
+		if ( columns )
+			columns->resize( text.size(), x );
+	}
+
+	if ( columns )
+		columns->push_back( textLen );
+
+	return true;
+}
+
+size_t TerminalHistory::getMemoryUsage() const {
+	size_t usage = sizeof( *this ) + mEncodeBuffer.capacity();
+
+	for ( const auto& block : mBlocks )
+		usage += sizeof( Block ) + block.data.capacity() +
+				 block.offsets.capacity() * sizeof( Uint32 );
+
+	for ( const auto& decoded : mDecodedBlocks )
+		usage += sizeof( DecodedBlock ) + decoded.data.capacity();
+
+	for ( const auto& cached : mLineCache )
+		usage += sizeof( CachedLine ) + cached.glyphs.capacity() * sizeof( TerminalGlyph );
+
+	return usage;
+}
+
+TerminalHistorySearch::TerminalHistorySearch( const std::string& pattern, bool caseSensitive,
+											  bool isRegEx ) :
+	mPattern( pattern ), mCaseSensitive( caseSensitive ) {
+	if ( isRegEx ) {
+		mRegEx = std::make_unique<RegEx>(
+			mPattern, caseSensitive ? RegEx::Options::Utf
+									: (RegEx::Options)( RegEx::Options::Utf | RegEx::Caseless ) );
+	} else if ( !caseSensitive ) {
+		String::toLowerInPlace( mPattern );
+	}
+}
+
+TerminalHistorySearch::~TerminalHistorySearch() {}
+
+bool TerminalHistorySearch::isValid() const {
+	return !mPattern.empty() && ( !mRegEx || mRegEx->isValid() );
+}
+
+void TerminalHistorySearch::reset() {
+	mStarted = false;
+	mDone = false;
+	mMatches.clear();
+}
+
+bool TerminalHistorySearch::step( const TerminalHistory& history, size_t maxLines ) {
+	if ( mDone )
+		return true;
+
+	if ( !isValid() ) {
+		mDone = true;
+		return true;
+	}
+
+	if ( !mStarted ) {
+		mStarted = true;
+		mNextLineId = history.getNextLineId();
+	}
+
+	for ( size_t i = 0; i < maxLines; i++ ) {
+		if ( mNextLineId <= history.getFirstLineId() ) {
+			mDone = true;
+			break;
+		}
+
+		mNextLineId--;
+
+		// The oldest lines were dropped while searching
+		if ( !history.getLineText( mNextLineId, mText, &mColumns ) ) {
+			mDone = true;
+			break;
+		}
+
+		searchLine( mNextLineId );
+	}
+
+	return mDone;
+}
+
+void TerminalHistorySearch::searchLine( Uint64 lineId ) {
+	if ( mText.empty() )
+		return;
+
+	auto addMatch = [&]( size_t start, size_t end ) {
+		mMatches.push_back(
+			{ lineId, mColumns[start], mColumns[end] - mColumns[start] } );
+	};
+
+	if ( mRegEx ) {
+		int offset = 0;
+		int start, end;
+		while ( offset < (int)mText.size() &&
+				mRegEx->find( mText.c_str(), start, end, offset, (int)mText.size() ) ) {
+			if ( end > start )
+				addMatch( start, end );
+			offset = end > start ? end : start + 1;
+		}
+		return;
+	}
+
+	if ( !mCaseSensitive )
+		String::toLowerInPlace( mText );
+
+	size_t pos = 0;
+	while ( ( pos = mText.find( mPattern, pos ) ) != std::string::npos ) {
+		addMatch( pos, pos + mPattern.size() );
+		pos += mPattern.size();
+	}
+}
+
+}} // namespace eterm::Terminal
@@ -83,6 +83,7 @@ class EE_MAPS_API MapEditor {
 	UIMenuCheckBox* mChkShowGrid;
 	UIMenuCheckBox* mChkMarkTileOver;
 	UIMenuCheckBox* mChkShowBlocked;
+	UIMenuCheckBox* mChkSaveChunked;
 	UICheckBox* mChkClampToTile;
 
 	//! Light Color
@@ -71,6 +71,30 @@ struct sMapLightHdr {
 	Uint32 Type;
 };
 
+//! Chunked map format: the header, properties, texture atlases, virtual object types and layers
+//! are stored as in the plain format, followed by the sMapChunksHdr, the object layers, the lights,
+//! the chunk index table ( one sMapChunkIndex per chunk, row-major ) and the chunks data.
+//! Every chunk stores its tiles ( row-major ) the same way the plain format stores the map tiles.
+enum EE_MAP_CHUNK_COMPRESSION { MAP_CHUNK_COMPRESSION_NONE, MAP_CHUNK_COMPRESSION_DEFLATE };
+
+#define EE_MAP_CHUNKED_VERSION ( 1 )
+#define EE_MAP_DEFAULT_CHUNK_SIZE ( 32 )
+
+struct sMapChunksHdr {
+	Uint32 Version;
+	Uint32 ChunkSize;
+	Uint32 ChunksX;
+	Uint32 ChunksY;
+	Uint32 Compression;
+	Uint32 Reserved;
+};
+
+struct sMapChunkIndex {
+	Uint64 Offset;	 //! Offset from the beginning of the chunks data
+	Uint32 Size;	 //! Stored ( possibly compressed ) size, zero for empty chunks
+	Uint32 DataSize; //! Uncompressed size
+};
+
 struct sMapObjObjHdr {
 	char Name[MAP_PROPERTY_SIZE];
 	char Type[MAP_PROPERTY_SIZE];
@@ -59,6 +59,12 @@ class EE_MAPS_API MapLight {
 
 	void setPosition( const Vector2f& newPos );
 
+	/** Static lights are baked once into the light manager static layer and only recomputed
+	 * when any of their properties change. */
+	const bool& isStatic() const;
+
+	void setStatic( const bool& isStatic );
+
   protected:
 	Float mRadius;
 	Vector2f mPos;
@@ -66,6 +72,7 @@ class EE_MAPS_API MapLight {
 	MapLightType mType;
 	Rectf mAABB;
 	bool mActive;
+	bool mStatic;
 
 	void updateAABB();
 };
@@ -3,11 +3,20 @@
 
 #include <eepp/maps/base.hpp>
 #include <eepp/maps/maplight.hpp>
+#include <eepp/system/threadpool.hpp>
+#include <memory>
+#include <unordered_map>
 
 namespace EE { namespace Maps {
 
 class TileMap;
 
+/** The light manager keeps a flat lightmap buffer with one color per light sample (one sample per
+ * tile, or one sample per tile corner when the lights are computed by vertex).
+ * The lightmap is updated incrementally: only the samples touched by lights that have been
+ * added, removed, moved or modified (and the samples that became visible) are recomputed.
+ * Static lights ( MapLight::isStatic ) are baked into a separate layer that is only rebuilt when
+ * a static light changes, dynamic lights are composited on top of it. */
 class EE_MAPS_API MapLightManager {
   public:
 	typedef std::vector<MapLight*> LightsList;
@@ -38,12 +47,46 @@ class EE_MAPS_API MapLightManager {
 
 	MapLight* getLightOver( const Vector2f& OverPos, MapLight* LightCurrent = NULL );
 
+	/** Forces a full recomputation of the lightmap in the next update. */
+	void invalidate();
+
+	/** Sets a thread pool used to compute the dirty lightmap rows in parallel. */
+	void setThreadPool( const std::shared_ptr<ThreadPool>& threadPool );
+
+	const std::shared_ptr<ThreadPool>& getThreadPool() const;
+
+	/** @return The number of light samples recomputed in the last update. */
+	const Uint64& getLastUpdateSamplesCount() const;
+
   protected:
+	struct LightState {
+		Rectf AABB;
+		RGB Color;
+		MapLightType Type{ MapLightType::Normal };
+		bool Active{ true };
+		bool Static{ false };
+
+		LightState() {}
+
+		explicit LightState( MapLight* Light );
+
+		bool operator==( const LightState& other ) const;
+	};
+
 	TileMap* mMap;
 	Int32 mNumVertex;
-	Color**** mTileColors;
+	Sizei mGridSize;
+	Vector2f mSampleOffset;
+	std::vector<Color> mStaticColors;
+	std::vector<Color> mColors;
 	LightsList mLights;
+	std::unordered_map<MapLight*, LightState> mLightStates;
+	std::shared_ptr<ThreadPool> mThreadPool;
+	Rect mValidSamples;
+	Color mBaseColor;
+	Uint64 mLastUpdateSamplesCount{ 0 };
 	bool mIsByVertex;
+	bool mStaticInvalid{ true };
 
 	void allocateColors();
 
@@ -51,9 +94,19 @@ class EE_MAPS_API MapLightManager {
 
 	void destroyLights();
 
-	virtual void updateByVertex();
+	void updateLights();
+
+	Rect getSamplesFromArea( const Rectf& area ) const;
+
+	Rect getVisibleSamples() const;
+
+	Vector2f getSamplePosition( const Int32& x, const Int32& y ) const;
+
+	void updateStaticSamples( const Rect& samples );
+
+	void updateSamples( const Rect& samples );
 
-	virtual void updateByTile();
+	void updateSamplesRows( const Rect& samples, const LightsList& lights );
 };
 
 }} // namespace EE::Maps
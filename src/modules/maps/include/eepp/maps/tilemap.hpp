@@ -8,6 +8,7 @@
 #include <eepp/maps/maplayer.hpp>
 #include <eepp/maps/maplight.hpp>
 #include <eepp/maps/maplightmanager.hpp>
+#include <eepp/maps/tilemapchunks.hpp>
 
 #include <eepp/window/engine.hpp>
 #include <eepp/window/input.hpp>
@@ -25,6 +26,7 @@ class UIMapNew;
 
 #define EE_MAP_LAYER_UNKNOWN eeINDEX_NOT_FOUND
 #define EE_MAP_MAGIC ( ( 'E' << 0 ) | ( 'E' << 8 ) | ( 'M' << 16 ) | ( 'P' << 24 ) )
+#define EE_MAP_CHUNKED_MAGIC ( ( 'E' << 0 ) | ( 'E' << 8 ) | ( 'M' << 16 ) | ( 'C' << 24 ) )
 
 class EE_MAPS_API TileMap {
   public:
@@ -232,8 +234,25 @@ class EE_MAPS_API TileMap {
 
 	const Color& setGridLinesColor() const;
 
+	/** Sets if the map will be saved using the chunked map format. Maps loaded from a file keep
+	 * the format of the file. */
+	void setChunkedFormat( const bool& chunked, const Uint32& chunkSize = EE_MAP_DEFAULT_CHUNK_SIZE,
+						   const Uint32& compression = MAP_CHUNK_COMPRESSION_DEFLATE );
+
+	const bool& isChunkedFormat() const;
+
+	/** Enables streaming the tiles of chunked maps in and out around the view. If enabled before
+	 * loading the map only the chunks around the view will be loaded. */
+	void setChunkStreaming( const bool& streaming );
+
+	const bool& isChunkStreaming() const;
+
+	/** @return The chunks of the map if the map was loaded from the chunked map format. */
+	TileMapChunks* getChunks() const;
+
   protected:
 	friend class EE::Maps::Private::UIMapNew;
+	friend class TileMapChunks;
 
 	class ForcedHeaders {
 	  public:
@@ -286,6 +305,12 @@ class EE_MAPS_API TileMap {
 	Uint32 mLastObjId;
 	PolyObjMap mPolyObjs;
 	ForcedHeaders* mForcedHeaders;
+	TileMapChunks* mChunks;
+	std::string mChunksSourcePath;
+	Uint32 mChunkSize;
+	Uint32 mChunkCompression;
+	bool mChunkedFormat;
+	bool mChunkStreaming;
 
 	virtual GameObject* createGameObject( const Uint32& Type, const Uint32& Flags, MapLayer* Layer,
 										  const Uint32& DataId = 0 );
@@ -0,0 +1,123 @@
+#ifndef EE_MAPS_TILEMAPCHUNKS_HPP
+#define EE_MAPS_TILEMAPCHUNKS_HPP
+
+#include <eepp/maps/base.hpp>
+#include <eepp/maps/maphelper.hpp>
+#include <eepp/system/mutex.hpp>
+#include <eepp/system/threadpool.hpp>
+#include <memory>
+#include <unordered_set>
+
+namespace EE { namespace Maps {
+
+class TileMap;
+
+/** @brief Keeps the chunk index of a map loaded from the chunked map format and streams the tiles
+ * of the chunks in and out around the map view.
+ * Chunks are read and decompressed in a background thread, the tile game objects are created in
+ * the main thread from TileMap::update. Chunks that have been modified since they were loaded are
+ * never streamed out. */
+class EE_MAPS_API TileMapChunks {
+  public:
+	/** Converts a map saved in the plain map format into the chunked map format.
+	 * @param src The plain map stream
+	 * @param dst The stream where the chunked map will be written
+	 * @param chunkSize The chunk width and height in tiles
+	 * @param compression The chunks compression ( EE_MAP_CHUNK_COMPRESSION ) */
+	static bool convert( IOStream& src, IOStream& dst,
+						 const Uint32& chunkSize = EE_MAP_DEFAULT_CHUNK_SIZE,
+						 const Uint32& compression = MAP_CHUNK_COMPRESSION_DEFLATE );
+
+	/** Writes the chunk index table and the chunks data of the map.
+	 * @param chunks The chunks of the map if it was loaded from a chunked map, chunks that are
+	 * not loaded are read from its source. */
+	static void write( TileMap* map, IOStream& IOS, const sMapChunksHdr& hdr,
+					   TileMapChunks* chunks = NULL );
+
+	TileMapChunks( TileMap* map, const Sizei& mapSize, const sMapChunksHdr& hdr );
+
+	~TileMapChunks();
+
+	/** Reads the chunk index table and the chunks data source.
+	 * @param IOS The map stream, positioned at the chunk index table
+	 * @param sourcePath If not empty, the file where the chunks will be streamed from, otherwise
+	 * the chunks data is kept in memory ( compressed ). */
+	bool load( IOStream& IOS, const std::string& sourcePath = "" );
+
+	/** Requests the chunks around the view, creates the tiles of the chunks already decoded and
+	 * releases the chunks far away from the view. */
+	void update();
+
+	/** Synchronously loads every chunk not yet loaded. */
+	void loadAll();
+
+	void setStreaming( const bool& streaming );
+
+	const bool& isStreaming() const;
+
+	/** Number of chunks around the visible chunks that are also kept loaded. */
+	void setMargin( const Uint32& margin );
+
+	const Uint32& getMargin() const;
+
+	const sMapChunksHdr& getHeader() const;
+
+	Uint32 getLoadedCount() const;
+
+	/** Marks the chunk containing the tile as modified. Modified chunks are never streamed out. */
+	void invalidateTile( const Vector2i& tilePos );
+
+	bool isChunkLoaded( const Vector2i& chunkPos ) const;
+
+  protected:
+	enum ChunkState : Uint8 { Unloaded, Loading, Loaded };
+
+	struct TileRecord {
+		Vector2i Pos;
+		Uint32 Layer;
+		sMapTileGOHdr Hdr;
+	};
+
+	struct DecodedChunk {
+		Uint32 Index;
+		std::vector<TileRecord> Tiles;
+	};
+
+	TileMap* mMap;
+	Sizei mMapSize;
+	sMapChunksHdr mHdr;
+	std::vector<sMapChunkIndex> mIndex;
+	std::vector<ChunkState> mState;
+	std::vector<bool> mModified;
+	std::unordered_set<Uint32> mLoaded;
+	std::unique_ptr<IOStream> mSource;
+	std::string mSourceData;
+	ios_size mDataOffset{ 0 };
+	Mutex mSourceMutex;
+	Mutex mDecodedMutex;
+	std::vector<DecodedChunk> mDecoded;
+	std::unique_ptr<ThreadPool> mThreadPool;
+	Uint32 mMargin{ 1 };
+	bool mStreaming{ false };
+	bool mUpdatingTiles{ false };
+
+	Rect getChunksInView( const Int32& margin ) const;
+
+	bool readChunkData( const Uint32& index, std::string& data );
+
+	bool decodeChunk( const Uint32& index, DecodedChunk& chunk );
+
+	void createTiles( const DecodedChunk& chunk );
+
+	void loadChunk( const Uint32& index );
+
+	void unloadChunk( const Uint32& index );
+
+	void requestChunk( const Uint32& index );
+
+	static std::string encodeChunk( TileMap* map, const Rect& tiles );
+};
+
+}} // namespace EE::Maps
+
+#endif
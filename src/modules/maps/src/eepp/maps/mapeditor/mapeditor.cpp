@@ -132,6 +132,7 @@ void MapEditor::createMenuBar() {
 															   PixelDensity::dpToPxI( 16 ) ) );
 	PU1->add( "Save As...", PU1->getUISceneNode()->findIconDrawable(
 								"document-save-as", PixelDensity::dpToPxI( 16 ) ) );
+	mChkSaveChunked = PU1->addCheckBox( "Save Chunked" );
 	PU1->addSeparator();
 	PU1->add( "Close", PU1->getUISceneNode()->findIconDrawable( "document-close",
 																PixelDensity::dpToPxI( 16 ) ) );
@@ -1160,6 +1161,8 @@ void MapEditor::fileMenuClick( const Event* Event ) {
 		if ( mUIMap->Map()->getPath().size() ) {
 			mUIMap->Map()->saveToFile( mUIMap->Map()->getPath() );
 		}
+	} else if ( "Save Chunked" == txt ) {
+		mUIMap->Map()->setChunkedFormat( Event->getNode()->asType<UIMenuCheckBox>()->isActive() );
 	} else if ( "Close" == txt ) {
 		UIMessageBox* MsgBox = UIMessageBox::New(
 			UIMessageBox::OK_CANCEL,
@@ -1615,6 +1618,7 @@ void MapEditor::setViewOptions() {
 	mChkShowGrid->setActive( mUIMap->Map()->getDrawGrid() ? true : false );
 	mChkMarkTileOver->setActive( mUIMap->Map()->getDrawTileOver() ? true : false );
 	mChkShowBlocked->setActive( mUIMap->Map()->getShowBlocked() ? true : false );
+	mChkSaveChunked->setActive( mUIMap->Map()->isChunkedFormat() );
 }
 
 }} // namespace EE::Maps
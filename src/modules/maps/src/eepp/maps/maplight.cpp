@@ -3,13 +3,13 @@
 namespace EE { namespace Maps {
 
 MapLight::MapLight() :
-	mRadius( 0 ), mColor( 255, 255, 255 ), mType( MapLightType::Normal ), mActive( true ) {}
+	mRadius( 0 ), mColor( 255, 255, 255 ), mType( MapLightType::Normal ), mActive( true ), mStatic( false ) {}
 
 MapLight::~MapLight() {}
 
 MapLight::MapLight( const Float& Radius, const Float& x, const Float& y, const RGB& Color,
 					MapLightType Type ) :
-	mActive( true ) {
+	mActive( true ), mStatic( false ) {
 	create( Radius, x, y, Color, Type );
 }
 
@@ -189,4 +189,12 @@ const Vector2f& MapLight::getPosition() const {
 	return mPos;
 }
 
+const bool& MapLight::isStatic() const {
+	return mStatic;
+}
+
+void MapLight::setStatic( const bool& isStatic ) {
+	mStatic = isStatic;
+}
+
 }} // namespace EE::Maps
@@ -1,10 +1,41 @@
 #include <algorithm>
+#include <condition_variable>
 #include <eepp/maps/maplightmanager.hpp>
 #include <eepp/maps/tilemap.hpp>
+#include <mutex>
 
 namespace EE { namespace Maps {
 
-MapLightManager::MapLightManager( TileMap* Map, bool ByVertex ) : mMap( Map ), mTileColors( NULL ) {
+namespace {
+
+Rect samplesIntersection( const Rect& a, const Rect& b ) {
+	Rect r( eemax( a.Left, b.Left ), eemax( a.Top, b.Top ), eemin( a.Right, b.Right ),
+			 eemin( a.Bottom, b.Bottom ) );
+	if ( r.Left >= r.Right || r.Top >= r.Bottom )
+		return Rect();
+	return r;
+}
+
+bool samplesEmpty( const Rect& r ) {
+	return r.Left >= r.Right || r.Top >= r.Bottom;
+}
+
+} // namespace
+
+MapLightManager::LightState::LightState( MapLight* Light ) :
+	AABB( Light->getAABB() ),
+	Color( Light->getColor() ),
+	Type( Light->getType() ),
+	Active( Light->isActive() ),
+	Static( Light->isStatic() ) {}
+
+bool MapLightManager::LightState::operator==( const LightState& other ) const {
+	return AABB == other.AABB && Color.r == other.Color.r && Color.g == other.Color.g &&
+		   Color.b == other.Color.b && Type == other.Type && Active == other.Active &&
+		   Static == other.Static;
+}
+
+MapLightManager::MapLightManager( TileMap* Map, bool ByVertex ) : mMap( Map ) {
 	mIsByVertex = ByVertex;
 
 	if ( mIsByVertex )
@@ -21,119 +52,222 @@ MapLightManager::~MapLightManager() {
 }
 
 void MapLightManager::update() {
-	if ( mIsByVertex ) {
-		updateByVertex();
-	} else {
-		updateByTile();
-	}
+	if ( mLights.empty() && mLightStates.empty() )
+		return;
+
+	updateLights();
 }
 
 const bool& MapLightManager::isByVertex() const {
 	return mIsByVertex;
 }
 
-void MapLightManager::updateByVertex() {
+void MapLightManager::invalidate() {
+	mStaticInvalid = true;
+}
+
+void MapLightManager::setThreadPool( const std::shared_ptr<ThreadPool>& threadPool ) {
+	mThreadPool = threadPool;
+}
+
+const std::shared_ptr<ThreadPool>& MapLightManager::getThreadPool() const {
+	return mThreadPool;
+}
+
+const Uint64& MapLightManager::getLastUpdateSamplesCount() const {
+	return mLastUpdateSamplesCount;
+}
+
+Vector2f MapLightManager::getSamplePosition( const Int32& x, const Int32& y ) const {
+	const Sizei& tileSize = mMap->getTileSize();
+	return Vector2f( x * tileSize.x + mSampleOffset.x, y * tileSize.y + mSampleOffset.y );
+}
+
+Rect MapLightManager::getSamplesFromArea( const Rectf& area ) const {
+	const Sizei& tileSize = mMap->getTileSize();
+	Rect samples(
+		(Int32)eeceil( ( area.Left - mSampleOffset.x ) / tileSize.x ),
+		(Int32)eeceil( ( area.Top - mSampleOffset.y ) / tileSize.y ),
+		(Int32)eefloor( ( area.Right - mSampleOffset.x ) / tileSize.x ) + 1,
+		(Int32)eefloor( ( area.Bottom - mSampleOffset.y ) / tileSize.y ) + 1 );
+	return samplesIntersection( samples, Rect( 0, 0, mGridSize.x, mGridSize.y ) );
+}
+
+Rect MapLightManager::getVisibleSamples() const {
 	Vector2i start = mMap->getStartTile();
 	Vector2i end = mMap->getEndTile();
-	Rectf VisibleArea = mMap->getViewAreaAABB();
-	Sizei TileSize = mMap->getTileSize();
-	Color BaseColor = mMap->getBaseColor();
-	bool firstLight = true;
-	Vector2i Pos;
 
-	if ( !mLights.size() )
-		return;
+	// Vertex samples are the tile corners, so the visible tiles need one extra row and column.
+	if ( mIsByVertex ) {
+		end.x++;
+		end.y++;
+	}
 
-	for ( LightsList::iterator it = mLights.begin(); it != mLights.end(); ++it ) {
-		MapLight* Light = ( *it );
+	return samplesIntersection( Rect( start.x, start.y, end.x, end.y ),
+								Rect( 0, 0, mGridSize.x, mGridSize.y ) );
+}
 
-		if ( firstLight || VisibleArea.intersect( Light->getAABB() ) ) {
-			for ( Int32 x = start.x; x < end.x; x++ ) {
-				for ( Int32 y = start.y; y < end.y; y++ ) {
-					if ( firstLight ) {
-						mTileColors[x][y][0]->r = mTileColors[x][y][1]->r =
-							mTileColors[x][y][2]->r = mTileColors[x][y][3]->r = BaseColor.r;
-						mTileColors[x][y][0]->g = mTileColors[x][y][1]->g =
-							mTileColors[x][y][2]->g = mTileColors[x][y][3]->g = BaseColor.g;
-						mTileColors[x][y][0]->b = mTileColors[x][y][1]->b =
-							mTileColors[x][y][2]->b = mTileColors[x][y][3]->b = BaseColor.b;
-					}
+void MapLightManager::updateLights() {
+	std::vector<Rectf> staticDirty;
+	std::vector<Rectf> dynamicDirty;
+	std::unordered_map<MapLight*, LightState> states;
+	states.reserve( mLights.size() );
 
-					Pos.x = x * TileSize.x;
-					Pos.y = y * TileSize.y;
-
-					Rectf TileAABB( Pos.x, Pos.y, Pos.x + TileSize.x, Pos.y + TileSize.y );
-
-					if ( TileAABB.intersect( Light->getAABB() ) ) {
-						if ( y > 0 )
-							mTileColors[x][y][0]->assign( *mTileColors[x][y - 1][1] );
-						else
-							mTileColors[x][y][0]->assign(
-								Light->processVertex( Pos.x, Pos.y, *( mTileColors[x][y][0] ),
-													  *( mTileColors[x][y][0] ) ) );
-
-						mTileColors[x][y][1]->assign( Light->processVertex(
-							Pos.x, Pos.y + TileSize.getHeight(), *( mTileColors[x][y][1] ),
-							*( mTileColors[x][y][1] ) ) );
-
-						mTileColors[x][y][2]->assign( Light->processVertex(
-							Pos.x + TileSize.getWidth(), Pos.y + TileSize.getHeight(),
-							*( mTileColors[x][y][2] ), *( mTileColors[x][y][2] ) ) );
-
-						if ( y > 0 )
-							mTileColors[x][y][3]->assign( *mTileColors[x][y - 1][2] );
-						else
-							mTileColors[x][y][3]->assign( Light->processVertex(
-								Pos.x + TileSize.getWidth(), Pos.y, *( mTileColors[x][y][3] ),
-								*( mTileColors[x][y][3] ) ) );
-					}
-				}
+	const Color& baseColor = mMap->getBaseColor();
+
+	if ( baseColor != mBaseColor ) {
+		mBaseColor = baseColor;
+		mStaticInvalid = true;
+	}
+
+	for ( MapLight* Light : mLights ) {
+		LightState state( Light );
+		auto found = mLightStates.find( Light );
+
+		if ( found == mLightStates.end() ) {
+			( state.Static ? staticDirty : dynamicDirty ).push_back( state.AABB );
+		} else {
+			if ( !( found->second == state ) ) {
+				( found->second.Static ? staticDirty : dynamicDirty )
+					.push_back( found->second.AABB );
+				( state.Static ? staticDirty : dynamicDirty ).push_back( state.AABB );
 			}
 
-			firstLight = false;
+			mLightStates.erase( found );
+		}
+
+		states[Light] = state;
+	}
+
+	// Whatever is left was removed since the last update
+	for ( const auto& removed : mLightStates )
+		( removed.second.Static ? staticDirty : dynamicDirty ).push_back( removed.second.AABB );
+
+	mLightStates.swap( states );
+
+	mLastUpdateSamplesCount = 0;
+
+	if ( mStaticInvalid ) {
+		updateStaticSamples( Rect( 0, 0, mGridSize.x, mGridSize.y ) );
+		mValidSamples = Rect();
+		mStaticInvalid = false;
+	} else {
+		for ( const Rectf& area : staticDirty ) {
+			updateStaticSamples( getSamplesFromArea( area ) );
+			dynamicDirty.push_back( area );
+		}
+	}
+
+	Rect visible = getVisibleSamples();
+	Rect valid = samplesIntersection( visible, mValidSamples );
+
+	if ( samplesEmpty( valid ) ) {
+		updateSamples( visible );
+	} else {
+		// Only the newly visible strips around the still valid area need to be computed
+		updateSamples( Rect( visible.Left, visible.Top, visible.Right, valid.Top ) );
+		updateSamples( Rect( visible.Left, valid.Bottom, visible.Right, visible.Bottom ) );
+		updateSamples( Rect( visible.Left, valid.Top, valid.Left, valid.Bottom ) );
+		updateSamples( Rect( valid.Right, valid.Top, visible.Right, valid.Bottom ) );
+
+		for ( const Rectf& area : dynamicDirty )
+			updateSamples( samplesIntersection( getSamplesFromArea( area ), valid ) );
+	}
+
+	mValidSamples = visible;
+}
+
+void MapLightManager::updateStaticSamples( const Rect& samples ) {
+	if ( samplesEmpty( samples ) )
+		return;
+
+	Color base( mBaseColor.r, mBaseColor.g, mBaseColor.b, 255 );
+
+	for ( Int32 y = samples.Top; y < samples.Bottom; y++ ) {
+		Color* row = &mStaticColors[y * mGridSize.x];
+		for ( Int32 x = samples.Left; x < samples.Right; x++ )
+			row[x] = base;
+	}
+
+	for ( MapLight* Light : mLights ) {
+		if ( !Light->isStatic() || !Light->isActive() )
+			continue;
+
+		Rect lightSamples = samplesIntersection( getSamplesFromArea( Light->getAABB() ), samples );
+
+		for ( Int32 y = lightSamples.Top; y < lightSamples.Bottom; y++ ) {
+			Color* row = &mStaticColors[y * mGridSize.x];
+			for ( Int32 x = lightSamples.Left; x < lightSamples.Right; x++ ) {
+				Vector2f pos( getSamplePosition( x, y ) );
+				row[x] = Light->processVertex( pos.x, pos.y, row[x], row[x] );
+			}
 		}
 	}
 }
 
-void MapLightManager::updateByTile() {
-	Vector2i start = mMap->getStartTile();
-	Vector2i end = mMap->getEndTile();
-	Rectf VisibleArea = mMap->getViewAreaAABB();
-	Sizei TileSize = mMap->getTileSize();
-	Sizei HalfTileSize = mMap->getTileSize() / 2;
-	Color BaseColor = mMap->getBaseColor();
-	bool firstLight = true;
-	Vector2i Pos;
+void MapLightManager::updateSamples( const Rect& samples ) {
+	if ( samplesEmpty( samples ) )
+		return;
 
-	if ( !mLights.size() )
+	LightsList lights;
+
+	for ( MapLight* Light : mLights ) {
+		if ( !Light->isStatic() && Light->isActive() &&
+			 !samplesEmpty(
+				 samplesIntersection( getSamplesFromArea( Light->getAABB() ), samples ) ) )
+			lights.push_back( Light );
+	}
+
+	Int32 rows = samples.Bottom - samples.Top;
+	Uint64 count = (Uint64)rows * ( samples.Right - samples.Left );
+	mLastUpdateSamplesCount += count;
+
+	// Small regions are not worth the synchronization cost
+	if ( !mThreadPool || mThreadPool->numThreads() <= 1 || rows < 2 || lights.empty() ||
+		 count * lights.size() < 16384 ) {
+		updateSamplesRows( samples, lights );
 		return;
+	}
 
-	for ( LightsList::iterator it = mLights.begin(); it != mLights.end(); ++it ) {
-		MapLight* Light = ( *it );
+	Int32 chunks = eemin<Int32>( rows, mThreadPool->numThreads() );
+	Int32 rowsPerChunk = ( rows + chunks - 1 ) / chunks;
+	std::mutex mutex;
+	std::condition_variable cond;
+	Int32 pending = 0;
+
+	for ( Int32 top = samples.Top; top < samples.Bottom; top += rowsPerChunk ) {
+		Rect chunk( samples.Left, top, samples.Right, eemin( top + rowsPerChunk, samples.Bottom ) );
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			pending++;
+		}
+		mThreadPool->run( [this, chunk, &lights, &mutex, &cond, &pending] {
+			updateSamplesRows( chunk, lights );
+			std::lock_guard<std::mutex> lock( mutex );
+			pending--;
+			cond.notify_all();
+		} );
+	}
 
-		if ( firstLight || VisibleArea.intersect( Light->getAABB() ) ) {
-			for ( Int32 x = start.x; x < end.x; x++ ) {
-				for ( Int32 y = start.y; y < end.y; y++ ) {
-					if ( firstLight ) {
-						mTileColors[x][y][0]->r = BaseColor.r;
-						mTileColors[x][y][0]->g = BaseColor.g;
-						mTileColors[x][y][0]->b = BaseColor.b;
-					}
+	std::unique_lock<std::mutex> lock( mutex );
+	cond.wait( lock, [&pending] { return pending <= 0; } );
+}
 
-					Pos.x = x * TileSize.x;
-					Pos.y = y * TileSize.y;
+void MapLightManager::updateSamplesRows( const Rect& samples, const LightsList& lights ) {
+	for ( Int32 y = samples.Top; y < samples.Bottom; y++ ) {
+		const Color* staticRow = &mStaticColors[y * mGridSize.x];
+		Color* row = &mColors[y * mGridSize.x];
 
-					Rectf TileAABB( Pos.x, Pos.y, Pos.x + TileSize.x, Pos.y + TileSize.y );
+		for ( Int32 x = samples.Left; x < samples.Right; x++ ) {
+			Color col( staticRow[x] );
+			Vector2f pos( getSamplePosition( x, y ) );
 
-					if ( TileAABB.intersect( Light->getAABB() ) ) {
-						mTileColors[x][y][0]->assign( Light->processVertex(
-							Pos.x + HalfTileSize.getWidth(), Pos.y + HalfTileSize.getHeight(),
-							*( mTileColors[x][y][0] ), *( mTileColors[x][y][0] ) ) );
-					}
-				}
+			for ( MapLight* Light : lights ) {
+				if ( Light->getAABB().contains( pos ) )
+					col = Light->processVertex( pos.x, pos.y, col, col );
 			}
 
-			firstLight = false;
+			row[x] = col;
 		}
 	}
 }
@@ -193,7 +327,7 @@ const Color* MapLightManager::getTileColor( const Vector2i& TilePos ) {
 	if ( !mLights.size() )
 		return &mMap->getBaseColor();
 
-	return mTileColors[TilePos.x][TilePos.y][0];
+	return &mColors[TilePos.y * mGridSize.x + TilePos.x];
 }
 
 const Color* MapLightManager::getTileColor( const Vector2i& TilePos, const Uint32& Vertex ) {
@@ -202,42 +336,41 @@ const Color* MapLightManager::getTileColor( const Vector2i& TilePos, const Uint3
 	if ( !mLights.size() )
 		return &mMap->getBaseColor();
 
-	return mTileColors[TilePos.x][TilePos.y][Vertex];
+	// Vertex order: top-left, bottom-left, bottom-right, top-right
+	static const Vector2i VertexOffset[4] = { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 1, 0 } };
+
+	const Vector2i& offset = VertexOffset[Vertex & 3];
+
+	return &mColors[( TilePos.y + offset.y ) * mGridSize.x + TilePos.x + offset.x];
 }
 
 void MapLightManager::allocateColors() {
 	Sizei Size = mMap->getSize();
-	mTileColors = eeNewArray( Color***, Size.getWidth() );
 
-	for ( Int32 x = 0; x < Size.x; x++ ) {
-		mTileColors[x] = eeNewArray( Color**, Size.getHeight() );
-
-		for ( Int32 y = 0; y < Size.y; y++ ) {
-			mTileColors[x][y] = eeNewArray( Color*, mNumVertex );
-
-			for ( Int32 v = 0; v < mNumVertex; v++ ) {
-				mTileColors[x][y][v] = eeNew( Color, ( 255, 255, 255, 255 ) );
-			}
-		}
+	// Tile corners are shared between neighbour tiles, so vertex samples form a lattice of
+	// ( width + 1 ) x ( height + 1 ) points.
+	if ( mIsByVertex ) {
+		mGridSize = Sizei( Size.x + 1, Size.y + 1 );
+		mSampleOffset = Vector2f::Zero;
+	} else {
+		Sizei HalfTileSize = mMap->getTileSize() / 2;
+		mGridSize = Size;
+		mSampleOffset = Vector2f( HalfTileSize.getWidth(), HalfTileSize.getHeight() );
 	}
+
+	size_t samples = (size_t)mGridSize.getWidth() * mGridSize.getHeight();
+	mStaticColors.assign( samples, Color::White );
+	mColors.assign( samples, Color::White );
+	mValidSamples = Rect();
+	mStaticInvalid = true;
 }
 
 void MapLightManager::deallocateColors() {
-	Sizei Size = mMap->getSize();
-
-	for ( Int32 x = 0; x < Size.x; x++ ) {
-		for ( Int32 y = 0; y < Size.y; y++ ) {
-			for ( Int32 v = 0; v < mNumVertex; v++ ) {
-				eeSAFE_DELETE( mTileColors[x][y][v] );
-			}
-
-			eeSAFE_DELETE_ARRAY( mTileColors[x][y] );
-		}
-
-		eeSAFE_DELETE_ARRAY( mTileColors[x] );
-	}
-
-	eeSAFE_DELETE_ARRAY( mTileColors );
+	mStaticColors.clear();
+	mStaticColors.shrink_to_fit();
+	mColors.clear();
+	mColors.shrink_to_fit();
+	mValidSamples = Rect();
 }
 
 void MapLightManager::destroyLights() {
@@ -45,7 +45,12 @@ TileMap::TileMap() :
 	mScale( 1 ),
 	mOffscale( 1, 1 ),
 	mLastObjId( 0 ),
-	mForcedHeaders( NULL ) {
+	mForcedHeaders( NULL ),
+	mChunks( NULL ),
+	mChunkSize( EE_MAP_DEFAULT_CHUNK_SIZE ),
+	mChunkCompression( MAP_CHUNK_COMPRESSION_DEFLATE ),
+	mChunkedFormat( false ),
+	mChunkStreaming( false ) {
 	setViewSize( mViewSize );
 }
 
@@ -78,6 +83,7 @@ void TileMap::disableForcedHeaders() {
 
 void TileMap::deleteLayers() {
 	eeSAFE_DELETE( mLightManager );
+	eeSAFE_DELETE( mChunks );
 
 	for ( Uint32 i = 0; i < mLayerCount; i++ )
 		eeSAFE_DELETE( mLayers[i] );
@@ -451,6 +457,9 @@ void TileMap::update() {
 
 	updateScreenAABB();
 
+	if ( NULL != mChunks )
+		mChunks->update();
+
 	if ( NULL != mLightManager )
 		mLightManager->update();
 
@@ -537,6 +546,32 @@ void TileMap::setBaseColor( const Color& color ) {
 	mBaseColor = color;
 }
 
+void TileMap::setChunkedFormat( const bool& chunked, const Uint32& chunkSize,
+								const Uint32& compression ) {
+	mChunkedFormat = chunked;
+	mChunkSize = eemax<Uint32>( 1, chunkSize );
+	mChunkCompression = compression;
+}
+
+const bool& TileMap::isChunkedFormat() const {
+	return mChunkedFormat;
+}
+
+void TileMap::setChunkStreaming( const bool& streaming ) {
+	mChunkStreaming = streaming;
+
+	if ( NULL != mChunks )
+		mChunks->setStreaming( streaming );
+}
+
+const bool& TileMap::isChunkStreaming() const {
+	return mChunkStreaming;
+}
+
+TileMapChunks* TileMap::getChunks() const {
+	return mChunks;
+}
+
 const Color& TileMap::getBaseColor() const {
 	return mBaseColor;
 }
@@ -816,7 +851,7 @@ bool TileMap::loadFromStream( IOStream& IOS ) {
 	if ( IOS.isOpen() ) {
 		IOS.read( (char*)&MapHdr, sizeof( sMapHdr ) );
 
-		if ( MapHdr.Magic == EE_MAP_MAGIC ) {
+		if ( MapHdr.Magic == EE_MAP_MAGIC || MapHdr.Magic == EE_MAP_CHUNKED_MAGIC ) {
 			if ( NULL == mForcedHeaders ) {
 				create( Sizei( MapHdr.SizeX, MapHdr.SizeY ), MapHdr.MaxLayers,
 						Sizei( MapHdr.TileSizeX, MapHdr.TileSizeY ), MapHdr.Flags );
@@ -827,6 +862,8 @@ bool TileMap::loadFromStream( IOStream& IOS ) {
 
 			setBaseColor( Color( MapHdr.BaseColor ) );
 
+			mChunkedFormat = MapHdr.Magic == EE_MAP_CHUNKED_MAGIC;
+
 			//! Load Properties
 			if ( MapHdr.PropertyCount ) {
 				sPropertyHdr* tProp = eeNewArray( sPropertyHdr, MapHdr.PropertyCount );
@@ -942,7 +979,17 @@ bool TileMap::loadFromStream( IOStream& IOS ) {
 					mSize = Sizei( MapHdr.SizeX, MapHdr.SizeY );
 				}
 
-				if ( ThereIsTiled ) {
+				if ( mChunkedFormat ) {
+					//! The tiled layers are stored in chunks after the lights
+					sMapChunksHdr tChunksHdr;
+
+					IOS.read( (char*)&tChunksHdr, sizeof( sMapChunksHdr ) );
+
+					mChunkSize = tChunksHdr.ChunkSize;
+					mChunkCompression = tChunksHdr.Compression;
+					mChunks = eeNew( TileMapChunks,
+									 ( this, Sizei( MapHdr.SizeX, MapHdr.SizeY ), tChunksHdr ) );
+				} else if ( ThereIsTiled ) {
 					//! First we read the tiled layers.
 					for ( y = 0; y < mSize.y; y++ ) {
 						for ( x = 0; x < mSize.x; x++ ) {
@@ -1061,6 +1108,20 @@ bool TileMap::loadFromStream( IOStream& IOS ) {
 					eeSAFE_DELETE_ARRAY( tLighsHdr );
 				}
 
+				if ( NULL != mChunks ) {
+					if ( !mChunks->load( IOS, mChunksSourcePath ) ) {
+						eeSAFE_DELETE( mChunks );
+						eeSAFE_DELETE_ARRAY( tLayersHdr );
+						return false;
+					}
+
+					if ( mChunkStreaming ) {
+						mChunks->setStreaming( true );
+					} else {
+						mChunks->loadAll();
+					}
+				}
+
 				eeSAFE_DELETE_ARRAY( tLayersHdr );
 			}
 
@@ -1085,7 +1146,14 @@ bool TileMap::loadFromFile( const std::string& path ) {
 
 		IOStreamFile IOS( mPath );
 
-		return loadFromStream( IOS );
+		//! Chunked maps loaded from a file stream its chunks from the same file
+		mChunksSourcePath = mPath;
+
+		bool loaded = loadFromStream( IOS );
+
+		mChunksSourcePath.clear();
+
+		return loaded;
 	} else if ( PackManager::instance()->isFallbackToPacksActive() ) {
 		std::string tPath( path );
 		Pack* tPack = PackManager::instance()->exists( tPath );
@@ -1125,7 +1193,7 @@ void TileMap::saveToStream( IOStream& IOS ) {
 
 	std::vector<std::string> TextureAtlases = getTextureAtlases();
 
-	MapHdr.Magic = EE_MAP_MAGIC;
+	MapHdr.Magic = mChunkedFormat ? EE_MAP_CHUNKED_MAGIC : EE_MAP_MAGIC;
 	MapHdr.Flags = mFlags;
 	MapHdr.MaxLayers = mMaxLayers;
 	MapHdr.SizeX = mSize.getWidth();
@@ -1249,7 +1317,19 @@ void TileMap::saveToStream( IOStream& IOS ) {
 
 		std::vector<GameObject*> tObjects( mLayerCount );
 
-		if ( ThereIsTiled ) {
+		sMapChunksHdr tChunksHdr;
+
+		if ( mChunkedFormat && mLayerCount ) {
+			//! The tiled layers are saved in chunks after the lights
+			tChunksHdr.Version = EE_MAP_CHUNKED_VERSION;
+			tChunksHdr.ChunkSize = mChunkSize;
+			tChunksHdr.ChunksX = ( mSize.x + mChunkSize - 1 ) / mChunkSize;
+			tChunksHdr.ChunksY = ( mSize.y + mChunkSize - 1 ) / mChunkSize;
+			tChunksHdr.Compression = mChunkCompression;
+			tChunksHdr.Reserved = 0;
+
+			IOS.write( (const char*)&tChunksHdr, sizeof( sMapChunksHdr ) );
+		} else if ( ThereIsTiled ) {
 			//! First we save the tiled layers.
 			for ( y = 0; y < mSize.y; y++ ) {
 				for ( x = 0; x < mSize.x; x++ ) {
@@ -1421,11 +1501,19 @@ void TileMap::saveToStream( IOStream& IOS ) {
 				IOS.write( (const char*)&tLightHdr, sizeof( sMapLightHdr ) );
 			}
 		}
+
+		if ( mChunkedFormat && mLayerCount )
+			TileMapChunks::write( this, IOS, tChunksHdr, mChunks );
 	}
 }
 
 void TileMap::saveToFile( const std::string& path ) {
 	if ( !FileSystem::isDirectory( path ) ) {
+		//! The chunks not loaded are read from the map file, so they must be loaded before
+		//! overwriting it
+		if ( NULL != mChunks && path == mPath )
+			mChunks->loadAll();
+
 		mPath = path;
 
 		IOStreamFile IOS( path, "wb" );
@@ -0,0 +1,661 @@
+#include <eepp/maps/gameobjectvirtual.hpp>
+#include <eepp/maps/tilemap.hpp>
+#include <eepp/maps/tilemapchunks.hpp>
+#include <eepp/maps/tilemaplayer.hpp>
+#include <eepp/system/compression.hpp>
+#include <eepp/system/iostreamstring.hpp>
+#include <eepp/system/lock.hpp>
+
+namespace EE { namespace Maps {
+
+namespace {
+
+bool compressChunk( const std::string& payload, const Uint32& compression, std::string& out ) {
+	out.clear();
+
+	if ( payload.empty() )
+		return true;
+
+	if ( compression == MAP_CHUNK_COMPRESSION_NONE ) {
+		out = payload;
+		return true;
+	}
+
+	IOStreamMemory src( payload.data(), payload.size() );
+	IOStreamString dst;
+
+	if ( Compression::compress( dst, src, Compression::MODE_DEFLATE ) != Compression::OK )
+		return false;
+
+	out = dst.getStream();
+	return true;
+}
+
+bool decompressChunk( const std::string& data, const Uint32& compression, const Uint32& dataSize,
+					  std::string& out ) {
+	out.clear();
+
+	if ( data.empty() )
+		return true;
+
+	if ( compression == MAP_CHUNK_COMPRESSION_NONE ) {
+		out = data;
+		return true;
+	}
+
+	out.resize( dataSize );
+
+	return Compression::decompress( (Uint8*)&out[0], out.size(), (const Uint8*)data.data(),
+									data.size(), Compression::MODE_DEFLATE ) == Compression::OK;
+}
+
+bool copyStream( IOStream& dst, IOStream& src, ios_size size ) {
+	char buffer[16384];
+
+	while ( size > 0 ) {
+		ios_size read = src.read( buffer, eemin<ios_size>( size, sizeof( buffer ) ) );
+
+		if ( read <= 0 )
+			return false;
+
+		dst.write( buffer, read );
+		size -= read;
+	}
+
+	return true;
+}
+
+//! Writes the chunk index table followed by the chunks data. getChunk returns the stored chunk
+//! data and its uncompressed size.
+void writeChunks( IOStream& IOS, const sMapChunksHdr& hdr,
+				  const std::function<void( const Uint32&, std::string&, Uint32& )>& getChunk ) {
+	Uint32 count = hdr.ChunksX * hdr.ChunksY;
+	std::vector<sMapChunkIndex> index( count );
+
+	ios_size indexPos = IOS.tell();
+
+	IOS.write( (const char*)index.data(), sizeof( sMapChunkIndex ) * count );
+
+	Uint64 offset = 0;
+	std::string data;
+
+	for ( Uint32 i = 0; i < count; i++ ) {
+		Uint32 dataSize = 0;
+
+		getChunk( i, data, dataSize );
+
+		index[i].Offset = offset;
+		index[i].Size = data.size();
+		index[i].DataSize = data.empty() ? 0 : dataSize;
+
+		if ( !data.empty() ) {
+			IOS.write( data.data(), data.size() );
+			offset += data.size();
+		}
+	}
+
+	ios_size endPos = IOS.tell();
+
+	IOS.seek( indexPos );
+	IOS.write( (const char*)index.data(), sizeof( sMapChunkIndex ) * count );
+	IOS.seek( endPos );
+}
+
+} // namespace
+
+bool TileMapChunks::convert( IOStream& src, IOStream& dst, const Uint32& chunkSize,
+							 const Uint32& compression ) {
+	sMapHdr MapHdr;
+
+	if ( !src.isOpen() || !dst.isOpen() || chunkSize == 0 ||
+		 src.read( (char*)&MapHdr, sizeof( sMapHdr ) ) != sizeof( sMapHdr ) ||
+		 MapHdr.Magic != EE_MAP_MAGIC )
+		return false;
+
+	sMapHdr ChunkedHdr( MapHdr );
+	ChunkedHdr.Magic = EE_MAP_CHUNKED_MAGIC;
+
+	dst.write( (const char*)&ChunkedHdr, sizeof( sMapHdr ) );
+
+	//! Properties, texture atlases and virtual object types are kept as is
+	if ( !copyStream( dst, src,
+					  sizeof( sPropertyHdr ) * MapHdr.PropertyCount +
+						  sizeof( sMapTextureAtlas ) * MapHdr.TextureAtlasCount +
+						  sizeof( sVirtualObj ) * MapHdr.VirtualObjectTypesCount ) )
+		return false;
+
+	if ( !MapHdr.LayerCount )
+		return copyStream( dst, src, src.getSize() - src.tell() );
+
+	bool ThereIsTiled = false;
+
+	for ( Uint32 i = 0; i < MapHdr.LayerCount; i++ ) {
+		sLayerHdr tLayerHdr;
+
+		if ( src.read( (char*)&tLayerHdr, sizeof( sLayerHdr ) ) != sizeof( sLayerHdr ) )
+			return false;
+
+		dst.write( (const char*)&tLayerHdr, sizeof( sLayerHdr ) );
+
+		if ( !copyStream( dst, src, sizeof( sPropertyHdr ) * tLayerHdr.PropertyCount ) )
+			return false;
+
+		if ( tLayerHdr.Type == MAP_LAYER_TILED )
+			ThereIsTiled = true;
+	}
+
+	sMapChunksHdr ChunksHdr;
+	ChunksHdr.Version = EE_MAP_CHUNKED_VERSION;
+	ChunksHdr.ChunkSize = chunkSize;
+	ChunksHdr.ChunksX = ( MapHdr.SizeX + chunkSize - 1 ) / chunkSize;
+	ChunksHdr.ChunksY = ( MapHdr.SizeY + chunkSize - 1 ) / chunkSize;
+	ChunksHdr.Compression = compression;
+	ChunksHdr.Reserved = 0;
+
+	dst.write( (const char*)&ChunksHdr, sizeof( sMapChunksHdr ) );
+
+	std::vector<std::string> payloads( ChunksHdr.ChunksX * ChunksHdr.ChunksY );
+	std::vector<bool> hasTiles( payloads.size(), false );
+
+	//! The plain format stores the tiles row-major, so appending every tile to its chunk keeps the
+	//! tiles row-major inside each chunk.
+	if ( ThereIsTiled ) {
+		for ( Uint32 y = 0; y < MapHdr.SizeY; y++ ) {
+			for ( Uint32 x = 0; x < MapHdr.SizeX; x++ ) {
+				Uint32 chunk = ( y / chunkSize ) * ChunksHdr.ChunksX + x / chunkSize;
+				std::string& payload = payloads[chunk];
+				Uint32 tReadFlag = 0;
+
+				if ( src.read( (char*)&tReadFlag, sizeof( Uint32 ) ) != sizeof( Uint32 ) )
+					return false;
+
+				payload.append( (const char*)&tReadFlag, sizeof( Uint32 ) );
+
+				for ( Uint32 i = 0; i < MapHdr.LayerCount; i++ ) {
+					if ( tReadFlag & ( 1u << i ) ) {
+						sMapTileGOHdr tTGOHdr;
+
+						if ( src.read( (char*)&tTGOHdr, sizeof( sMapTileGOHdr ) ) !=
+							 sizeof( sMapTileGOHdr ) )
+							return false;
+
+						payload.append( (const char*)&tTGOHdr, sizeof( sMapTileGOHdr ) );
+						hasTiles[chunk] = true;
+					}
+				}
+			}
+		}
+	}
+
+	//! Object layers and lights
+	if ( !copyStream( dst, src, src.getSize() - src.tell() ) )
+		return false;
+
+	bool success = true;
+
+	writeChunks( dst, ChunksHdr,
+				 [&]( const Uint32& index, std::string& data, Uint32& dataSize ) {
+					 data.clear();
+					 dataSize = 0;
+
+					 if ( hasTiles[index] ) {
+						 dataSize = payloads[index].size();
+						 success = compressChunk( payloads[index], compression, data ) && success;
+					 }
+
+					 payloads[index].clear();
+					 payloads[index].shrink_to_fit();
+				 } );
+
+	return success;
+}
+
+std::string TileMapChunks::encodeChunk( TileMap* map, const Rect& tiles ) {
+	std::string payload;
+	Uint32 layerCount = map->getLayerCount();
+	std::vector<GameObject*> tObjects( layerCount );
+	bool hasTiles = false;
+
+	for ( Int32 y = tiles.Top; y < tiles.Bottom; y++ ) {
+		for ( Int32 x = tiles.Left; x < tiles.Right; x++ ) {
+			Uint32 tReadFlag = 0;
+
+			for ( Uint32 i = 0; i < layerCount; i++ ) {
+				MapLayer* tLayer = map->getLayer( i );
+				tObjects[i] = NULL;
+
+				if ( NULL != tLayer && tLayer->getType() == MAP_LAYER_TILED ) {
+					tObjects[i] =
+						static_cast<TileMapLayer*>( tLayer )->getGameObject( Vector2i( x, y ) );
+
+					if ( NULL != tObjects[i] )
+						tReadFlag |= 1u << i;
+				}
+			}
+
+			payload.append( (const char*)&tReadFlag, sizeof( Uint32 ) );
+
+			for ( Uint32 i = 0; i < layerCount; i++ ) {
+				if ( tReadFlag & ( 1u << i ) ) {
+					GameObject* tObj = tObjects[i];
+					sMapTileGOHdr tTGOHdr;
+
+					tTGOHdr.Id = tObj->getDataId();
+
+					if ( tObj->getType() != GAMEOBJECT_TYPE_VIRTUAL ) {
+						tTGOHdr.Type = tObj->getType();
+					} else {
+						tTGOHdr.Type = static_cast<GameObjectVirtual*>( tObj )->getRealType();
+					}
+
+					tTGOHdr.Flags = tObj->getFlags();
+
+					payload.append( (const char*)&tTGOHdr, sizeof( sMapTileGOHdr ) );
+					hasTiles = true;
+				}
+			}
+		}
+	}
+
+	if ( !hasTiles )
+		payload.clear();
+
+	return payload;
+}
+
+void TileMapChunks::write( TileMap* map, IOStream& IOS, const sMapChunksHdr& hdr,
+						   TileMapChunks* chunks ) {
+	const Sizei& mapSize = map->getSize();
+
+	//! Chunks can only be copied from the source if the chunks layout did not change
+	if ( NULL != chunks &&
+		 ( chunks->mHdr.ChunkSize != hdr.ChunkSize || chunks->mHdr.ChunksX != hdr.ChunksX ||
+		   chunks->mHdr.ChunksY != hdr.ChunksY || chunks->mMapSize != mapSize ) ) {
+		chunks->loadAll();
+	}
+
+	writeChunks( IOS, hdr, [&]( const Uint32& index, std::string& data, Uint32& dataSize ) {
+		data.clear();
+		dataSize = 0;
+
+		if ( NULL != chunks && chunks->mState[index] != Loaded && !chunks->mModified[index] ) {
+			std::string stored;
+
+			if ( chunks->readChunkData( index, stored ) ) {
+				if ( chunks->mHdr.Compression == hdr.Compression ) {
+					data = std::move( stored );
+					dataSize = chunks->mIndex[index].DataSize;
+				} else {
+					std::string payload;
+
+					if ( decompressChunk( stored, chunks->mHdr.Compression,
+										  chunks->mIndex[index].DataSize, payload ) ) {
+						dataSize = payload.size();
+						compressChunk( payload, hdr.Compression, data );
+					}
+				}
+
+				return;
+			}
+		}
+
+		if ( NULL != chunks && chunks->mState[index] != Loaded )
+			chunks->loadChunk( index );
+
+		Int32 cx = index % hdr.ChunksX;
+		Int32 cy = index / hdr.ChunksX;
+		Int32 size = hdr.ChunkSize;
+		Rect tiles( cx * size, cy * size, eemin( ( cx + 1 ) * size, mapSize.x ),
+					eemin( ( cy + 1 ) * size, mapSize.y ) );
+		std::string payload( encodeChunk( map, tiles ) );
+
+		dataSize = payload.size();
+		compressChunk( payload, hdr.Compression, data );
+	} );
+}
+
+TileMapChunks::TileMapChunks( TileMap* map, const Sizei& mapSize, const sMapChunksHdr& hdr ) :
+	mMap( map ), mMapSize( mapSize ), mHdr( hdr ) {
+	Uint32 count = mHdr.ChunksX * mHdr.ChunksY;
+	mIndex.resize( count );
+	mState.resize( count, Unloaded );
+	mModified.resize( count, false );
+}
+
+TileMapChunks::~TileMapChunks() {
+	if ( mThreadPool ) {
+		mThreadPool->removeWithTag( (Uint64)this );
+		mThreadPool.reset();
+	}
+}
+
+bool TileMapChunks::load( IOStream& IOS, const std::string& sourcePath ) {
+	if ( mIndex.empty() )
+		return true;
+
+	ios_size indexSize = sizeof( sMapChunkIndex ) * mIndex.size();
+
+	if ( IOS.read( (char*)mIndex.data(), indexSize ) != indexSize )
+		return false;
+
+	Uint64 dataSize = 0;
+
+	for ( const auto& index : mIndex )
+		dataSize = eemax<Uint64>( dataSize, index.Offset + index.Size );
+
+	if ( !sourcePath.empty() ) {
+		mDataOffset = IOS.tell();
+		mSource = std::make_unique<IOStreamFile>( sourcePath );
+
+		if ( mSource->isOpen() )
+			return true;
+	}
+
+	//! The stream is not a file that can be reopened, keep the chunks data in memory
+	mDataOffset = 0;
+	mSourceData.resize( dataSize );
+
+	if ( dataSize && IOS.read( &mSourceData[0], dataSize ) != (ios_size)dataSize )
+		return false;
+
+	mSource = std::make_unique<IOStreamMemory>( mSourceData.data(), mSourceData.size() );
+
+	return true;
+}
+
+bool TileMapChunks::readChunkData( const Uint32& index, std::string& data ) {
+	const sMapChunkIndex& chunk = mIndex[index];
+
+	data.resize( chunk.Size );
+
+	if ( !chunk.Size )
+		return true;
+
+	if ( !mSource )
+		return false;
+
+	Lock l( mSourceMutex );
+
+	mSource->seek( mDataOffset + chunk.Offset );
+
+	return mSource->read( &data[0], chunk.Size ) == chunk.Size;
+}
+
+bool TileMapChunks::decodeChunk( const Uint32& index, DecodedChunk& chunk ) {
+	std::string stored;
+	std::string payload;
+
+	chunk.Index = index;
+	chunk.Tiles.clear();
+
+	if ( !readChunkData( index, stored ) ||
+		 !decompressChunk( stored, mHdr.Compression, mIndex[index].DataSize, payload ) )
+		return false;
+
+	if ( payload.empty() )
+		return true;
+
+	Int32 cx = index % mHdr.ChunksX;
+	Int32 cy = index / mHdr.ChunksX;
+	Int32 size = mHdr.ChunkSize;
+	Int32 endX = eemin( ( cx + 1 ) * size, mMapSize.x );
+	Int32 endY = eemin( ( cy + 1 ) * size, mMapSize.y );
+	const char* data = payload.data();
+	const char* end = data + payload.size();
+
+	for ( Int32 y = cy * size; y < endY; y++ ) {
+		for ( Int32 x = cx * size; x < endX; x++ ) {
+			Uint32 tReadFlag;
+
+			if ( data + sizeof( Uint32 ) > end )
+				return false;
+
+			memcpy( &tReadFlag, data, sizeof( Uint32 ) );
+			data += sizeof( Uint32 );
+
+			for ( Uint32 i = 0; i < 32 && tReadFlag; i++ ) {
+				if ( tReadFlag & ( 1u << i ) ) {
+					TileRecord record;
+
+					if ( data + sizeof( sMapTileGOHdr ) > end )
+						return false;
+
+					record.Pos = Vector2i( x, y );
+					record.Layer = i;
+					memcpy( &record.Hdr, data, sizeof( sMapTileGOHdr ) );
+					data += sizeof( sMapTileGOHdr );
+
+					chunk.Tiles.emplace_back( record );
+					tReadFlag &= ~( 1u << i );
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+void TileMapChunks::createTiles( const DecodedChunk& chunk ) {
+	const Sizei& mapSize = mMap->getSize();
+
+	mUpdatingTiles = true;
+
+	for ( const TileRecord& tile : chunk.Tiles ) {
+		MapLayer* layer = mMap->getLayer( tile.Layer );
+
+		if ( NULL == layer || layer->getType() != MAP_LAYER_TILED || tile.Pos.x >= mapSize.x ||
+			 tile.Pos.y >= mapSize.y )
+			continue;
+
+		TileMapLayer* tTLayer = static_cast<TileMapLayer*>( layer );
+
+		//! Tiles added while the chunk was not loaded have priority over the stored ones
+		if ( NULL != tTLayer->getGameObject( tile.Pos ) )
+			continue;
+
+		GameObject* tGO =
+			mMap->createGameObject( tile.Hdr.Type, tile.Hdr.Flags, layer, tile.Hdr.Id );
+
+		tTLayer->addGameObject( tGO, tile.Pos );
+	}
+
+	mUpdatingTiles = false;
+}
+
+void TileMapChunks::loadChunk( const Uint32& index ) {
+	if ( mState[index] == Loaded )
+		return;
+
+	DecodedChunk chunk;
+
+	if ( decodeChunk( index, chunk ) )
+		createTiles( chunk );
+
+	mState[index] = Loaded;
+	mLoaded.insert( index );
+}
+
+void TileMapChunks::unloadChunk( const Uint32& index ) {
+	const Sizei& mapSize = mMap->getSize();
+	Int32 cx = index % mHdr.ChunksX;
+	Int32 cy = index / mHdr.ChunksX;
+	Int32 size = mHdr.ChunkSize;
+	Int32 endX = eemin( ( cx + 1 ) * size, mapSize.x );
+	Int32 endY = eemin( ( cy + 1 ) * size, mapSize.y );
+
+	mUpdatingTiles = true;
+
+	for ( Uint32 i = 0; i < mMap->getLayerCount(); i++ ) {
+		MapLayer* layer = mMap->getLayer( i );
+
+		if ( NULL == layer || layer->getType() != MAP_LAYER_TILED )
+			continue;
+
+		TileMapLayer* tTLayer = static_cast<TileMapLayer*>( layer );
+
+		for ( Int32 y = cy * size; y < endY; y++ )
+			for ( Int32 x = cx * size; x < endX; x++ )
+				tTLayer->removeGameObject( Vector2i( x, y ) );
+	}
+
+	mUpdatingTiles = false;
+
+	mState[index] = Unloaded;
+	mLoaded.erase( index );
+}
+
+void TileMapChunks::requestChunk( const Uint32& index ) {
+	if ( !mIndex[index].Size ) {
+		mState[index] = Loaded;
+		mLoaded.insert( index );
+		return;
+	}
+
+	if ( !mThreadPool )
+		mThreadPool = ThreadPool::createUnique( 1 );
+
+	mState[index] = Loading;
+
+	mThreadPool->run(
+		[this, index] {
+			DecodedChunk chunk;
+
+			if ( !decodeChunk( index, chunk ) )
+				chunk.Tiles.clear();
+
+			Lock l( mDecodedMutex );
+			mDecoded.emplace_back( std::move( chunk ) );
+		},
+		[]( const Uint64& ) {}, (Uint64)this );
+}
+
+void TileMapChunks::loadAll() {
+	std::vector<DecodedChunk> decoded;
+
+	{
+		Lock l( mDecodedMutex );
+		decoded.swap( mDecoded );
+	}
+
+	for ( const DecodedChunk& chunk : decoded ) {
+		if ( mState[chunk.Index] == Loading ) {
+			createTiles( chunk );
+			mState[chunk.Index] = Loaded;
+			mLoaded.insert( chunk.Index );
+		}
+	}
+
+	for ( Uint32 i = 0; i < mIndex.size(); i++ )
+		loadChunk( i );
+}
+
+Rect TileMapChunks::getChunksInView( const Int32& margin ) const {
+	Int32 size = mHdr.ChunkSize;
+	const Vector2i& start = mMap->getStartTile();
+	const Vector2i& end = mMap->getEndTile();
+
+	return Rect( eemax( 0, start.x / size - margin ), eemax( 0, start.y / size - margin ),
+				 eemin<Int32>( mHdr.ChunksX, eemax( start.x, end.x - 1 ) / size + margin + 1 ),
+				 eemin<Int32>( mHdr.ChunksY, eemax( start.y, end.y - 1 ) / size + margin + 1 ) );
+}
+
+void TileMapChunks::update() {
+	if ( !mStreaming || mIndex.empty() )
+		return;
+
+	Rect view( getChunksInView( mMargin ) );
+	Rect keep( getChunksInView( mMargin + 1 ) );
+	std::vector<DecodedChunk> decoded;
+
+	{
+		Lock l( mDecodedMutex );
+		decoded.swap( mDecoded );
+	}
+
+	for ( const DecodedChunk& chunk : decoded ) {
+		if ( mState[chunk.Index] != Loading )
+			continue;
+
+		Int32 cx = chunk.Index % mHdr.ChunksX;
+		Int32 cy = chunk.Index / mHdr.ChunksX;
+
+		if ( cx >= keep.Left && cx < keep.Right && cy >= keep.Top && cy < keep.Bottom ) {
+			createTiles( chunk );
+			mState[chunk.Index] = Loaded;
+			mLoaded.insert( chunk.Index );
+		} else {
+			mState[chunk.Index] = Unloaded;
+		}
+	}
+
+	for ( Int32 cy = view.Top; cy < view.Bottom; cy++ ) {
+		for ( Int32 cx = view.Left; cx < view.Right; cx++ ) {
+			Uint32 index = cy * mHdr.ChunksX + cx;
+
+			if ( mState[index] == Unloaded )
+				requestChunk( index );
+		}
+	}
+
+	std::vector<Uint32> release;
+
+	for ( const Uint32& index : mLoaded ) {
+		Int32 cx = index % mHdr.ChunksX;
+		Int32 cy = index / mHdr.ChunksX;
+
+		if ( !mModified[index] &&
+			 ( cx < keep.Left || cx >= keep.Right || cy < keep.Top || cy >= keep.Bottom ) )
+			release.push_back( index );
+	}
+
+	for ( const Uint32& index : release )
+		unloadChunk( index );
+}
+
+void TileMapChunks::setStreaming( const bool& streaming ) {
+	mStreaming = streaming;
+
+	if ( !mStreaming )
+		loadAll();
+}
+
+const bool& TileMapChunks::isStreaming() const {
+	return mStreaming;
+}
+
+void TileMapChunks::setMargin( const Uint32& margin ) {
+	mMargin = margin;
+}
+
+const Uint32& TileMapChunks::getMargin() const {
+	return mMargin;
+}
+
+const sMapChunksHdr& TileMapChunks::getHeader() const {
+	return mHdr;
+}
+
+Uint32 TileMapChunks::getLoadedCount() const {
+	return mLoaded.size();
+}
+
+void TileMapChunks::invalidateTile( const Vector2i& tilePos ) {
+	if ( mUpdatingTiles || tilePos.x < 0 || tilePos.y < 0 || mHdr.ChunkSize == 0 )
+		return;
+
+	Uint32 cx = tilePos.x / mHdr.ChunkSize;
+	Uint32 cy = tilePos.y / mHdr.ChunkSize;
+
+	if ( cx < mHdr.ChunksX && cy < mHdr.ChunksY )
+		mModified[cy * mHdr.ChunksX + cx] = true;
+}
+
+bool TileMapChunks::isChunkLoaded( const Vector2i& chunkPos ) const {
+	if ( chunkPos.x < 0 || chunkPos.y < 0 || (Uint32)chunkPos.x >= mHdr.ChunksX ||
+		 (Uint32)chunkPos.y >= mHdr.ChunksY )
+		return false;
+
+	return mState[chunkPos.y * mHdr.ChunksX + chunkPos.x] == Loaded;
+}
+
+}} // namespace EE::Maps
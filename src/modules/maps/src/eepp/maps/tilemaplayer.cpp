@@ -106,6 +106,9 @@ void TileMapLayer::addGameObject( GameObject* obj, const Vector2i& TilePos ) {
 
 		mTiles[TilePos.x][TilePos.y] = obj;
 
+		if ( NULL != mMap->getChunks() )
+			mMap->getChunks()->invalidateTile( TilePos );
+
 		obj->setPosition(
 			Vector2f( TilePos.x * mMap->getTileSize().x, TilePos.y * mMap->getTileSize().y ) );
 	}
@@ -117,6 +120,9 @@ void TileMapLayer::removeGameObject( const Vector2i& TilePos ) {
 	if ( TilePos.x < mSize.x && TilePos.y < mSize.y ) {
 		if ( NULL != mTiles[TilePos.x][TilePos.y] ) {
 			eeSAFE_DELETE( mTiles[TilePos.x][TilePos.y] );
+
+			if ( NULL != mMap->getChunks() )
+				mMap->getChunks()->invalidateTile( TilePos );
 		}
 	}
 }
@@ -129,6 +135,11 @@ void TileMapLayer::moveTileObject( const Vector2i& FromPos, const Vector2i& ToPo
 	mTiles[FromPos.x][FromPos.y] = NULL;
 
 	mTiles[ToPos.x][ToPos.y] = tObj;
+
+	if ( NULL != mMap->getChunks() ) {
+		mMap->getChunks()->invalidateTile( FromPos );
+		mMap->getChunks()->invalidateTile( ToPos );
+	}
 }
 
 GameObject* TileMapLayer::getGameObject( const Vector2i& TilePos ) {
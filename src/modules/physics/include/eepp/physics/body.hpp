@@ -107,6 +107,19 @@ class EE_PHYSICS_API Body {
 
 	void setAngleDeg( const cpFloat& angle );
 
+	/** @return The position interpolated between the previous and the current fixed step (
+	 *PhysicsManager::getInterpolationAlpha ). */
+	cVect getInterpolatedPos() const;
+
+	/** @return The angle in radians interpolated between the previous and the current fixed
+	 *step. */
+	cpFloat getInterpolatedAngle() const;
+
+	cpFloat getInterpolatedAngleDeg() const;
+
+	/** Stores the current transform as the previous transform used for the interpolation. */
+	void storeTransform();
+
 	cpFloat getAngVel() const;
 
 	void setAngVel( const cpFloat& angVel );
@@ -171,6 +184,8 @@ class EE_PHYSICS_API Body {
 
 	cpBody* mBody;
 	void* mData;
+	cpVect mPrevPos;
+	cpFloat mPrevAngle;
 
 	BodyVelocityFunc mVelocityFunc;
 
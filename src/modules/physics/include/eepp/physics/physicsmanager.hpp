@@ -2,6 +2,7 @@
 #define EE_PHYSICS_PHYSICSMANAGER_HPP
 
 #include <eepp/physics/base.hpp>
+#include <eepp/system/time.hpp>
 
 namespace EE { namespace Physics {
 
@@ -37,6 +38,19 @@ class EE_PHYSICS_API PhysicsManager {
 		cpFloat LineThickness;
 	};
 
+	class StepStats {
+	  public:
+		//! Fixed steps executed in the last update
+		Uint32 Steps{ 0 };
+		//! Fixed steps dropped in the last update because they exceeded the catch-up budget
+		Uint32 DroppedSteps{ 0 };
+		//! Maximum number of fixed steps executed in a single update
+		Uint32 MaxSteps{ 0 };
+		Uint64 TotalSteps{ 0 };
+		Uint64 TotalDroppedSteps{ 0 };
+		Uint64 Updates{ 0 };
+	};
+
 	~PhysicsManager();
 
 	/** The Memory Manager will keep track of all the allocations from Space, Body, Shape and
@@ -51,8 +65,57 @@ class EE_PHYSICS_API PhysicsManager {
 
 	PhysicsManager::DrawSpaceOptions* getDrawOptions();
 
+	/** Advances every space by the elapsed time.
+	 *** If a fixed time step is set the elapsed time is accumulated and the spaces are stepped
+	 *with the fixed time step as many times as the accumulated time allows ( limited by the
+	 *maximum steps per update ), the remaining time is used to interpolate the body transforms.
+	 *** Otherwise the spaces are stepped once with the elapsed time.
+	 *** Every step is divided in the configured number of sub-steps.
+	 */
+	void update( const Time& elapsed );
+
+	/** Sets the fixed time step used by update. Time::Zero disables the fixed time step. */
+	void setFixedTimeStep( const Time& timeStep );
+
+	const Time& getFixedTimeStep() const;
+
+	/** Number of space steps of ( time step / sub-steps ) executed for every step. */
+	void setSubSteps( const Uint32& subSteps );
+
+	const Uint32& getSubSteps() const;
+
+	/** Maximum number of fixed steps executed in a single update, the accumulated time that
+	 *exceeds it is dropped so a slow frame can't make the simulation spiral. 0 means no limit.
+	 */
+	void setMaxStepsPerUpdate( const Uint32& maxSteps );
+
+	const Uint32& getMaxStepsPerUpdate() const;
+
+	/** Enables the interpolation of the body transforms between the last two fixed steps (
+	 *Body::getInterpolatedPos, Body::getInterpolatedAngle ). Enabled by default.
+	 */
+	void setInterpolation( bool interpolate );
+
+	const bool& isInterpolationEnabled() const;
+
+	/** @return The interpolation factor between the previous and the current fixed step
+	 *transforms. 1 when the fixed time step or the interpolation are disabled. */
+	const cpFloat& getInterpolationAlpha() const;
+
+	const StepStats& getStepStats() const;
+
+	/** Resets the accumulated time and the step stats. */
+	void resetStepScheduler();
+
   protected:
 	DrawSpaceOptions mOptions;
+	StepStats mStepStats;
+	Time mFixedTimeStep;
+	cpFloat mAccumulator;
+	cpFloat mInterpolationAlpha;
+	Uint32 mSubSteps;
+	Uint32 mMaxStepsPerUpdate;
+	bool mInterpolation;
 
 	friend class Body;
 	friend class Shape;
@@ -67,6 +130,8 @@ class EE_PHYSICS_API PhysicsManager {
 
 	PhysicsManager();
 
+	void stepSpaces( const cpFloat& dt, bool storeTransforms );
+
 	void addBodyFree( Body* body );
 
 	void removeBodyFree( Body* body );
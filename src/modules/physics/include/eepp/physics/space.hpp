@@ -6,6 +6,8 @@
 #include <eepp/physics/body.hpp>
 #include <eepp/physics/constraints/constraint.hpp>
 #include <eepp/physics/shape.hpp>
+#include <eepp/system/threadpool.hpp>
+#include <memory>
 
 namespace EE { namespace Physics {
 
@@ -110,6 +112,22 @@ class EE_PHYSICS_API Space {
 
 	void step( const cpFloat& dt );
 
+	/** Sets the number of threads used to step the space.
+	 * With 0 threads ( the default ) the space is stepped by the Chipmunk solver.
+	 * With 1 or more threads the space is stepped by the threaded solver: bodies are integrated
+	 * and arbiters and constraints are pre-stepped in parallel, and the contacts and constraints
+	 * are solved in batches that do not share any dynamic body. The batches do not depend on the
+	 * number of threads, so the simulation is deterministic for any thread count.
+	 * Collision handlers, constraint callbacks, custom body velocity and position functions and
+	 * post-step callbacks are always called from the thread that steps the space. */
+	void setThreadCount( const Uint32& threadCount );
+
+	const Uint32& getThreadCount() const;
+
+	/** Stores the current transform of every body of the space as its previous transform ( used
+	 * by PhysicsManager before the last fixed step of an update to interpolate the transforms ). */
+	void storeBodiesTransforms();
+
 	void update();
 
 	Body* getStaticBody() const;
@@ -248,6 +266,26 @@ class EE_PHYSICS_API Space {
 	UnorderedMap<cpHashValue, CollisionHandler> mCollisions;
 	CollisionHandler mCollisionsDefault;
 	std::vector<PostStepCallbackCont*> mPostStepCallbacks;
+	std::unique_ptr<ThreadPool> mThreadPool;
+	Uint32 mThreadCount{ 0 };
+
+	struct SolverItem {
+		cpArbiter* arbiter;
+		cpConstraint* constraint;
+	};
+
+	std::vector<std::vector<SolverItem>> mSolverBatches;
+	std::vector<cpBody*> mCustomVelocityBodies;
+	std::vector<cpBody*> mCustomPositionBodies;
+
+	void stepThreaded( const cpFloat& dt );
+
+	void buildSolverBatches();
+
+	void solveBatches( const std::function<void( const SolverItem& )>& func );
+
+	void parallelFor( const int& count, const int& minChunkSize,
+					  const std::function<void( int, int )>& func );
 };
 
 }} // namespace EE::Physics
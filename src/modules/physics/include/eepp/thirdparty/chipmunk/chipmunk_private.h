@@ -22,6 +22,10 @@
 #define CP_ALLOW_PRIVATE_ACCESS 1
 #include "chipmunk.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define CP_HASH_COEF (3344921057ul)
 #define CP_HASH_PAIR(A, B) ((cpHashValue)(A)*CP_HASH_COEF ^ (cpHashValue)(B)*CP_HASH_COEF)
 
@@ -263,3 +267,7 @@ void cpArbiterUpdate(cpArbiter *arb, cpContact *contacts, int numContacts, struc
 void cpArbiterPreStep(cpArbiter *arb, cpFloat dt, cpFloat bias, cpFloat slop);
 void cpArbiterApplyCachedImpulse(cpArbiter *arb, cpFloat dt_coef);
 void cpArbiterApplyImpulse(cpArbiter *arb);
+
+#ifdef __cplusplus
+}
+#endif
@@ -42,6 +42,9 @@ normal_relative_velocity(cpBody *a, cpBody *b, cpVect r1, cpVect r2, cpVect n){
 
 static inline void
 apply_impulse(cpBody *body, cpVect j, cpVect r){
+	// Bodies with infinite mass and moment are never written, the threaded solver of the eepp
+	// wrapper shares them between the constraints solved in parallel.
+	if(body->m_inv == 0.0f && body->i_inv == 0.0f) return;
 	body->v = cpvadd(body->v, cpvmult(j, body->m_inv));
 	body->w += body->i_inv*cpvcross(r, j);
 }
@@ -56,6 +59,7 @@ apply_impulses(cpBody *a , cpBody *b, cpVect r1, cpVect r2, cpVect j)
 static inline void
 apply_bias_impulse(cpBody *body, cpVect j, cpVect r)
 {
+	if(body->m_inv == 0.0f && body->i_inv == 0.0f) return;
 	body->CP_PRIVATE(v_bias) = cpvadd(body->CP_PRIVATE(v_bias), cpvmult(j, body->m_inv));
 	body->CP_PRIVATE(w_bias) += body->i_inv*cpvcross(r, j);
 }
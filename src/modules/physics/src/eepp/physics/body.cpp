@@ -44,6 +44,8 @@ Body::~Body() {
 void Body::setData() {
 	mBody->data = (void*)this;
 
+	storeTransform();
+
 	PhysicsManager::instance()->addBodyFree( this );
 }
 
@@ -101,6 +103,9 @@ cVect Body::getPos() const {
 
 void Body::setPos( const cVect& pos ) {
 	cpBodySetPos( mBody, tocpv( pos ) );
+
+	// Teleports must not be interpolated
+	mPrevPos = mBody->p;
 }
 
 cVect Body::getVel() const {
@@ -125,6 +130,8 @@ cpFloat Body::getAngle() const {
 
 void Body::setAngle( const cpFloat& rads ) {
 	cpBodySetAngle( mBody, rads );
+
+	mPrevAngle = mBody->a;
 }
 
 cpFloat Body::getAngleDeg() {
@@ -135,6 +142,24 @@ void Body::setAngleDeg( const cpFloat& angle ) {
 	this->setAngle( cpRadians( angle ) );
 }
 
+cVect Body::getInterpolatedPos() const {
+	return tovect(
+		cpvlerp( mPrevPos, mBody->p, PhysicsManager::instance()->getInterpolationAlpha() ) );
+}
+
+cpFloat Body::getInterpolatedAngle() const {
+	return cpflerp( mPrevAngle, mBody->a, PhysicsManager::instance()->getInterpolationAlpha() );
+}
+
+cpFloat Body::getInterpolatedAngleDeg() const {
+	return cpDegrees( getInterpolatedAngle() );
+}
+
+void Body::storeTransform() {
+	mPrevPos = mBody->p;
+	mPrevAngle = mBody->a;
+}
+
 cpFloat Body::getAngVel() const {
 	return cpBodyGetAngVel( mBody );
 }
@@ -9,14 +9,23 @@ namespace EE { namespace Physics {
 
 SINGLETON_DECLARE_IMPLEMENTATION( PhysicsManager )
 
-PhysicsManager::PhysicsManager() : mMemoryManager( false ) {}
+PhysicsManager::PhysicsManager() :
+	mFixedTimeStep( Time::Zero ),
+	mAccumulator( 0 ),
+	mInterpolationAlpha( 1 ),
+	mSubSteps( 1 ),
+	mMaxStepsPerUpdate( 8 ),
+	mInterpolation( true ),
+	mMemoryManager( false ) {}
 
 PhysicsManager::~PhysicsManager() {
 	if ( mMemoryManager ) {
 		mMemoryManager = false;
 
-		std::vector<Space*>::iterator its = mSpaces.begin();
-		for ( ; its != mSpaces.end(); ++its )
+		// The spaces remove themselves from the list when released
+		std::vector<Space*> spaces( mSpaces );
+		std::vector<Space*>::iterator its = spaces.begin();
+		for ( ; its != spaces.end(); ++its )
 			eeSAFE_DELETE( *its );
 
 		std::vector<Body*>::iterator itb = mBodysFree.begin();
@@ -92,18 +101,124 @@ void PhysicsManager::removeConstraintFree( Constraint* constraint ) {
 }
 
 void PhysicsManager::addSpace( Space* space ) {
-	if ( mMemoryManager ) {
-		if ( std::find( mSpaces.begin(), mSpaces.end(), space ) == mSpaces.end() )
-			mSpaces.push_back( space );
-	}
+	// The spaces are always tracked since update steps all of them
+	if ( std::find( mSpaces.begin(), mSpaces.end(), space ) == mSpaces.end() )
+		mSpaces.push_back( space );
 }
 
 void PhysicsManager::removeSpace( Space* space ) {
-	if ( mMemoryManager ) {
-		auto foundIt = std::find( mSpaces.begin(), mSpaces.end(), space );
-		if ( foundIt != mSpaces.end() )
-			mSpaces.erase( foundIt );
+	auto foundIt = std::find( mSpaces.begin(), mSpaces.end(), space );
+	if ( foundIt != mSpaces.end() )
+		mSpaces.erase( foundIt );
+}
+
+void PhysicsManager::stepSpaces( const cpFloat& dt, bool storeTransforms ) {
+	cpFloat subStep = dt / mSubSteps;
+
+	for ( size_t i = 0; i < mSpaces.size(); i++ ) {
+		Space* space = mSpaces[i];
+
+		if ( storeTransforms )
+			space->storeBodiesTransforms();
+
+		for ( Uint32 s = 0; s < mSubSteps; s++ )
+			space->step( subStep );
 	}
 }
 
+void PhysicsManager::update( const Time& elapsed ) {
+	mStepStats.Steps = 0;
+	mStepStats.DroppedSteps = 0;
+	mStepStats.Updates++;
+
+	if ( mFixedTimeStep == Time::Zero ) {
+		mInterpolationAlpha = 1;
+
+		if ( elapsed > Time::Zero ) {
+			stepSpaces( elapsed.asSeconds(), false );
+			mStepStats.Steps = 1;
+			mStepStats.TotalSteps++;
+			mStepStats.MaxSteps = eemax<Uint32>( mStepStats.MaxSteps, 1 );
+		}
+
+		return;
+	}
+
+	cpFloat timeStep = mFixedTimeStep.asSeconds();
+	mAccumulator += elapsed.asSeconds();
+
+	Uint32 steps = (Uint32)( mAccumulator / timeStep );
+
+	if ( mMaxStepsPerUpdate > 0 && steps > mMaxStepsPerUpdate ) {
+		mStepStats.DroppedSteps = steps - mMaxStepsPerUpdate;
+		mStepStats.TotalDroppedSteps += mStepStats.DroppedSteps;
+		mAccumulator -= mStepStats.DroppedSteps * timeStep;
+		steps = mMaxStepsPerUpdate;
+	}
+
+	for ( Uint32 i = 0; i < steps; i++ ) {
+		// Only the transforms previous to the last step are needed to interpolate
+		stepSpaces( timeStep, mInterpolation && i + 1 == steps );
+		mAccumulator -= timeStep;
+	}
+
+	mAccumulator = eemax<cpFloat>( 0, mAccumulator );
+	mInterpolationAlpha = mInterpolation ? eemin<cpFloat>( 1, mAccumulator / timeStep ) : 1;
+
+	mStepStats.Steps = steps;
+	mStepStats.TotalSteps += steps;
+	mStepStats.MaxSteps = eemax( mStepStats.MaxSteps, steps );
+}
+
+void PhysicsManager::setFixedTimeStep( const Time& timeStep ) {
+	mFixedTimeStep = timeStep > Time::Zero ? timeStep : Time::Zero;
+	mAccumulator = 0;
+	mInterpolationAlpha = 1;
+}
+
+const Time& PhysicsManager::getFixedTimeStep() const {
+	return mFixedTimeStep;
+}
+
+void PhysicsManager::setSubSteps( const Uint32& subSteps ) {
+	mSubSteps = eemax<Uint32>( 1, subSteps );
+}
+
+const Uint32& PhysicsManager::getSubSteps() const {
+	return mSubSteps;
+}
+
+void PhysicsManager::setMaxStepsPerUpdate( const Uint32& maxSteps ) {
+	mMaxStepsPerUpdate = maxSteps;
+}
+
+const Uint32& PhysicsManager::getMaxStepsPerUpdate() const {
+	return mMaxStepsPerUpdate;
+}
+
+void PhysicsManager::setInterpolation( bool interpolate ) {
+	mInterpolation = interpolate;
+
+	if ( !mInterpolation )
+		mInterpolationAlpha = 1;
+}
+
+const bool& PhysicsManager::isInterpolationEnabled() const {
+	return mInterpolation;
+}
+
+const cpFloat& PhysicsManager::getInterpolationAlpha() const {
+	return mInterpolationAlpha;
+}
+
+const PhysicsManager::StepStats& PhysicsManager::getStepStats() const {
+	return mStepStats;
+}
+
+void PhysicsManager::resetStepScheduler() {
+	mAccumulator = 0;
+	mInterpolationAlpha = 1;
+	mStepStats = StepStats();
+}
+
 }} // namespace EE::Physics
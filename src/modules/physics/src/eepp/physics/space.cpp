@@ -1,6 +1,10 @@
 #include <eepp/physics/physicsmanager.hpp>
 #include <eepp/physics/space.hpp>
 
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+
 #ifdef PHYSICS_RENDERER_ENABLED
 #include <eepp/graphics/globalbatchrenderer.hpp>
 #include <eepp/window/engine.hpp>
@@ -57,14 +61,308 @@ void* Space::getData() const {
 }
 
 void Space::step( const cpFloat& dt ) {
-	cpSpaceStep( mSpace, dt );
+	if ( mThreadCount > 0 ) {
+		stepThreaded( dt );
+	} else {
+		cpSpaceStep( mSpace, dt );
+	}
+}
+
+void Space::setThreadCount( const Uint32& threadCount ) {
+	if ( threadCount == mThreadCount )
+		return;
+
+	mThreadCount = threadCount;
+
+	// The calling thread always takes a share of the work
+	mThreadPool.reset();
+
+	if ( mThreadCount > 1 )
+		mThreadPool = ThreadPool::createUnique( mThreadCount - 1 );
+}
+
+const Uint32& Space::getThreadCount() const {
+	return mThreadCount;
+}
+
+void Space::storeBodiesTransforms() {
+	for ( auto& body : mBodys )
+		body->storeTransform();
+}
+
+void Space::parallelFor( const int& count, const int& minChunkSize,
+						 const std::function<void( int, int )>& func ) {
+	int chunks = eemin<int>( mThreadCount, ( count + minChunkSize - 1 ) / minChunkSize );
+
+	if ( chunks <= 1 || !mThreadPool ) {
+		func( 0, count );
+		return;
+	}
+
+	int chunkSize = ( count + chunks - 1 ) / chunks;
+	std::mutex mutex;
+	std::condition_variable cv;
+	int pending = chunks - 1;
+
+	for ( int chunk = 1; chunk < chunks; chunk++ ) {
+		int start = chunk * chunkSize;
+		int end = eemin( count, start + chunkSize );
+
+		mThreadPool->run( [&, start, end] {
+			func( start, end );
+			std::lock_guard<std::mutex> lock( mutex );
+			if ( --pending == 0 )
+				cv.notify_one();
+		} );
+	}
+
+	func( 0, eemin( count, chunkSize ) );
+
+	std::unique_lock<std::mutex> lock( mutex );
+	cv.wait( lock, [&] { return pending == 0; } );
+}
+
+void Space::buildSolverBatches() {
+	// Greedy coloring of the contact graph: an arbiter or constraint takes the lowest batch not
+	// used by any of its dynamic bodies. Items that don't fit in the first 64 batches are solved
+	// serially in a last batch.
+	// Invariant: the items of a parallel batch never write to the same body. The bodies with
+	// infinite mass and moment are left out of the coloring, so they're shared by the items of a
+	// batch and must never be written by them: the impulses of the arbiters skip them (see
+	// apply_impulse in constraints/util.h), and the constraints attached to one of them, which
+	// can write to their bodies directly, are always solved in the serial batch.
+	static const size_t MaxBatches = 64;
+	std::unordered_map<cpBody*, Uint64> bodyBatches;
+	bodyBatches.reserve( mSpace->bodies->num );
+
+	for ( auto& batch : mSolverBatches )
+		batch.clear();
+
+	mSolverBatches.resize( MaxBatches + 1 );
+
+	auto isInfiniteMass = []( cpBody* body ) {
+		return body->m_inv == 0.0f && body->i_inv == 0.0f;
+	};
+
+	auto usedBatches = [&]( cpBody* body ) -> Uint64* {
+		if ( isInfiniteMass( body ) )
+			return NULL;
+		return &bodyBatches[body];
+	};
+
+	auto addItem = [&]( cpBody* a, cpBody* b, const SolverItem& item ) {
+		Uint64* usedA = usedBatches( a );
+		Uint64* usedB = usedBatches( b );
+		Uint64 used = ( usedA ? *usedA : 0 ) | ( usedB ? *usedB : 0 );
+		size_t batch = 0;
+
+		while ( batch < MaxBatches && ( used & ( (Uint64)1 << batch ) ) )
+			batch++;
+
+		if ( batch < MaxBatches ) {
+			if ( usedA )
+				*usedA |= (Uint64)1 << batch;
+			if ( usedB )
+				*usedB |= (Uint64)1 << batch;
+		}
+
+		mSolverBatches[batch].push_back( item );
+	};
+
+	cpArray* arbiters = mSpace->arbiters;
+	for ( int i = 0; i < arbiters->num; i++ ) {
+		cpArbiter* arb = (cpArbiter*)arbiters->arr[i];
+		addItem( arb->body_a, arb->body_b, { arb, NULL } );
+	}
+
+	cpArray* constraints = mSpace->constraints;
+	for ( int i = 0; i < constraints->num; i++ ) {
+		cpConstraint* constraint = (cpConstraint*)constraints->arr[i];
+
+		if ( isInfiniteMass( constraint->a ) || isInfiniteMass( constraint->b ) ) {
+			mSolverBatches[MaxBatches].push_back( { NULL, constraint } );
+		} else {
+			addItem( constraint->a, constraint->b, { NULL, constraint } );
+		}
+	}
+}
+
+void Space::solveBatches( const std::function<void( const SolverItem& )>& func ) {
+	size_t serialBatch = mSolverBatches.size() - 1;
+
+	for ( size_t b = 0; b < mSolverBatches.size(); b++ ) {
+		const std::vector<SolverItem>& batch = mSolverBatches[b];
+
+		if ( batch.empty() )
+			continue;
+
+		auto solve = [&batch, &func]( int start, int end ) {
+			for ( int i = start; i < end; i++ )
+				func( batch[i] );
+		};
+
+		if ( b == serialBatch ) {
+			solve( 0, batch.size() );
+		} else {
+			parallelFor( batch.size(), 64, solve );
+		}
+	}
+}
+
+void Space::stepThreaded( const cpFloat& dt ) {
+	// Same steps as cpSpaceStep, the callbacks into user code are kept in the calling thread.
+	if ( dt == 0.0f )
+		return;
+
+	cpSpace* space = mSpace;
+	space->stamp++;
+
+	cpFloat prev_dt = space->curr_dt;
+	space->curr_dt = dt;
+
+	cpArray* bodies = space->bodies;
+	cpArray* constraints = space->constraints;
+	cpArray* arbiters = space->arbiters;
+
+	for ( int i = 0; i < arbiters->num; i++ ) {
+		cpArbiter* arb = (cpArbiter*)arbiters->arr[i];
+		arb->state = cpArbiterStateNormal;
+
+		if ( !cpBodyIsSleeping( arb->body_a ) && !cpBodyIsSleeping( arb->body_b ) ) {
+			cpArbiterUnthread( arb );
+		}
+	}
+	arbiters->num = 0;
+
+	mCustomVelocityBodies.clear();
+	mCustomPositionBodies.clear();
+
+	for ( int i = 0; i < bodies->num; i++ ) {
+		cpBody* body = (cpBody*)bodies->arr[i];
+
+		if ( body->velocity_func != cpBodyUpdateVelocity )
+			mCustomVelocityBodies.push_back( body );
+
+		if ( body->position_func != cpBodyUpdatePosition )
+			mCustomPositionBodies.push_back( body );
+	}
+
+	cpSpaceLock( space );
+	{
+		// Integrate positions
+		parallelFor( bodies->num, 256, [bodies, dt]( int start, int end ) {
+			for ( int i = start; i < end; i++ ) {
+				cpBody* body = (cpBody*)bodies->arr[i];
+
+				if ( body->position_func == cpBodyUpdatePosition )
+					cpBodyUpdatePosition( body, dt );
+			}
+		} );
+
+		for ( auto& body : mCustomPositionBodies )
+			body->position_func( body, dt );
+
+		// Find colliding pairs, this calls the begin and pre-solve collision handlers.
+		cpSpacePushFreshContactBuffer( space );
+		cpSpatialIndexEach( space->activeShapes, (cpSpatialIndexIteratorFunc)cpShapeUpdateFunc,
+							NULL );
+		cpSpatialIndexReindexQuery( space->activeShapes,
+									(cpSpatialIndexQueryFunc)cpSpaceCollideShapes, space );
+	}
+	cpSpaceUnlock( space, cpFalse );
+
+	cpSpaceProcessComponents( space, dt );
+
+	cpSpaceLock( space );
+	{
+		cpHashSetFilter( space->cachedArbiters, (cpHashSetFilterFunc)cpSpaceArbiterSetFilter,
+						 space );
+
+		cpFloat slop = space->collisionSlop;
+		cpFloat biasCoef = 1.0f - cpfpow( space->collisionBias, dt );
+
+		parallelFor( arbiters->num, 128, [arbiters, dt, slop, biasCoef]( int start, int end ) {
+			for ( int i = start; i < end; i++ )
+				cpArbiterPreStep( (cpArbiter*)arbiters->arr[i], dt, slop, biasCoef );
+		} );
+
+		for ( int i = 0; i < constraints->num; i++ ) {
+			cpConstraint* constraint = (cpConstraint*)constraints->arr[i];
+
+			cpConstraintPreSolveFunc preSolve = constraint->preSolve;
+			if ( preSolve )
+				preSolve( constraint, space );
+		}
+
+		// Some constraints apply impulses to their bodies in the pre-step, so they're batched
+		buildSolverBatches();
+
+		solveBatches( [dt]( const SolverItem& item ) {
+			if ( item.constraint )
+				item.constraint->klass->preStep( item.constraint, dt );
+		} );
+
+		// Integrate velocities
+		cpFloat damping = cpfpow( space->damping, dt );
+		cpVect gravity = space->gravity;
+
+		parallelFor( bodies->num, 256, [bodies, gravity, damping, dt]( int start, int end ) {
+			for ( int i = start; i < end; i++ ) {
+				cpBody* body = (cpBody*)bodies->arr[i];
+
+				if ( body->velocity_func == cpBodyUpdateVelocity )
+					cpBodyUpdateVelocity( body, gravity, damping, dt );
+			}
+		} );
+
+		for ( auto& body : mCustomVelocityBodies )
+			body->velocity_func( body, gravity, damping, dt );
+
+		// Apply cached impulses and run the impulse solver, batch by batch
+		cpFloat dt_coef = ( prev_dt == 0.0f ? 0.0f : dt / prev_dt );
+
+		solveBatches( [dt_coef]( const SolverItem& item ) {
+			if ( item.arbiter )
+				cpArbiterApplyCachedImpulse( item.arbiter, dt_coef );
+			else
+				item.constraint->klass->applyCachedImpulse( item.constraint, dt_coef );
+		} );
+
+		for ( int iteration = 0; iteration < space->iterations; iteration++ ) {
+			solveBatches( [dt]( const SolverItem& item ) {
+				if ( item.arbiter )
+					cpArbiterApplyImpulse( item.arbiter );
+				else
+					item.constraint->klass->applyImpulse( item.constraint, dt );
+			} );
+		}
+
+		// Run the constraint post-solve callbacks
+		for ( int i = 0; i < constraints->num; i++ ) {
+			cpConstraint* constraint = (cpConstraint*)constraints->arr[i];
+
+			cpConstraintPostSolveFunc postSolve = constraint->postSolve;
+			if ( postSolve )
+				postSolve( constraint, space );
+		}
+
+		// Run the post-solve collision handlers
+		for ( int i = 0; i < arbiters->num; i++ ) {
+			cpArbiter* arb = (cpArbiter*)arbiters->arr[i];
+
+			cpCollisionHandler* handler = arb->handler;
+			handler->postSolve( arb, space, handler->data );
+		}
+	}
+	// Runs the post-step callbacks
+	cpSpaceUnlock( space, cpTrue );
 }
 
 void Space::update() {
 #ifdef PHYSICS_RENDERER_ENABLED
 	step( Window::Engine::instance()->getCurrentWindow()->getElapsed().asSeconds() );
 #else
-	Step( 1 / 60 );
+	step( 1 / 60.f );
 #endif
 }
 
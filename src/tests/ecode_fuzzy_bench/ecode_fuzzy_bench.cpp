@@ -0,0 +1,155 @@
+#include "../../tools/ecode/fuzzymatcher.hpp"
+#include <args/args.hxx>
+#include <climits>
+#include <eepp/ee.hpp>
+#include <iomanip>
+#include <iostream>
+#include <map>
+using namespace ecode;
+
+/**
+Fuzzy matcher benchmark: a synthetic list of project file paths is matched against every prefix of
+a query, as the locator does while the query is typed. Thread count 0 is the reference matcher
+that FuzzyMatcher replaced ( every path scored and sorted in a multimap ). Every thread count must
+return the same results as the reference.
+*/
+
+static void createPaths( std::vector<std::string>& files, std::vector<std::string>& names,
+						 Uint32 count ) {
+	static const char* dirs[] = { "src",	  "include", "tools",	 "modules", "thirdparty",
+								  "ui",		  "system",	 "graphics", "window",	"audio",
+								  "network",  "tests",	 "doc",		 "scene",	"maps",
+								  "physics",  "core",	 "math" };
+	static const char* words[] = { "editor",   "document", "text",	 "widget", "layout",
+								   "manager",  "texture",  "shader", "buffer", "socket",
+								   "terminal", "plugin",   "syntax", "font",   "image",
+								   "stream",   "thread",   "clock",	 "node",   "scroll" };
+	static const char* extensions[] = { ".cpp", ".hpp", ".c", ".h", ".lua", ".md", ".json" };
+	Uint32 seed = 12345;
+	auto next = [&seed]() {
+		seed = seed * 1103515245 + 12345;
+		return ( seed >> 16 ) & 0x7FFF;
+	};
+	files.reserve( count );
+	names.reserve( count );
+	for ( Uint32 i = 0; i < count; i++ ) {
+		std::string path( "/home/user/projects/eepp/" );
+		Uint32 depth = 1 + next() % 5;
+		for ( Uint32 d = 0; d < depth; d++ )
+			path += std::string( dirs[next() % eeARRAY_SIZE( dirs )] ) + "/";
+		std::string name( words[next() % eeARRAY_SIZE( words )] );
+		name += words[next() % eeARRAY_SIZE( words )];
+		name += String::toString( i % 100 );
+		name += extensions[next() % eeARRAY_SIZE( extensions )];
+		files.emplace_back( path + name );
+		names.emplace_back( std::move( name ) );
+	}
+}
+
+// The matcher that FuzzyMatcher replaced
+static std::vector<size_t> legacyMatch( const std::vector<std::string>& files,
+										const std::vector<std::string>& names,
+										const std::string& match, size_t max ) {
+	std::multimap<int, int, std::greater<int>> matchesMap;
+	std::vector<size_t> res;
+	for ( size_t i = 0; i < names.size(); i++ ) {
+		int matchName = String::fuzzyMatch( names[i], match );
+		int matchPath = String::fuzzyMatch( files[i], match );
+		matchesMap.insert( { std::max( matchName, matchPath ), i } );
+	}
+	for ( auto& m : matchesMap ) {
+		// Unlike FuzzyMatcher it also returned the paths that don't match
+		if ( res.size() >= max || m.first == INT_MIN )
+			break;
+		res.push_back( m.second );
+	}
+	return res;
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	args::ArgumentParser parser( "ecode - Fuzzy Matcher Benchmark" );
+	args::HelpFlag help( parser, "help", "Display this help menu", { 'h', "help" } );
+	args::ValueFlag<Uint32> pathsCount( parser, "paths", "Number of paths to match",
+										{ "paths" }, 300000, args::Options::Single );
+	args::ValueFlag<Uint32> maxResults( parser, "max", "Maximum results of each query",
+										{ "max" }, 100, args::Options::Single );
+	args::ValueFlag<std::string> query( parser, "query", "Query typed ( each prefix is matched )",
+										{ 'q', "query" }, "textedit", args::Options::Single );
+	args::ValueFlagList<Uint32> threads(
+		parser, "threads", "Thread counts to benchmark ( 0 = reference matcher )",
+		{ 't', "threads" } );
+
+	try {
+		parser.ParseCLI( argc, argv );
+	} catch ( const args::Help& ) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	} catch ( const args::ParseError& e ) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << parser;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<Uint32> threadCounts( threads.Get() );
+
+	if ( threadCounts.empty() ) {
+		Uint32 cpus = eemax<Uint32>( 1, Sys::getCPUCount() );
+		threadCounts.push_back( 0 );
+		for ( Uint32 count = 1; count < cpus; count *= 2 )
+			threadCounts.push_back( count );
+		threadCounts.push_back( cpus );
+	}
+
+	std::vector<std::string> files;
+	std::vector<std::string> names;
+	createPaths( files, names, pathsCount.Get() );
+	std::cout << "Paths: " << files.size() << " Query: " << query.Get() << std::endl;
+
+	std::vector<std::vector<size_t>> reference;
+	for ( size_t len = 1; len <= query.Get().size(); len++ )
+		reference.emplace_back(
+			legacyMatch( files, names, query.Get().substr( 0, len ), maxResults.Get() ) );
+
+	for ( const auto& threadCount : threadCounts ) {
+		std::shared_ptr<ThreadPool> pool;
+		if ( threadCount > 1 )
+			pool = ThreadPool::createShared( threadCount - 1 );
+
+		FuzzyMatcher matcher( pool );
+		FuzzyMatcher::ScoreFn score = [&]( size_t index, const std::string& match ) {
+			return std::max( String::fuzzyMatch( names[index], match ),
+							 String::fuzzyMatch( files[index], match ) );
+		};
+		FuzzyMatcher::MaskFn mask = [&]( size_t index ) {
+			return FuzzyMatcher::mask( files[index] );
+		};
+
+		bool equal = true;
+		std::vector<double> times;
+		Clock total;
+
+		for ( size_t len = 1; len <= query.Get().size(); len++ ) {
+			std::string match( query.Get().substr( 0, len ) );
+			std::vector<size_t> res;
+			Clock clock;
+			if ( threadCount == 0 ) {
+				res = legacyMatch( files, names, match, maxResults.Get() );
+			} else {
+				for ( const auto& m :
+					  matcher.match( match, files.size(), maxResults.Get(), score, mask, 1 ) )
+					res.push_back( m.index );
+			}
+			times.push_back( clock.getElapsedTime().asMilliseconds() );
+			equal = equal && res == reference[len - 1];
+		}
+
+		std::cout << "Threads: " << std::setw( 3 ) << threadCount << " Total: " << std::fixed
+				  << std::setprecision( 2 ) << total.getElapsedTime().asMilliseconds()
+				  << " ms Per key:";
+		for ( const auto& time : times )
+			std::cout << " " << std::setprecision( 1 ) << time;
+		std::cout << ( equal ? "" : " RESULTS DIFFER" ) << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,176 @@
+#include "../../tools/ecode/projectscanner.hpp"
+#include <args/args.hxx>
+#include <eepp/ee.hpp>
+#include <iomanip>
+#include <iostream>
+#include <set>
+using namespace ecode;
+
+/**
+Project directory scanner benchmark: a synthetic source tree ( nested directories with source files,
+object files and .gitignore files that ignore them ) is created once in the temporary directory and
+scanned once per thread count. Thread count 0 is the reference recursive scanner, that stats every
+entry to know if it's a directory. The file count must be equal for every thread count. The tree is
+kept between runs, so the results measure a warm file system cache.
+*/
+
+static Uint64 createTree( const std::string& path, const Uint32& totalFiles,
+						  const Uint32& filesPerDir, const Uint32& fanOut ) {
+	static const char* extensions[] = { ".cpp", ".hpp", ".c", ".h", ".md", ".txt", ".json", ".o" };
+	std::vector<std::string> pending{ path };
+	Uint32 files = 0;
+	Uint32 dirs = 0;
+
+	FileSystem::makeDir( path, true );
+	FileSystem::fileWrite( path + ".gitignore", "*.o\nbuild\n" );
+
+	for ( size_t i = 0; i < pending.size() && files < totalFiles; i++ ) {
+		std::string dir( pending[i] );
+
+		// Some nested directories have their own ignore file
+		if ( i > 0 && i % 16 == 0 )
+			FileSystem::fileWrite( dir + ".gitignore", "*.txt\n!keep.txt\n" );
+
+		for ( Uint32 f = 0; f < filesPerDir && files < totalFiles; f++, files++ ) {
+			FileSystem::fileWrite( dir + String::format( "file_%u", files ) +
+									   extensions[files % eeARRAY_SIZE( extensions )],
+								   "" );
+		}
+
+		for ( Uint32 d = 0; d < fanOut; d++ ) {
+			std::string subDir( dir + String::format( d == 0 && i % 32 == 0 ? "build" : "dir_%u",
+													  dirs++ ) );
+			FileSystem::makeDir( subDir );
+			pending.emplace_back( subDir + FileSystem::getOSSlash() );
+		}
+	}
+
+	return files;
+}
+
+// The recursive scanner that ProjectScanner replaced: a stat per entry and a single thread
+static void legacyScan( std::vector<std::string>& files, std::vector<std::string>& names,
+						std::string directory, std::set<std::string> currentDirs,
+						IgnoreMatcherManager& ignoreMatcher ) {
+	currentDirs.insert( directory );
+	std::vector<std::string> pathFiles =
+		FileSystem::filesGetInPath( directory, false, false, false );
+	for ( auto& file : pathFiles ) {
+		std::string fullpath( directory + file );
+		bool isDirectory = FileSystem::isDirectory( fullpath );
+		if ( ignoreMatcher.foundMatch() &&
+			 IgnoreMatcherManager::match( ignoreMatcher.getMatchers(), fullpath, isDirectory ) )
+			continue;
+		if ( isDirectory ) {
+			fullpath += FileSystem::getOSSlash();
+			IgnoreMatcherManager dirMatcher( fullpath );
+			IgnoreMatcher* childMatch = nullptr;
+			if ( dirMatcher.foundMatch() ) {
+				childMatch = dirMatcher.popMatcher( 0 );
+				ignoreMatcher.addChild( childMatch );
+			}
+			legacyScan( files, names, fullpath, currentDirs, ignoreMatcher );
+			if ( childMatch ) {
+				ignoreMatcher.removeChild( childMatch );
+				eeSAFE_DELETE( childMatch );
+			}
+		} else {
+			files.emplace_back( fullpath );
+			names.emplace_back( file );
+		}
+	}
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	args::ArgumentParser parser( "ecode - Project Scanner Benchmark" );
+	args::HelpFlag help( parser, "help", "Display this help menu", { 'h', "help" } );
+	args::ValueFlag<Uint32> totalFiles( parser, "files", "Number of files of the synthetic tree",
+										{ "files" }, 300000, args::Options::Single );
+	args::ValueFlag<Uint32> filesPerDir( parser, "files-per-dir", "Files per directory",
+										 { "files-per-dir" }, 32, args::Options::Single );
+	args::ValueFlag<Uint32> fanOut( parser, "fan-out", "Sub directories per directory",
+									{ "fan-out" }, 4, args::Options::Single );
+	args::ValueFlag<std::string> treePath( parser, "path",
+										   "Scan this directory instead of the synthetic tree",
+										   { 'p', "path" }, "", args::Options::Single );
+	args::ValueFlagList<Uint32> threads(
+		parser, "threads", "Thread counts to benchmark ( 0 = reference recursive scanner )",
+		{ 't', "threads" } );
+
+	try {
+		parser.ParseCLI( argc, argv );
+	} catch ( const args::Help& ) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	} catch ( const args::ParseError& e ) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << parser;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<Uint32> threadCounts( threads.Get() );
+
+	if ( threadCounts.empty() ) {
+		Uint32 cpus = eemax<Uint32>( 1, Sys::getCPUCount() );
+		threadCounts.push_back( 0 );
+		for ( Uint32 count = 1; count < cpus; count *= 2 )
+			threadCounts.push_back( count );
+		threadCounts.push_back( cpus );
+	}
+
+	std::string path( treePath.Get() );
+
+	if ( path.empty() ) {
+		path = Sys::getTempPath() +
+			   String::format( "ecode_scan_bench_%u_%u_%u", totalFiles.Get(), filesPerDir.Get(),
+							   fanOut.Get() );
+		FileSystem::dirAddSlashAtEnd( path );
+
+		if ( !FileSystem::isDirectory( path ) ) {
+			Clock clock;
+			Uint64 created =
+				createTree( path, totalFiles.Get(), eemax<Uint32>( 1, filesPerDir.Get() ),
+							eemax<Uint32>( 1, fanOut.Get() ) );
+			std::cout << "Created " << created << " files in " << path << " in "
+					  << clock.getElapsedTime().toString() << std::endl;
+		}
+	}
+
+	FileSystem::dirAddSlashAtEnd( path );
+	std::cout << "Tree: " << path << std::endl;
+
+	for ( const auto& threadCount : threadCounts ) {
+		IgnoreMatcherManager ignoreMatcher( path );
+		std::vector<std::string> files;
+		std::vector<std::string> names;
+
+		Clock clock;
+
+		if ( threadCount == 0 ) {
+			legacyScan( files, names, path, {}, ignoreMatcher );
+		} else {
+			std::shared_ptr<ThreadPool> pool;
+			if ( threadCount > 1 )
+				pool = ThreadPool::createShared( threadCount - 1 );
+
+			Mutex mutex;
+			ProjectScanner scanner(
+				pool, [&]( std::vector<std::string>& found, std::vector<std::string>& foundNames ) {
+					Lock l( mutex );
+					files.insert( files.end(), std::make_move_iterator( found.begin() ),
+								  std::make_move_iterator( found.end() ) );
+					names.insert( names.end(), std::make_move_iterator( foundNames.begin() ),
+								  std::make_move_iterator( foundNames.end() ) );
+				} );
+			scanner.scan( path, ignoreMatcher.getMatchers(), false );
+		}
+
+		double elapsed = clock.getElapsedTime().asMilliseconds();
+
+		std::cout << "Threads: " << std::setw( 3 ) << threadCount << " Total: " << std::fixed
+				  << std::setprecision( 2 ) << elapsed << " ms Files: " << files.size()
+				  << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,234 @@
+#include <args/args.hxx>
+#include <eepp/ee.hpp>
+#include <eterm/terminal/terminalemulator.hpp>
+#include <iomanip>
+#include <iostream>
+using namespace eterm::Terminal;
+
+/**
+Headless terminal emulator throughput benchmark: a synthetic escape-heavy output ( SGR colors,
+cursor movement, line erasing, UTF-8 and scrolling ) is fed through an in-memory pseudoterminal,
+parsed by the emulator reader thread and snapshotted by a display that copies the dirty lines like
+TerminalDisplay does. The main loop updates the emulator at the requested frame rate, so the
+reported MB/s shows how much the parser throughput depends on the frame rate. The memory used by
+the scrollback history is reported next to the memory the same lines would use as glyph arrays.
+*/
+
+static std::string createPayload( const Uint32& lines, const Uint32& columns ) {
+	static const char* words[] = { "eepp", "terminal", "ñandú", "λ", "→", "build", "warning:" };
+	std::string payload;
+	Uint32 seed = 1;
+
+	auto next = [&seed]() {
+		seed = seed * 1103515245 + 12345;
+		return ( seed >> 16 ) & 0x7FFF;
+	};
+
+	for ( Uint32 i = 0; i < lines; i++ ) {
+		Uint32 lineLen = 0;
+
+		switch ( next() % 4 ) {
+			case 0: // Truecolor foreground
+				payload += String::format( "\033[38;2;%d;%d;%dm", next() % 256, next() % 256,
+										   next() % 256 );
+				break;
+			case 1: // 256 colors background and bold
+				payload += String::format( "\033[1;48;5;%dm", next() % 256 );
+				break;
+			case 2: // Cursor movement and line erasing
+				payload += String::format( "\033[%dG\033[K", next() % columns + 1 );
+				break;
+			default: // Attributes reset
+				payload += "\033[0m";
+				break;
+		}
+
+		while ( lineLen < columns - 10 ) {
+			const char* word = words[next() % eeARRAY_SIZE( words )];
+			payload += word;
+			payload += next() % 3 == 0 ? "\033[0m " : " ";
+			lineLen += strlen( word ) + 1;
+		}
+
+		payload += "\033[0m\r\n";
+	}
+
+	return payload;
+}
+
+class MemoryPseudoTerminal final : public IPseudoTerminal {
+  public:
+	MemoryPseudoTerminal( const std::string& payload, Uint64 totalBytes, int columns, int rows ) :
+		mPayload( payload ), mTotalBytes( totalBytes ), mColumns( columns ), mRows( rows ) {}
+
+	virtual bool isTTY() const override { return true; }
+
+	virtual int getNumColumns() const override { return mColumns; }
+
+	virtual int getNumRows() const override { return mRows; }
+
+	virtual bool resize( int columns, int rows ) override {
+		mColumns = columns;
+		mRows = rows;
+		return true;
+	}
+
+	// Replies to the terminal queries are discarded
+	virtual int write( const char*, size_t n ) override { return (int)n; }
+
+	virtual int read( char* buf, size_t n, bool ) override {
+		Uint64 left = mTotalBytes - mReadBytes;
+		if ( left == 0 )
+			return 0;
+
+		size_t offset = mReadBytes % mPayload.size();
+		n = eemin<size_t>( eemin<Uint64>( n, left ), mPayload.size() - offset );
+		memcpy( buf, mPayload.data() + offset, n );
+		mReadBytes += n;
+		return (int)n;
+	}
+
+	virtual int waitForInput( int ) override { return mReadBytes < mTotalBytes ? 1 : -1; }
+
+	bool isDrained() const { return mReadBytes == mTotalBytes; }
+
+  protected:
+	const std::string& mPayload;
+	Uint64 mTotalBytes;
+	std::atomic<Uint64> mReadBytes{ 0 };
+	int mColumns;
+	int mRows;
+};
+
+// The process "exits" once all the output has been read
+class MemoryProcess final : public eterm::System::IProcess {
+  public:
+	explicit MemoryProcess( MemoryPseudoTerminal* pty ) : mPty( pty ) {}
+
+	virtual void checkExitStatus() override {}
+
+	virtual bool hasExited() const override { return mPty->isDrained(); }
+
+	virtual int getExitCode() const override { return 0; }
+
+	virtual void terminate() override {}
+
+	virtual void waitForExit() override {}
+
+	virtual int pid() override { return 0; }
+
+  protected:
+	MemoryPseudoTerminal* mPty;
+};
+
+class SnapshotDisplay final : public ITerminalDisplay {
+  public:
+	virtual bool drawBegin( Uint32 columns, Uint32 rows ) override {
+		mColumns = columns;
+		mBuffer.resize( columns * rows );
+		return true;
+	}
+
+	virtual void drawLine( Line line, int x1, int y, int x2 ) override {
+		memcpy( &mBuffer[y * mColumns + x1], line, ( x2 - x1 ) * sizeof( TerminalGlyph ) );
+		mLines++;
+	}
+
+	virtual void drawCursor( int, int, TerminalGlyph, int, int, TerminalGlyph ) override {}
+
+	virtual void drawEnd() override { mSnapshots++; }
+
+	Uint64 getSnapshots() const { return mSnapshots; }
+
+	Uint64 getLines() const { return mLines; }
+
+  protected:
+	std::vector<TerminalGlyph> mBuffer;
+	Uint32 mColumns{ 0 };
+	Uint64 mSnapshots{ 0 };
+	Uint64 mLines{ 0 };
+};
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	args::ArgumentParser parser( "eterm - Throughput Benchmark" );
+	args::HelpFlag help( parser, "help", "Display this help menu", { 'h', "help" } );
+	args::ValueFlag<Uint32> megabytes( parser, "megabytes", "Megabytes of output to parse",
+									   { 'm', "megabytes" }, 64, args::Options::Single );
+	args::ValueFlag<Uint32> columns( parser, "columns", "Terminal columns", { "columns" }, 160,
+									 args::Options::Single );
+	args::ValueFlag<Uint32> rows( parser, "rows", "Terminal rows", { "rows" }, 50,
+								  args::Options::Single );
+	args::ValueFlag<Uint32> history( parser, "history", "Scrollback history size", { "history" },
+									 10000, args::Options::Single );
+	args::ValueFlagList<Uint32> fps( parser, "fps",
+									 "Frame rates to benchmark ( 0 = update as fast as possible )",
+									 { 'f', "fps" } );
+	args::Flag noAsciiFastPath( parser, "no-ascii-fast-path",
+								"Parse the printable ASCII runs one character at a time",
+								{ "no-ascii-fast-path" } );
+
+	try {
+		parser.ParseCLI( argc, argv );
+	} catch ( const args::Help& ) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	} catch ( const args::ParseError& e ) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << parser;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<Uint32> frameRates( fps.Get() );
+
+	if ( frameRates.empty() )
+		frameRates = { 10, 60, 144 };
+
+	std::string payload( createPayload( 4096, eemax<Uint32>( 20, columns.Get() ) ) );
+	Uint64 totalBytes = static_cast<Uint64>( megabytes.Get() ) * 1024 * 1024;
+
+	std::cout << "Output: " << megabytes.Get() << " MB Terminal: " << columns.Get() << "x"
+			  << rows.Get() << " History: " << history.Get() << std::endl;
+
+	for ( const auto& frameRate : frameRates ) {
+		auto pty = std::make_unique<MemoryPseudoTerminal>( payload, totalBytes, columns.Get(),
+														   rows.Get() );
+		auto process = std::make_unique<MemoryProcess>( pty.get() );
+		auto display = std::make_shared<SnapshotDisplay>();
+		Time frameTime = frameRate ? Seconds( 1.f / frameRate ) : Time::Zero;
+
+		Clock clock;
+
+		auto terminal = TerminalEmulator::create( std::move( pty ), std::move( process ), display,
+												  history.Get() );
+		terminal->setAsciiFastPath( !noAsciiFastPath.Get() );
+
+		while ( !terminal->hasExited() ) {
+			Clock frameClock;
+			terminal->update();
+			Time elapsed = frameClock.getElapsedTime();
+			if ( elapsed < frameTime )
+				Sys::sleep( frameTime - elapsed );
+		}
+
+		double seconds = clock.getElapsedTime().asSeconds();
+
+		std::cout << "FPS: " << std::setw( 4 ) << frameRate << " Total: " << std::fixed
+				  << std::setprecision( 2 ) << seconds * 1000 << " ms Throughput: "
+				  << totalBytes / ( 1024. * 1024. ) / seconds
+				  << " MB/s Snapshots: " << display->getSnapshots()
+				  << " Lines: " << display->getLines() << std::endl;
+
+		size_t historyLines = terminal->getHistorySize();
+		size_t historyMemory = terminal->getHistoryMemoryUsage();
+		size_t glyphMemory =
+			historyLines * ( terminal->getNumColumns() * sizeof( TerminalGlyph ) + sizeof( Line ) );
+
+		std::cout << "History: " << historyLines << " lines Memory: " << historyMemory / 1024
+				  << " KB ( " << ( historyLines ? historyMemory / historyLines : 0 )
+				  << " bytes per line ) As glyphs: " << glyphMemory / 1024 << " KB ( "
+				  << ( historyLines ? glyphMemory / historyLines : 0 ) << " bytes per line )"
+				  << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
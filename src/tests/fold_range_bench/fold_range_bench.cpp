@@ -0,0 +1,120 @@
+#include <args/args.hxx>
+#include <eepp/ee.hpp>
+#include <iomanip>
+#include <iostream>
+
+/**
+Fold range benchmark: a synthetic C++ document is created, and the fold ranges are computed after
+each of a series of small edits ( typing a character, adding and removing lines ), once
+incrementally, where only the modified lines are scanned again, and once with a full scan of the
+document. Both computations must produce the same regions. The initial computation of the
+incremental service ( that must scan every line ) is reported separately.
+*/
+
+static String createSource( const Uint32& lines ) {
+	String text;
+	Uint32 count = 0;
+	for ( Uint32 f = 0; count < lines; f++ ) {
+		text += String::format( "static int function%u( int value ) {\n", f );
+		text += "\t// Braces in comments { are ignored\n";
+		text += "\tconst char* str = \"{ and in strings\";\n";
+		text += "\tfor ( int i = 0; i < value; i++ ) {\n";
+		text += "\t\tif ( i % 2 == 0 ) {\n\t\t\tvalue += i;\n\t\t} else {\n";
+		text += "\t\t\tvalue -= i;\n\t\t}\n\t}\n\treturn value;\n}\n\n";
+		count += 13;
+	}
+	return text;
+}
+
+static void printTimes( const std::string& name, std::vector<double>& times ) {
+	std::sort( times.begin(), times.end() );
+	double total = 0;
+	for ( const auto& time : times )
+		total += time;
+	std::cout << std::left << std::setw( 12 ) << name << std::right << std::fixed
+			  << std::setprecision( 3 ) << " avg: " << std::setw( 9 ) << total / times.size()
+			  << " ms p50: " << std::setw( 9 ) << times[times.size() / 2]
+			  << " ms max: " << std::setw( 9 ) << times.back() << " ms" << std::endl;
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	args::ArgumentParser parser( "eepp - Fold Range Benchmark" );
+	args::HelpFlag help( parser, "help", "Display this help menu", { 'h', "help" } );
+	args::ValueFlag<Uint32> linesCount( parser, "lines", "Number of lines of the document",
+										{ "lines" }, 100000, args::Options::Single );
+	args::ValueFlag<Uint32> editsCount( parser, "edits", "Number of edits", { "edits" }, 100,
+										args::Options::Single );
+	args::ValueFlag<std::string> language( parser, "language", "Language of the document",
+										   { "language" }, "C++", args::Options::Single );
+
+	try {
+		parser.ParseCLI( argc, argv );
+	} catch ( const args::Help& ) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	} catch ( const args::ParseError& e ) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << parser;
+		return EXIT_FAILURE;
+	}
+
+	TextDocument doc( false );
+	doc.setSyntaxDefinition(
+		SyntaxDefinitionManager::instance()->getByLanguageName( language.Get() ) );
+	doc.insert( 0, { 0, 0 }, createSource( linesCount.Get() ) );
+	auto& service = doc.getFoldRangeService();
+
+	std::cout << "Language: " << doc.getSyntaxDefinition().getLanguageName()
+			  << " Lines: " << doc.linesCount() << std::endl;
+
+	// The editor tokenizes the whole document in the background, do the same before measuring
+	Clock clock;
+	for ( size_t i = 0; i < doc.linesCount(); i++ )
+		doc.getHighlighter()->getLine( i );
+	std::cout << "Tokenization: " << std::fixed << std::setprecision( 3 )
+			  << clock.getElapsedTime().asMilliseconds() << " ms" << std::endl;
+
+	clock.restart();
+	auto regions = service.computeRegions();
+	std::cout << "Initial incremental computation: " << clock.getElapsedTime().asMilliseconds()
+			  << " ms Regions: " << regions.size() << std::endl;
+
+	std::vector<double> fullTimes;
+	std::vector<double> incrementalTimes;
+	bool mismatch = false;
+
+	for ( Uint32 i = 0; i < editsCount.Get(); i++ ) {
+		Int64 line = ( static_cast<Int64>( i ) * 7919 ) % doc.linesCount();
+		switch ( i % 3 ) {
+			case 0:
+				doc.insert( 0, { line, 0 }, "x" );
+				break;
+			case 1:
+				doc.insert( 0, { line, 0 }, "\tif ( x ) {\n\t}\n" );
+				break;
+			default:
+				doc.remove( 0, { { line, 0 }, { line + 1, 0 } } );
+		}
+
+		clock.restart();
+		auto incremental = service.computeRegions();
+		incrementalTimes.push_back( clock.getElapsedTime().asMilliseconds() );
+
+		clock.restart();
+		auto full = service.computeRegions( false );
+		fullTimes.push_back( clock.getElapsedTime().asMilliseconds() );
+
+		if ( full != incremental )
+			mismatch = true;
+	}
+
+	printTimes( "Full", fullTimes );
+	printTimes( "Incremental", incrementalTimes );
+
+	if ( mismatch ) {
+		std::cerr << "Full and incremental fold ranges differ" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
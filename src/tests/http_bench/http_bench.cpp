@@ -0,0 +1,204 @@
+#include <args/args.hxx>
+#include <atomic>
+#include <condition_variable>
+#include <eepp/ee.hpp>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+/**
+HTTP client benchmark: a loopback HTTP/1.1 server with keep-alive is started in a single thread,
+and a number of asynchronous GET requests are sent to it at once, as ecode does when it fetches
+many resources at the same time. It reports the total time, the latency of each request (the time
+since it's sent until its callback is called), the peak number of threads of the process and the
+number of connections accepted by the server. With --threads the requests run in a thread per
+request instead of the non-blocking engine, to compare both.
+*/
+
+static size_t getThreadCount() {
+#if EE_PLATFORM == EE_PLATFORM_LINUX
+	return FileSystem::filesGetInPath( std::string( "/proc/self/task" ) ).size();
+#else
+	return 0;
+#endif
+}
+
+static void printTimes( const std::string& name, std::vector<double>& times ) {
+	std::sort( times.begin(), times.end() );
+	double total = 0;
+	for ( const auto& time : times )
+		total += time;
+	std::cout << std::left << std::setw( 12 ) << name << std::right << std::fixed
+			  << std::setprecision( 3 ) << " avg: " << std::setw( 8 ) << total / times.size()
+			  << " ms p50: " << std::setw( 8 ) << times[times.size() / 2]
+			  << " ms p99: " << std::setw( 8 ) << times[times.size() * 99 / 100]
+			  << " ms max: " << std::setw( 8 ) << times.back() << " ms" << std::endl;
+}
+
+// Single threaded HTTP/1.1 server, every request gets the same body
+class LoopbackServer {
+  public:
+	explicit LoopbackServer( size_t bodySize ) : mBody( bodySize, 'x' ) {
+		mListening = mListener.listen( 0, IpAddress::LocalHost ) == Socket::Done;
+		if ( mListening )
+			mThread = std::thread( [this] { run(); } );
+	}
+
+	~LoopbackServer() {
+		mRunning = false;
+		if ( mThread.joinable() )
+			mThread.join();
+	}
+
+	bool isListening() const { return mListening; }
+
+	unsigned short getPort() const { return mListener.getLocalPort(); }
+
+	size_t getConnections() const { return mConnections; }
+
+  protected:
+	struct Client {
+		TcpSocket socket;
+		std::string buffer;
+	};
+
+	TcpListener mListener;
+	std::string mBody;
+	bool mListening{ false };
+	std::atomic<bool> mRunning{ true };
+	std::atomic<size_t> mConnections{ 0 };
+	std::thread mThread;
+
+	void run() {
+		SocketSelector selector;
+		std::vector<std::unique_ptr<Client>> clients;
+		std::string response( "HTTP/1.1 200 OK\r\nContent-Length: " +
+							  String::toString( (Uint64)mBody.size() ) + "\r\n\r\n" + mBody );
+		char data[4096];
+		std::size_t received;
+		selector.add( mListener );
+
+		while ( mRunning ) {
+			if ( !selector.wait( Milliseconds( 50 ) ) )
+				continue;
+
+			if ( selector.isReady( mListener ) ) {
+				auto client = std::make_unique<Client>();
+				if ( mListener.accept( client->socket ) == Socket::Done ) {
+					selector.add( client->socket );
+					clients.emplace_back( std::move( client ) );
+					mConnections++;
+				}
+			}
+
+			for ( auto& client : clients ) {
+				if ( !client || !selector.isReady( client->socket ) )
+					continue;
+
+				bool keepAlive = client->socket.receive( data, sizeof( data ), received ) ==
+								 Socket::Done;
+				if ( keepAlive )
+					client->buffer.append( data, received );
+
+				size_t end;
+				while ( keepAlive &&
+						( end = client->buffer.find( "\r\n\r\n" ) ) != std::string::npos ) {
+					keepAlive =
+						String::toLower( client->buffer.substr( 0, end ) ).find(
+							"connection: close" ) == std::string::npos;
+					client->buffer.erase( 0, end + 4 );
+					client->socket.send( response.data(), response.size() );
+				}
+
+				if ( !keepAlive ) {
+					selector.remove( client->socket );
+					client.reset();
+				}
+			}
+
+			clients.erase( std::remove( clients.begin(), clients.end(), nullptr ),
+						   clients.end() );
+		}
+	}
+};
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	args::ArgumentParser parser( "eepp - HTTP Client Benchmark" );
+	args::HelpFlag help( parser, "help", "Display this help menu", { 'h', "help" } );
+	args::ValueFlag<Uint32> requestsCount( parser, "requests", "Number of requests",
+										   { "requests" }, 1000, args::Options::Single );
+	args::ValueFlag<Uint32> bodySize( parser, "size", "Size of the body of each response",
+									  { "size" }, 16384, args::Options::Single );
+	args::ValueFlag<Uint32> maxConnections( parser, "connections",
+											"Maximum number of connections per host",
+											{ "connections" }, 6, args::Options::Single );
+	args::Flag threads( parser, "threads", "Run each request in its own thread", { "threads" } );
+
+	try {
+		parser.ParseCLI( argc, argv );
+	} catch ( const args::Help& ) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	} catch ( const args::ParseError& e ) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << parser;
+		return EXIT_FAILURE;
+	}
+
+	LoopbackServer server( bodySize.Get() );
+	if ( !server.isListening() ) {
+		std::cerr << "Couldn't listen for connections" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	Http::setAsyncEngineEnabled( !threads.Get() );
+	Http::setMaxConnectionsPerHost( maxConnections.Get() );
+
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::vector<double> latencies;
+	size_t failed = 0;
+	size_t peakThreads = getThreadCount();
+	Clock clock;
+
+	{
+		Http http( "http://127.0.0.1", server.getPort() );
+
+		for ( Uint32 i = 0; i < requestsCount.Get(); i++ ) {
+			double sentAt = clock.getElapsedTime().asMilliseconds();
+			http.sendAsyncRequest(
+				[&, sentAt]( const Http&, Http::Request&, Http::Response& response ) {
+					std::lock_guard<std::mutex> lock( mutex );
+					latencies.push_back( clock.getElapsedTime().asMilliseconds() - sentAt );
+					if ( response.getStatus() != Http::Response::Ok ||
+						 response.getBody().size() != bodySize.Get() )
+						failed++;
+					finished.notify_all();
+				},
+				Http::Request( "/" ) );
+		}
+
+		std::unique_lock<std::mutex> lock( mutex );
+		while ( latencies.size() < requestsCount.Get() ) {
+			finished.wait_for( lock, std::chrono::milliseconds( 1 ) );
+			lock.unlock();
+			peakThreads = std::max( peakThreads, getThreadCount() );
+			lock.lock();
+
+			if ( clock.getElapsedTime() > Seconds( 60 ) ) {
+				std::cerr << "The requests didn't finish" << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	std::cout << "Mode: " << ( threads.Get() ? "Threads" : "Engine" )
+			  << " Requests: " << requestsCount.Get() << " Failed: " << failed
+			  << " Time: " << std::fixed << std::setprecision( 3 )
+			  << clock.getElapsedTime().asMilliseconds() << " ms"
+			  << " Peak threads: " << peakThreads
+			  << " Connections: " << server.getConnections() << std::endl;
+	printTimes( "Latency", latencies );
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+#include <args/args.hxx>
+#include <atomic>
+#include <condition_variable>
+#include <eepp/ee.hpp>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+/**
+IO reactor benchmark: a number of `cat` child processes are started, and the same number of loopback
+TCP connections are opened, and all their streams are read asynchronously, as ecode does with its
+language servers, linters, debuggers and terminals. The number of threads of the process is reported
+once every stream is being read, and again after the reads. With all the streams idle, random
+processes and sockets are sent a small message to measure the wakeup latency, the time since the
+message is written until its read callback is called. With --threads the reads use a thread per
+stream instead of the shared IOReactor, to compare both.
+*/
+
+static size_t getThreadCount() {
+#if EE_PLATFORM == EE_PLATFORM_LINUX
+	return FileSystem::filesGetInPath( std::string( "/proc/self/task" ) ).size();
+#else
+	return 0;
+#endif
+}
+
+static void printTimes( const std::string& name, std::vector<double>& times ) {
+	std::sort( times.begin(), times.end() );
+	double total = 0;
+	for ( const auto& time : times )
+		total += time;
+	std::cout << std::left << std::setw( 12 ) << name << std::right << std::fixed
+			  << std::setprecision( 3 ) << " avg: " << std::setw( 8 ) << total / times.size()
+			  << " ms p50: " << std::setw( 8 ) << times[times.size() / 2]
+			  << " ms p99: " << std::setw( 8 ) << times[times.size() * 99 / 100]
+			  << " ms max: " << std::setw( 8 ) << times.back() << " ms" << std::endl;
+}
+
+// Counts the bytes read by the asynchronous reads, and wakes up the waiting writer
+class ReadCounter {
+  public:
+	void add( size_t bytes ) {
+		{
+			std::lock_guard<std::mutex> lock( mMutex );
+			mBytes += bytes;
+		}
+		mRead.notify_all();
+	}
+
+	bool waitFor( size_t bytes ) {
+		std::unique_lock<std::mutex> lock( mMutex );
+		return mRead.wait_for( lock, std::chrono::seconds( 5 ),
+							   [this, bytes] { return mBytes >= bytes; } );
+	}
+
+	size_t getBytes() {
+		std::lock_guard<std::mutex> lock( mMutex );
+		return mBytes;
+	}
+
+  protected:
+	std::mutex mMutex;
+	std::condition_variable mRead;
+	size_t mBytes{ 0 };
+};
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	args::ArgumentParser parser( "eepp - IO Reactor Benchmark" );
+	args::HelpFlag help( parser, "help", "Display this help menu", { 'h', "help" } );
+	args::ValueFlag<Uint32> processesCount( parser, "processes", "Number of child processes",
+											{ "processes" }, 32, args::Options::Single );
+	args::ValueFlag<Uint32> socketsCount( parser, "sockets", "Number of TCP connections",
+										  { "sockets" }, 32, args::Options::Single );
+	args::ValueFlag<Uint32> messagesCount( parser, "messages", "Number of messages of each kind",
+										   { "messages" }, 2000, args::Options::Single );
+	args::Flag threads( parser, "threads", "Read each stream from its own thread",
+						{ "threads" } );
+
+	try {
+		parser.ParseCLI( argc, argv );
+	} catch ( const args::Help& ) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	} catch ( const args::ParseError& e ) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << parser;
+		return EXIT_FAILURE;
+	}
+
+	if ( threads.Get() )
+		IOReactor::instance()->setEnabled( false );
+
+	size_t initialThreads = getThreadCount();
+	ReadCounter counter;
+	auto onRead = [&counter]( const char*, size_t n ) { counter.add( n ); };
+
+	std::vector<std::unique_ptr<Process>> processes;
+	for ( Uint32 i = 0; i < processesCount.Get(); i++ ) {
+		auto process = std::make_unique<Process>();
+		if ( !process->create( "cat", Process::getDefaultOptions() | Process::EnableAsync ) ) {
+			std::cerr << "Couldn't start the process " << i << std::endl;
+			return EXIT_FAILURE;
+		}
+		process->startAsyncRead( onRead, onRead );
+		processes.emplace_back( std::move( process ) );
+	}
+
+	TcpListener listener;
+	if ( listener.listen( 0, IpAddress::LocalHost ) != Socket::Done ) {
+		std::cerr << "Couldn't listen for connections" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<std::unique_ptr<TcpSocket>> clients;
+	std::vector<std::unique_ptr<TcpSocket>> servers;
+	for ( Uint32 i = 0; i < socketsCount.Get(); i++ ) {
+		auto client = std::make_unique<TcpSocket>();
+		auto server = std::make_unique<TcpSocket>();
+		if ( client->connect( IpAddress::LocalHost, listener.getLocalPort(), Seconds( 5 ) ) !=
+				 Socket::Done ||
+			 listener.accept( *server ) != Socket::Done ) {
+			std::cerr << "Couldn't connect client " << i << std::endl;
+			return EXIT_FAILURE;
+		}
+		server->startAsyncRead( onRead );
+		clients.emplace_back( std::move( client ) );
+		servers.emplace_back( std::move( server ) );
+	}
+
+	std::cout << "Mode: " << ( threads.Get() ? "Threads" : "IOReactor" )
+			  << " Processes: " << processes.size() << " Sockets: " << servers.size()
+			  << " Threads: " << initialThreads << " -> " << getThreadCount() << std::endl;
+
+	const std::string message( "ping\n" );
+	Clock clock;
+
+	auto measure = [&]( const std::string& name, size_t count,
+						const std::function<void( size_t )>& send ) {
+		std::vector<double> latencies;
+		for ( Uint32 i = 0; i < messagesCount.Get(); i++ ) {
+			size_t expected = counter.getBytes() + message.size();
+			clock.restart();
+			send( ( static_cast<Uint64>( i ) * 7919 ) % count );
+			if ( !counter.waitFor( expected ) )
+				return false;
+			latencies.push_back( clock.getElapsedTime().asMilliseconds() );
+		}
+		printTimes( name, latencies );
+		return true;
+	};
+
+	if ( !processes.empty() &&
+		 !measure( "Process", processes.size(),
+				   [&]( size_t i ) { processes[i]->write( message ); } ) ) {
+		std::cerr << "The process didn't echo the message" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if ( !clients.empty() &&
+		 !measure( "TcpSocket", clients.size(), [&]( size_t i ) {
+			 clients[i]->send( message.data(), message.size() );
+		 } ) ) {
+		std::cerr << "The message wasn't received" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// The reactor pool threads are started by the first dispatched read
+	std::cout << "Threads after the reads: " << getThreadCount() << std::endl;
+
+	return EXIT_SUCCESS;
+}
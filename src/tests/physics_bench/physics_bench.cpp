@@ -0,0 +1,130 @@
+#include <args/args.hxx>
+#include <eepp/ee.hpp>
+#include <eepp/physics/physics.hpp>
+#include <iomanip>
+#include <iostream>
+using namespace EE::Physics;
+
+/**
+Deterministic physics benchmark: a grid of boxes falls into a closed container and is stepped with
+a fixed time step, once per thread count. The scene is built the same way on every run, so the
+final state checksum must be equal for every thread count that uses the threaded solver ( 1 or
+more threads ). Thread count 0 is the reference single threaded Chipmunk solver.
+*/
+
+static Space* createScene( const Uint32& columns, const Uint32& rows, const Uint32& iterations ) {
+	const cpFloat boxSize = 10;
+	const cpFloat spacing = 12;
+	const cpFloat width = columns * spacing + spacing * 2;
+	const cpFloat height = rows * spacing + spacing * 4;
+
+	// The shape ids define the collision pairs order, reset them so every scene is identical
+	Shape::resetShapeIdCounter();
+
+	Space* space = Space::New();
+	space->setIterations( iterations );
+	space->setGravity( cVectNew( 0, 100 ) );
+	space->setSleepTimeThreshold( INFINITY );
+
+	Body* staticBody = space->getStaticBody();
+	cVect corners[] = { cVectNew( 0, 0 ), cVectNew( 0, height ), cVectNew( width, height ),
+						cVectNew( width, 0 ) };
+
+	for ( int i = 0; i < 4; i++ ) {
+		Shape* shape =
+			space->addShape( ShapeSegment::New( staticBody, corners[i], corners[( i + 1 ) % 4], 1 ) );
+		shape->setElasticity( 0.0f );
+		shape->setFriction( 1.0f );
+	}
+
+	for ( Uint32 y = 0; y < rows; y++ ) {
+		for ( Uint32 x = 0; x < columns; x++ ) {
+			// Deterministic jitter so the boxes don't stack perfectly aligned
+			cpFloat jitter = ( ( x * 7 + y * 13 ) % 5 ) * 0.25f;
+			Body* body =
+				space->addBody( Body::New( 1.0f, Moment::forBox( 1.0f, boxSize, boxSize ) ) );
+			body->setPos( cVectNew( spacing * 1.5f + x * spacing + jitter,
+									height - spacing * 1.5f - y * spacing ) );
+
+			Shape* shape = space->addShape( ShapePoly::New( body, boxSize, boxSize ) );
+			shape->setElasticity( 0.0f );
+			shape->setFriction( 0.7f );
+		}
+	}
+
+	return space;
+}
+
+static double getChecksum( Space* space ) {
+	double checksum = 0;
+
+	space->eachBody(
+		[&checksum]( Space*, Body* body, void* ) {
+			cVect pos( body->getPos() );
+			checksum += pos.x * 3 + pos.y * 7 + body->getAngle();
+		},
+		NULL );
+
+	return checksum;
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	args::ArgumentParser parser( "eepp - Physics Benchmark" );
+	args::HelpFlag help( parser, "help", "Display this help menu", { 'h', "help" } );
+	args::ValueFlag<Uint32> columns( parser, "columns", "Number of box columns", { "columns" }, 80,
+									 args::Options::Single );
+	args::ValueFlag<Uint32> rows( parser, "rows", "Number of box rows", { "rows" }, 64,
+								  args::Options::Single );
+	args::ValueFlag<Uint32> steps( parser, "steps", "Number of steps", { "steps" }, 300,
+								   args::Options::Single );
+	args::ValueFlag<Uint32> iterations( parser, "iterations", "Solver iterations",
+										{ "iterations" }, 10, args::Options::Single );
+	args::ValueFlagList<Uint32> threads( parser, "threads",
+										 "Thread counts to benchmark ( 0 = Chipmunk solver )",
+										 { 't', "threads" } );
+
+	try {
+		parser.ParseCLI( argc, argv );
+	} catch ( const args::Help& ) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	} catch ( const args::ParseError& e ) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << parser;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<Uint32> threadCounts( threads.Get() );
+
+	if ( threadCounts.empty() ) {
+		Uint32 cpus = eemax<Uint32>( 1, Sys::getCPUCount() );
+		threadCounts.push_back( 0 );
+		for ( Uint32 count = 1; count < cpus; count *= 2 )
+			threadCounts.push_back( count );
+		threadCounts.push_back( cpus );
+	}
+
+	std::cout << "Bodies: " << columns.Get() * rows.Get() << " Steps: " << steps.Get()
+			  << " Iterations: " << iterations.Get() << std::endl;
+
+	for ( const auto& threadCount : threadCounts ) {
+		Space* space = createScene( columns.Get(), rows.Get(), iterations.Get() );
+		space->setThreadCount( threadCount );
+
+		Clock clock;
+
+		for ( Uint32 i = 0; i < steps.Get(); i++ )
+			space->step( 1 / 60.f );
+
+		double elapsed = clock.getElapsedTime().asMilliseconds();
+
+		std::cout << "Threads: " << std::setw( 3 ) << threadCount << " Total: " << std::fixed
+				  << std::setprecision( 2 ) << elapsed << " ms Step: " << elapsed / steps.Get()
+				  << " ms Checksum: " << std::setprecision( 6 ) << getChecksum( space )
+				  << std::endl;
+
+		Space::Free( space );
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,201 @@
+#include <args/args.hxx>
+#include <atomic>
+#include <eepp/ee.hpp>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#if defined( EE_PLATFORM_POSIX )
+#include <sys/resource.h>
+#endif
+
+/**
+Socket selector benchmark: a loopback echo server runs in its own thread, waiting on a single
+SocketSelector that holds the listener and every accepted client. The clients are connected one
+after the other to measure the connections per second accepted through the selector. Then, with all
+the connections open and idle, random clients send a small message and wait for the echo, to
+measure the round trip latency of a wait when the selector holds all the sockets. The server visits
+only the ready sockets with forEachReady.
+*/
+
+static bool raiseFileLimit( const Uint32& sockets ) {
+#if defined( EE_PLATFORM_POSIX )
+	// Each connection uses two descriptors, the client and the server sides
+	rlim_t required = static_cast<rlim_t>( sockets ) * 2 + 64;
+	rlimit limit;
+	if ( getrlimit( RLIMIT_NOFILE, &limit ) != 0 )
+		return false;
+	if ( limit.rlim_cur < required ) {
+		if ( limit.rlim_max < required )
+			return false;
+		limit.rlim_cur = required;
+		return setrlimit( RLIMIT_NOFILE, &limit ) == 0;
+	}
+#endif
+	return true;
+}
+
+static void printTimes( const std::string& name, std::vector<double>& times ) {
+	std::sort( times.begin(), times.end() );
+	double total = 0;
+	for ( const auto& time : times )
+		total += time;
+	std::cout << std::left << std::setw( 12 ) << name << std::right << std::fixed
+			  << std::setprecision( 3 ) << " avg: " << std::setw( 8 ) << total / times.size()
+			  << " ms p50: " << std::setw( 8 ) << times[times.size() / 2]
+			  << " ms p99: " << std::setw( 8 ) << times[times.size() * 99 / 100]
+			  << " ms max: " << std::setw( 8 ) << times.back() << " ms" << std::endl;
+}
+
+class EchoServer {
+  public:
+	EchoServer( SocketSelector::Trigger trigger ) : mSelector( trigger ) {}
+
+	~EchoServer() {
+		mRunning = false;
+		if ( mThread.joinable() )
+			mThread.join();
+		for ( auto client : mClients )
+			delete client;
+	}
+
+	bool start() {
+		if ( mListener.listen( 0, IpAddress::LocalHost ) != Socket::Done )
+			return false;
+		mListener.setBlocking( false );
+		mSelector.add( mListener );
+		mThread = std::thread( [this] { run(); } );
+		return true;
+	}
+
+	unsigned short getPort() const { return mListener.getLocalPort(); }
+
+	size_t getClientsCount() const { return mClientsCount; }
+
+  protected:
+	TcpListener mListener;
+	SocketSelector mSelector;
+	std::vector<TcpSocket*> mClients;
+	std::thread mThread;
+	std::atomic<bool> mRunning{ true };
+	std::atomic<size_t> mClientsCount{ 0 };
+
+	void accept() {
+		while ( true ) {
+			TcpSocket* client = new TcpSocket();
+			if ( mListener.accept( *client ) != Socket::Done ) {
+				delete client;
+				return;
+			}
+			client->setBlocking( false );
+			mClients.push_back( client );
+			mSelector.add( *client );
+			mClientsCount++;
+		}
+	}
+
+	void echo( TcpSocket& client ) {
+		char buffer[256];
+		std::size_t received;
+		// Read until there's nothing left, as required by the edge triggered selectors
+		while ( client.receive( buffer, sizeof( buffer ), received ) == Socket::Done ) {
+			std::size_t sent;
+			client.send( buffer, received, sent );
+		}
+	}
+
+	void run() {
+		while ( mRunning ) {
+			if ( !mSelector.wait( Milliseconds( 50 ) ) )
+				continue;
+			mSelector.forEachReady( [this]( Socket& socket ) {
+				if ( &socket == &mListener )
+					accept();
+				else
+					echo( static_cast<TcpSocket&>( socket ) );
+			} );
+		}
+	}
+};
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	args::ArgumentParser parser( "eepp - Socket Selector Benchmark" );
+	args::HelpFlag help( parser, "help", "Display this help menu", { 'h', "help" } );
+	args::ValueFlag<Uint32> socketsCount( parser, "sockets", "Number of connections",
+										  { "sockets" }, 10000, args::Options::Single );
+	args::ValueFlag<Uint32> messagesCount( parser, "messages", "Number of echo round trips",
+										   { "messages" }, 10000, args::Options::Single );
+	args::Flag edge( parser, "edge", "Use an edge triggered selector", { "edge" } );
+
+	try {
+		parser.ParseCLI( argc, argv );
+	} catch ( const args::Help& ) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	} catch ( const args::ParseError& e ) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << parser;
+		return EXIT_FAILURE;
+	}
+
+	if ( !raiseFileLimit( socketsCount.Get() ) ) {
+		std::cerr << "The open files limit is too low for " << socketsCount.Get() << " sockets"
+				  << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	EchoServer server( edge.Get() ? SocketSelector::Trigger::Edge
+								  : SocketSelector::Trigger::Level );
+	if ( !server.start() ) {
+		std::cerr << "Couldn't start the echo server" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<std::unique_ptr<TcpSocket>> clients;
+	clients.reserve( socketsCount.Get() );
+
+	Clock clock;
+	for ( Uint32 i = 0; i < socketsCount.Get(); i++ ) {
+		auto client = std::make_unique<TcpSocket>();
+		if ( client->connect( IpAddress::LocalHost, server.getPort(), Seconds( 5 ) ) !=
+			 Socket::Done ) {
+			std::cerr << "Couldn't connect client " << i << std::endl;
+			return EXIT_FAILURE;
+		}
+		clients.emplace_back( std::move( client ) );
+	}
+	while ( server.getClientsCount() < clients.size() &&
+			clock.getElapsedTime() < Seconds( 30 ) )
+		Sys::sleep( Milliseconds( 1 ) );
+	double elapsed = clock.getElapsedTime().asSeconds();
+
+	std::cout << "Trigger: " << ( edge.Get() ? "Edge" : "Level" )
+			  << " Connections: " << server.getClientsCount() << " in " << std::fixed
+			  << std::setprecision( 3 ) << elapsed << " s ("
+			  << static_cast<Uint64>( server.getClientsCount() / elapsed ) << " connections/s)"
+			  << std::endl;
+
+	std::vector<double> latencies;
+	const char message[] = "ping";
+	char reply[sizeof( message )];
+	for ( Uint32 i = 0; i < messagesCount.Get(); i++ ) {
+		TcpSocket& client = *clients[( static_cast<Uint64>( i ) * 7919 ) % clients.size()];
+		clock.restart();
+		client.send( message, sizeof( message ) );
+		std::size_t total = 0;
+		std::size_t received;
+		while ( total < sizeof( reply ) &&
+				client.receive( reply + total, sizeof( reply ) - total, received ) ==
+					Socket::Done )
+			total += received;
+		latencies.push_back( clock.getElapsedTime().asMilliseconds() );
+		if ( total != sizeof( reply ) ) {
+			std::cerr << "The echo server didn't reply" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	printTimes( "Round trip", latencies );
+
+	return EXIT_SUCCESS;
+}
@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <args/args.hxx>
 #include <eepp/ee.hpp>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
 
 using namespace EE::UI::Abstract;
 
@@ -98,11 +103,182 @@ class TestModel : public Model {
 };
 
 // This file is used to test some UI related stuffs.
-// It's not a benchmark or a real test suite.
-// It's just used to test whatever I need to test at any given moment.
+// It's not a real test suite, it's used to test whatever I need to test at any given moment.
+// Run it with --benchmark to time the UITreeView navigation over the TestModel tree.
+// Run it with --editor-benchmark to time the UICodeEditor frames while scrolling a large file.
 
 EE::Window::Window* win = NULL;
 
+static void drawFrame() {
+	SceneManager::instance()->update();
+	win->clear();
+	SceneManager::instance()->draw();
+	win->display();
+}
+
+static void runTreeViewBenchmark( UITreeView* view, const int& iterations ) {
+	auto report = []( const std::string& name, const Clock& clock, const int& ops ) {
+		double ms = clock.getElapsedTime().asMilliseconds();
+		std::cout << std::left << std::setw( 24 ) << name << std::right << std::fixed
+				  << std::setprecision( 3 ) << std::setw( 12 ) << ms << " ms total "
+				  << std::setw( 10 ) << ms / eemax( 1, ops ) << " ms/op" << std::endl;
+	};
+	auto keyDown = [view]( const Keycode& keyCode ) {
+		KeyEvent event( view, Event::KeyDown, keyCode, SCANCODE_UNKNOWN, 0, 0 );
+		view->forceKeyDown( event );
+	};
+	auto pressKeys = [&]( const std::string& name, const Keycode& keyCode ) {
+		Clock clock;
+		for ( int i = 0; i < iterations; i++ ) {
+			keyDown( keyCode );
+			drawFrame();
+		}
+		report( name, clock, iterations );
+	};
+	Model* model = view->getModel();
+
+	drawFrame();
+
+	Clock clock;
+	view->expandAll();
+	drawFrame();
+	report( "expand all", clock, 1 );
+	std::cout << "Visible rows: " << view->getVisibleRowCount() << std::endl;
+
+	view->setSelection( model->index( 0, model->treeColumn() ) );
+	drawFrame();
+	pressKeys( "key down", KEY_DOWN );
+	pressKeys( "key up", KEY_UP );
+	pressKeys( "page down", KEY_PAGEDOWN );
+	pressKeys( "page up", KEY_PAGEUP );
+
+	clock.restart();
+	for ( int i = 0; i < iterations; i++ ) {
+		keyDown( i % 2 == 0 ? KEY_END : KEY_HOME );
+		drawFrame();
+	}
+	report( "end / home", clock, iterations );
+
+	clock.restart();
+	for ( int i = 0; i < iterations; i++ ) {
+		view->getVerticalScrollBar()->setValue( ( i * 37 % 100 ) / 100.f );
+		drawFrame();
+	}
+	report( "scroll", clock, iterations );
+
+	clock.restart();
+	size_t rows = model->rowCount();
+	for ( int i = 0; i < iterations; i++ ) {
+		ModelIndex index( model->index( ( i * 7919 ) % rows, model->treeColumn() ) );
+		view->setExpanded( index, false );
+		drawFrame();
+		view->setExpanded( index, true );
+		drawFrame();
+	}
+	report( "collapse / expand", clock, iterations * 2 );
+
+	clock.restart();
+	view->collapseAll();
+	drawFrame();
+	report( "collapse all", clock, 1 );
+}
+
+static std::string createSourceFile( const int& lines ) {
+	static const char* words[] = { "editor", "document", "text",   "widget", "buffer",
+								   "cursor", "line",	 "glyph",  "scroll", "selection" };
+	Uint32 seed = 12345;
+	auto word = [&seed]() {
+		seed = seed * 1103515245 + 12345;
+		return std::string( words[( ( seed >> 16 ) & 0x7FFF ) % eeARRAY_SIZE( words )] );
+	};
+	std::string text;
+	for ( int i = 0; i < lines; i++ ) {
+		std::string num( String::toString( i ) );
+		switch ( i % 8 ) {
+			case 0:
+				text += "// Updates the " + word() + " of the " + word() + " and the " + word();
+				break;
+			case 1:
+				text += "static int " + word() + num + "( const std::string& " + word() + " ) {";
+				break;
+			case 2:
+				text += "\tif ( " + word() + ".size() > " + num + " && " + word() + " != \"" +
+						word() + "\" )";
+				break;
+			case 3:
+				text += "\t\treturn " + word() + "( " + num + ", 0x" + num + " ); // " + word();
+				break;
+			case 4:
+				text += "\tfloat " + word() + " = " + num + ".5f * " + word() + "->" + word() +
+						"();";
+				break;
+			case 5:
+				text += "\treturn " + num + ";";
+				break;
+			case 6:
+				text += "}";
+				break;
+			default:
+				break;
+		}
+		text += "\n";
+	}
+	return text;
+}
+
+static void runCodeEditorBenchmark( UICodeEditor* editor, const int& iterations ) {
+	std::vector<double> times;
+	auto frame = [&times]() {
+		Clock clock;
+		drawFrame();
+		times.push_back( clock.getElapsedTime().asMilliseconds() );
+	};
+	auto report = [&times]( const std::string& name ) {
+		std::sort( times.begin(), times.end() );
+		double total = std::accumulate( times.begin(), times.end(), 0. );
+		size_t count = eemax<size_t>( 1, times.size() );
+		std::cout << std::left << std::setw( 24 ) << name << std::right << std::fixed
+				  << std::setprecision( 3 ) << std::setw( 6 ) << times.size() << " frames avg "
+				  << std::setw( 8 ) << total / count << " ms p50 " << std::setw( 8 )
+				  << times[times.size() / 2] << " ms p95 " << std::setw( 8 )
+				  << times[times.size() * 95 / 100] << " ms max " << std::setw( 8 )
+				  << times.back() << " ms" << std::endl;
+		times.clear();
+	};
+
+	drawFrame();
+	Float lineHeight = editor->getLineHeight();
+	Float pageHeight = editor->getPixelsSize().getHeight();
+	Float maxScroll = editor->getMaxScroll().getHeight();
+	std::cout << "Lines: " << editor->getDocument().linesCount()
+			  << " Visible lines: " << static_cast<int>( pageHeight / lineHeight ) << std::endl;
+
+	for ( Float y = 0; y <= maxScroll; y += pageHeight ) {
+		editor->setScrollY( y );
+		frame();
+	}
+	report( "scroll pages" );
+
+	for ( Float y = maxScroll; y >= 0; y -= pageHeight ) {
+		editor->setScrollY( y );
+		frame();
+	}
+	report( "scroll pages back" );
+
+	for ( int i = 0; i < iterations; i++ ) {
+		editor->setScrollY( eemin( maxScroll, i * lineHeight ) );
+		frame();
+	}
+	report( "scroll lines" );
+
+	// Nothing changes but the editor is drawn again, as when the cursor blinks
+	for ( int i = 0; i < iterations; i++ ) {
+		editor->invalidateDraw();
+		frame();
+	}
+	report( "redraw" );
+}
+
 void mainLoop() {
 	win->getInput()->update();
 
@@ -150,7 +326,31 @@ void mainLoop() {
 	}
 }
 
-EE_MAIN_FUNC int main( int, char*[] ) {
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	args::ArgumentParser parser( "eepp - UI Perf Test" );
+	args::HelpFlag help( parser, "help", "Display this help menu", { 'h', "help" } );
+	args::Flag benchmark( parser, "benchmark", "Run the timed UITreeView benchmark and exit",
+						  { 'b', "benchmark" } );
+	args::Flag editorBenchmark( parser, "editor-benchmark",
+								"Run the timed UICodeEditor scroll benchmark and exit",
+								{ "editor-benchmark" } );
+	args::ValueFlag<int> iterations( parser, "iterations", "Benchmark iterations per operation",
+									 { "iterations" }, 200, args::Options::Single );
+	args::ValueFlag<int> editorLines( parser, "editor-lines",
+									  "Lines of the document scrolled by the editor benchmark",
+									  { "editor-lines" }, 50000, args::Options::Single );
+
+	try {
+		parser.ParseCLI( argc, argv );
+	} catch ( const args::Help& ) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	} catch ( const args::ParseError& e ) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << parser;
+		return EXIT_FAILURE;
+	}
+
 	win = Engine::instance()->createWindow( WindowSettings( 1366, 768, "eepp - UI Perf Test" ),
 											ContextSettings( false ) );
 
@@ -201,17 +401,41 @@ EE_MAIN_FUNC int main( int, char*[] ) {
 		auto* vlay = UILinearLayout::NewVertical();
 		vlay->setLayoutSizePolicy( SizePolicy::MatchParent, SizePolicy::MatchParent );
 
+		if ( editorBenchmark ) {
+			FontTrueType* monospace =
+				FontTrueType::New( "monospace", "assets/fonts/DejaVuSansMono.ttf" );
+			UICodeEditor* editor = UICodeEditor::New();
+			editor->setLayoutSizePolicy( SizePolicy::MatchParent, SizePolicy::MatchParent );
+			editor->setParent( vlay );
+			editor->setFont( monospace );
+			std::string text( createSourceFile( eemax( 1, editorLines.Get() ) ) );
+			editor->getDocument().loadFromMemory( reinterpret_cast<const Uint8*>( text.data() ),
+												  text.size() );
+			editor->setSyntaxDefinition(
+				SyntaxDefinitionManager::instance()->getByLanguageName( "C++" ) );
+			editor->setFocus();
+			runCodeEditorBenchmark( editor, eemax( 1, iterations.Get() ) );
+			Engine::destroySingleton();
+			return EXIT_SUCCESS;
+		}
+
 		Clock clock;
-		auto model = FileSystemModel::New( "." ); // std::make_shared<TestModel>();
-		// UITreeView* view = UITreeView::New();
-		UITableView* view = UITableView::New();
+		auto model = std::make_shared<TestModel>();
+		UITreeView* view = UITreeView::New();
 		// view->setExpanderIconSize( PixelDensity::dpToPx( 20 ) );
 		view->setId( "treeview" );
 		view->setLayoutSizePolicy( SizePolicy::MatchParent, SizePolicy::MatchParent );
 		view->setParent( vlay );
-		view->setModel( SortingProxyModel::New( model ) );
+		view->setModel( model );
+		view->setFocus();
 		Log::notice( "Total time: %.2fms", clock.getElapsedTime().asMilliseconds() );
 
+		if ( benchmark ) {
+			runTreeViewBenchmark( view, eemax( 1, iterations.Get() ) );
+			Engine::destroySingleton();
+			return EXIT_SUCCESS;
+		}
+
 		/* ListBox test */ /*
 		 std::vector<String> strings;
 		 for ( size_t i = 0; i < 10000; i++ )
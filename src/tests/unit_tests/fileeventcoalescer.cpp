@@ -0,0 +1,78 @@
+#include "../../tools/ecode/fileeventcoalescer.hpp"
+#include "utest.h"
+
+using namespace ecode;
+
+namespace {
+
+FileEvent event( FileSystemEventType type, const std::string& filename,
+				 const std::string& oldFilename = "" ) {
+	return FileEvent( type, "/project/", filename, oldFilename );
+}
+
+std::vector<std::pair<FileSystemEventType, std::string>> take( FileEventCoalescer& coalescer ) {
+	std::vector<std::pair<FileSystemEventType, std::string>> changes;
+	for ( const auto& change : coalescer.take() )
+		changes.emplace_back( change.type, change.filename );
+	return changes;
+}
+
+} // namespace
+
+UTEST( FileEventCoalescer, mergesEventsOfPath ) {
+	FileEventCoalescer coalescer;
+	coalescer.add( event( FileSystemEventType::Add, "a" ) );
+	coalescer.add( event( FileSystemEventType::Modified, "b" ) );
+	coalescer.add( event( FileSystemEventType::Modified, "a" ) );
+	coalescer.add( event( FileSystemEventType::Modified, "b" ) );
+	coalescer.add( event( FileSystemEventType::Add, "c" ) );
+	coalescer.add( event( FileSystemEventType::Delete, "c" ) );
+	coalescer.add( event( FileSystemEventType::Delete, "d" ) );
+	coalescer.add( event( FileSystemEventType::Add, "d" ) );
+	coalescer.add( event( FileSystemEventType::Modified, "e" ) );
+	coalescer.add( event( FileSystemEventType::Delete, "e" ) );
+	EXPECT_EQ( coalescer.getEventsCount(), 10UL );
+
+	auto changes = take( coalescer );
+	ASSERT_EQ( changes.size(), 4UL );
+	EXPECT_EQ( changes[0].first, FileSystemEventType::Add );
+	EXPECT_STREQ( changes[0].second.c_str(), "a" );
+	EXPECT_EQ( changes[1].first, FileSystemEventType::Modified );
+	EXPECT_STREQ( changes[1].second.c_str(), "b" );
+	EXPECT_EQ( changes[2].first, FileSystemEventType::Modified );
+	EXPECT_STREQ( changes[2].second.c_str(), "d" );
+	EXPECT_EQ( changes[3].first, FileSystemEventType::Delete );
+	EXPECT_STREQ( changes[3].second.c_str(), "e" );
+
+	EXPECT_TRUE( coalescer.empty() );
+	EXPECT_TRUE( coalescer.take().empty() );
+}
+
+UTEST( FileEventCoalescer, keepsMovesInOrder ) {
+	FileEventCoalescer coalescer;
+	coalescer.add( event( FileSystemEventType::Add, "a" ) );
+	coalescer.add( event( FileSystemEventType::Moved, "b", "a" ) );
+	coalescer.add( event( FileSystemEventType::Modified, "b" ) );
+	coalescer.add( event( FileSystemEventType::Modified, "b" ) );
+	coalescer.add( event( FileSystemEventType::Add, "a" ) );
+
+	auto changes = take( coalescer );
+	ASSERT_EQ( changes.size(), 4UL );
+	EXPECT_EQ( changes[0].first, FileSystemEventType::Add );
+	EXPECT_STREQ( changes[0].second.c_str(), "a" );
+	EXPECT_EQ( changes[1].first, FileSystemEventType::Moved );
+	EXPECT_STREQ( changes[1].second.c_str(), "b" );
+	EXPECT_EQ( changes[2].first, FileSystemEventType::Modified );
+	EXPECT_STREQ( changes[2].second.c_str(), "b" );
+	EXPECT_EQ( changes[3].first, FileSystemEventType::Add );
+	EXPECT_STREQ( changes[3].second.c_str(), "a" );
+}
+
+UTEST( FileEventCoalescer, manyEvents ) {
+	// A checkout rewriting the same files many times
+	FileEventCoalescer coalescer;
+	for ( int i = 0; i < 100000; i++ )
+		coalescer.add( event( FileSystemEventType::Modified, std::to_string( i % 100 ) ) );
+	EXPECT_EQ( coalescer.getEventsCount(), 100000UL );
+	EXPECT_EQ( coalescer.take().size(), 100UL );
+}
@@ -0,0 +1,113 @@
+#include "utest.h"
+#include <eepp/ui/doc/foldrangeservice.hpp>
+#include <eepp/ui/doc/syntaxdefinitionmanager.hpp>
+#include <eepp/ui/doc/textdocument.hpp>
+
+using namespace EE;
+using namespace EE::UI::Doc;
+
+namespace {
+
+// Applies random insertions, removals, undos and redos and checks after each round that the
+// incremental fold ranges match the ones of a full scan of the document.
+int randomEditsMatchFullScan( TextDocument& doc, const std::vector<String>& snippets ) {
+	auto& service = doc.getFoldRangeService();
+	Uint32 seed = 4321;
+	auto next = [&seed]( Uint32 max ) {
+		seed = seed * 1103515245 + 12345;
+		return ( ( seed >> 16 ) & 0x7FFF ) % max;
+	};
+	auto randomPosition = [&]() {
+		Int64 line = next( doc.linesCount() );
+		return TextPosition( line, next( doc.line( line ).size() ) );
+	};
+
+	for ( int i = 0; i < 200; i++ ) {
+		int edits = 1 + next( 4 );
+		for ( int e = 0; e < edits; e++ ) {
+			switch ( next( 5 ) ) {
+				case 0:
+				case 1:
+					doc.insert( 0, randomPosition(), snippets[next( snippets.size() )] );
+					break;
+				case 2:
+				case 3: {
+					TextPosition start( randomPosition() );
+					TextPosition end( eemin<Int64>( start.line() + next( 3 ),
+													doc.linesCount() - 1 ),
+									  0 );
+					end.setColumn( next( doc.line( end.line() ).size() ) );
+					doc.remove( 0, TextRange( start, end ).normalized() );
+					break;
+				}
+				default: {
+					if ( next( 2 ) )
+						doc.undo();
+					else
+						doc.redo();
+				}
+			}
+		}
+		auto incremental = service.computeRegions();
+		if ( incremental != service.computeRegions( false ) )
+			return i;
+	}
+	return -1;
+}
+
+} // namespace
+
+UTEST( FoldRangeService, braces ) {
+	TextDocument doc( false );
+	const auto& cpp = SyntaxDefinitionManager::instance()->getByLanguageName( "C++" );
+	ASSERT_STREQ( cpp.getLanguageName().c_str(), "C++" );
+	doc.setSyntaxDefinition( cpp );
+
+	String text;
+	for ( int i = 0; i < 100; i++ ) {
+		text += "void function" + String::toString( i ) + "() {\n";
+		text += "\tif ( value ) {\n\t\tcall( \"{ not a brace\" );\n\t}\n";
+		text += "\t// a comment {\n\treturn;\n}\n";
+	}
+	doc.insert( 0, { 0, 0 }, text );
+
+	auto& service = doc.getFoldRangeService();
+	auto regions = service.computeRegions();
+	EXPECT_EQ( regions.size(), 200UL );
+	EXPECT_TRUE( regions == service.computeRegions( false ) );
+
+	// Braces inside strings and comments are ignored
+	EXPECT_TRUE( regions[0] == TextRange( { 1, 14 }, { 3, 1 } ) );
+	EXPECT_TRUE( regions[1] == TextRange( { 0, 17 }, { 6, 0 } ) );
+
+	// The regions are only applied when they change
+	service.findRegions();
+	EXPECT_TRUE( service.isFoldingRegionInLine( 0 ) );
+	EXPECT_FALSE( service.isFoldingRegionInLine( 2 ) );
+
+	EXPECT_EQ( randomEditsMatchFullScan( doc, { "{", "}", "{\n", "\n}", "\"{\"", "/* {",
+												"*/", "// }\n", "value\n" } ),
+			   -1 );
+}
+
+UTEST( FoldRangeService, indentation ) {
+	TextDocument doc( false );
+	const auto& python = SyntaxDefinitionManager::instance()->getByLanguageName( "Python" );
+	ASSERT_STREQ( python.getLanguageName().c_str(), "Python" );
+	doc.setSyntaxDefinition( python );
+
+	String text;
+	for ( int i = 0; i < 100; i++ ) {
+		text += "def function" + String::toString( i ) + "():\n";
+		text += "    if value:\n        call()\n    return\n\n";
+	}
+	doc.insert( 0, { 0, 0 }, text );
+
+	auto& service = doc.getFoldRangeService();
+	EXPECT_TRUE( service.computeRegions() == service.computeRegions( false ) );
+	EXPECT_FALSE( service.computeRegions().empty() );
+
+	EXPECT_EQ( randomEditsMatchFullScan( doc, { "    ", "\n", "\n    ", "\n        pass",
+												"\tvalue", "if value:\n    " } ),
+			   -1 );
+}
@@ -0,0 +1,467 @@
+#include "utest.h"
+#include <atomic>
+#include <condition_variable>
+#include <eepp/network/http.hpp>
+#include <eepp/network/socketselector.hpp>
+#include <eepp/network/tcplistener.hpp>
+#include <eepp/system/clock.hpp>
+#include <eepp/system/filesystem.hpp>
+#include <eepp/system/iostreamstring.hpp>
+#include <eepp/system/sys.hpp>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace EE;
+using namespace EE::Network;
+using namespace EE::System;
+
+namespace {
+
+std::string makeBody( size_t size ) {
+	std::string body( size, ' ' );
+	for ( size_t i = 0; i < size; i++ )
+		body[i] = 'a' + i % 26;
+	return body;
+}
+
+// Minimal HTTP/1.1 server with keep-alive and byte ranges, counts the connections accepted
+class LoopbackServer {
+  public:
+	LoopbackServer() {
+		mListener.setBlocking( false );
+		mListening = mListener.listen( 0, IpAddress::LocalHost ) == Socket::Done;
+		if ( mListening )
+			mAcceptThread = std::thread( [this] { accept(); } );
+	}
+
+	~LoopbackServer() {
+		mRunning = false;
+		if ( mAcceptThread.joinable() )
+			mAcceptThread.join();
+		for ( auto& thread : mThreads )
+			thread.join();
+	}
+
+	bool isListening() const { return mListening; }
+
+	unsigned short getPort() const { return mListener.getLocalPort(); }
+
+	size_t getConnections() const { return mConnections; }
+
+	size_t getRangeRequests() const { return mRangeRequests; }
+
+  protected:
+	TcpListener mListener;
+	bool mListening{ false };
+	std::atomic<bool> mRunning{ true };
+	std::atomic<size_t> mConnections{ 0 };
+	std::atomic<size_t> mRangeRequests{ 0 };
+	std::thread mAcceptThread;
+	std::vector<std::thread> mThreads;
+
+	void accept() {
+		while ( mRunning ) {
+			auto socket = std::make_shared<TcpSocket>();
+			if ( mListener.accept( *socket ) != Socket::Done ) {
+				Sys::sleep( Milliseconds( 1 ) );
+				continue;
+			}
+			socket->setBlocking( true );
+			mConnections++;
+			mThreads.emplace_back( [this, socket] { serve( *socket ); } );
+		}
+	}
+
+	void serve( TcpSocket& socket ) {
+		SocketSelector selector;
+		selector.add( socket );
+		std::string buffer;
+		char data[4096];
+		std::size_t received;
+
+		while ( mRunning ) {
+			if ( !selector.wait( Milliseconds( 20 ) ) )
+				continue;
+			if ( socket.receive( data, sizeof( data ), received ) != Socket::Done )
+				return;
+			buffer.append( data, received );
+
+			size_t end;
+			while ( ( end = buffer.find( "\r\n\r\n" ) ) != std::string::npos ) {
+				std::string header( buffer.substr( 0, end ) );
+				std::string path( header.substr( header.find( ' ' ) + 1 ) );
+				path = path.substr( 0, path.find( ' ' ) );
+				buffer.erase( 0, end + 4 );
+				if ( !respond( socket, header, path ) )
+					return;
+			}
+		}
+	}
+
+	bool respond( TcpSocket& socket, const std::string& header, const std::string& path ) {
+		std::string response;
+		bool keepAlive = true;
+
+		if ( path.find( "/file/" ) == 0 || path.find( "/flaky/" ) == 0 ||
+			 path.find( "/norange/" ) == 0 || path.find( "/badrange/" ) == 0 ) {
+			return respondRange( socket, header, path );
+		} else if ( path.find( "/size/" ) == 0 ) {
+			std::string body( makeBody( std::stoul( path.substr( 6 ) ) ) );
+			response = "HTTP/1.1 200 OK\r\nContent-Length: " +
+					   String::toString( (Uint64)body.size() ) + "\r\n\r\n" + body;
+		} else if ( path.find( "/chunked/" ) == 0 ) {
+			std::string body( makeBody( std::stoul( path.substr( 9 ) ) ) );
+			response = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+			for ( size_t pos = 0; pos < body.size(); pos += 1000 ) {
+				std::string chunk( body.substr( pos, 1000 ) );
+				response +=
+					String::format( "%x\r\n", (unsigned int)chunk.size() ) + chunk + "\r\n";
+			}
+			response += "0\r\n\r\n";
+		} else if ( path == "/close" ) {
+			response = "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\nclosed";
+			keepAlive = false;
+		} else if ( path == "/slow" ) {
+			Sys::sleep( Milliseconds( 500 ) );
+			response = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\nslow";
+		} else if ( path == "/redirect" ) {
+			response = "HTTP/1.1 302 Found\r\nLocation: /size/10\r\nContent-Length: 0\r\n\r\n";
+		} else {
+			response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+		}
+
+		return socket.send( response.data(), response.size() ) == Socket::Done && keepAlive;
+	}
+
+	// "/file/N" serves N bytes accepting ranges, "/flaky/N" also closes the connection after
+	// sending 64 KiB of each range. "/norange/N" and "/badrange/N" claim to accept ranges, but
+	// the first ignores them and the second always sends the range from the first byte.
+	bool respondRange( TcpSocket& socket, const std::string& header, const std::string& path ) {
+		bool flaky = path.find( "/flaky/" ) == 0;
+		bool badRange = path.find( "/badrange/" ) == 0;
+		std::string body( makeBody( std::stoul( path.substr( path.find( '/', 1 ) + 1 ) ) ) );
+		std::string response;
+
+		if ( header.find( "HEAD " ) == 0 ) {
+			response = "HTTP/1.1 200 OK\r\nAccept-Ranges: bytes\r\nContent-Length: " +
+					   String::toString( (Uint64)body.size() ) + "\r\n\r\n";
+			return socket.send( response.data(), response.size() ) == Socket::Done;
+		}
+
+		size_t range = String::toLower( header ).find( "\nrange: bytes=" );
+		if ( range != std::string::npos && path.find( "/norange/" ) == 0 ) {
+			mRangeRequests++;
+			range = std::string::npos;
+		}
+
+		if ( range == std::string::npos ) {
+			response = "HTTP/1.1 200 OK\r\nContent-Length: " +
+					   String::toString( (Uint64)body.size() ) + "\r\n\r\n" + body;
+			return socket.send( response.data(), response.size() ) == Socket::Done;
+		}
+
+		mRangeRequests++;
+		std::string bytes( header.substr( range + 14 ) );
+		bytes = bytes.substr( 0, bytes.find( '\r' ) );
+		size_t first = std::stoul( bytes.substr( 0, bytes.find( '-' ) ) );
+		size_t last = std::stoul( bytes.substr( bytes.find( '-' ) + 1 ) );
+		if ( badRange ) {
+			last -= first;
+			first = 0;
+			bytes = "0-" + String::toString( (Uint64)last );
+		}
+		std::string part( body.substr( first, last - first + 1 ) );
+		response = "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes " + bytes + "/" +
+				   String::toString( (Uint64)body.size() ) +
+				   "\r\nContent-Length: " + String::toString( (Uint64)part.size() ) + "\r\n\r\n";
+		if ( flaky && part.size() > 65536 ) {
+			response += part.substr( 0, 65536 );
+			socket.send( response.data(), response.size() );
+			return false;
+		}
+		response += part;
+		return socket.send( response.data(), response.size() ) == Socket::Done;
+	}
+};
+
+// Collects the responses of the asynchronous requests
+class Responses {
+  public:
+	Http::AsyncResponseCallback callback() {
+		return [this]( const Http&, Http::Request& request, Http::Response& response ) {
+			std::lock_guard<std::mutex> lock( mMutex );
+			mResponses.emplace_back( request.getUri(), response );
+			mReceived.notify_all();
+		};
+	}
+
+	bool waitFor( size_t count ) {
+		std::unique_lock<std::mutex> lock( mMutex );
+		return mReceived.wait_for( lock, std::chrono::seconds( 10 ),
+								   [this, count] { return mResponses.size() >= count; } );
+	}
+
+	std::vector<std::pair<std::string, Http::Response>> get() {
+		std::lock_guard<std::mutex> lock( mMutex );
+		return mResponses;
+	}
+
+  protected:
+	std::mutex mMutex;
+	std::condition_variable mReceived;
+	std::vector<std::pair<std::string, Http::Response>> mResponses;
+};
+
+} // namespace
+
+UTEST( HttpEngine, parallelRequests ) {
+	LoopbackServer server;
+	ASSERT_TRUE( server.isListening() );
+	Http::setMaxConnectionsPerHost( 4 );
+
+	Responses responses;
+	{
+		Http http( "http://127.0.0.1", server.getPort() );
+		for ( Uint64 i = 0; i < 64; i++ )
+			http.sendAsyncRequest( responses.callback(),
+								   Http::Request( "/size/" + String::toString( i * 1000 ) ) );
+		ASSERT_TRUE( responses.waitFor( 64 ) );
+	}
+
+	for ( auto& response : responses.get() ) {
+		EXPECT_EQ( response.second.getStatus(), Http::Response::Ok );
+		EXPECT_TRUE( response.second.getBody() ==
+					 makeBody( std::stoul( response.first.substr( 6 ) ) ) );
+	}
+
+	// The requests waited for the connections already open
+	EXPECT_LE( server.getConnections(), 4UL );
+	Http::setMaxConnectionsPerHost( 6 );
+}
+
+UTEST( HttpEngine, connectionReuse ) {
+	LoopbackServer server;
+	ASSERT_TRUE( server.isListening() );
+
+	Http http( "http://127.0.0.1", server.getPort() );
+	Responses responses;
+	for ( size_t i = 0; i < 10; i++ ) {
+		http.sendAsyncRequest( responses.callback(), Http::Request( "/size/100" ) );
+		ASSERT_TRUE( responses.waitFor( i + 1 ) );
+	}
+
+	// The connection is closed by the server, the next request opens another one
+	http.sendAsyncRequest( responses.callback(), Http::Request( "/close" ) );
+	http.sendAsyncRequest( responses.callback(), Http::Request( "/chunked/100000" ) );
+	ASSERT_TRUE( responses.waitFor( 12 ) );
+
+	for ( auto& response : responses.get() ) {
+		EXPECT_EQ( response.second.getStatus(), Http::Response::Ok );
+		if ( response.first == "/close" ) {
+			EXPECT_STREQ( response.second.getBody().c_str(), "closed" );
+		} else if ( response.first == "/chunked/100000" ) {
+			EXPECT_TRUE( response.second.getBody() == makeBody( 100000 ) );
+		}
+	}
+
+	EXPECT_EQ( server.getConnections(), 2UL );
+}
+
+UTEST( HttpEngine, redirectAndDownload ) {
+	LoopbackServer server;
+	ASSERT_TRUE( server.isListening() );
+
+	Http http( "http://127.0.0.1", server.getPort() );
+	IOStreamString stream;
+	Responses responses;
+	http.downloadAsyncRequest( responses.callback(), Http::Request( "/redirect" ), stream );
+	ASSERT_TRUE( responses.waitFor( 1 ) );
+
+	auto response = responses.get().front();
+	EXPECT_EQ( response.second.getStatus(), Http::Response::Ok );
+	EXPECT_STREQ( response.first.c_str(), "/size/10" );
+	EXPECT_TRUE( stream.getStream() == makeBody( 10 ) );
+}
+
+UTEST( HttpEngine, timeout ) {
+	LoopbackServer server;
+	ASSERT_TRUE( server.isListening() );
+
+	Http http( "http://127.0.0.1", server.getPort() );
+	Responses responses;
+	Clock clock;
+	http.sendAsyncRequest( responses.callback(), Http::Request( "/slow" ), Milliseconds( 100 ) );
+	ASSERT_TRUE( responses.waitFor( 1 ) );
+
+	EXPECT_NE( responses.get().front().second.getStatus(), Http::Response::Ok );
+	EXPECT_TRUE( clock.getElapsedTime() < Milliseconds( 400 ) );
+}
+
+UTEST( HttpEngine, queuedTimeout ) {
+	LoopbackServer server;
+	ASSERT_TRUE( server.isListening() );
+	Http::setMaxConnectionsPerHost( 1 );
+
+	// The second request waits for the only connection, its timeout counts since it was sent
+	Http http( "http://127.0.0.1", server.getPort() );
+	Responses responses;
+	Clock clock;
+	http.sendAsyncRequest( responses.callback(), Http::Request( "/slow" ) );
+	http.sendAsyncRequest( responses.callback(), Http::Request( "/size/10" ), Milliseconds( 100 ) );
+	ASSERT_TRUE( responses.waitFor( 1 ) );
+	EXPECT_TRUE( clock.getElapsedTime() < Milliseconds( 400 ) );
+
+	auto response = responses.get().front();
+	EXPECT_STREQ( response.first.c_str(), "/size/10" );
+	EXPECT_NE( response.second.getStatus(), Http::Response::Ok );
+
+	ASSERT_TRUE( responses.waitFor( 2 ) );
+	EXPECT_EQ( responses.get().back().second.getStatus(), Http::Response::Ok );
+	Http::setMaxConnectionsPerHost( 6 );
+}
+
+UTEST( HttpEngine, unresolvedHost ) {
+	LoopbackServer server;
+	ASSERT_TRUE( server.isListening() );
+
+	// The lookup doesn't stop the requests to the other hosts
+	Http invalid( "http://eepp.invalid", 80 );
+	Http http( "http://127.0.0.1", server.getPort() );
+	Responses responses;
+	invalid.sendAsyncRequest( responses.callback(), Http::Request( "/size/10" ) );
+	http.sendAsyncRequest( responses.callback(), Http::Request( "/size/20" ) );
+	ASSERT_TRUE( responses.waitFor( 2 ) );
+
+	for ( auto& response : responses.get() ) {
+		if ( response.first == "/size/20" ) {
+			EXPECT_EQ( response.second.getStatus(), Http::Response::Ok );
+		} else {
+			EXPECT_EQ( response.second.getStatus(), Http::Response::ConnectionFailed );
+		}
+	}
+}
+
+UTEST( HttpEngine, segmentedDownload ) {
+	LoopbackServer server;
+	ASSERT_TRUE( server.isListening() );
+
+	std::string path( Sys::getTempPath() + "eepp_segmented_download.bin" );
+	Http http( "http://127.0.0.1", server.getPort() );
+	Http::Request request( "/file/2000000" );
+	request.setSegments( 4 );
+
+	std::mutex mutex;
+	size_t total = 0;
+	size_t current = 0;
+	bool increasing = true;
+	request.setProgressCallback( [&]( const Http&, const Http::Request&, const Http::Response&,
+									  const Http::Request::Status&, size_t totalBytes,
+									  size_t currentBytes ) {
+		std::lock_guard<std::mutex> lock( mutex );
+		increasing = increasing && currentBytes >= current;
+		total = totalBytes;
+		current = currentBytes;
+		return true;
+	} );
+
+	Responses responses;
+	http.downloadAsyncRequest( responses.callback(), request, path );
+	ASSERT_TRUE( responses.waitFor( 1 ) );
+
+	std::string data;
+	FileSystem::fileGet( path, data );
+	FileSystem::fileRemove( path );
+	EXPECT_EQ( responses.get().front().second.getStatus(), Http::Response::Ok );
+	EXPECT_TRUE( data == makeBody( 2000000 ) );
+	EXPECT_EQ( server.getRangeRequests(), 4UL );
+	EXPECT_EQ( total, 2000000UL );
+	EXPECT_EQ( current, 2000000UL );
+	EXPECT_TRUE( increasing );
+}
+
+UTEST( HttpEngine, segmentedDownloadResume ) {
+	LoopbackServer server;
+	ASSERT_TRUE( server.isListening() );
+
+	std::string path( Sys::getTempPath() + "eepp_segmented_download_resume.bin" );
+	Http http( "http://127.0.0.1", server.getPort() );
+	Http::Request request( "/flaky/1000000" );
+	request.setSegments( 2 );
+
+	Responses responses;
+	http.downloadAsyncRequest( responses.callback(), request, path );
+	ASSERT_TRUE( responses.waitFor( 1 ) );
+
+	std::string data;
+	FileSystem::fileGet( path, data );
+	FileSystem::fileRemove( path );
+	EXPECT_EQ( responses.get().front().second.getStatus(), Http::Response::Ok );
+	EXPECT_TRUE( data == makeBody( 1000000 ) );
+	// Each segment of 500000 bytes was resumed after every 65536 bytes received
+	EXPECT_EQ( server.getRangeRequests(), 16UL );
+}
+
+UTEST( HttpEngine, segmentedDownloadCancel ) {
+	LoopbackServer server;
+	ASSERT_TRUE( server.isListening() );
+
+	std::string path( Sys::getTempPath() + "eepp_segmented_download_cancel.bin" );
+	Http http( "http://127.0.0.1", server.getPort() );
+	Http::Request request( "/file/2000000" );
+	request.setSegments( 4 );
+	request.setProgressCallback( []( const Http&, const Http::Request&, const Http::Response&,
+									 const Http::Request::Status&, size_t,
+									 size_t currentBytes ) { return currentBytes < 500000; } );
+
+	std::mutex mutex;
+	std::condition_variable done;
+	std::vector<bool> cancelled;
+	http.downloadAsyncRequest(
+		[&]( const Http&, Http::Request& request, Http::Response& response ) {
+			std::lock_guard<std::mutex> lock( mutex );
+			// The response of a stopped segment is never reported as the result
+			cancelled.push_back( request.isCancelled() &&
+								 response.getStatus() != Http::Response::PartialContent );
+			done.notify_all();
+		},
+		request, path );
+
+	{
+		std::unique_lock<std::mutex> lock( mutex );
+		ASSERT_TRUE( done.wait_for( lock, std::chrono::seconds( 10 ),
+									[&cancelled] { return !cancelled.empty(); } ) );
+	}
+	FileSystem::fileRemove( path );
+	ASSERT_EQ( cancelled.size(), 1UL );
+	EXPECT_TRUE( cancelled.front() );
+	// The file is not downloaded again without ranges
+	Sys::sleep( Milliseconds( 100 ) );
+	EXPECT_EQ( cancelled.size(), 1UL );
+}
+
+UTEST( HttpEngine, segmentedDownloadRangeIgnored ) {
+	LoopbackServer server;
+	ASSERT_TRUE( server.isListening() );
+
+	// The segments are stopped and the file is downloaded again without ranges
+	for ( const std::string route : { "/norange/", "/badrange/" } ) {
+		std::string path( Sys::getTempPath() + "eepp_segmented_download_ignored.bin" );
+		Http http( "http://127.0.0.1", server.getPort() );
+		Http::Request request( route + "1000000" );
+		request.setSegments( 4 );
+
+		Responses responses;
+		http.downloadAsyncRequest( responses.callback(), request, path );
+		ASSERT_TRUE( responses.waitFor( 1 ) );
+
+		std::string data;
+		FileSystem::fileGet( path, data );
+		FileSystem::fileRemove( path );
+		EXPECT_EQ( responses.get().size(), 1UL );
+		EXPECT_EQ( responses.get().front().second.getStatus(), Http::Response::Ok );
+		EXPECT_TRUE( data == makeBody( 1000000 ) );
+	}
+
+	EXPECT_TRUE( server.getRangeRequests() > 0 );
+}
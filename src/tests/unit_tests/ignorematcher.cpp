@@ -0,0 +1,183 @@
+#include "../../tools/ecode/ignorematcher.hpp"
+#include "../../tools/ecode/projectscanner.hpp"
+#include "utest.h"
+#include <algorithm>
+#include <eepp/system/filesystem.hpp>
+#include <eepp/system/mutex.hpp>
+#include <eepp/system/sys.hpp>
+
+#if defined( EE_PLATFORM_POSIX )
+#include <unistd.h>
+#endif
+
+using namespace EE;
+using namespace EE::System;
+using namespace ecode;
+
+namespace {
+
+struct Repository {
+	std::string path;
+	std::vector<std::pair<std::string, bool>> paths;
+};
+
+// Creates the repository described by assets/gitignore/repository.txt in the temporary directory
+// and returns its paths with the results of git check-ignore
+Repository createRepository() {
+	Repository repo;
+	std::string data;
+	FileSystem::changeWorkingDirectory( Sys::getProcessPath() );
+	FileSystem::fileGet( "assets/gitignore/repository.txt", data );
+
+	repo.path = Sys::getTempPath() + "eepp_unit_tests_gitignore";
+	FileSystem::dirAddSlashAtEnd( repo.path );
+	FileSystem::makeDir( repo.path + ".git", true );
+	FileSystem::fileWrite( repo.path + ".git/HEAD", "ref: refs/heads/master\n" );
+
+	std::string section;
+	std::string content;
+	auto flush = [&] {
+		if ( !section.empty() && section != "paths" )
+			FileSystem::fileWrite( repo.path + section, content );
+		content.clear();
+	};
+
+	for ( const auto& line : String::split( data, '\n', true ) ) {
+		if ( line.size() > 2 && line.front() == '[' && line.back() == ']' ) {
+			flush();
+			section = line.substr( 1, line.size() - 2 );
+			FileSystem::makeDir( FileSystem::fileRemoveFileName( repo.path + section ), true );
+		} else if ( section == "paths" ) {
+			if ( line.size() < 3 )
+				continue;
+			std::string path( line.substr( 2 ) );
+			repo.paths.emplace_back( path, line[0] == '1' );
+			FileSystem::makeDir( FileSystem::fileRemoveFileName( repo.path + path ), true );
+			if ( !FileSystem::fileExists( repo.path + path ) )
+				FileSystem::fileWrite( repo.path + path, "" );
+		} else if ( !section.empty() ) {
+			content += line + "\n";
+		}
+	}
+	flush();
+
+	return repo;
+}
+
+} // namespace
+
+UTEST( IgnoreMatcher, precedence ) {
+	std::string path( Sys::getTempPath() + "eepp_unit_tests_gitignore_precedence" );
+	FileSystem::dirAddSlashAtEnd( path );
+	FileSystem::makeDir( path, true );
+	FileSystem::fileWrite( path + ".gitignore",
+						   "*.txt\n!keep.txt\nkeep.txt\nout/\n!*.md\nsrc/*.tmp\nbuild/**\n" );
+	GitIgnoreMatcher matcher( path );
+	ASSERT_TRUE( matcher.matcherReady() );
+
+	// The last pattern that matches wins
+	EXPECT_TRUE( matcher.match( "a.txt", false ) == IgnoreMatcher::Result::Ignored );
+	EXPECT_TRUE( matcher.match( "keep.txt", false ) == IgnoreMatcher::Result::Ignored );
+	EXPECT_TRUE( matcher.match( "readme.md", false ) == IgnoreMatcher::Result::Included );
+	EXPECT_TRUE( matcher.match( "main.cpp", false ) == IgnoreMatcher::Result::None );
+	// Directory only patterns
+	EXPECT_TRUE( matcher.match( "out", true ) == IgnoreMatcher::Result::Ignored );
+	EXPECT_TRUE( matcher.match( "out", false ) == IgnoreMatcher::Result::None );
+	EXPECT_TRUE( matcher.match( "src/out", true ) == IgnoreMatcher::Result::Ignored );
+	// Patterns with a slash are relative to the ignore file directory
+	EXPECT_TRUE( matcher.match( "src/a.tmp", false ) == IgnoreMatcher::Result::Ignored );
+	EXPECT_TRUE( matcher.match( "lib/src/a.tmp", false ) == IgnoreMatcher::Result::None );
+	// A directory whose contents are all ignored doesn't need to be scanned
+	EXPECT_TRUE( matcher.match( "build", true ) == IgnoreMatcher::Result::Ignored );
+	EXPECT_TRUE( matcher.match( "build/a.cpp", false ) == IgnoreMatcher::Result::Ignored );
+}
+
+UTEST( IgnoreMatcher, gitCheckIgnore ) {
+	Repository repo( createRepository() );
+	ASSERT_FALSE( repo.paths.empty() );
+
+	for ( const auto& path : repo.paths ) {
+		std::string fullPath( repo.path + path.first );
+		std::string dir( FileSystem::fileRemoveFileName( fullPath ) );
+
+		// The ignore files from the repository root to the directory of the file
+		IgnoreMatcherManager manager( repo.path );
+		std::string curDir( repo.path );
+		std::string localDir( dir.substr( repo.path.size() ) );
+		for ( const auto& part : String::split( localDir, '/' ) ) {
+			curDir += part + "/";
+			IgnoreMatcherManager child( curDir );
+			if ( child.foundMatch() )
+				manager.addChild( child.popMatcher( 0 ) );
+		}
+
+		ASSERT_TRUE( manager.foundMatch() );
+		EXPECT_EQ_MSG( manager.match( fullPath, false ), path.second, path.first.c_str() );
+	}
+}
+
+UTEST( IgnoreMatcher, scannerPrunesIgnoredDirectories ) {
+	Repository repo( createRepository() );
+	ASSERT_FALSE( repo.paths.empty() );
+
+	std::vector<std::string> found;
+	std::vector<std::string> directories;
+	Mutex mutex;
+	ProjectScanner scanner(
+		nullptr,
+		[&]( std::vector<std::string>& files, std::vector<std::string>& ) {
+			Lock l( mutex );
+			for ( auto& file : files )
+				found.emplace_back( file.substr( repo.path.size() ) );
+		},
+		[&]( const std::string& directory ) {
+			Lock l( mutex );
+			directories.emplace_back( directory.substr( repo.path.size() ) );
+		} );
+	IgnoreMatcherManager manager( repo.path );
+	scanner.scan( repo.path, manager.getMatchers(), false );
+
+	std::vector<std::string> expected;
+	for ( const auto& path : repo.paths ) {
+		if ( !path.second )
+			expected.emplace_back( path.first );
+	}
+
+	std::sort( found.begin(), found.end() );
+	std::sort( expected.begin(), expected.end() );
+	ASSERT_EQ( found.size(), expected.size() );
+	for ( size_t i = 0; i < found.size(); i++ )
+		EXPECT_STREQ( found[i].c_str(), expected[i].c_str() );
+
+	// The ignored directories are not scanned
+	for ( const auto& dir : { ".git/", "build/", "src/sub/", "bin/", "generated/" } )
+		EXPECT_TRUE_MSG(
+			std::find( directories.begin(), directories.end(), dir ) == directories.end(), dir );
+}
+
+#if defined( EE_PLATFORM_POSIX )
+UTEST( IgnoreMatcher, scannerVisitsRealPathsOnce ) {
+	std::string path( Sys::getTempPath() + "eepp_unit_tests_scanner_links" );
+	FileSystem::dirAddSlashAtEnd( path );
+	FileSystem::makeDir( path + "real/sub", true );
+	FileSystem::fileWrite( path + "real/sub/file.txt", "" );
+	unlink( ( path + "real/link" ).c_str() );
+	unlink( ( path + "root" ).c_str() );
+	// The root is reached through a link, and "link" points to "sub" through its real path
+	ASSERT_EQ( symlink( ( path + "real/sub" ).c_str(), ( path + "real/link" ).c_str() ), 0 );
+	ASSERT_EQ( symlink( ( path + "real" ).c_str(), ( path + "root" ).c_str() ), 0 );
+
+	std::vector<std::string> found;
+	Mutex mutex;
+	ProjectScanner scanner( ThreadPool::createShared( 2 ),
+							[&]( std::vector<std::string>& files, std::vector<std::string>& ) {
+								Lock l( mutex );
+								for ( auto& file : files )
+									found.emplace_back( file );
+							} );
+	scanner.scan( path + "root/", {} );
+
+	ASSERT_EQ( found.size(), 1UL );
+	EXPECT_TRUE( String::endsWith( found[0], "sub/file.txt" ) );
+}
+#endif
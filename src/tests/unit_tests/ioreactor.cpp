@@ -0,0 +1,142 @@
+#include "utest.h"
+#include <atomic>
+#include <eepp/system/clock.hpp>
+#include <eepp/system/ioreactor.hpp>
+#include <eepp/system/process.hpp>
+#include <eepp/system/sys.hpp>
+#include <mutex>
+
+#if defined( EE_PLATFORM_POSIX )
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace EE;
+using namespace EE::System;
+
+namespace {
+
+template <typename Predicate> bool waitFor( Predicate predicate ) {
+	Clock clock;
+	while ( !predicate() ) {
+		if ( clock.getElapsedTime() > Seconds( 10 ) )
+			return false;
+		Sys::sleep( Milliseconds( 1 ) );
+	}
+	return true;
+}
+
+} // namespace
+
+#if defined( EE_PLATFORM_POSIX )
+UTEST( IOReactor, serializedCallbacks ) {
+	if ( !IOReactor::isSupported() )
+		UTEST_SKIP( "IOReactor not supported" );
+
+	int pipes[2][2];
+	for ( auto& fds : pipes ) {
+		ASSERT_EQ( pipe( fds ), 0 );
+		fcntl( fds[0], F_SETFL, fcntl( fds[0], F_GETFL ) | O_NONBLOCK );
+	}
+
+	std::atomic<int> running{ 0 };
+	std::atomic<bool> concurrent{ false };
+	std::atomic<size_t> received{ 0 };
+	std::atomic<int> closed{ 0 };
+	Uint64 id = IOReactor::instance()->add( { pipes[0][0], pipes[1][0] }, [&]( int fd ) {
+		if ( running++ > 0 )
+			concurrent = true;
+		Sys::sleep( Milliseconds( 1 ) );
+		char buffer[64];
+		bool keep = true;
+		while ( true ) {
+			ssize_t n = read( fd, buffer, sizeof( buffer ) );
+			if ( n > 0 ) {
+				received += n;
+			} else {
+				if ( n == 0 ) {
+					closed++;
+					keep = false;
+				}
+				break;
+			}
+		}
+		running--;
+		return keep;
+	} );
+	ASSERT_NE( id, 0UL );
+
+	for ( int i = 0; i < 100; i++ ) {
+		for ( auto& fds : pipes )
+			EXPECT_EQ( write( fds[1], "data", 4 ), 4 );
+	}
+	EXPECT_TRUE( waitFor( [&] { return received == 800; } ) );
+
+	// The end of file stops watching each descriptor
+	for ( auto& fds : pipes )
+		close( fds[1] );
+	EXPECT_TRUE( waitFor( [&] { return closed == 2; } ) );
+	EXPECT_FALSE( concurrent );
+
+	IOReactor::instance()->remove( id );
+	for ( auto& fds : pipes )
+		close( fds[0] );
+}
+
+UTEST( IOReactor, removeWaitsForCallback ) {
+	if ( !IOReactor::isSupported() )
+		UTEST_SKIP( "IOReactor not supported" );
+
+	int fds[2];
+	ASSERT_EQ( pipe( fds ), 0 );
+	fcntl( fds[0], F_SETFL, fcntl( fds[0], F_GETFL ) | O_NONBLOCK );
+
+	std::atomic<bool> started{ false };
+	std::atomic<bool> finished{ false };
+	Uint64 id = IOReactor::instance()->add( { fds[0] }, [&]( int fd ) {
+		char buffer[16];
+		while ( read( fd, buffer, sizeof( buffer ) ) > 0 )
+			;
+		started = true;
+		Sys::sleep( Milliseconds( 50 ) );
+		finished = true;
+		return true;
+	} );
+	ASSERT_NE( id, 0UL );
+
+	EXPECT_EQ( write( fds[1], "x", 1 ), 1 );
+	ASSERT_TRUE( waitFor( [&] { return started.load(); } ) );
+	IOReactor::instance()->remove( id );
+	EXPECT_TRUE( finished );
+
+	close( fds[0] );
+	close( fds[1] );
+}
+#endif
+
+UTEST( Process, asyncRead ) {
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	Process process( "cmd /c echo hello&& echo error 1>&2" );
+#else
+	Process process( "sh -c \"echo hello; echo error >&2\"" );
+#endif
+	std::mutex mutex;
+	std::string out;
+	std::string err;
+	process.startAsyncRead(
+		[&]( const char* bytes, size_t n ) {
+			std::lock_guard<std::mutex> lock( mutex );
+			out.append( bytes, n );
+		},
+		[&]( const char* bytes, size_t n ) {
+			std::lock_guard<std::mutex> lock( mutex );
+			err.append( bytes, n );
+		} );
+
+	EXPECT_TRUE( waitFor( [&] {
+		std::lock_guard<std::mutex> lock( mutex );
+		return out.find( "hello" ) != std::string::npos &&
+			   err.find( "error" ) != std::string::npos;
+	} ) );
+}
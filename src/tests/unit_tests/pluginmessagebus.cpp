@@ -0,0 +1,108 @@
+#include "../../tools/ecode/plugins/pluginmessagebus.hpp"
+#include "utest.h"
+#include <algorithm>
+#include <condition_variable>
+#include <thread>
+
+using namespace ecode;
+
+UTEST( PluginMessageBus, deliversByType ) {
+	PluginMessageBus bus( ThreadPool::createShared( 1 ) );
+	std::vector<std::string> received;
+
+	bus.subscribe( "diagnostics", { PluginMessageType::Diagnostics },
+				   [&received]( const PluginMessage& ) -> PluginRequestHandle {
+					   received.emplace_back( "diagnostics" );
+					   return {};
+				   } );
+	bus.subscribe( "all", {}, [&received]( const PluginMessage& msg ) -> PluginRequestHandle {
+		received.emplace_back( "all" );
+		return msg.isRequest() ? PluginRequestHandle( 7 ) : PluginRequestHandle();
+	} );
+
+	bus.publish( "", { PluginMessageType::Diagnostics, PluginMessageFormat::Empty, nullptr, -1 },
+				 false );
+	bus.publish( "", { PluginMessageType::UIReady, PluginMessageFormat::Empty, nullptr, -1 },
+				 false );
+	bus.publish( "all", { PluginMessageType::Diagnostics, PluginMessageFormat::Empty, nullptr, -1 },
+				 false );
+	ASSERT_EQ( received.size(), 4UL );
+	EXPECT_STREQ( received[0].c_str(), "all" );
+	EXPECT_STREQ( received[1].c_str(), "diagnostics" );
+	EXPECT_STREQ( received[2].c_str(), "all" );
+	EXPECT_STREQ( received[3].c_str(), "diagnostics" );
+
+	// A request stops at the first subscriber that handles it
+	PluginRequestHandle handle =
+		bus.publish( "", { PluginMessageType::Diagnostics, PluginMessageFormat::Empty, nullptr },
+					 true );
+	EXPECT_EQ( handle.id().asInt(), 7 );
+	EXPECT_EQ( received.size(), 5UL );
+
+	PluginMessageStats stats = bus.getStats( PluginMessageType::Diagnostics );
+	EXPECT_EQ( stats.messages, 3UL );
+	EXPECT_EQ( stats.deliveries, 4UL );
+	stats = bus.getStats( PluginMessageType::UIReady );
+	EXPECT_EQ( stats.messages, 1UL );
+	EXPECT_EQ( stats.deliveries, 1UL );
+	EXPECT_EQ( bus.getStats( PluginMessageType::ShowMessage ).messages, 0UL );
+
+	bus.unsubscribe( "all" );
+	bus.publish( "", { PluginMessageType::UIReady, PluginMessageFormat::Empty, nullptr, -1 },
+				 false );
+	EXPECT_EQ( received.size(), 5UL );
+	EXPECT_EQ( bus.getStats( PluginMessageType::UIReady ).deliveries, 1UL );
+
+	bus.resetStats();
+	EXPECT_EQ( bus.getStats( PluginMessageType::Diagnostics ).messages, 0UL );
+	EXPECT_EQ( bus.getStats( PluginMessageType::Diagnostics ).deliveries, 0UL );
+}
+
+UTEST( PluginMessageBus, asyncBroadcast ) {
+	PluginMessageBus bus( ThreadPool::createShared( 2 ) );
+	std::mutex mutex;
+	std::condition_variable delivered;
+	std::vector<int> values;
+	std::thread::id caller( std::this_thread::get_id() );
+	bool sameThread = false;
+
+	bus.subscribe( "listener", { PluginMessageType::SymbolReference },
+				   [&]( const PluginMessage& msg ) -> PluginRequestHandle {
+					   std::lock_guard<std::mutex> lock( mutex );
+					   values.push_back( *static_cast<const int*>( msg.asData() ) );
+					   sameThread = sameThread || std::this_thread::get_id() == caller;
+					   delivered.notify_all();
+					   return {};
+				   } );
+
+	for ( int i = 0; i < 100; i++ )
+		bus.publishAsync( "", PluginMessageType::SymbolReference, PluginMessageFormat::Empty,
+						  std::make_shared<int>( i ) );
+
+	{
+		// The data was kept alive until it was delivered
+		std::unique_lock<std::mutex> lock( mutex );
+		ASSERT_TRUE( delivered.wait_for( lock, std::chrono::seconds( 10 ),
+										 [&values] { return values.size() == 100; } ) );
+	}
+
+	bus.close();
+	EXPECT_TRUE( bus.isClosed() );
+	EXPECT_FALSE( sameThread );
+	ASSERT_EQ( values.size(), 100UL );
+	std::sort( values.begin(), values.end() );
+	for ( int i = 0; i < 100; i++ )
+		EXPECT_EQ( values[i], i );
+
+	PluginMessageStats stats = bus.getStats( PluginMessageType::SymbolReference );
+	EXPECT_EQ( stats.messages, 100UL );
+	EXPECT_EQ( stats.deliveries, 100UL );
+
+	// Nothing is delivered once closed
+	bus.publishAsync( "", PluginMessageType::SymbolReference, PluginMessageFormat::Empty,
+					  std::make_shared<int>( 100 ) );
+	bus.publish( "", { PluginMessageType::SymbolReference, PluginMessageFormat::Empty, nullptr },
+				 false );
+	EXPECT_EQ( values.size(), 100UL );
+	EXPECT_EQ( bus.getStats( PluginMessageType::SymbolReference ).messages, 100UL );
+}
@@ -0,0 +1,91 @@
+#include "utest.h"
+#include <eepp/network/ipaddress.hpp>
+#include <eepp/network/socketselector.hpp>
+#include <eepp/network/tcplistener.hpp>
+#include <eepp/network/tcpsocket.hpp>
+#include <memory>
+
+using namespace EE;
+using namespace EE::Network;
+
+namespace {
+
+struct Connection {
+	TcpSocket client;
+	TcpSocket server;
+};
+
+bool connect( TcpListener& listener, Connection& connection ) {
+	return connection.client.connect( IpAddress::LocalHost, listener.getLocalPort(),
+									   Seconds( 5 ) ) == Socket::Done &&
+		   listener.accept( connection.server ) == Socket::Done;
+}
+
+} // namespace
+
+UTEST( SocketSelector, forEachReady ) {
+	TcpListener listener;
+	ASSERT_EQ( listener.listen( 0, IpAddress::LocalHost ), Socket::Done );
+
+	SocketSelector selector;
+	std::vector<std::unique_ptr<Connection>> connections;
+	for ( int i = 0; i < 8; i++ ) {
+		connections.emplace_back( std::make_unique<Connection>() );
+		ASSERT_TRUE( connect( listener, *connections.back() ) );
+		selector.add( connections.back()->server );
+	}
+	EXPECT_EQ( selector.getSocketCount(), 8UL );
+	EXPECT_FALSE( selector.wait( Milliseconds( 10 ) ) );
+
+	const char message[] = "ping";
+	connections[2]->client.send( message, sizeof( message ) );
+	connections[5]->client.send( message, sizeof( message ) );
+	ASSERT_TRUE( selector.wait( Seconds( 5 ) ) );
+	// Both messages might not have arrived in the first wait
+	if ( selector.getReadyCount() < 2 )
+		selector.wait( Seconds( 5 ) );
+
+	EXPECT_EQ( selector.getReadyCount(), 2UL );
+	EXPECT_TRUE( selector.isReady( connections[2]->server ) );
+	EXPECT_TRUE( selector.isReady( connections[5]->server ) );
+	EXPECT_FALSE( selector.isReady( connections[0]->server ) );
+
+	// Sockets removed while iterating are not visited
+	size_t visited = 0;
+	selector.forEachReady( [&]( Socket& ) {
+		visited++;
+		selector.remove( connections[2]->server );
+		selector.remove( connections[5]->server );
+	} );
+	EXPECT_EQ( visited, 1UL );
+	EXPECT_EQ( selector.getSocketCount(), 6UL );
+}
+
+UTEST( SocketSelector, edgeTrigger ) {
+	TcpListener listener;
+	ASSERT_EQ( listener.listen( 0, IpAddress::LocalHost ), Socket::Done );
+
+	Connection connection;
+	ASSERT_TRUE( connect( listener, connection ) );
+
+	SocketSelector level;
+	SocketSelector edge( SocketSelector::Trigger::Edge );
+	level.add( connection.server );
+	edge.add( connection.server );
+
+	const char message[] = "ping";
+	connection.client.send( message, sizeof( message ) );
+	ASSERT_TRUE( level.wait( Seconds( 5 ) ) );
+	ASSERT_TRUE( edge.wait( Seconds( 5 ) ) );
+
+	// The data wasn't read, level triggered selectors keep reporting it
+	EXPECT_TRUE( level.wait( Milliseconds( 10 ) ) );
+#if EE_PLATFORM == EE_PLATFORM_LINUX || EE_PLATFORM == EE_PLATFORM_MACOS
+	EXPECT_FALSE( edge.wait( Milliseconds( 10 ) ) );
+#endif
+
+	char buffer[sizeof( message )];
+	std::size_t received;
+	EXPECT_EQ( connection.server.receive( buffer, sizeof( buffer ), received ), Socket::Done );
+	EXPECT_FALSE( level.wait( Milliseconds( 10 ) ) );
+}
@@ -0,0 +1,155 @@
+#include "utest.h"
+#include <cmath>
+#include <cstdlib>
+#include <eepp/audio/soundstream.hpp>
+#include <eepp/audio/soundstreamscheduler.hpp>
+#include <eepp/system/sys.hpp>
+#include <memory>
+#include <vector>
+
+using namespace EE;
+using namespace EE::Audio;
+using namespace EE::System;
+
+namespace {
+
+// The streams are played through the SDL dummy audio driver, that consumes the audio in real time
+// without a sound card.
+void useDummyAudioDriver() {
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	_putenv_s( "SDL_AUDIODRIVER", "dummy" );
+#else
+	setenv( "SDL_AUDIODRIVER", "dummy", 1 );
+#endif
+}
+
+class ToneStream : public SoundStream {
+  public:
+	static constexpr unsigned int SampleRate = 22050;
+
+	explicit ToneStream( const Time& duration ) :
+		mTotalFrames( static_cast<Uint64>( duration.asSeconds() * SampleRate ) ) {
+		initialize( 2, SampleRate );
+	}
+
+	~ToneStream() { stop(); }
+
+	// Blocks onGetData once after the given number of calls, simulating a slow stream source
+	void setStall( int afterCalls, const Time& duration ) {
+		mStallAfter = afterCalls;
+		mStallDuration = duration;
+	}
+
+  protected:
+	bool onGetData( SoundStream::Chunk& data ) override {
+		if ( mStallAfter >= 0 && mCalls++ == mStallAfter )
+			Sys::sleep( mStallDuration );
+
+		std::size_t frames = eemin<std::size_t>( getBufferSampleCount() / 2,
+												 mTotalFrames - eemin( mTotalFrames, mFrame ) );
+		mSamples.resize( frames * 2 );
+
+		for ( std::size_t i = 0; i < frames; ++i, ++mFrame ) {
+			Int16 sample = static_cast<Int16>( std::sin( mFrame * 0.05 ) * 8000 );
+			mSamples[i * 2] = sample;
+			mSamples[i * 2 + 1] = sample;
+		}
+
+		data.samples = mSamples.empty() ? NULL : &mSamples[0];
+		data.sampleCount = mSamples.size();
+		return mFrame < mTotalFrames;
+	}
+
+	void onSeek( Time timeOffset ) override {
+		mFrame = static_cast<Uint64>( timeOffset.asSeconds() * SampleRate );
+	}
+
+	Uint64 mTotalFrames;
+	Uint64 mFrame{ 0 };
+	int mCalls{ 0 };
+	int mStallAfter{ -1 };
+	Time mStallDuration;
+	std::vector<Int16> mSamples;
+};
+
+} // namespace
+
+UTEST( SoundStreamScheduler, sharedStreaming ) {
+	useDummyAudioDriver();
+
+	std::vector<std::unique_ptr<ToneStream>> streams;
+
+	for ( int i = 0; i < 16; i++ ) {
+		streams.emplace_back( std::make_unique<ToneStream>( Seconds( 30 ) ) );
+		streams.back()->setBufferCount( 4 );
+		streams.back()->setBufferDuration( Milliseconds( 20 ) );
+		streams.back()->play();
+	}
+
+	// Every stream is updated by the same scheduler
+	EXPECT_EQ( SoundStreamScheduler::instance()->getActiveStreamCount(), streams.size() );
+
+	Sys::sleep( Milliseconds( 300 ) );
+
+	for ( auto& stream : streams ) {
+		EXPECT_EQ( stream->getStatus(), SoundSource::Playing );
+		EXPECT_TRUE( stream->getPlayingOffset() > Time::Zero );
+	}
+
+	streams[0]->pause();
+	EXPECT_EQ( streams[0]->getStatus(), SoundSource::Paused );
+	streams[0]->play();
+	EXPECT_EQ( streams[0]->getStatus(), SoundSource::Playing );
+
+	for ( auto& stream : streams ) {
+		stream->stop();
+		EXPECT_EQ( stream->getStatus(), SoundSource::Stopped );
+	}
+
+	EXPECT_EQ( SoundStreamScheduler::instance()->getActiveStreamCount(), 0ul );
+}
+
+UTEST( SoundStreamScheduler, streamEnds ) {
+	useDummyAudioDriver();
+
+	ToneStream stream( Milliseconds( 100 ) );
+	stream.setBufferDuration( Milliseconds( 20 ) );
+	stream.play();
+
+	for ( int i = 0; i < 200 && stream.getStatus() != SoundSource::Stopped; i++ )
+		Sys::sleep( Milliseconds( 10 ) );
+
+	EXPECT_EQ( stream.getStatus(), SoundSource::Stopped );
+	EXPECT_EQ( SoundStreamScheduler::instance()->getActiveStreamCount(), 0ul );
+
+	// It can be played again once it ended
+	stream.play();
+	EXPECT_EQ( stream.getStatus(), SoundSource::Playing );
+	stream.stop();
+}
+
+UTEST( SoundStreamScheduler, underrunCount ) {
+	useDummyAudioDriver();
+
+	SoundStreamScheduler::instance()->setWorkerCount( 1 );
+	EXPECT_EQ( SoundStreamScheduler::instance()->getWorkerCount(), 1u );
+
+	ToneStream stream( Seconds( 30 ) );
+	stream.setBufferCount( 2 );
+	stream.setBufferDuration( Milliseconds( 10 ) );
+	stream.setStall( 4, Milliseconds( 150 ) );
+
+	Uint64 underruns = SoundStreamScheduler::instance()->getUnderrunCount();
+
+	stream.play();
+	Sys::sleep( Milliseconds( 400 ) );
+
+	// The queue ran dry while the source was stalled, and the stream recovered from it
+	EXPECT_TRUE( stream.getUnderrunCount() >= 1 );
+	EXPECT_TRUE( SoundStreamScheduler::instance()->getUnderrunCount() >=
+				 underruns + stream.getUnderrunCount() );
+	EXPECT_EQ( stream.getStatus(), SoundSource::Playing );
+
+	stream.stop();
+	SoundStreamScheduler::instance()->setWorkerCount( 2 );
+}
@@ -0,0 +1,396 @@
+#include "utest.h"
+#include <atomic>
+#include <climits>
+#include <eepp/system/filesystem.hpp>
+#include <eepp/system/sys.hpp>
+#include <eterm/terminal/terminalemulator.hpp>
+#include <eterm/terminal/terminalhistory.hpp>
+#include <memory>
+#include <vector>
+
+using namespace EE;
+using namespace EE::System;
+using namespace eterm::Terminal;
+
+namespace {
+
+// Returns the recorded output in chunks of chunkSize bytes, splitting escape sequences and UTF-8
+// characters between reads
+class ReplayPseudoTerminal final : public IPseudoTerminal {
+  public:
+	ReplayPseudoTerminal( const std::string& data, size_t chunkSize ) :
+		mData( data ), mChunkSize( chunkSize ) {}
+
+	bool isTTY() const override { return true; }
+
+	int getNumColumns() const override { return 80; }
+
+	int getNumRows() const override { return 24; }
+
+	bool resize( int, int ) override { return true; }
+
+	int write( const char*, size_t n ) override { return (int)n; }
+
+	int read( char* buf, size_t n, bool ) override {
+		n = eemin( eemin( n, mChunkSize ), mData.size() - mPos );
+		memcpy( buf, mData.data() + mPos, n );
+		mPos += n;
+		return (int)n;
+	}
+
+	int waitForInput( int ) override { return isDrained() ? -1 : 1; }
+
+	bool isDrained() const { return mPos == mData.size(); }
+
+  protected:
+	const std::string& mData;
+	size_t mChunkSize;
+	std::atomic<size_t> mPos{ 0 };
+};
+
+class ReplayProcess final : public eterm::System::IProcess {
+  public:
+	explicit ReplayProcess( ReplayPseudoTerminal* pty ) : mPty( pty ) {}
+
+	void checkExitStatus() override {}
+
+	bool hasExited() const override { return mPty->isDrained(); }
+
+	int getExitCode() const override { return 0; }
+
+	void terminate() override {}
+
+	void waitForExit() override {}
+
+	int pid() override { return 0; }
+
+  protected:
+	ReplayPseudoTerminal* mPty;
+};
+
+class ScreenDisplay final : public ITerminalDisplay {
+  public:
+	bool drawBegin( Uint32 columns, Uint32 rows ) override {
+		mColumns = columns;
+		screen.resize( columns * rows );
+		return true;
+	}
+
+	void drawLine( Line line, int x1, int y, int x2 ) override {
+		memcpy( &screen[y * mColumns + x1], line, ( x2 - x1 ) * sizeof( TerminalGlyph ) );
+	}
+
+	void drawCursor( int cx, int cy, TerminalGlyph, int, int, TerminalGlyph ) override {
+		cursor = { cx, cy };
+	}
+
+	void drawEnd() override {}
+
+	void setTitle( const char* title ) override { this->title = title ? title : ""; }
+
+	std::vector<TerminalGlyph> screen;
+	Vector2i cursor;
+	std::string title;
+
+  protected:
+	Uint32 mColumns{ 0 };
+};
+
+struct ReplayResult {
+	std::vector<TerminalGlyph> screen;
+	std::vector<TerminalGlyph> history;
+	Vector2i cursor;
+	int historySize{ 0 };
+	std::string title;
+	std::string selection;
+};
+
+ReplayResult replay( const std::string& data, size_t chunkSize, bool asciiFastPath,
+					 bool withSelection ) {
+	auto pty = std::make_unique<ReplayPseudoTerminal>( data, chunkSize );
+	auto process = std::make_unique<ReplayProcess>( pty.get() );
+	auto display = std::make_shared<ScreenDisplay>();
+	auto terminal =
+		TerminalEmulator::create( std::move( pty ), std::move( process ), display, 500 );
+	terminal->setAsciiFastPath( asciiFastPath );
+
+	if ( withSelection ) {
+		terminal->selstart( 10, 3, 0 );
+		terminal->selextend( 40, 6, SEL_REGULAR, 1 );
+	}
+
+	while ( !terminal->hasExited() ) {
+		terminal->update();
+		Sys::sleep( Milliseconds( 1 ) );
+	}
+
+	ReplayResult result;
+	result.screen = display->screen;
+	result.cursor = display->cursor;
+	result.historySize = terminal->getHistorySize();
+	result.title = display->title;
+	result.selection = terminal->getSelection();
+
+	TerminalArg arg( INT_MAX );
+	terminal->kscrollup( &arg );
+	terminal->redraw();
+	result.history = display->screen;
+
+	return result;
+}
+
+bool sameGlyphs( std::vector<TerminalGlyph> a, const std::vector<TerminalGlyph>& b ) {
+	if ( a.size() != b.size() )
+		return false;
+	for ( size_t i = 0; i < a.size(); i++ )
+		if ( a[i] != b[i] )
+			return false;
+	return true;
+}
+
+std::vector<std::string> loadCaptures() {
+	FileSystem::changeWorkingDirectory( Sys::getProcessPath() );
+	std::vector<std::string> captures;
+	auto files = FileSystem::filesGetInPath( std::string{ "assets/terminal" }, true );
+	for ( const auto& file : files ) {
+		std::string data;
+		FileSystem::fileGet( "assets/terminal/" + file, data );
+		captures.emplace_back( std::move( data ) );
+	}
+	return captures;
+}
+
+std::vector<TerminalGlyph> makeLine( const String& text, int cols, Uint32 seed ) {
+	std::vector<TerminalGlyph> line( cols );
+	for ( int x = 0; x < cols; x++ ) {
+		line[x].u = ' ';
+		line[x].fg = ( seed + x / 7 ) % 3 ? 7 : ( 1 << 24 | ( seed * 2654435761u & 0xFFFFFF ) );
+		line[x].bg = 0;
+		line[x].mode = ( x / 5 + seed ) % 4 == 0 ? ATTR_BOLD : ATTR_NULL;
+	}
+	for ( size_t i = 0, x = 0; i < text.size() && x < (size_t)cols; i++, x++ ) {
+		line[x].u = text[i];
+		// CJK characters take two cells, as the emulator stores them
+		if ( text[i] >= 0x4E00 && text[i] <= 0x9FFF && x + 1 < (size_t)cols ) {
+			line[x].mode |= ATTR_WIDE;
+			line[++x].u = 0;
+			line[x].mode |= ATTR_WDUMMY;
+		}
+	}
+	if ( seed % 5 == 0 )
+		line[cols - 1].mode |= ATTR_WRAP;
+	return line;
+}
+
+String makeText( Uint32 i ) {
+	static const char* words[] = { "build", "λ", "→", "warning:", "ñandú", "漢字", "error", "" };
+	String text;
+	for ( Uint32 w = 0; w < i % 9; w++ ) {
+		text += String( words[( i + w * 3 ) % eeARRAY_SIZE( words )] );
+		text += " ";
+	}
+	text += String::toString( i );
+	return text;
+}
+
+// Exposes the blocks to damage their compressed data
+class CorruptibleHistory : public TerminalHistory {
+  public:
+	using TerminalHistory::TerminalHistory;
+
+	bool isCompressed( size_t index ) const { return mBlocks[index].compressed; }
+
+	void corrupt( size_t index ) {
+		std::fill( mBlocks[index].data.begin(), mBlocks[index].data.end(), 0xFF );
+	}
+};
+
+} // namespace
+
+UTEST( TerminalEmulator, asciiFastPathReplay ) {
+	auto captures = loadCaptures();
+	ASSERT_TRUE( captures.size() >= 3 );
+
+	for ( const auto& capture : captures ) {
+		ASSERT_FALSE( capture.empty() );
+
+		ReplayResult reference = replay( capture, 8192, false, false );
+
+		for ( size_t chunkSize : { (size_t)1, (size_t)7, (size_t)8192 } ) {
+			ReplayResult result = replay( capture, chunkSize, true, false );
+			EXPECT_TRUE( sameGlyphs( reference.screen, result.screen ) );
+			EXPECT_TRUE( sameGlyphs( reference.history, result.history ) );
+			EXPECT_TRUE( reference.cursor == result.cursor );
+			EXPECT_EQ( reference.historySize, result.historySize );
+			EXPECT_TRUE( reference.title == result.title );
+		}
+	}
+}
+
+UTEST( TerminalEmulator, asciiFastPathSelection ) {
+	auto captures = loadCaptures();
+	ASSERT_TRUE( captures.size() >= 3 );
+
+	for ( const auto& capture : captures ) {
+		ReplayResult reference = replay( capture, 8192, false, true );
+		ReplayResult result = replay( capture, 8192, true, true );
+		EXPECT_TRUE( sameGlyphs( reference.screen, result.screen ) );
+		EXPECT_TRUE( reference.selection == result.selection );
+	}
+}
+
+UTEST( TerminalHistory, compressedLines ) {
+	const int cols = 80;
+	const Uint32 lines = 3000;
+	TerminalHistory history( 2000 );
+
+	for ( Uint32 i = 0; i < lines; i++ ) {
+		auto line = makeLine( makeText( i ), cols, i );
+		history.push( line.data(), cols );
+	}
+
+	EXPECT_EQ( history.size(), (size_t)2000 );
+	// Every block but the last one is deflated
+	EXPECT_TRUE( history.getMemoryUsage() < 2000 * cols * sizeof( TerminalGlyph ) / 10 );
+
+	for ( size_t index = 0; index < history.size(); index++ ) {
+		Uint32 i = lines - 1 - index;
+		auto expected = makeLine( makeText( i ), cols, i );
+		ASSERT_TRUE( sameGlyphs( expected, std::vector<TerminalGlyph>(
+												   history.getLine( index, cols ),
+												   history.getLine( index, cols ) + cols ) ) );
+	}
+
+	// Narrower and wider screens truncate and pad the lines
+	TerminalGlyph blank;
+	blank.u = ' ';
+	blank.fg = 3;
+	history.setBlank( blank );
+	Line wide = history.getLine( 10, cols + 4 );
+	EXPECT_TRUE( wide[cols + 3] == blank );
+	EXPECT_EQ( history.getLine( 10, 20 )[0].u, history.getLine( 10, cols )[0].u );
+
+	// Removing lines reopens the last deflated block
+	for ( int i = 0; i < 300; i++ )
+		history.pop();
+	EXPECT_EQ( history.size(), (size_t)1700 );
+	Uint32 newest = lines - 301;
+	auto expected = makeLine( makeText( newest ), cols, newest );
+	EXPECT_TRUE( sameGlyphs( expected, std::vector<TerminalGlyph>( history.getLine( 0, cols ),
+																   history.getLine( 0, cols ) +
+																	   cols ) ) );
+
+	history.clear();
+	EXPECT_TRUE( history.empty() );
+}
+
+UTEST( TerminalHistory, deferredCompression ) {
+	const int cols = 80;
+	TerminalHistory history( 100000 );
+	history.setDeferredCompression( true );
+
+	for ( Uint32 i = 0; i < 4 * TerminalHistory::LinesPerBlock + 10; i++ ) {
+		auto line = makeLine( makeText( i ), cols, i );
+		history.push( line.data(), cols );
+	}
+
+	EXPECT_EQ( history.getPendingBlockCount(), (size_t)4 );
+	size_t uncompressed = history.getMemoryUsage();
+
+	TerminalHistory::PendingBlock pending;
+	ASSERT_TRUE( history.getPendingBlock( pending ) );
+	TerminalHistory::compressBlock( pending );
+	EXPECT_TRUE( history.setCompressedBlock( pending ) );
+	EXPECT_EQ( history.getPendingBlockCount(), (size_t)3 );
+
+	// A block modified while it was being compressed is discarded
+	ASSERT_TRUE( history.getPendingBlock( pending ) );
+	TerminalHistory::compressBlock( pending );
+	history.pop();
+	EXPECT_FALSE( history.setCompressedBlock( pending ) );
+
+	while ( history.getPendingBlock( pending ) ) {
+		TerminalHistory::compressBlock( pending );
+		EXPECT_TRUE( history.setCompressedBlock( pending ) );
+	}
+
+	EXPECT_EQ( history.getPendingBlockCount(), (size_t)0 );
+	EXPECT_TRUE( history.getMemoryUsage() < uncompressed / 2 );
+
+	for ( size_t index = 0; index < history.size(); index++ ) {
+		Uint32 i = 4 * TerminalHistory::LinesPerBlock + 8 - index;
+		auto expected = makeLine( makeText( i ), cols, i );
+		ASSERT_TRUE( sameGlyphs( expected, std::vector<TerminalGlyph>(
+												   history.getLine( index, cols ),
+												   history.getLine( index, cols ) + cols ) ) );
+	}
+}
+
+UTEST( TerminalHistory, corruptedBlock ) {
+	const int cols = 80;
+	const Uint32 lines = 2 * TerminalHistory::LinesPerBlock + 10;
+	CorruptibleHistory history( 100000 );
+
+	for ( Uint32 i = 0; i < lines; i++ ) {
+		auto line = makeLine( makeText( i ), cols, i );
+		history.push( line.data(), cols );
+	}
+
+	ASSERT_TRUE( history.isCompressed( 0 ) );
+	ASSERT_TRUE( history.isCompressed( 1 ) );
+	history.corrupt( 0 );
+	history.corrupt( 1 );
+
+	// The lines of a block that can't be inflated are blank, the others are still read
+	std::string text;
+	size_t oldest = history.size() - 1;
+	EXPECT_FALSE( history.getLineText( history.getLineId( oldest ), text ) );
+	EXPECT_EQ( history.getLine( oldest, cols )[0].u, (Rune)' ' );
+	auto expected = makeLine( makeText( lines - 1 ), cols, lines - 1 );
+	EXPECT_TRUE( sameGlyphs( expected, std::vector<TerminalGlyph>( history.getLine( 0, cols ),
+																   history.getLine( 0, cols ) +
+																	   cols ) ) );
+
+	// Reopening the block keeps its lines as empty lines
+	for ( int i = 0; i < 11; i++ )
+		history.pop();
+	EXPECT_EQ( history.size(), (size_t)( 2 * TerminalHistory::LinesPerBlock - 1 ) );
+	EXPECT_TRUE( history.getLineText( history.getLineId( 0 ), text ) );
+	EXPECT_TRUE( text.empty() );
+}
+
+UTEST( TerminalHistory, search ) {
+	const int cols = 60;
+	TerminalHistory history( 10000 );
+
+	for ( Uint32 i = 0; i < 5000; i++ ) {
+		auto line = makeLine( makeText( i ), cols, i );
+		history.push( line.data(), cols );
+	}
+
+	auto line = makeLine( String( "漢字 → Needle in the haystack" ), cols, 1 );
+	history.push( line.data(), cols );
+
+	TerminalHistorySearch search( "needle", false );
+	size_t steps = 0;
+	while ( !search.step( history, 100 ) )
+		steps++;
+	EXPECT_TRUE( steps > 10 );
+	ASSERT_EQ( search.getMatches().size(), (size_t)1 );
+	EXPECT_EQ( history.getLineIndex( search.getMatches()[0].lineId ), (Int64)0 );
+	// The wide characters take two columns each
+	EXPECT_EQ( search.getMatches()[0].column, 7 );
+	EXPECT_EQ( search.getMatches()[0].length, 6 );
+
+	TerminalHistorySearch caseSensitive( "needle" );
+	while ( !caseSensitive.step( history ) )
+		;
+	EXPECT_TRUE( caseSensitive.getMatches().empty() );
+
+	TerminalHistorySearch digits( "49[0-9]{2}$", true, true );
+	ASSERT_TRUE( digits.isValid() );
+	while ( !digits.step( history ) )
+		;
+	EXPECT_EQ( digits.getMatches().size(), (size_t)100 );
+	EXPECT_EQ( history.getLineIndex( digits.getMatches().back().lineId ), (Int64)( 5000 - 4900 ) );
+}
@@ -74,3 +74,202 @@ UTEST( TextDocument, multicursor ) {
 	doc.resetUndoRedo();
 	doc.resetSelection( TextRange{ { 0, 0 }, { 0, 0 } } );
 }
+
+UTEST( TextDocument, replaceAll ) {
+	TextDocument doc;
+	String text;
+	for ( int i = 0; i < 1000; i++ )
+		text += "foo(" + String::toString( i ) + ") bar foo\n";
+	doc.insert( 0, { 0, 0 }, text );
+	doc.resetUndoRedo();
+	doc.setSelection( { 10, 2 } );
+	text = doc.getText();
+
+	EXPECT_EQ( 2000, doc.replaceAll( "foo", "foobar" ) );
+	EXPECT_STRINGEQ( "foobar(0) bar foobar\n", doc.line( 0 ).getText() );
+	EXPECT_STRINGEQ( "foobar(999) bar foobar\n", doc.line( 999 ).getText() );
+	EXPECT_STDSTREQ( TextRange( { 10, 2 }, { 10, 2 } ).toString(),
+					 doc.getSelection().toString() );
+
+	// The whole replacement is a single undo step
+	doc.undo();
+	EXPECT_TRUE( text == doc.getText() );
+	EXPECT_FALSE( doc.hasUndo() );
+	doc.redo();
+	EXPECT_STRINGEQ( "foobar(1) bar foobar\n", doc.line( 1 ).getText() );
+
+	// Captures
+	EXPECT_EQ( 1000, doc.replaceAll( "foobar%((%d+)%)", "call[$1]", true, false,
+									 TextDocument::FindReplaceType::LuaPattern ) );
+	EXPECT_STRINGEQ( "call[42] bar foobar\n", doc.line( 42 ).getText() );
+
+	// Restricted ranges, replacing the line ends
+	EXPECT_EQ( 3, doc.replaceAll( "\n", " ", true, false, TextDocument::FindReplaceType::Normal,
+								  { { 0, 0 }, { 3, 0 } } ) );
+	EXPECT_STRINGEQ( "call[0] bar foobar call[1] bar foobar call[2] bar foobar call[3] bar foobar\n",
+					 doc.line( 0 ).getText() );
+	EXPECT_STRINGEQ( "call[4] bar foobar\n", doc.line( 1 ).getText() );
+	EXPECT_EQ( 998UL, doc.linesCount() );
+}
+
+UTEST( TextDocument, find ) {
+	TextDocument doc;
+	doc.insert( 0, { 0, 0 },
+				"int value = 1;\n"
+				"Value++;\n"
+				"// Ñandú values\n"
+				"int valueB = value;\n" );
+
+	// Searches that span lines return the whole range
+	auto res = doc.find( "1;\nValue", { 0, 0 } );
+	EXPECT_TRUE( res.result == TextRange( { 0, 12 }, { 1, 5 } ) );
+	res = doc.find( "\\d;\\n\\w+", { 0, 0 }, true, false, TextDocument::FindReplaceType::RegEx );
+	EXPECT_TRUE( res.result == TextRange( { 0, 12 }, { 1, 5 } ) );
+
+	// Case sensitivity, whole words and multi-byte characters
+	res = doc.find( "value", { 0, 5 } );
+	EXPECT_TRUE( res.result == TextRange( { 2, 9 }, { 2, 14 } ) );
+	res = doc.find( "value", { 0, 5 }, false );
+	EXPECT_TRUE( res.result == TextRange( { 1, 0 }, { 1, 5 } ) );
+	res = doc.find( "value", { 0, 5 }, true, true );
+	EXPECT_TRUE( res.result == TextRange( { 3, 13 }, { 3, 18 } ) );
+	res = doc.find( "ÑANDú", { 0, 0 }, false );
+	EXPECT_TRUE( res.result == TextRange( { 2, 3 }, { 2, 8 } ) );
+
+	// Restricted ranges
+	res = doc.find( "value", { 0, 0 }, true, false, TextDocument::FindReplaceType::Normal,
+					{ { 0, 0 }, { 2, 12 } } );
+	EXPECT_TRUE( res.result == TextRange( { 0, 4 }, { 0, 9 } ) );
+	res = doc.find( "value", { 1, 0 }, true, false, TextDocument::FindReplaceType::Normal,
+					{ { 0, 0 }, { 2, 12 } } );
+	EXPECT_FALSE( res.isValid() );
+
+	// Backwards
+	res = doc.findLast( "value", doc.endOfDoc() );
+	EXPECT_TRUE( res.result == TextRange( { 3, 13 }, { 3, 18 } ) );
+	res = doc.findLast( "value", { 3, 13 }, true, true );
+	EXPECT_TRUE( res.result == TextRange( { 0, 4 }, { 0, 9 } ) );
+	res = doc.findLast( "v(al)ue", { 3, 13 }, true, false, TextDocument::FindReplaceType::RegEx );
+	EXPECT_TRUE( res.result == TextRange( { 3, 4 }, { 3, 9 } ) );
+	ASSERT_EQ( res.captures.size(), 1UL );
+	EXPECT_TRUE( res.captures[0] == TextRange( { 3, 5 }, { 3, 7 } ) );
+
+	EXPECT_EQ( 5UL, doc.findAll( "value", false ).size() );
+	EXPECT_EQ( 3UL, doc.findAll( "^%w+", true, false, TextDocument::FindReplaceType::LuaPattern )
+						.size() );
+	EXPECT_EQ( 2UL, doc.findAll( "value", true, false, TextDocument::FindReplaceType::Normal,
+								 TextRange(), 2 )
+						.size() );
+
+	// The search buffer follows the document modifications
+	doc.insert( 0, { 1, 0 }, "value\n" );
+	res = doc.find( "value", { 0, 5 } );
+	EXPECT_TRUE( res.result == TextRange( { 1, 0 }, { 1, 5 } ) );
+}
+
+UTEST( TextDocument, undoMemory ) {
+	TextDocument doc;
+	String text;
+	for ( int i = 0; i < 10000; i++ )
+		text += "line number " + String::toString( i ) + " of the document\n";
+	doc.insert( 0, { 0, 0 }, text );
+	doc.resetUndoRedo();
+	std::string utf8( text.toUtf8() );
+
+	// The removed text is kept compressed, far below its UTF-32 size
+	doc.selectAll();
+	doc.deleteSelection();
+	EXPECT_EQ( 1UL, doc.linesCount() );
+	auto& undoStack = doc.getUndoStack();
+	EXPECT_LT( undoStack.getMemoryUsage(), utf8.size() / 4 );
+
+	doc.undo();
+	EXPECT_TRUE( doc.getText() == text );
+	doc.redo();
+	EXPECT_EQ( 1UL, doc.linesCount() );
+	doc.undo();
+
+	// Many smaller removals, the oldest ones are compressed as the history grows
+	String block( doc.getText( { { 0, 0 }, { 600, 0 } } ) );
+	for ( int i = 0; i < 300; i++ ) {
+		doc.remove( 0, { { 0, 0 }, { 600, 0 } } );
+		doc.insert( 0, { 0, 0 }, block );
+	}
+	EXPECT_GT( block.size() * 300, 5 * 1024 * 1024UL );
+	EXPECT_LT( undoStack.getMemoryUsage(), 5 * 1024 * 1024UL );
+	while ( doc.hasUndo() )
+		doc.undo();
+	EXPECT_TRUE( doc.getText() == text );
+
+	// The oldest commands are discarded when the memory budget is exceeded
+	undoStack.setMaxMemoryUsage( 1024 );
+	EXPECT_LE( undoStack.getMemoryUsage(), 1024UL );
+	doc.selectAll();
+	doc.deleteSelection();
+	EXPECT_TRUE( doc.hasUndo() );
+	doc.undo();
+	EXPECT_TRUE( doc.getText() == text );
+}
+
+UTEST( TextDocument, undoMemoryChunks ) {
+	TextDocument doc;
+	String text;
+	for ( int i = 0; i < 10000; i++ )
+		text += "line number " + String::toString( i ) + " of the document\n";
+	doc.insert( 0, { 0, 0 }, text );
+	doc.resetUndoRedo();
+	auto& undoStack = doc.getUndoStack();
+
+	// The text of the commands shares chunks of memory that are counted as a whole
+	doc.remove( 0, { { 0, 0 }, { 0, 4 } } );
+	EXPECT_GE( undoStack.getMemoryUsage(), 64 * 1024UL );
+
+	// Small removals mixed with big ones keep their chunks alive until they're moved out
+	String block( doc.getText( { { 0, 0 }, { 600, 0 } } ) );
+	for ( int i = 0; i < 300; i++ ) {
+		doc.remove( 0, { { 0, 0 }, { 600, 0 } } );
+		doc.insert( 0, { 0, 0 }, block );
+		doc.remove( 0, { { 0, 0 }, { 0, 10 } } );
+	}
+	EXPECT_GT( block.size() * 300, 5 * 1024 * 1024UL );
+	EXPECT_LT( undoStack.getMemoryUsage(), 5 * 1024 * 1024UL );
+
+	// The budget bounds the chunks, the commands are discarded until they're released
+	undoStack.setMaxMemoryUsage( 32 * 1024 );
+	EXPECT_LE( undoStack.getMemoryUsage(), 32 * 1024UL );
+	EXPECT_FALSE( doc.hasUndo() );
+	undoStack.setMaxMemoryUsage( 64 * 1024 * 1024 );
+
+	doc.remove( 0, { { 0, 0 }, { 0, 4 } } );
+	doc.undo();
+	EXPECT_TRUE( doc.hasRedo() );
+	doc.resetUndoRedo();
+	EXPECT_EQ( undoStack.getMemoryUsage(), 0UL );
+}
+
+UTEST( TextDocument, undoMemoryGroups ) {
+	TextDocument doc;
+	auto& undoStack = doc.getUndoStack();
+	undoStack.setMergeTimeout( Milliseconds( 20 ) );
+
+	// Two groups of two insertions each, every group is undone at once
+	std::vector<String> texts;
+	for ( int group = 0; group < 2; group++ ) {
+		if ( group > 0 )
+			Sys::sleep( Milliseconds( 50 ) );
+		doc.insert( 0, doc.endOfDoc(), "first insertion of group " + String::toString( group ) );
+		doc.insert( 0, doc.endOfDoc(), " second insertion\n" );
+		texts.emplace_back( doc.getText() );
+	}
+
+	// The undo moves the group to the redo stack, which goes over the budget. The commands of the
+	// group must be kept together, only the older groups can be discarded.
+	undoStack.setMaxMemoryUsage( undoStack.getMemoryUsage() );
+	doc.undo();
+	EXPECT_TRUE( doc.getText() == texts[0] );
+	doc.redo();
+	EXPECT_TRUE( doc.getText() == texts[1] );
+	EXPECT_FALSE( doc.hasRedo() );
+	doc.undo();
+	EXPECT_TRUE( doc.getText() == texts[0] );
+}
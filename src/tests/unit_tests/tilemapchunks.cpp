@@ -0,0 +1,180 @@
+#include "utest.h"
+#include <algorithm>
+#include <cstring>
+#include <eepp/maps/tilemap.hpp>
+#include <eepp/maps/tilemapchunks.hpp>
+#include <eepp/system/filesystem.hpp>
+#include <eepp/system/iostreamfile.hpp>
+#include <eepp/system/iostreammemory.hpp>
+#include <eepp/system/iostreamstring.hpp>
+#include <eepp/system/sys.hpp>
+#include <tuple>
+
+using namespace EE;
+using namespace EE::Maps;
+using namespace EE::System;
+
+namespace {
+
+using Tile = std::tuple<Int32, Int32, Uint32, Uint32, Uint32, Uint32>;
+
+constexpr Uint32 MAP_WIDTH = 70;
+constexpr Uint32 MAP_HEIGHT = 40;
+constexpr Uint32 LAYERS = 32;
+
+// Tiles scattered over every layer, with the chunk of the bottom right corner left empty
+std::vector<Tile> makeTiles() {
+	std::vector<Tile> tiles;
+	for ( Uint32 y = 0; y < MAP_HEIGHT; y++ ) {
+		for ( Uint32 x = 0; x < MAP_WIDTH; x++ ) {
+			if ( x >= 64 && y >= 32 )
+				continue;
+			for ( Uint32 layer = 0; layer < LAYERS; layer++ ) {
+				if ( ( x * 7 + y * 3 + layer ) % 11 == 0 || ( x == 63 && layer == LAYERS - 1 ) )
+					tiles.emplace_back( x, y, layer, 0x1000 + layer, x * 1000 + y, layer );
+			}
+		}
+	}
+	return tiles;
+}
+
+// A map in the plain format with only tiled layers
+std::string makePlainMap( const std::vector<Tile>& tiles ) {
+	IOStreamString stream;
+	sMapHdr mapHdr{};
+	mapHdr.Magic = EE_MAP_MAGIC;
+	mapHdr.SizeX = MAP_WIDTH;
+	mapHdr.SizeY = MAP_HEIGHT;
+	mapHdr.TileSizeX = mapHdr.TileSizeY = 32;
+	mapHdr.MaxLayers = mapHdr.LayerCount = LAYERS;
+	stream.write( (const char*)&mapHdr, sizeof( sMapHdr ) );
+
+	for ( Uint32 i = 0; i < LAYERS; i++ ) {
+		sLayerHdr layerHdr{};
+		std::string name( "layer" + String::toString( i ) );
+		String::strCopy( layerHdr.Name, name.c_str(), LAYER_NAME_SIZE );
+		layerHdr.Type = MAP_LAYER_TILED;
+		stream.write( (const char*)&layerHdr, sizeof( sLayerHdr ) );
+	}
+
+	size_t next = 0;
+	for ( Uint32 y = 0; y < MAP_HEIGHT; y++ ) {
+		for ( Uint32 x = 0; x < MAP_WIDTH; x++ ) {
+			Uint32 flags = 0;
+			size_t first = next;
+			for ( ; next < tiles.size() && std::get<0>( tiles[next] ) == (Int32)x &&
+					std::get<1>( tiles[next] ) == (Int32)y;
+				  next++ )
+				flags |= 1u << std::get<2>( tiles[next] );
+
+			stream.write( (const char*)&flags, sizeof( Uint32 ) );
+			for ( size_t i = first; i < next; i++ ) {
+				sMapTileGOHdr tileHdr{ std::get<3>( tiles[i] ), std::get<4>( tiles[i] ),
+									   std::get<5>( tiles[i] ) };
+				stream.write( (const char*)&tileHdr, sizeof( sMapTileGOHdr ) );
+			}
+		}
+	}
+
+	return stream.getStream();
+}
+
+// Reads the tiles stored in the chunks without creating them in a map
+class ChunksReader : public TileMapChunks {
+  public:
+	ChunksReader( const sMapChunksHdr& hdr ) :
+		TileMapChunks( NULL, Sizei( MAP_WIDTH, MAP_HEIGHT ), hdr ) {}
+
+	const sMapChunkIndex& getIndex( const Uint32& index ) const { return mIndex[index]; }
+
+	bool read( std::vector<Tile>& tiles ) {
+		for ( Uint32 i = 0; i < mIndex.size(); i++ ) {
+			DecodedChunk chunk;
+			if ( !decodeChunk( i, chunk ) )
+				return false;
+			for ( const auto& tile : chunk.Tiles )
+				tiles.emplace_back( tile.Pos.x, tile.Pos.y, tile.Layer, tile.Hdr.Type, tile.Hdr.Id,
+									tile.Hdr.Flags );
+		}
+		std::sort( tiles.begin(), tiles.end() );
+		return true;
+	}
+};
+
+void roundTrip( int* utest_result, const Uint32& compression, bool stream ) {
+	std::vector<Tile> tiles( makeTiles() );
+	std::string plain( makePlainMap( tiles ) );
+	std::string path( Sys::getTempPath() + "eepp_tilemapchunks.eem" );
+
+	{
+		IOStreamMemory src( plain.data(), plain.size() );
+		IOStreamFile dst( path, "wb" );
+		ASSERT_TRUE( TileMapChunks::convert( src, dst, EE_MAP_DEFAULT_CHUNK_SIZE, compression ) );
+	}
+
+	IOStreamFile file( path );
+	sMapHdr mapHdr;
+	ASSERT_EQ( file.read( (char*)&mapHdr, sizeof( sMapHdr ) ), (ios_size)sizeof( sMapHdr ) );
+	EXPECT_EQ( mapHdr.Magic, (Uint32)EE_MAP_CHUNKED_MAGIC );
+	EXPECT_EQ( mapHdr.LayerCount, LAYERS );
+	file.seek( file.tell() + sizeof( sLayerHdr ) * LAYERS );
+
+	sMapChunksHdr chunksHdr;
+	ASSERT_EQ( file.read( (char*)&chunksHdr, sizeof( sMapChunksHdr ) ),
+			   (ios_size)sizeof( sMapChunksHdr ) );
+	EXPECT_EQ( chunksHdr.ChunksX, 3u );
+	EXPECT_EQ( chunksHdr.ChunksY, 2u );
+	EXPECT_EQ( chunksHdr.Compression, compression );
+
+	std::vector<Tile> loaded;
+	{
+		ChunksReader reader( chunksHdr );
+		ASSERT_TRUE( reader.load( file, stream ? path : "" ) );
+		EXPECT_EQ( reader.getIndex( 5 ).Size, 0u );
+		EXPECT_TRUE( reader.read( loaded ) );
+	}
+
+	FileSystem::fileRemove( path );
+	std::sort( tiles.begin(), tiles.end() );
+	EXPECT_EQ( loaded.size(), tiles.size() );
+	EXPECT_TRUE( loaded == tiles );
+}
+
+} // namespace
+
+UTEST( TileMapChunks, roundTrip ) {
+	roundTrip( utest_result, MAP_CHUNK_COMPRESSION_NONE, false );
+}
+
+UTEST( TileMapChunks, roundTripDeflate ) {
+	roundTrip( utest_result, MAP_CHUNK_COMPRESSION_DEFLATE, false );
+}
+
+UTEST( TileMapChunks, roundTripStreamed ) {
+	roundTrip( utest_result, MAP_CHUNK_COMPRESSION_DEFLATE, true );
+}
+
+UTEST( TileMapChunks, truncatedIndex ) {
+	std::vector<Tile> tiles( makeTiles() );
+	std::string plain( makePlainMap( tiles ) );
+	std::string path( Sys::getTempPath() + "eepp_tilemapchunks_truncated.eem" );
+
+	{
+		IOStreamMemory src( plain.data(), plain.size() );
+		IOStreamFile dst( path, "wb" );
+		ASSERT_TRUE( TileMapChunks::convert( src, dst ) );
+	}
+
+	std::string data;
+	FileSystem::fileGet( path, data );
+	FileSystem::fileRemove( path );
+
+	size_t indexStart = sizeof( sMapHdr ) + sizeof( sLayerHdr ) * LAYERS + sizeof( sMapChunksHdr );
+	sMapChunksHdr chunksHdr;
+	memcpy( &chunksHdr, &data[indexStart - sizeof( sMapChunksHdr )], sizeof( sMapChunksHdr ) );
+
+	IOStreamMemory truncated( data.data(), indexStart + sizeof( sMapChunkIndex ) * 2 );
+	truncated.seek( indexStart );
+	ChunksReader reader( chunksHdr );
+	EXPECT_FALSE( reader.load( truncated ) );
+}
@@ -0,0 +1,184 @@
+#include "../../tools/ecode/plugins/autocomplete/wordindex.hpp"
+#include "utest.h"
+#include <algorithm>
+#include <eepp/ui/doc/syntaxdefinitionmanager.hpp>
+#include <eepp/ui/doc/textdocument.hpp>
+
+using namespace EE;
+using namespace EE::UI::Doc;
+using namespace ecode;
+
+namespace {
+
+static const char* WORD_PATTERN = "[%a_][%w_]*";
+
+void update( WordIndex& index, TextDocument& doc ) {
+	index.apply( index.collectChanges( &doc ) );
+}
+
+// The words of the document indexed from scratch
+std::vector<std::pair<std::string, Uint32>> indexFromScratch( TextDocument& doc ) {
+	WordIndex index( WORD_PATTERN );
+	index.addDocument( &doc );
+	update( index, doc );
+	auto words = index.getWords( doc.getSyntaxDefinition().getLanguageName() );
+	index.removeDocument( &doc );
+	return words;
+}
+
+bool hasWord( const std::vector<WordIndex::Match>& matches, const std::string& word ) {
+	return std::any_of( matches.begin(), matches.end(),
+						[&word]( const WordIndex::Match& m ) { return m.text == word; } );
+}
+
+} // namespace
+
+UTEST( WordIndex, incrementalUpdate ) {
+	static const char* words[] = { "textDocument", "editor", "foo", "bar", "buffer", "cursor",
+								   "selection", "undo", "redo", "line" };
+	TextDocument doc( false );
+	String text;
+	for ( int i = 0; i < 1000; i++ )
+		text += String( words[i % eeARRAY_SIZE( words )] ) + " " + String::toString( i ) + " " +
+				String( words[( i * 7 ) % eeARRAY_SIZE( words )] ) + "\n";
+	doc.insert( 0, { 0, 0 }, text );
+
+	WordIndex index( WORD_PATTERN );
+	index.addDocument( &doc );
+	update( index, doc );
+	const std::string lang( doc.getSyntaxDefinition().getLanguageName() );
+	EXPECT_TRUE( index.getWords( lang ) == indexFromScratch( doc ) );
+
+	// A single line edit only copies the modified line
+	doc.insert( 0, { 500, 0 }, "newWord " );
+	EXPECT_TRUE( index.isDirty( &doc ) );
+	auto changes = index.collectChanges( &doc );
+	EXPECT_EQ( changes.start, 500 );
+	EXPECT_EQ( changes.removed, 1 );
+	EXPECT_EQ( changes.lines.size(), 1UL );
+	index.apply( std::move( changes ) );
+	EXPECT_FALSE( index.isDirty( &doc ) );
+	EXPECT_TRUE( index.getWords( lang ) == indexFromScratch( doc ) );
+
+	// Random insertions, removals, undos and redos, spanning multiple lines
+	Uint32 seed = 12345;
+	auto next = [&seed]( Uint32 max ) {
+		seed = seed * 1103515245 + 12345;
+		return ( ( seed >> 16 ) & 0x7FFF ) % max;
+	};
+	auto randomPosition = [&]() {
+		Int64 line = next( doc.linesCount() );
+		return TextPosition( line, next( doc.line( line ).size() ) );
+	};
+
+	for ( int i = 0; i < 300; i++ ) {
+		int edits = 1 + next( 4 );
+		for ( int e = 0; e < edits; e++ ) {
+			switch ( next( 5 ) ) {
+				case 0:
+				case 1: {
+					String insert( words[next( eeARRAY_SIZE( words ) )] );
+					for ( Uint32 n = next( 4 ); n > 0; n-- )
+						insert += ( next( 2 ) ? " " : "\n" ) +
+								  String( words[next( eeARRAY_SIZE( words ) )] );
+					doc.insert( 0, randomPosition(), insert );
+					break;
+				}
+				case 2:
+				case 3: {
+					TextPosition start( randomPosition() );
+					TextPosition end( eemin<Int64>( start.line() + next( 3 ),
+													doc.linesCount() - 1 ),
+									  0 );
+					end.setColumn( next( doc.line( end.line() ).size() ) );
+					doc.remove( 0, TextRange( start, end ).normalized() );
+					break;
+				}
+				default: {
+					if ( next( 2 ) )
+						doc.undo();
+					else
+						doc.redo();
+				}
+			}
+		}
+		update( index, doc );
+		ASSERT_TRUE( index.getWords( lang ) == indexFromScratch( doc ) );
+	}
+
+	index.removeDocument( &doc );
+	EXPECT_TRUE( index.getWords( lang ).empty() );
+}
+
+UTEST( WordIndex, match ) {
+	TextDocument doc( false );
+	doc.insert( 0, { 0, 0 },
+				"textDocument textEditor\ntextDocument texture\nbuffer tex tx\ntypedWord\n" );
+	WordIndex index( WORD_PATTERN );
+	index.addDocument( &doc );
+	update( index, doc );
+	const std::string lang( doc.getSyntaxDefinition().getLanguageName() );
+
+	auto matches = index.match( lang, "tex", 10 );
+	EXPECT_TRUE( hasWord( matches, "textDocument" ) );
+	EXPECT_TRUE( hasWord( matches, "textEditor" ) );
+	EXPECT_TRUE( hasWord( matches, "texture" ) );
+	EXPECT_FALSE( hasWord( matches, "buffer" ) );
+	// Words shorter than 3 characters are not indexed
+	EXPECT_FALSE( hasWord( matches, "tx" ) );
+	// The word being typed is not suggested
+	EXPECT_FALSE( hasWord( matches, "tex" ) );
+	EXPECT_FALSE( hasWord( index.match( lang, "typedWord", 10 ), "typedWord" ) );
+	EXPECT_TRUE( hasWord( index.match( lang, "typed", 10 ), "typedWord" ) );
+
+	for ( size_t i = 1; i < matches.size(); i++ )
+		EXPECT_TRUE( matches[i - 1].score > matches[i].score ||
+					 ( matches[i - 1].score == matches[i].score &&
+					   matches[i - 1].refs >= matches[i].refs ) );
+
+	EXPECT_EQ( index.match( lang, "tex", 1 ).size(), 1UL );
+
+	// The words move with the document to its new language
+	const auto& cpp = SyntaxDefinitionManager::instance()->getByLanguageName( "C++" );
+	ASSERT_STREQ( cpp.getLanguageName().c_str(), "C++" );
+	doc.setSyntaxDefinition( cpp );
+	EXPECT_TRUE( index.isDirty( &doc ) );
+	auto changes = index.collectChanges( &doc );
+	EXPECT_TRUE( changes.lines.empty() );
+	index.apply( std::move( changes ) );
+	EXPECT_TRUE( index.getWords( lang ).empty() );
+	EXPECT_TRUE( hasWord( index.match( "C++", "tex", 10 ), "texture" ) );
+}
+
+UTEST( WordIndex, matchWhileTyping ) {
+	TextDocument doc( false );
+	doc.insert( 0, { 0, 0 },
+				"getTextDocument textDocument documentTexture\nsetTextureFilter textEditor\n"
+				"buffer texture\n" );
+	WordIndex index( WORD_PATTERN );
+	index.addDocument( &doc );
+	update( index, doc );
+	const std::string lang( doc.getSyntaxDefinition().getLanguageName() );
+
+	// The words that score below zero with the first characters must be found once the query
+	// matches them better
+	for ( const std::string query : { "textdoc", "texture" } ) {
+		for ( size_t i = 1; i <= query.size(); i++ ) {
+			WordIndex fromScratch( WORD_PATTERN );
+			fromScratch.addDocument( &doc );
+			update( fromScratch, doc );
+			auto expected = fromScratch.match( lang, query.substr( 0, i ), 10 );
+			auto matches = index.match( lang, query.substr( 0, i ), 10 );
+			EXPECT_EQ( matches.size(), expected.size() );
+			for ( size_t m = 0; m < eemin( matches.size(), expected.size() ); m++ ) {
+				EXPECT_STREQ( matches[m].text.c_str(), expected[m].text.c_str() );
+				EXPECT_EQ( matches[m].score, expected[m].score );
+			}
+			for ( const auto& match : matches )
+				EXPECT_TRUE( match.score > 0 );
+		}
+	}
+
+	EXPECT_TRUE( hasWord( index.match( lang, "textdoc", 10 ), "getTextDocument" ) );
+	EXPECT_TRUE( hasWord( index.match( lang, "texture", 10 ), "setTextureFilter" ) );
+}
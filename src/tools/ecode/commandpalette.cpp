@@ -21,11 +21,13 @@ CommandPalette::asModel( const std::vector<std::string>& commandList,
 	return CommandPaletteModel::create( 3, build( commandList, keybindings ) );
 }
 
-CommandPalette::CommandPalette( const std::shared_ptr<ThreadPool>& pool ) : mPool( pool ) {}
+CommandPalette::CommandPalette( const std::shared_ptr<ThreadPool>& pool ) :
+	mPool( pool ), mFuzzyMatcher( pool ) {}
 
 void CommandPalette::setCommandPalette( const std::vector<std::string>& commandList,
 										const UI::KeyBindings& keybindings ) {
 	mCommandPalette = build( commandList, keybindings );
+	mCommandPaletteVersion = ++mLastVersion;
 	mBaseModel = CommandPaletteModel::create( 3, mCommandPalette );
 	if ( !mCurModel )
 		mCurModel = mBaseModel;
@@ -42,6 +44,7 @@ const std::shared_ptr<CommandPaletteModel>& CommandPalette::getBaseModel() const
 void CommandPalette::setEditorCommandPalette( const std::vector<std::string>& commandList,
 											  const UI::KeyBindings& keybindings ) {
 	mCommandPaletteEditor = build( commandList, keybindings );
+	mCommandPaletteEditorVersion = ++mLastVersion;
 	mEditorModel = CommandPaletteModel::create( 3, mCommandPaletteEditor );
 	if ( !mCurModel )
 		mCurModel = mEditorModel;
@@ -58,6 +61,7 @@ const std::shared_ptr<CommandPaletteModel>& CommandPalette::getEditorModel() con
 void CommandPalette::setCommandPaletteEditor(
 	const std::vector<std::vector<std::string>>& commandPaletteEditor ) {
 	mCommandPaletteEditor = commandPaletteEditor;
+	mCommandPaletteEditorVersion = ++mLastVersion;
 }
 
 void CommandPalette::setCurModel( const std::shared_ptr<CommandPaletteModel>& curModel ) {
@@ -71,18 +75,30 @@ CommandPalette::fuzzyMatch( const std::vector<std::vector<std::string>>& cmdPale
 		return {};
 
 	Lock rl( mMatchingMutex );
-	std::multimap<int, int, std::greater<int>> matchesMap;
 	std::vector<std::vector<std::string>> ret;
-
-	for ( size_t i = 0; i < cmdPalette.size(); i++ ) {
-		int matchName = String::fuzzyMatch( cmdPalette[i][0], match );
-		int matchKeybind = String::fuzzyMatch( cmdPalette[i][2], match );
-		matchesMap.insert( { std::max( matchName, matchKeybind ), i } );
-	}
-	for ( auto& res : matchesMap ) {
-		if ( ret.size() < max )
-			ret.push_back( cmdPalette[res.second] );
-	}
+	Uint64 version = 0;
+
+	/* only the palettes owned can be narrowed incrementally */
+	if ( &cmdPalette == &mCommandPalette )
+		version = mCommandPaletteVersion;
+	else if ( &cmdPalette == &mCommandPaletteEditor )
+		version = mCommandPaletteEditorVersion;
+
+	auto matches = mFuzzyMatcher.match(
+		match, cmdPalette.size(), max,
+		[&cmdPalette]( size_t index, const std::string& query ) {
+			return std::max( String::fuzzyMatch( cmdPalette[index][0], query ),
+							 String::fuzzyMatch( cmdPalette[index][2], query ) );
+		},
+		[&cmdPalette]( size_t index ) {
+			return FuzzyMatcher::mask( cmdPalette[index][0] ) |
+				   FuzzyMatcher::mask( cmdPalette[index][2] );
+		},
+		version );
+
+	ret.reserve( matches.size() );
+	for ( const auto& res : matches )
+		ret.push_back( cmdPalette[res.index] );
 	return CommandPaletteModel::create( 3, ret );
 }
 
@@ -1,6 +1,7 @@
 #ifndef ECODE_COMMANDPALETTE_HPP
 #define ECODE_COMMANDPALETTE_HPP
 
+#include "fuzzymatcher.hpp"
 #include <eepp/core.hpp>
 #include <eepp/system/mutex.hpp>
 #include <eepp/system/threadpool.hpp>
@@ -61,6 +62,10 @@ class CommandPalette {
 	std::shared_ptr<ThreadPool> mPool;
 	std::vector<std::vector<std::string>> mCommandPalette;
 	std::vector<std::vector<std::string>> mCommandPaletteEditor;
+	mutable FuzzyMatcher mFuzzyMatcher;
+	Uint64 mLastVersion{ 0 };
+	Uint64 mCommandPaletteVersion{ 0 };
+	Uint64 mCommandPaletteEditorVersion{ 0 };
 	std::shared_ptr<CommandPaletteModel> mCurModel;
 	std::shared_ptr<CommandPaletteModel> mBaseModel;
 	std::shared_ptr<CommandPaletteModel> mEditorModel;
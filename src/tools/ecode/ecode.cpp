@@ -919,6 +919,9 @@ App::~App() {
 		delete mFileWatcher;
 		mFileWatcher = nullptr;
 	}
+	// The pending changes would be delivered to the editors and plugins being destroyed
+	if ( mFileSystemListener )
+		mFileSystemListener->stop();
 	if ( mDirTree )
 		mDirTree->resetPluginManager();
 	mPluginManager.reset();
@@ -2673,7 +2676,12 @@ void App::loadDirTree( const std::string& path ) {
 			}
 			mFileSystemListener->setDirTree( mDirTree );
 		},
-		supportedExts );
+		supportedExts, true,
+		[this]( ProjectDirectoryTree&, size_t ) {
+			// The files found so far can already be located while the scan continues
+			mDirTreeReady = true;
+			mUISceneNode->runOnMainThread( [this] { mUniversalLocator->updateFilesTable(); } );
+		} );
 }
 
 UIMessageBox* App::errorMsgBox( const String& msg ) {
@@ -0,0 +1,77 @@
+#include "fileeventcoalescer.hpp"
+#include <eepp/system/filesystem.hpp>
+
+using namespace EE::System;
+
+namespace ecode {
+
+static inline bool endsWithSlash( const std::string& dir ) {
+	return !dir.empty() && ( dir.back() == '\\' || dir.back() == '/' );
+}
+
+static std::string joinPath( const std::string& dir, const std::string& filename ) {
+	return ( endsWithSlash( dir ) ? dir : ( dir + FileSystem::getOSSlash() ) ) + filename;
+}
+
+std::string FileEventCoalescer::getPath( const FileEvent& event ) {
+	return joinPath( event.directory, event.filename );
+}
+
+std::string FileEventCoalescer::getOldPath( const FileEvent& event ) {
+	return FileSystem::isRelativePath( event.oldFilename )
+			   ? joinPath( event.directory, event.oldFilename )
+			   : event.oldFilename;
+}
+
+void FileEventCoalescer::add( FileEvent&& event ) {
+	mEventsCount++;
+
+	if ( event.type == FileSystemEventType::Moved ) {
+		mPaths.erase( getOldPath( event ) );
+		mPaths.erase( getPath( event ) );
+		mChanges.push_back( { std::move( event ) } );
+		return;
+	}
+
+	std::string path( getPath( event ) );
+	auto found = mPaths.find( path );
+	if ( found == mPaths.end() ) {
+		mPaths[path] = mChanges.size();
+		mChanges.push_back( { std::move( event ) } );
+		return;
+	}
+
+	Change& change = mChanges[found->second];
+	switch ( change.event.type ) {
+		case FileSystemEventType::Add:
+			// It didn't exist before the window, so it's still new unless it was deleted
+			if ( event.type == FileSystemEventType::Delete ) {
+				change.dropped = true;
+				mPaths.erase( found );
+			}
+			break;
+		case FileSystemEventType::Delete:
+			if ( event.type != FileSystemEventType::Delete )
+				change.event.type = FileSystemEventType::Modified;
+			break;
+		default:
+			if ( event.type == FileSystemEventType::Delete )
+				change.event.type = FileSystemEventType::Delete;
+			break;
+	}
+}
+
+std::vector<FileEvent> FileEventCoalescer::take() {
+	std::vector<FileEvent> events;
+	events.reserve( mChanges.size() );
+	for ( auto& change : mChanges ) {
+		if ( !change.dropped )
+			events.emplace_back( std::move( change.event ) );
+	}
+	mChanges.clear();
+	mPaths.clear();
+	mEventsCount = 0;
+	return events;
+}
+
+} // namespace ecode
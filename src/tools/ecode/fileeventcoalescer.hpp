@@ -0,0 +1,50 @@
+#ifndef ECODE_FILEEVENTCOALESCER_HPP
+#define ECODE_FILEEVENTCOALESCER_HPP
+
+#include <eepp/ui/models/filesystemmodel.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace EE;
+using namespace EE::UI::Models;
+
+namespace ecode {
+
+/** Merges the file system events of a path received in a time window into the change that they
+ * produce. An added file that is modified is still an added file, a file added and deleted
+ * produces no change, and a deleted file that is added again was modified. The changes keep the
+ * order of the first event of each path. A move isn't merged: it's kept in its position and the
+ * later events of both paths start new changes. */
+class FileEventCoalescer {
+  public:
+	/** @return The full path of the file of the event */
+	static std::string getPath( const FileEvent& event );
+
+	/** @return The full path of the file moved by a move event */
+	static std::string getOldPath( const FileEvent& event );
+
+	void add( FileEvent&& event );
+
+	/** @return The changes since the last call, and starts a new window */
+	std::vector<FileEvent> take();
+
+	/** @return The number of events added since the last take */
+	size_t getEventsCount() const { return mEventsCount; }
+
+	bool empty() const { return mEventsCount == 0; }
+
+  protected:
+	struct Change {
+		FileEvent event;
+		bool dropped{ false };
+	};
+
+	std::vector<Change> mChanges;
+	std::unordered_map<std::string, size_t> mPaths;
+	size_t mEventsCount{ 0 };
+};
+
+} // namespace ecode
+
+#endif // ECODE_FILEEVENTCOALESCER_HPP
@@ -22,24 +22,109 @@ std::string getFileSystemEventTypeName( FileSystemEventType action ) {
 FileSystemListener::FileSystemListener( UICodeEditorSplitter* splitter,
 										std::shared_ptr<FileSystemModel> fileSystemModel,
 										const std::vector<std::string>& ignoreFiles ) :
-	mSplitter( splitter ), mFileSystemModel( fileSystemModel ), mIgnoredFiles( ignoreFiles ) {}
+	mSplitter( splitter ), mFileSystemModel( fileSystemModel ), mIgnoredFiles( ignoreFiles ) {
+	mThread = std::thread( [this] { run(); } );
+}
+
+FileSystemListener::~FileSystemListener() {
+	stop();
+}
+
+void FileSystemListener::stop() {
+	{
+		std::lock_guard<std::mutex> lock( mEventsMutex );
+		mRunning = false;
+	}
+	mEventsCond.notify_all();
+	if ( mThread.joinable() )
+		mThread.join();
+}
 
-static inline bool endsWithSlash( const std::string& dir ) {
-	return !dir.empty() && ( dir.back() == '\\' || dir.back() == '/' );
+void FileSystemListener::setBatchWindow( const Time& window ) {
+	std::lock_guard<std::mutex> lock( mEventsMutex );
+	mBatchWindow = window;
+}
+
+void FileSystemListener::setBatchMaxDelay( const Time& maxDelay ) {
+	std::lock_guard<std::mutex> lock( mEventsMutex );
+	mBatchMaxDelay = maxDelay;
 }
 
 void FileSystemListener::handleFileAction( efsw::WatchID, const std::string& dir,
 										   const std::string& filename, efsw::Action action,
 										   std::string oldFilename ) {
-	FileInfo file( ( endsWithSlash( dir ) ? dir : ( dir + FileSystem::getOSSlash() ) ) + filename );
+	{
+		std::lock_guard<std::mutex> lock( mEventsMutex );
+		if ( !mRunning )
+			return;
+		if ( mEvents.empty() )
+			mFirstEventClock.restart();
+		mLastEventClock.restart();
+		mEvents.add( FileEvent( (FileSystemEventType)action, dir, filename, oldFilename ) );
+	}
+	mEventsCond.notify_one();
+}
 
-	switch ( action ) {
-		case efsw::Actions::Add:
-		case efsw::Actions::Delete:
-		case efsw::Actions::Moved: {
-			FileEvent event( (FileSystemEventType)action, dir, filename, oldFilename );
+void FileSystemListener::run() {
+	std::unique_lock<std::mutex> lock( mEventsMutex );
+	while ( mRunning ) {
+		if ( mEvents.empty() ) {
+			mEventsCond.wait( lock );
+			continue;
+		}
+
+		// Waits until the events stop arriving, a checkout or an install sends thousands of them
+		Time quiet = mBatchWindow - mLastEventClock.getElapsedTime();
+		Time left = mBatchMaxDelay - mFirstEventClock.getElapsedTime();
+		Time wait = eemin( quiet, left );
+		if ( wait > Time::Zero ) {
+			mEventsCond.wait_for( lock, std::chrono::microseconds( wait.asMicroseconds() ) );
+			continue;
+		}
+
+		size_t eventsCount = mEvents.getEventsCount();
+		Time latency = mFirstEventClock.getElapsedTime();
+		std::vector<FileEvent> events( mEvents.take() );
+		lock.unlock();
+		process( std::move( events ), eventsCount, latency );
+		lock.lock();
+	}
+}
 
-			if ( Log::instance() && Log::instance()->getLogLevelThreshold() == LogLevel::Debug ) {
+void FileSystemListener::process( std::vector<FileEvent>&& events, size_t eventsCount,
+								  const Time& latency ) {
+	FileSystemChangeSet changeSet;
+	changeSet.events = eventsCount;
+	changeSet.latency = latency;
+	changeSet.changes.reserve( events.size() );
+
+	// Only the paths that survived the merge are read
+	Clock clock;
+	std::vector<FileInfo> files;
+	files.reserve( events.size() );
+	for ( auto& event : events ) {
+		files.emplace_back( FileEventCoalescer::getPath( event ) );
+		FileInfo file( files.back() );
+		if ( file.isLink() )
+			file = FileInfo( file.linksTo() );
+		changeSet.changes.push_back( { std::move( event ), std::move( file ) } );
+	}
+	changeSet.statTime = clock.getElapsedTimeAndReset();
+
+	UnorderedSet<std::string> openFiles;
+	mSplitter->forEachDoc(
+		[&]( TextDocument& doc ) { openFiles.insert( doc.getFileInfo().getFilepath() ); } );
+	auto isFileOpen = [&openFiles]( const FileInfo& file ) {
+		return openFiles.find( file.getFilepath() ) != openFiles.end();
+	};
+	bool logEvents = Log::instance() && Log::instance()->getLogLevelThreshold() == LogLevel::Debug;
+
+	for ( size_t i = 0; i < changeSet.changes.size(); i++ ) {
+		const FileEvent& event = changeSet.changes[i].event;
+		const FileInfo& file = changeSet.changes[i].file;
+
+		if ( event.type != FileSystemEventType::Modified ) {
+			if ( logEvents ) {
 				std::string txt =
 					"DIR ( " + event.directory + " ) FILE ( " +
 					( ( event.oldFilename.empty() ? ""
@@ -54,55 +139,45 @@ void FileSystemListener::handleFileAction( efsw::WatchID, const std::string& dir
 				mFileSystemModel->handleFileEvent( event );
 
 			if ( mDirTree )
-				mDirTree->onChange( (ProjectDirectoryTree::Action)action, file, oldFilename );
+				mDirTree->onChange( (ProjectDirectoryTree::Action)event.type, files[i],
+									event.oldFilename );
+		}
 
-			if ( action == efsw::Actions::Moved ) {
-				FileInfo oldFile( FileSystem::isRelativePath( oldFilename ) ? dir + oldFilename
-																			: oldFilename );
-				if ( file.isLink() )
-					file = FileInfo( file.linksTo() );
+		if ( event.type == FileSystemEventType::Moved ) {
+			FileInfo oldFile( FileEventCoalescer::getOldPath( event ) );
 
-				if ( isFileOpen( oldFile ) )
-					notifyMove( oldFile, file );
+			if ( isFileOpen( oldFile ) )
+				notifyMove( oldFile, file );
 
-				if ( oldFile.isLink() ) {
-					oldFile = FileInfo( oldFile.linksTo() );
+			if ( oldFile.isLink() ) {
+				oldFile = FileInfo( oldFile.linksTo() );
 
-					if ( isFileOpen( oldFile ) )
-						notifyMove( oldFile, file );
-				}
+				if ( isFileOpen( oldFile ) )
+					notifyMove( oldFile, file );
 			}
+		}
 
-			if ( file.isLink() )
-				file = FileInfo( file.linksTo() );
-
-			if ( isFileOpen( file ) )
-				notifyChange( file );
-
-			Lock l( mCbsMutex );
-			if ( !mCbs.empty() ) {
-				auto cbs = mCbs;
-				for ( const auto& cb : cbs )
-					cb.second( event, file );
-			}
+		if ( isFileOpen( file ) )
+			notifyChange( file );
+	}
 
-			break;
-		}
-		case efsw::Actions::Modified: {
-			if ( file.isLink() )
-				file = FileInfo( file.linksTo() );
-			if ( isFileOpen( file ) )
-				notifyChange( file );
-
-			Lock l( mCbsMutex );
-			if ( !mCbs.empty() ) {
-				auto cbs = mCbs;
-				FileEvent event( (FileSystemEventType)action, dir, filename, oldFilename );
-				for ( const auto& cb : cbs )
-					cb.second( event, file );
-			}
-		}
+	Lock l( mCbsMutex );
+	if ( !mCbs.empty() ) {
+		auto cbs = mCbs;
+		for ( const auto& change : changeSet.changes )
+			for ( const auto& cb : cbs )
+				cb.second( change.event, change.file );
 	}
+	if ( !mBatchCbs.empty() ) {
+		auto cbs = mBatchCbs;
+		for ( const auto& cb : cbs )
+			cb.second( changeSet );
+	}
+
+	Log::debug( "FileSystemListener: %zu events merged into %zu changes, waited %.2f ms, read "
+				"the files in %.2f ms, delivered in %.2f ms",
+				changeSet.events, changeSet.changes.size(), changeSet.latency.asMilliseconds(),
+				changeSet.statTime.asMilliseconds(), clock.getElapsedTime().asMilliseconds() );
 }
 
 void FileSystemListener::setDirTree( const std::shared_ptr<ProjectDirectoryTree>& dirTree ) {
@@ -116,26 +191,16 @@ Uint64 FileSystemListener::addListener( const FileEventFn& fn ) {
 	return id;
 }
 
-bool FileSystemListener::removeListener( const Uint64& id ) {
+Uint64 FileSystemListener::addBatchListener( const FileChangeSetFn& fn ) {
 	Lock l( mCbsMutex );
-	auto it = mCbs.find( id );
-	if ( it != mCbs.end() ) {
-		mCbs.erase( it );
-		return true;
-	}
-	return false;
+	Uint64 id = ++mLastId;
+	mBatchCbs[id] = fn;
+	return id;
 }
 
-bool FileSystemListener::isFileOpen( const FileInfo& file ) {
-	bool found = false;
-	mSplitter->forEachDocStoppable( [&]( TextDocument& doc ) {
-		if ( file.getFilepath() == doc.getFileInfo().getFilepath() ) {
-			found = true;
-			return true;
-		}
-		return false;
-	} );
-	return found;
+bool FileSystemListener::removeListener( const Uint64& id ) {
+	Lock l( mCbsMutex );
+	return mCbs.erase( id ) > 0 || mBatchCbs.erase( id ) > 0;
 }
 
 void FileSystemListener::notifyChange( const FileInfo& file ) {
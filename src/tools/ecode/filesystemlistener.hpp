@@ -1,13 +1,18 @@
 #ifndef ECODE_FILESYSTEMLISTENER_HPP
 #define ECODE_FILESYSTEMLISTENER_HPP
 
+#include "fileeventcoalescer.hpp"
 #include "projectdirectorytree.hpp"
 #include <atomic>
+#include <condition_variable>
+#include <eepp/system/clock.hpp>
 #include <eepp/system/fileinfo.hpp>
 #include <eepp/ui/models/filesystemmodel.hpp>
 #include <eepp/ui/tools/uicodeeditorsplitter.hpp>
 #include <eepp/ui/uicodeeditor.hpp>
 #include <efsw/efsw.hpp>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
 using namespace EE::System;
@@ -17,25 +22,56 @@ using namespace EE::UI::Tools;
 
 namespace ecode {
 
+struct FileSystemChange {
+	FileEvent event;
+	FileInfo file; ///< The file changed, or the file it links to
+};
+
+struct FileSystemChangeSet {
+	std::vector<FileSystemChange> changes; ///< One change per path, unless it was moved
+	size_t events{ 0 };					   ///< Events received from the watcher
+	Time latency;						   ///< Time since the first event was received
+	Time statTime;						   ///< Time spent reading the information of the files
+};
+
+/** Receives the events of the file watcher and delivers them in batches. The events are
+ * collected until no event is received during the batch window ( or the batch gets too old ),
+ * the events of each path are merged ( see FileEventCoalescer ) and only the paths that changed
+ * are read. The changes are delivered from the thread of the listener. */
 class FileSystemListener : public efsw::FileWatchListener {
   public:
 	typedef std::function<void( const FileEvent&, const FileInfo& )> FileEventFn;
 
+	typedef std::function<void( const FileSystemChangeSet& )> FileChangeSetFn;
+
 	FileSystemListener( UICodeEditorSplitter* codeSplitter,
 						std::shared_ptr<FileSystemModel> fileSystemModel,
 						const std::vector<std::string>& ignoreFiles );
 
-	virtual ~FileSystemListener() {}
+	virtual ~FileSystemListener();
 
 	void handleFileAction( efsw::WatchID, const std::string& dir, const std::string& filename,
 						   efsw::Action action, std::string oldFilename );
 
+	/** Stops delivering the changes, the pending ones are discarded */
+	void stop();
+
+	/** Sets the time without events that closes a batch */
+	void setBatchWindow( const Time& window );
+
+	/** Sets the maximum time that the first event of a batch can wait */
+	void setBatchMaxDelay( const Time& maxDelay );
+
 	void setFileSystemModel( std::shared_ptr<FileSystemModel> model ) { mFileSystemModel = model; }
 
 	void setDirTree( const std::shared_ptr<ProjectDirectoryTree>& dirTree );
 
+	/** Adds a listener called for each change */
 	Uint64 addListener( const FileEventFn& fn );
 
+	/** Adds a listener called once per batch with all its changes */
+	Uint64 addBatchListener( const FileChangeSetFn& fn );
+
 	bool removeListener( const Uint64& id );
 
   protected:
@@ -44,10 +80,22 @@ class FileSystemListener : public efsw::FileWatchListener {
 	std::shared_ptr<ProjectDirectoryTree> mDirTree;
 	std::atomic<Uint64> mLastId{ 0 };
 	std::unordered_map<Uint64, FileEventFn> mCbs;
+	std::unordered_map<Uint64, FileChangeSetFn> mBatchCbs;
 	std::vector<std::string> mIgnoredFiles;
 	Mutex mCbsMutex;
-
-	bool isFileOpen( const FileInfo& file );
+	std::mutex mEventsMutex;
+	std::condition_variable mEventsCond;
+	FileEventCoalescer mEvents;
+	Clock mFirstEventClock;
+	Clock mLastEventClock;
+	Time mBatchWindow{ Milliseconds( 100 ) };
+	Time mBatchMaxDelay{ Milliseconds( 500 ) };
+	bool mRunning{ true };
+	std::thread mThread;
+
+	void run();
+
+	void process( std::vector<FileEvent>&& events, size_t eventsCount, const Time& latency );
 
 	void notifyChange( const FileInfo& file );
 
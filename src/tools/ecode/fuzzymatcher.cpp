@@ -0,0 +1,205 @@
+#include "fuzzymatcher.hpp"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <mutex>
+
+namespace ecode {
+
+struct FuzzyMatcher::State {
+	std::string query;
+	Uint64 queryMask{ 0 };
+	size_t max{ 0 };
+	const ScoreFn* score{ nullptr };
+	const MaskFn* mask{ nullptr };
+	/* the masks cache, null if the candidates don't have a version */
+	Uint64* masks{ nullptr };
+	/* the candidates to score, all of them if null */
+	const std::vector<Uint32>* candidates{ nullptr };
+	size_t count{ 0 };
+	size_t chunkSize{ 0 };
+	std::vector<Chunk> chunks;
+	std::atomic<size_t> nextChunk{ 0 };
+	std::mutex mutex;
+	std::condition_variable cond;
+	size_t running{ 0 }; /* helper tasks scoring chunks */
+	bool finished{ false };
+};
+
+static inline Uint64 charBit( unsigned char ch ) {
+	if ( ch >= 'a' && ch <= 'z' )
+		return 1ULL << ( ch - 'a' );
+	if ( ch >= 'A' && ch <= 'Z' )
+		return 1ULL << ( ch - 'A' );
+	if ( ch >= '0' && ch <= '9' )
+		return 1ULL << ( 26 + ch - '0' );
+	if ( ch == ' ' )
+		return 0;
+	// The rest of the ASCII characters share 26 bits, and the bytes of multi-byte characters one
+	return ch >= 128 ? 1ULL << 62 : 1ULL << ( 36 + ch % 26 );
+}
+
+/* set in the cached masks, to tell them from the masks not computed yet */
+static constexpr Uint64 MASK_CACHED = 1ULL << 63;
+
+static inline bool isBetter( const FuzzyMatcher::Match& a, const FuzzyMatcher::Match& b ) {
+	return a.score > b.score || ( a.score == b.score && a.index < b.index );
+}
+
+Uint64 FuzzyMatcher::mask( std::string_view str ) {
+	Uint64 res = 0;
+	for ( const auto& ch : str )
+		res |= charBit( ch );
+	return res;
+}
+
+FuzzyMatcher::FuzzyMatcher( std::shared_ptr<ThreadPool> threadPool ) :
+	mPool( std::move( threadPool ) ) {}
+
+void FuzzyMatcher::reset() {
+	Lock l( mMutex );
+	mLastQuery.clear();
+	mLastVersion = 0;
+	mLastCount = 0;
+	mLastMatches.clear();
+	mMasksVersion = 0;
+	mMasks.clear();
+}
+
+void FuzzyMatcher::setChunkSize( size_t chunkSize ) {
+	mChunkSize = eemax<size_t>( 1, chunkSize );
+}
+
+std::vector<FuzzyMatcher::Match> FuzzyMatcher::match( const std::string& query, size_t count,
+													  size_t max, const ScoreFn& score,
+													  const MaskFn& mask, Uint64 version ) {
+	Lock l( mMutex );
+
+	auto state = std::make_shared<State>();
+	state->query = query;
+	state->queryMask = FuzzyMatcher::mask( query );
+	state->max = max;
+	state->score = &score;
+	state->mask = mask ? &mask : nullptr;
+	state->chunkSize = mChunkSize;
+
+	if ( mask && version != 0 ) {
+		if ( version != mMasksVersion || mMasks.size() != count ) {
+			mMasks.assign( count, 0 );
+			mMasksVersion = version;
+		}
+		state->masks = mMasks.data();
+	}
+
+	// Extending the query can only discard candidates
+	if ( version != 0 && version == mLastVersion && count == mLastCount &&
+		 !mLastQuery.empty() && query.size() >= mLastQuery.size() &&
+		 query.compare( 0, mLastQuery.size(), mLastQuery ) == 0 ) {
+		state->candidates = &mLastMatches;
+		state->count = mLastMatches.size();
+	} else {
+		state->count = count;
+	}
+
+	state->chunks.resize( eemax<size_t>( 1, ( state->count + mChunkSize - 1 ) / mChunkSize ) );
+
+	if ( mPool ) {
+		size_t helpers = eemin<size_t>( mPool->numThreads(), state->chunks.size() - 1 );
+		for ( size_t i = 0; i < helpers; i++ )
+			mPool->run( [state] { work( state, true ); } );
+	}
+
+	work( state, false );
+
+	std::vector<Match> matches;
+	std::vector<Uint32> matched;
+	size_t matchedCount = 0;
+	for ( const auto& chunk : state->chunks ) {
+		matches.insert( matches.end(), chunk.best.begin(), chunk.best.end() );
+		matchedCount += chunk.matched.size();
+	}
+
+	matched.reserve( matchedCount );
+	for ( const auto& chunk : state->chunks )
+		matched.insert( matched.end(), chunk.matched.begin(), chunk.matched.end() );
+
+	std::sort( matches.begin(), matches.end(), isBetter );
+	if ( matches.size() > max )
+		matches.resize( max );
+
+	mLastQuery = query;
+	mLastVersion = version;
+	mLastCount = count;
+	mLastMatches = std::move( matched );
+
+	return matches;
+}
+
+void FuzzyMatcher::work( const std::shared_ptr<State>& state, bool isHelper ) {
+	if ( isHelper ) {
+		std::lock_guard<std::mutex> lock( state->mutex );
+		/* every chunk was scored before the helper task started */
+		if ( state->finished )
+			return;
+		state->running++;
+	}
+
+	size_t chunk;
+	while ( ( chunk = state->nextChunk++ ) < state->chunks.size() ) {
+		size_t start = chunk * state->chunkSize;
+		scoreChunk( *state, state->chunks[chunk], start,
+					eemin( start + state->chunkSize, state->count ) );
+	}
+
+	std::unique_lock<std::mutex> lock( state->mutex );
+	if ( isHelper ) {
+		state->running--;
+		state->cond.notify_all();
+	} else {
+		/* the thread that started the match waits for the helpers still scoring */
+		state->finished = true;
+		state->cond.wait( lock, [&state] { return state->running == 0; } );
+	}
+}
+
+void FuzzyMatcher::scoreChunk( State& state, Chunk& chunk, size_t start, size_t end ) {
+	for ( size_t i = start; i < end; i++ ) {
+		size_t index = state.candidates ? ( *state.candidates )[i] : i;
+
+		if ( state.mask ) {
+			Uint64 mask;
+			if ( state.masks ) {
+				mask = state.masks[index];
+				if ( mask == 0 )
+					mask = state.masks[index] = ( *state.mask )( index ) | MASK_CACHED;
+			} else {
+				mask = ( *state.mask )( index );
+			}
+			if ( ( state.queryMask & ~mask ) != 0 )
+				continue;
+		}
+
+		int score = ( *state.score )( index, state.query );
+		if ( score == INT_MIN )
+			continue;
+
+		chunk.matched.push_back( index );
+
+		if ( state.max == 0 )
+			continue;
+
+		/* a heap with the worst of the best matches on top */
+		Match match{ score, index };
+		if ( chunk.best.size() < state.max ) {
+			chunk.best.push_back( match );
+			std::push_heap( chunk.best.begin(), chunk.best.end(), isBetter );
+		} else if ( isBetter( match, chunk.best.front() ) ) {
+			std::pop_heap( chunk.best.begin(), chunk.best.end(), isBetter );
+			chunk.best.back() = match;
+			std::push_heap( chunk.best.begin(), chunk.best.end(), isBetter );
+		}
+	}
+}
+
+} // namespace ecode
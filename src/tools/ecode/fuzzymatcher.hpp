@@ -0,0 +1,90 @@
+#ifndef ECODE_FUZZYMATCHER_HPP
+#define ECODE_FUZZYMATCHER_HPP
+
+#include <eepp/system/mutex.hpp>
+#include <eepp/system/threadpool.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace EE;
+using namespace EE::System;
+
+namespace ecode {
+
+/** Finds the best scored candidates of a list for a fuzzy query ( see String::fuzzyMatch ).
+ * Candidates are discarded without being scored when they don't contain every character of the
+ * query ( compared with a bitmask of the characters of each candidate ). The rest are scored in
+ * chunks spread across a thread pool, each chunk keeps only its best results in a bounded heap.
+ * The candidates that matched the last query are kept, so when the query is extended ( the user
+ * keeps typing ) only those candidates are scored again. */
+class FuzzyMatcher {
+  public:
+	/** @return The score of the candidate "index" for the query or INT_MIN if it doesn't match.
+	 * It's called concurrently from the matching threads. */
+	typedef std::function<int( size_t index, const std::string& query )> ScoreFn;
+
+	/** @return The characters mask of the candidate "index" ( see mask ). Called concurrently,
+	 * but never for the same index at the same time. The masks are cached while the version of
+	 * the candidates doesn't change. */
+	typedef std::function<Uint64( size_t index )> MaskFn;
+
+	struct Match {
+		int score;
+		size_t index;
+	};
+
+	/** @return The bitmask of the characters of a string, case insensitive and ignoring spaces */
+	static Uint64 mask( std::string_view str );
+
+	/** @param threadPool The pool where the candidates are scored, if null they are scored only
+	 * by the thread calling match. */
+	explicit FuzzyMatcher( std::shared_ptr<ThreadPool> threadPool = nullptr );
+
+	/** @return The best "max" matches sorted by score, matches with the same score are sorted by
+	 * index.
+	 * @param count The number of candidates.
+	 * @param mask If set, the candidates that don't contain the characters of the query are not
+	 * scored ( the score function must reject them, as String::fuzzyMatch does unless
+	 * allowUneven is set ).
+	 * @param version Identifies the contents of the candidates list, if it's not 0 and equals the
+	 * version of the previous call, and the query extends the previous one, only the previous
+	 * matches are scored. */
+	std::vector<Match> match( const std::string& query, size_t count, size_t max,
+							  const ScoreFn& score, const MaskFn& mask = {}, Uint64 version = 0 );
+
+	/** Forgets the matches of the previous query */
+	void reset();
+
+	/** Minimum number of candidates of each chunk scored in parallel */
+	void setChunkSize( size_t chunkSize );
+
+  protected:
+	struct Chunk {
+		std::vector<Match> best;
+		std::vector<Uint32> matched;
+	};
+
+	struct State;
+
+	std::shared_ptr<ThreadPool> mPool;
+	size_t mChunkSize{ 8192 };
+	Mutex mMutex;
+	std::string mLastQuery;
+	Uint64 mLastVersion{ 0 };
+	size_t mLastCount{ 0 };
+	/* every candidate that matched the last query, in ascending order */
+	std::vector<Uint32> mLastMatches;
+	Uint64 mMasksVersion{ 0 };
+	std::vector<Uint64> mMasks;
+
+	static void scoreChunk( State& state, Chunk& chunk, size_t start, size_t end );
+
+	static void work( const std::shared_ptr<State>& state, bool isHelper );
+};
+
+} // namespace ecode
+
+#endif // ECODE_FUZZYMATCHER_HPP
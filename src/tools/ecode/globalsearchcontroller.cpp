@@ -9,7 +9,8 @@ GlobalSearchController::GlobalSearchController( UICodeEditorSplitter* editorSpli
 												UISceneNode* sceneNode, App* app ) :
 	mSplitter( editorSplitter ), mUISceneNode( sceneNode ), mApp( app ) {
 	mApp->getPluginManager()->subscribeMessages(
-		"GlobalSearchController", [this]( const PluginMessage& msg ) -> PluginRequestHandle {
+		"GlobalSearchController", { PluginMessageType::SymbolReference },
+		[this]( const PluginMessage& msg ) -> PluginRequestHandle {
 			return processMessage( msg );
 		} );
 }
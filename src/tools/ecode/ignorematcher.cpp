@@ -18,10 +18,13 @@ GitIgnoreMatcher::GitIgnoreMatcher( const std::string& rootPath, const std::stri
 	mIgnoreFilePath( mPath + mIgnoreFileName ) {
 	if ( canMatch() ) {
 		if ( addGitFolderFilter ) {
-			if ( FileSystem::fileExists( mPath + ".git" ) ) // Also ignore the .git folder
-				mPatterns.emplace_back( std::make_pair( ".git/**", false ) );
+			if ( FileSystem::fileExists( mPath + ".git" ) ) { // Also ignore the .git folder
+				addPattern( ".git/**" );
+				mGitFolderFilter = true;
+			}
 		}
 		if ( parse() ) {
+			compile();
 			mMatcherReady = true;
 		}
 	}
@@ -39,49 +42,168 @@ bool GitIgnoreMatcher::parse() {
 	std::string patternFile;
 	FileSystem::fileGet( mPath + mIgnoreFileName, patternFile );
 	std::vector<std::string> patterns = String::split( patternFile );
-	for ( auto& pattern : patterns ) {
-		bool negates = false;
-		if ( pattern.empty() )
-			continue;
-		if ( pattern[0] == '#' )
+	for ( auto& pattern : patterns )
+		addPattern( std::move( pattern ) );
+	return !mPatterns.empty();
+}
+
+void GitIgnoreMatcher::addPattern( std::string pattern ) {
+	Pattern res;
+	pattern = String::rTrim( pattern, '\r' );
+	// Trailing spaces are ignored unless they are escaped
+	while ( !pattern.empty() && pattern.back() == ' ' &&
+			!( pattern.size() > 1 && pattern[pattern.size() - 2] == '\\' ) )
+		pattern.pop_back();
+	if ( pattern.empty() || pattern[0] == '#' )
+		return;
+	if ( pattern[0] == '!' ) {
+		res.negates = true;
+		pattern = pattern.substr( 1 );
+	}
+	if ( !pattern.empty() && pattern.back() == '/' ) {
+		res.directoryOnly = true;
+		pattern = String::rTrim( pattern, '/' );
+	}
+	if ( pattern.empty() )
+		return;
+	res.glob = std::move( pattern );
+	mPatterns.emplace_back( std::move( res ) );
+}
+
+static bool hasWildcards( std::string_view str ) {
+	return str.find_first_of( "*?[\\" ) != std::string_view::npos;
+}
+
+static void addToTable( UnorderedMap<String::HashType, std::vector<Uint32>>& table,
+						const std::string& literal, Uint32 index ) {
+	table[String::hash( literal.data(), literal.size() )].push_back( index );
+}
+
+static void addLength( std::vector<size_t>& lengths, size_t length ) {
+	if ( std::find( lengths.begin(), lengths.end(), length ) == lengths.end() )
+		lengths.push_back( length );
+}
+
+void GitIgnoreMatcher::compile() {
+	Int64 lastNegation = -1;
+	for ( Uint32 i = 0; i < mPatterns.size(); i++ ) {
+		if ( mPatterns[i].negates )
+			lastNegation = i;
+	}
+
+	for ( Uint32 i = 0; i < mPatterns.size(); i++ ) {
+		Pattern& pattern = mPatterns[i];
+		std::string_view glob( pattern.glob );
+
+		// "**/name" matches the same as "name"
+		if ( String::startsWith( glob, "**/" ) && glob.find( '/', 3 ) == std::string_view::npos )
+			glob = glob.substr( 3 );
+
+		if ( glob.find( '/' ) == std::string_view::npos ) {
+			// Matches the file name
+			if ( !hasWildcards( glob ) ) {
+				pattern.literal = glob;
+				addToTable( mNames, pattern.literal, i );
+				continue;
+			}
+			if ( glob.size() > 1 && glob[0] == '*' && !hasWildcards( glob.substr( 1 ) ) ) {
+				pattern.literal = glob.substr( 1 );
+				addToTable( mSuffixes, pattern.literal, i );
+				addLength( mSuffixLengths, pattern.literal.size() );
+				continue;
+			}
+			if ( glob.size() > 1 && glob.back() == '*' &&
+				 !hasWildcards( glob.substr( 0, glob.size() - 1 ) ) ) {
+				pattern.literal = glob.substr( 0, glob.size() - 1 );
+				addToTable( mPrefixes, pattern.literal, i );
+				addLength( mPrefixLengths, pattern.literal.size() );
+				continue;
+			}
+		} else if ( !hasWildcards( glob ) ) {
+			// Matches the path relative to the ignore file directory
+			pattern.literal = glob[0] == '/' ? glob.substr( 1 ) : glob;
+			addToTable( mPaths, pattern.literal, i );
 			continue;
-		pattern = String::rTrim( pattern, ' ' );
-		pattern = String::rTrim( pattern, '\r' );
-		if ( pattern[0] == '!' ) {
-			negates = true;
-			pattern = String::lTrim( pattern, '!' );
 		}
-		pattern = String::rTrim( pattern, '/' );
-		mPatterns.emplace_back( std::make_pair( pattern, negates ) );
+
+		if ( glob.size() > 3 && glob.substr( glob.size() - 3 ) == "/**" &&
+			 ( i > lastNegation || ( i == 0 && mGitFolderFilter ) ) ) {
+			// Keeps it relative to the ignore file directory
+			pattern.contentsOf = glob.substr( 0, glob.size() - 3 );
+			if ( pattern.contentsOf.find( '/' ) == std::string::npos )
+				pattern.contentsOf.insert( 0, "/" );
+		}
+
+		mGlobs.push_back( i );
+	}
+
+	std::reverse( mGlobs.begin(), mGlobs.end() );
+}
+
+void GitIgnoreMatcher::find( const PatternTable& table, std::string_view key, bool isDirectory,
+							 Int64& best ) const {
+	auto it = table.find( String::hash( key.data(), key.size() ) );
+	if ( it == table.end() )
+		return;
+	const auto& indexes = it->second;
+	for ( auto index = indexes.rbegin(); index != indexes.rend() && *index > best; ++index ) {
+		const Pattern& pattern = mPatterns[*index];
+		if ( ( isDirectory || !pattern.directoryOnly ) && pattern.literal == key ) {
+			best = *index;
+			return;
+		}
 	}
-	return !mPatterns.empty();
 }
 
 bool GitIgnoreMatcher::match( const std::string& value ) const {
-	if ( mPatterns.empty() )
-		return false;
-	bool match = false;
-	for ( size_t i = 0; i < mPatterns.size(); i++ ) {
-		auto& pattern = mPatterns[i];
-		match = String::globMatch( value, pattern.first );
-		if ( pattern.second )
-			match = !match;
-		if ( match && !pattern.second ) {
-			if ( i + 1 < mPatterns.size() && mPatterns[i + 1].second ) {
-				for ( size_t n = i + 1; n < mPatterns.size(); n++ ) {
-					// Check if there's a positive negate after the match
-					if ( mPatterns[n].second ) {
-						if ( String::globMatch( value, mPatterns[n].first ) )
-							return false;
-					} else {
-						break;
-					}
-				}
-			}
-			return true;
+	return match( value, true, false ) == Result::Ignored;
+}
+
+IgnoreMatcher::Result GitIgnoreMatcher::match( std::string_view path, bool isDirectory ) const {
+	return match( path, isDirectory, true );
+}
+
+IgnoreMatcher::Result GitIgnoreMatcher::match( std::string_view path, bool isDirectory,
+											   bool pruneContents ) const {
+	if ( mPatterns.empty() || path.empty() )
+		return Result::None;
+
+	size_t sep = path.rfind( '/' );
+	std::string_view name( sep != std::string_view::npos ? path.substr( sep + 1 ) : path );
+	Int64 best = -1;
+
+	find( mNames, name, isDirectory, best );
+	find( mPaths, path, isDirectory, best );
+
+	for ( const auto& length : mSuffixLengths ) {
+		if ( length <= name.size() )
+			find( mSuffixes, name.substr( name.size() - length ), isDirectory, best );
+	}
+
+	for ( const auto& length : mPrefixLengths ) {
+		if ( length <= name.size() )
+			find( mPrefixes, name.substr( 0, length ), isDirectory, best );
+	}
+
+	// Only the globs that would take precedence over the best match found are evaluated
+	for ( const auto& index : mGlobs ) {
+		if ( (Int64)index <= best )
+			break;
+		const Pattern& pattern = mPatterns[index];
+		if ( !isDirectory && pattern.directoryOnly )
+			continue;
+		if ( String::globMatch( path, pattern.glob ) ||
+			 ( isDirectory && pruneContents && !pattern.contentsOf.empty() &&
+			   String::globMatch( path, pattern.contentsOf ) ) ) {
+			best = index;
+			break;
 		}
 	}
-	return false;
+
+	if ( best < 0 )
+		return Result::None;
+
+	return mPatterns[best].negates ? Result::Included : Result::Ignored;
 }
 
 std::string GitIgnoreMatcher::findRepositoryRootPath() const {
@@ -124,28 +246,34 @@ bool IgnoreMatcherManager::foundMatch() const {
 }
 
 bool IgnoreMatcherManager::match( const FileInfo& file ) const {
+	return match( file.getFilepath(), file.isDirectory() );
+}
+
+bool IgnoreMatcherManager::match( const std::string& path, bool isDirectory ) const {
 	eeASSERT( foundMatch() );
-	auto dirPath( file.getDirectoryPath() );
-	std::string localPath;
-	for ( const auto& matcher : mMatchers ) {
-		localPath.clear();
-		if ( String::startsWith( dirPath, matcher->getPath() ) )
-			localPath = dirPath.substr( matcher->getPath().size() );
-		if ( matcher->match( localPath + file.getFileName() ) )
+	std::string_view fullPath( path );
+	while ( !fullPath.empty() && fullPath.back() == '/' )
+		fullPath.remove_suffix( 1 );
+	if ( !String::startsWith( fullPath, mMatchers.front()->getPath() ) )
+		return match( mMatchers, fullPath, isDirectory );
+	// A file can't be included again if one of its parent directories is ignored
+	for ( size_t sep = fullPath.find( '/', mMatchers.front()->getPath().size() );
+		  sep != std::string_view::npos; sep = fullPath.find( '/', sep + 1 ) ) {
+		if ( match( mMatchers, fullPath.substr( 0, sep ), true ) )
 			return true;
 	}
-	return false;
+	return match( mMatchers, fullPath, isDirectory );
 }
 
-bool IgnoreMatcherManager::match( const std::string& dir, const std::string& value ) const {
-	eeASSERT( foundMatch() );
-	std::string localPath;
-	for ( const auto& matcher : mMatchers ) {
-		localPath.clear();
-		if ( String::startsWith( dir, matcher->getPath() ) )
-			localPath = dir.substr( matcher->getPath().size() );
-		if ( matcher->match( localPath + value ) )
-			return true;
+bool IgnoreMatcherManager::match( const std::vector<IgnoreMatcher*>& matchers,
+								  std::string_view path, bool isDirectory ) {
+	for ( auto it = matchers.rbegin(); it != matchers.rend(); ++it ) {
+		const std::string& matcherPath = ( *it )->getPath();
+		if ( path.size() <= matcherPath.size() || !String::startsWith( path, matcherPath ) )
+			continue;
+		auto res = ( *it )->match( path.substr( matcherPath.size() ), isDirectory );
+		if ( res != IgnoreMatcher::Result::None )
+			return res == IgnoreMatcher::Result::Ignored;
 	}
 	return false;
 }
@@ -1,8 +1,11 @@
 #ifndef ECODE_IGNOREMATCHER_HPP
 #define ECODE_IGNOREMATCHER_HPP
 
+#include <eepp/core/containers.hpp>
+#include <eepp/core/string.hpp>
 #include <eepp/system/fileinfo.hpp>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace EE;
@@ -12,14 +15,25 @@ namespace ecode {
 
 class IgnoreMatcher {
   public:
+	enum class Result {
+		None,	  // no pattern matches the path
+		Ignored,  // the last pattern that matches ignores the path
+		Included, // the last pattern that matches is a negation
+	};
+
 	IgnoreMatcher( const std::string& rootPath );
 
 	virtual ~IgnoreMatcher();
 
 	virtual bool canMatch() = 0;
 
+	/** Matches a path relative to getPath() whose type is unknown, so the patterns that only apply
+	 * to directories also apply to it. */
 	virtual bool match( const std::string& value ) const = 0;
 
+	/** Matches a path relative to getPath() ( without a trailing slash ). */
+	virtual Result match( std::string_view path, bool isDirectory ) const = 0;
+
 	virtual std::string findRepositoryRootPath() const = 0;
 
 	virtual const std::string& getIgnoreFilePath() const = 0;
@@ -47,14 +61,53 @@ class GitIgnoreMatcher : public IgnoreMatcher {
 
 	bool match( const std::string& value ) const override;
 
+	/** The last pattern that matches the path decides the result, as git does. A directory is
+	 * also ignored by a pattern that matches all its contents ( its path followed by "**" ) when
+	 * no negation follows it, or by the .git folder filter, so it doesn't need to be scanned. */
+	Result match( std::string_view path, bool isDirectory ) const override;
+
 	std::string findRepositoryRootPath() const override;
 
   protected:
+	struct Pattern {
+		std::string glob;
+		/* the text compared by the literal, prefix and suffix tables */
+		std::string literal;
+		/* the directory of a pattern that matches all its contents ( the directory followed by
+		 * "**" ) and that no negation can include again */
+		std::string contentsOf;
+		bool negates{ false };
+		bool directoryOnly{ false };
+	};
+
+	/* indexes of the patterns with the same literal hash, in ascending order */
+	typedef UnorderedMap<String::HashType, std::vector<Uint32>> PatternTable;
+
 	std::string mIgnoreFileName;
 	std::string mIgnoreFilePath;
-	std::vector<std::pair<std::string, bool>> mPatterns;
+	std::vector<Pattern> mPatterns;
+	/* the patterns are compiled into hash tables of literal file names, literal paths, file name
+	 * prefixes ( "name*" ) and suffixes ( "*.ext" ), anything else is a glob */
+	PatternTable mNames;
+	PatternTable mPaths;
+	PatternTable mPrefixes;
+	PatternTable mSuffixes;
+	std::vector<size_t> mPrefixLengths;
+	std::vector<size_t> mSuffixLengths;
+	/* indexes of the glob patterns, in descending order */
+	std::vector<Uint32> mGlobs;
+	bool mGitFolderFilter{ false };
 
 	bool parse() override;
+
+	void addPattern( std::string pattern );
+
+	void compile();
+
+	void find( const PatternTable& table, std::string_view key, bool isDirectory,
+			   Int64& best ) const;
+
+	Result match( std::string_view path, bool isDirectory, bool pruneContents ) const;
 };
 
 class IgnoreMatcherManager {
@@ -71,7 +124,15 @@ class IgnoreMatcherManager {
 
 	bool match( const FileInfo& file ) const;
 
-	bool match( const std::string& dir, const std::string& value ) const;
+	/** Matches a full path and each of its parent directories up to the repository root, a file
+	 * inside an ignored directory is ignored. */
+	bool match( const std::string& path, bool isDirectory ) const;
+
+	/** Matches a full path ( without a trailing slash ) against a list of matchers, ordered from
+	 * the outermost to the innermost directory. The innermost matcher with a pattern that matches
+	 * decides, its parent directories are not matched. */
+	static bool match( const std::vector<IgnoreMatcher*>& matchers, std::string_view path,
+					   bool isDirectory );
 
 	std::string findRepositoryRootPath() const;
 
@@ -11,7 +11,8 @@ namespace ecode {
 NotificationCenter::NotificationCenter( UILayout* layout, PluginManager* pluginManager ) :
 	mLayout( layout ), mPluginManager( pluginManager ) {
 	mPluginManager->subscribeMessages(
-		"notificationcenter", [this]( const PluginMessage& msg ) -> PluginRequestHandle {
+		"notificationcenter", { PluginMessageType::ShowMessage, PluginMessageType::ShowDocument },
+		[this]( const PluginMessage& msg ) -> PluginRequestHandle {
 			if ( !msg.isBroadcast() )
 				return {};
 			if ( msg.type == PluginMessageType::ShowMessage ) {
@@ -90,10 +90,15 @@ AutoCompletePlugin::AutoCompletePlugin( PluginManager* pluginManager, bool sync
 	Plugin( pluginManager ),
 	mSymbolPattern( "[%a_ñàáâãäåèéêëìíîïòóôõöùúûüýÿÑÀÁÂÃÄÅÈÉÊËÌÍÎÏÒÓÔÕÖÙÚÛÜÝ][%w_"
 					"ñàáâãäåèéêëìíîïòóôõöùúûüýÿÑÀÁÂÃÄÅÈÉÊËÌÍÎÏÒÓÔÕÖÙÚÛÜÝ]*" ),
+	mWordIndex( mSymbolPattern ),
 	mBoxPadding( PixelDensity::dpToPx( Rectf( 4, 4, 12, 4 ) ) ) {
-	mManager->subscribeMessages( this, [this]( const PluginMessage& msg ) -> PluginRequestHandle {
-		return processResponse( msg );
-	} );
+	mManager->subscribeMessages(
+		this,
+		{ PluginMessageType::UIReady, PluginMessageType::CodeCompletion,
+		  PluginMessageType::SignatureHelp, PluginMessageType::LanguageServerCapabilities },
+		[this]( const PluginMessage& msg ) -> PluginRequestHandle {
+			return processResponse( msg );
+		} );
 	if ( sync ) {
 		load( pluginManager );
 	} else {
@@ -113,8 +118,7 @@ AutoCompletePlugin::~AutoCompletePlugin() {
 
 	{
 		Lock l( mDocMutex );
-		Lock l2( mLangSymbolsMutex );
-		Lock l3( mSuggestionsMutex );
+		Lock l2( mSuggestionsMutex );
 		for ( const auto& editor : mEditors ) {
 			for ( auto listener : editor.second )
 				editor.first->removeEventListener( listener );
@@ -248,20 +252,15 @@ void AutoCompletePlugin::onRegister( UICodeEditor* editor ) {
 	std::vector<Uint32> listeners;
 	listeners.push_back(
 		editor->addEventListener( Event::OnDocumentLoaded, [this, editor]( const Event* ) {
-			mDirty = true;
-			mDocs.insert( editor->getDocumentRef().get() );
+			addDocument( editor->getDocumentRef().get() );
 			mEditorDocs[editor] = editor->getDocumentRef().get();
 			tryRequestCapabilities( editor );
 		} ) );
 
 	listeners.push_back(
 		editor->addEventListener( Event::OnDocumentClosed, [this]( const Event* event ) {
-			Lock l( mDocMutex );
 			const DocEvent* docEvent = static_cast<const DocEvent*>( event );
-			TextDocument* doc = docEvent->getDoc();
-			mDocs.erase( doc );
-			mDocCache.erase( doc );
-			mDirty = true;
+			removeDocument( docEvent->getDoc() );
 		} ) );
 
 	listeners.push_back(
@@ -269,10 +268,11 @@ void AutoCompletePlugin::onRegister( UICodeEditor* editor ) {
 			TextDocument* oldDoc = mEditorDocs[editor];
 			TextDocument* newDoc = editor->getDocumentRef().get();
 			Lock l( mDocMutex );
-			mDocs.erase( oldDoc );
-			mDocCache.erase( oldDoc );
 			mEditorDocs[editor] = newDoc;
-			mDirty = true;
+			if ( std::none_of( mEditorDocs.begin(), mEditorDocs.end(),
+							   [oldDoc]( const auto& ed ) { return ed.second == oldDoc; } ) )
+				removeDocument( oldDoc );
+			addDocument( newDoc );
 		} ) );
 
 	listeners.push_back( editor->addEventListener( Event::OnCursorPosChange, [this, editor](
@@ -293,26 +293,13 @@ void AutoCompletePlugin::onRegister( UICodeEditor* editor ) {
 	listeners.push_back( editor->addEventListener(
 		Event::OnDocumentUndoRedo, [this]( const Event* ) { resetSignatureHelp(); } ) );
 
+	// The document words are moved to the new language with the next update
 	listeners.push_back( editor->addEventListener(
-		Event::OnDocumentSyntaxDefinitionChange, [this]( const Event* ev ) {
-			const DocSyntaxDefEvent* event = static_cast<const DocSyntaxDefEvent*>( ev );
-			std::string oldLang = event->getOldLang();
-			std::string newLang = event->getNewLang();
-#if defined( AUTO_COMPLETE_THREADED ) && AUTO_COMPLETE_THREADED == 1
-			mThreadPool->run( [this, oldLang, newLang] {
-				updateLangCache( oldLang );
-				updateLangCache( newLang );
-			} );
-#else
-			updateLangCache( oldLang );
-			updateLangCache( newLang );
-#endif
-		} ) );
+		Event::OnDocumentSyntaxDefinitionChange, [this]( const Event* ) { mDirty = true; } ) );
 
 	mEditors.insert( { editor, listeners } );
-	mDocs.insert( editor->getDocumentRef().get() );
+	addDocument( editor->getDocumentRef().get() );
 	mEditorDocs[editor] = editor->getDocumentRef().get();
-	mDirty = true;
 }
 
 void AutoCompletePlugin::onUnregister( UICodeEditor* editor ) {
@@ -332,8 +319,20 @@ void AutoCompletePlugin::onUnregister( UICodeEditor* editor ) {
 	for ( auto ceditor : mEditorDocs )
 		if ( ceditor.second == doc )
 			return;
+	removeDocument( doc );
+}
+
+void AutoCompletePlugin::addDocument( TextDocument* doc ) {
+	Lock l( mDocMutex );
+	mDocs.insert( doc );
+	mWordIndex.addDocument( doc );
+	mDirty = true;
+}
+
+void AutoCompletePlugin::removeDocument( TextDocument* doc ) {
+	Lock l( mDocMutex );
 	mDocs.erase( doc );
-	mDocCache.erase( doc );
+	mWordIndex.removeDocument( doc );
 	mDirty = true;
 }
 
@@ -542,7 +541,8 @@ bool AutoCompletePlugin::onTextInput( UICodeEditor* editor, const TextInputEvent
 	return false;
 }
 
-void AutoCompletePlugin::updateDocCache( TextDocument* doc ) {
+void AutoCompletePlugin::updateDocCache( WordIndex::Changes&& changes ) {
+	TextDocument* doc = changes.doc;
 	ScopedOp op(
 		[this, doc] {
 			Lock lu( mDocsUpdatingMutex );
@@ -553,55 +553,15 @@ void AutoCompletePlugin::updateDocCache( TextDocument* doc ) {
 			mDocsUpdating[doc] = false;
 		} );
 
-	Clock clock;
-	std::unordered_map<TextDocument*, DocCache>::iterator docCache;
-	{
-		Lock l( mDocMutex );
-		docCache = mDocCache.find( doc );
-		if ( docCache == mDocCache.end() || mShuttingDown )
-			return;
-	}
-
-	auto changeId = doc->getCurrentChangeId();
-	auto symbols = getDocumentSymbols( doc );
-
-	{
-		Lock l( mDocMutex );
-		docCache = mDocCache.find( doc );
-		if ( docCache == mDocCache.end() || mShuttingDown )
-			return;
-		auto& cache = docCache->second;
-		cache.changeId = changeId;
-		cache.symbols = std::move( symbols );
-	}
-
-	std::string langName( doc->getSyntaxDefinition().getLanguageName() );
-	{
-		Lock l( mLangSymbolsMutex );
-		auto& lang = mLangCache[langName];
-		lang.clear();
-		Lock l2( mDocMutex );
-		for ( const auto& d : mDocCache ) {
-			if ( d.first->getSyntaxDefinition().getLanguageName() == langName )
-				lang.insert( lang.end(), d.second.symbols.begin(), d.second.symbols.end() );
-		}
-	}
-	Log::debug( "Dictionary for %s updated in: %.2fms", doc->getFilename().c_str(),
-				clock.getElapsedTime().asMilliseconds() );
-}
+	if ( mShuttingDown )
+		return;
 
-void AutoCompletePlugin::updateLangCache( const std::string& langName ) {
 	Clock clock;
-	Lock l( mLangSymbolsMutex );
-	Lock l2( mDocMutex );
-	auto& lang = mLangCache[langName];
-	lang.clear();
-	for ( const auto& d : mDocCache ) {
-		if ( d.first->getSyntaxDefinition().getLanguageName() == langName )
-			lang.insert( lang.end(), d.second.symbols.begin(), d.second.symbols.end() );
-	}
-	Log::debug( "Lang dictionary for %s updated in: %.2fms", langName.c_str(),
-				clock.getElapsedTime().asMilliseconds() );
+	std::string langName( changes.language );
+	size_t linesCount = changes.lines.size();
+	mWordIndex.apply( std::move( changes ) );
+	Log::debug( "Dictionary for %s updated ( %zu lines ) in: %.2fms", langName.c_str(),
+				linesCount, clock.getElapsedTime().asMilliseconds() );
 }
 
 void AutoCompletePlugin::pickSuggestion( UICodeEditor* editor ) {
@@ -776,23 +736,14 @@ AutoCompletePlugin::processCodeCompletion( const LSPCompletionList& completion )
 		return {};
 	std::string symbol( getPartialSymbol( editor->getDocumentRef().get() ) );
 	const std::string& lang = editor->getDocument().getSyntaxDefinition().getLanguageName();
-	bool hasLangSuggestions = false;
-	{
-		Lock l2( mLangSymbolsMutex );
-		auto langSuggestions = mLangCache.find( lang );
-		hasLangSuggestions = langSuggestions != mLangCache.end();
-	}
-	if ( symbol.empty() || !hasLangSuggestions ) {
+	if ( symbol.empty() || !mWordIndex.hasLanguage( lang ) ) {
 		Lock l( mSuggestionsMutex );
 		mSuggestions = suggestions;
 	} else {
-		SymbolsList fuzzySuggestions;
-		{
-			Lock l2( mLangSymbolsMutex );
-			auto& symbols = mLangCache[lang];
-			fuzzySuggestions = fuzzyMatchSymbols( { &suggestions, &symbols }, symbol,
-												  eemax<size_t>( 100UL, suggestions.size() ) );
-		}
+		SymbolsList words( getWordSuggestions( lang, symbol, mSuggestionsMaxVisible ) );
+		SymbolsList fuzzySuggestions = fuzzyMatchSymbols(
+			{ &suggestions, &words }, symbol,
+			eemax<size_t>( mSuggestionsMaxVisible, suggestions.size() ) );
 
 		if ( fuzzySuggestions.empty() && !suggestions.empty() ) {
 			for ( const auto& suggestion : suggestions )
@@ -903,20 +854,20 @@ void AutoCompletePlugin::update( UICodeEditor* ) {
 		mDirty = false;
 		Lock l( mDocMutex );
 		for ( auto& doc : mDocs ) {
-			if ( !doc->isLoading() && mDocCache[doc].changeId != doc->getCurrentChangeId() ) {
-				{
-					Lock lu( mDocsUpdatingMutex );
-					auto du = mDocsUpdating.find( doc );
-					// Dont update the document cache if it's still updating the document
-					if ( du != mDocsUpdating.end() && du->second == true )
-						continue;
-				}
+			// A document is not dirty while its previous changes are still being indexed
+			if ( doc->isLoading() || !mWordIndex.isDirty( doc ) )
+				continue;
+			// Only the lines modified since the last update are copied
+			auto changes = mWordIndex.collectChanges( doc );
+			if ( changes.empty() )
+				continue;
 #if AUTO_COMPLETE_THREADED
-				mThreadPool->run( [this, doc] { updateDocCache( doc ); } );
+			mThreadPool->run( [this, changes = std::move( changes )]() mutable {
+				updateDocCache( std::move( changes ) );
+			} );
 #else
-				updateDocCache( doc );
+			updateDocCache( std::move( changes ) );
 #endif
-			}
 		}
 	}
 }
@@ -1269,6 +1220,7 @@ const std::string& AutoCompletePlugin::getSymbolPattern() const {
 
 void AutoCompletePlugin::setSymbolPattern( const std::string& symbolPattern ) {
 	mSymbolPattern = symbolPattern;
+	mWordIndex.setWordPattern( symbolPattern );
 }
 
 bool AutoCompletePlugin::isDirty() const {
@@ -1304,38 +1256,19 @@ void AutoCompletePlugin::resetSignatureHelp() {
 	mSignatureHelpEditor = nullptr;
 }
 
-AutoCompletePlugin::SymbolsList AutoCompletePlugin::getDocumentSymbols( TextDocument* doc ) {
-	static constexpr auto MAX_LINE_LENGTH = EE_1KB * 10;
-	LuaPattern pattern( mSymbolPattern );
-	AutoCompletePlugin::SymbolsList symbols;
-	if ( doc->linesCount() == 0 || doc->isHuge() || mShuttingDown )
-		return symbols;
-	std::string current( getPartialSymbol( doc ) );
-	TextPosition end = doc->getSelection().end();
-	for ( Int64 i = 0; i < static_cast<Int64>( doc->linesCount() ); i++ ) {
-		const auto& line = doc->line( i );
-		if ( line.size() > MAX_LINE_LENGTH )
-			continue;
-		auto string = line.toUtf8();
-		for ( auto& match : pattern.gmatch( string ) ) {
-			std::string matchStr( match[0] );
-			// Ignore the symbol if is actually the current symbol being written
-			if ( matchStr.size() < 3 || ( end.line() == i && current == matchStr ) )
-				continue;
-			if ( std::none_of( symbols.begin(), symbols.end(),
-							   [matchStr]( const Suggestion& suggestion ) {
-								   return suggestion.text == matchStr;
-							   } ) )
-				symbols.push_back( std::move( matchStr ) );
-		}
-		if ( mShuttingDown )
-			break;
+AutoCompletePlugin::SymbolsList
+AutoCompletePlugin::getWordSuggestions( const std::string& lang, const std::string& symbol,
+										size_t max ) {
+	SymbolsList suggestions;
+	for ( auto& match : mWordIndex.match( lang, symbol, max ) ) {
+		suggestions.emplace_back( match.text );
+		suggestions.back().score = match.score;
 	}
-	return symbols;
+	return suggestions;
 }
 
 void AutoCompletePlugin::runUpdateSuggestions( const std::string& symbol,
-											   const SymbolsList& symbols, UICodeEditor* editor ) {
+											   const std::string& lang, UICodeEditor* editor ) {
 	{
 		{
 			Lock l( mSuggestionsEditorMutex );
@@ -1343,30 +1276,25 @@ void AutoCompletePlugin::runUpdateSuggestions( const std::string& symbol,
 		}
 		if ( tryRequestCapabilities( editor ) )
 			requestCodeCompletion( editor );
-		if ( symbol.empty() || symbols.empty() )
+		if ( symbol.empty() )
 			return;
-		Lock l( mLangSymbolsMutex );
-		Lock l2( mSuggestionsMutex );
-		mSuggestions = fuzzyMatchSymbols( { &symbols }, symbol, mSuggestionsMaxVisible );
+		SymbolsList words( getWordSuggestions( lang, symbol, mSuggestionsMaxVisible ) );
+		Lock l( mSuggestionsMutex );
+		mSuggestions = std::move( words );
 	}
 	editor->runOnMainThread( [editor] { editor->invalidateDraw(); } );
 }
 
 void AutoCompletePlugin::updateSuggestions( const std::string& symbol, UICodeEditor* editor ) {
-	const std::string& lang = editor->getDocument().getSyntaxDefinition().getLanguageName();
-	Lock l( mLangSymbolsMutex );
-	auto langSuggestions = mLangCache.find( lang );
-	if ( langSuggestions == mLangCache.end() )
+	std::string lang( editor->getDocument().getSyntaxDefinition().getLanguageName() );
+	if ( !mWordIndex.hasLanguage( lang ) )
 		return;
-	const auto& symbols = langSuggestions->second;
-	{
 #if AUTO_COMPLETE_THREADED
-		mThreadPool->run(
-			[this, symbol, &symbols, editor] { runUpdateSuggestions( symbol, symbols, editor ); } );
+	mThreadPool->run(
+		[this, symbol, lang, editor] { runUpdateSuggestions( symbol, lang, editor ); } );
 #else
-		runUpdateSuggestions( symbol, symbols, editor );
+	runUpdateSuggestions( symbol, lang, editor );
 #endif
-	}
 }
 
 } // namespace ecode
@@ -4,6 +4,7 @@
 #include "../lsp/lspprotocol.hpp"
 #include "../plugin.hpp"
 #include "../pluginmanager.hpp"
+#include "wordindex.hpp"
 #include <eepp/config.hpp>
 #include <eepp/system/clock.hpp>
 #include <eepp/system/mutex.hpp>
@@ -115,9 +116,9 @@ class AutoCompletePlugin : public Plugin {
 
   protected:
 	std::string mSymbolPattern;
+	WordIndex mWordIndex;
 	Rectf mBoxPadding;
 	Clock mClock;
-	Mutex mLangSymbolsMutex;
 	Mutex mSuggestionsMutex;
 	Mutex mDocMutex;
 	Time mUpdateFreq{ Seconds( 5 ) };
@@ -128,12 +129,6 @@ class AutoCompletePlugin : public Plugin {
 	bool mReplacing{ false };
 	bool mSignatureHelpVisible{ false };
 	bool mHighlightSuggestions{ false };
-	struct DocCache {
-		Uint64 changeId{ static_cast<Uint64>( -1 ) };
-		SymbolsList symbols;
-	};
-	std::unordered_map<TextDocument*, DocCache> mDocCache;
-	std::unordered_map<std::string, SymbolsList> mLangCache;
 	std::vector<Suggestion> mSuggestions;
 	Mutex mSuggestionsEditorMutex;
 	Mutex mSignatureHelpEditorMutex;
@@ -168,17 +163,20 @@ class AutoCompletePlugin : public Plugin {
 
 	void updateSuggestions( const std::string& symbol, UICodeEditor* editor );
 
-	SymbolsList getDocumentSymbols( TextDocument* );
+	SymbolsList getWordSuggestions( const std::string& lang, const std::string& symbol,
+									size_t max );
+
+	void addDocument( TextDocument* doc );
 
-	void updateDocCache( TextDocument* doc );
+	void removeDocument( TextDocument* doc );
+
+	void updateDocCache( WordIndex::Changes&& changes );
 
 	std::string getPartialSymbol( TextDocument* doc );
 
-	void runUpdateSuggestions( const std::string& symbol, const SymbolsList& symbols,
+	void runUpdateSuggestions( const std::string& symbol, const std::string& lang,
 							   UICodeEditor* editor );
 
-	void updateLangCache( const std::string& langName );
-
 	void pickSuggestion( UICodeEditor* editor );
 
 	PluginRequestHandle processResponse( const PluginMessage& msg );
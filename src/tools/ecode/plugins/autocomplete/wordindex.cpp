@@ -0,0 +1,341 @@
+#include "wordindex.hpp"
+#include <algorithm>
+#include <climits>
+#include <eepp/system/lock.hpp>
+#include <eepp/system/luapattern.hpp>
+
+namespace ecode {
+
+static constexpr Int64 UNMODIFIED = std::numeric_limits<Int64>::max();
+
+void WordIndex::Client::onDocumentLineChanged( const Int64& lineIndex ) {
+	// Lines are only inserted or removed after the modified line, so the lines before it and the
+	// lines after the last modified line ( counting from the end ) keep their contents
+	Lock l( mMutex );
+	mFirst = eemin( mFirst, lineIndex );
+	mLast = eemin( mLast, static_cast<Int64>( mDoc->linesCount() ) - 1 - lineIndex );
+}
+
+void WordIndex::Client::onDocumentClosed( TextDocument* ) {
+	Lock l( mMutex );
+	mClosed = true;
+}
+
+void WordIndex::Client::invalidate() {
+	Lock l( mMutex );
+	mReset = true;
+}
+
+bool WordIndex::Client::isClosed() const {
+	Lock l( mMutex );
+	return mClosed;
+}
+
+bool WordIndex::Client::isModified() const {
+	Lock l( mMutex );
+	return mReset || mFirst != UNMODIFIED;
+}
+
+void WordIndex::Client::takeChanges( Int64& first, Int64& last, bool& reset ) {
+	Lock l( mMutex );
+	first = mFirst;
+	last = mLast;
+	reset = mReset;
+	mFirst = mLast = UNMODIFIED;
+	mReset = false;
+}
+
+WordIndex::WordIndex( const std::string& wordPattern, size_t minWordLength ) :
+	mWordPattern( wordPattern ), mMinWordLength( minWordLength ) {}
+
+WordIndex::~WordIndex() {
+	Lock l( mMutex );
+	for ( auto& document : mDocuments ) {
+		if ( !document.second.client->isClosed() )
+			document.first->unregisterClient( document.second.client.get() );
+	}
+}
+
+void WordIndex::addDocument( TextDocument* doc ) {
+	Lock l( mMutex );
+	if ( mDocuments.find( doc ) != mDocuments.end() )
+		return;
+	Document& document = mDocuments[doc];
+	document.client = std::make_unique<Client>( doc );
+	document.serial = ++mLastSerial;
+	doc->registerClient( document.client.get() );
+}
+
+void WordIndex::removeDocument( TextDocument* doc ) {
+	Lock l( mMutex );
+	auto it = mDocuments.find( doc );
+	if ( it == mDocuments.end() )
+		return;
+	Document& document = it->second;
+	removeLines( document, 0, document.lines.size() );
+	if ( !document.client->isClosed() )
+		doc->unregisterClient( document.client.get() );
+	mDocuments.erase( it );
+}
+
+bool WordIndex::hasDocument( TextDocument* doc ) const {
+	Lock l( mMutex );
+	return mDocuments.find( doc ) != mDocuments.end();
+}
+
+bool WordIndex::isDirty( TextDocument* doc ) const {
+	Lock l( mMutex );
+	auto it = mDocuments.find( doc );
+	if ( it == mDocuments.end() || it->second.pending || it->second.client->isClosed() )
+		return false;
+	return it->second.client->isModified() ||
+		   it->second.language != doc->getSyntaxDefinition().getLanguageName();
+}
+
+WordIndex::Changes WordIndex::collectChanges( TextDocument* doc ) {
+	Changes changes;
+	Lock l( mMutex );
+	auto it = mDocuments.find( doc );
+	if ( it == mDocuments.end() || it->second.pending || it->second.client->isClosed() )
+		return changes;
+
+	Document& document = it->second;
+	std::string language( doc->getSyntaxDefinition().getLanguageName() );
+	Int64 first, last;
+	bool reset;
+	document.client->takeChanges( first, last, reset );
+
+	if ( !reset && first == UNMODIFIED && language == document.language )
+		return changes;
+
+	Int64 indexed = document.lines.size();
+	Int64 count = doc->isHuge() ? 0 : doc->linesCount();
+	Int64 end = 0;
+
+	if ( !reset && first != UNMODIFIED ) {
+		if ( first > eemin( indexed, count ) ) {
+			reset = true;
+		} else {
+			last = eemin( last, eemin( indexed, count ) - first );
+			changes.start = first;
+			changes.removed = indexed - first - last;
+			end = count - last;
+		}
+	}
+
+	if ( reset || doc->isHuge() ) {
+		changes.reset = true;
+		changes.start = 0;
+		changes.removed = indexed;
+		end = count;
+	}
+
+	changes.lines.reserve( end - changes.start );
+	for ( Int64 i = changes.start; i < end; i++ ) {
+		const auto& line = doc->line( i );
+		changes.lines.emplace_back( line.size() > MAX_LINE_LENGTH ? std::string()
+																  : line.toUtf8() );
+	}
+
+	changes.doc = doc;
+	changes.serial = document.serial;
+	changes.language = std::move( language );
+	document.pending = true;
+	return changes;
+}
+
+void WordIndex::apply( Changes&& changes ) {
+	if ( changes.empty() )
+		return;
+
+	std::string wordPattern;
+	{
+		Lock l( mMutex );
+		wordPattern = mWordPattern;
+	}
+
+	auto lineWords = tokenize( changes.lines, wordPattern );
+
+	Lock l( mMutex );
+	auto it = mDocuments.find( changes.doc );
+	if ( it == mDocuments.end() || it->second.serial != changes.serial )
+		return;
+
+	Document& document = it->second;
+	document.pending = false;
+	setDocumentLanguage( document, changes.language );
+	Language& language = *mLanguages[document.language];
+
+	// The new words are added before removing the old ones, so the words that are still used don't
+	// leave the index
+	std::vector<std::vector<Uint32>> lines( lineWords.size() );
+	for ( size_t i = 0; i < lineWords.size(); i++ ) {
+		lines[i].reserve( lineWords[i].size() );
+		for ( const auto& word : lineWords[i] )
+			lines[i].push_back( addWord( language, word ) );
+	}
+
+	removeLines( document, changes.start, changes.start + changes.removed );
+	document.lines.erase( document.lines.begin() + changes.start,
+						  document.lines.begin() + changes.start + changes.removed );
+	document.lines.insert( document.lines.begin() + changes.start,
+						   std::make_move_iterator( lines.begin() ),
+						   std::make_move_iterator( lines.end() ) );
+}
+
+bool WordIndex::hasLanguage( const std::string& language ) const {
+	Lock l( mMutex );
+	return mLanguages.find( language ) != mLanguages.end();
+}
+
+std::vector<WordIndex::Match> WordIndex::match( const std::string& language,
+												const std::string& query, size_t max ) {
+	std::vector<Match> matches;
+	Lock l( mMutex );
+	auto it = mLanguages.find( language );
+	if ( it == mLanguages.end() || query.empty() )
+		return matches;
+
+	Language& lang = *it->second;
+	const auto& words = lang.words;
+	// Only the previous matches are scored again when the query is extended, and a word that
+	// scores badly now can score well for a longer query. So every word that contains the
+	// characters of the query is kept as a candidate, and only the positive scores are suggested.
+	auto res = lang.matcher.match(
+		query, words.size(), max,
+		[&words]( size_t index, const std::string& query ) {
+			const Word& word = words[index];
+			if ( word.refs == 0 || ( word.refs == 1 && word.text == query ) )
+				return INT_MIN;
+			return String::fuzzyMatch( word.text, query );
+		},
+		[&words]( size_t index ) { return words[index].mask; }, lang.version );
+
+	matches.reserve( res.size() );
+	for ( const auto& m : res ) {
+		if ( m.score > 0 )
+			matches.push_back( { words[m.index].text, m.score, words[m.index].refs } );
+	}
+
+	std::stable_sort( matches.begin(), matches.end(), []( const Match& a, const Match& b ) {
+		return a.score > b.score || ( a.score == b.score && a.refs > b.refs );
+	} );
+
+	return matches;
+}
+
+std::vector<std::pair<std::string, Uint32>>
+WordIndex::getWords( const std::string& language ) const {
+	std::vector<std::pair<std::string, Uint32>> words;
+	Lock l( mMutex );
+	auto it = mLanguages.find( language );
+	if ( it == mLanguages.end() )
+		return words;
+	for ( const auto& word : it->second->words ) {
+		if ( word.refs > 0 )
+			words.emplace_back( word.text, word.refs );
+	}
+	std::sort( words.begin(), words.end() );
+	return words;
+}
+
+const std::string& WordIndex::getWordPattern() const {
+	return mWordPattern;
+}
+
+void WordIndex::setWordPattern( const std::string& wordPattern ) {
+	Lock l( mMutex );
+	if ( mWordPattern == wordPattern )
+		return;
+	mWordPattern = wordPattern;
+	for ( auto& document : mDocuments )
+		document.second.client->invalidate();
+}
+
+std::vector<std::vector<std::string>>
+WordIndex::tokenize( const std::vector<std::string>& lines, const std::string& wordPattern ) const {
+	LuaPattern pattern( wordPattern );
+	std::vector<std::vector<std::string>> words( lines.size() );
+	for ( size_t i = 0; i < lines.size(); i++ ) {
+		for ( auto& match : pattern.gmatch( lines[i] ) ) {
+			std::string word( match[0] );
+			if ( word.size() >= mMinWordLength )
+				words[i].emplace_back( std::move( word ) );
+		}
+	}
+	return words;
+}
+
+Uint32 WordIndex::addWord( Language& language, const std::string& text ) {
+	auto it = language.ids.find( text );
+	if ( it != language.ids.end() ) {
+		Word& word = language.words[it->second];
+		// A word that occurs once is not matched by the same query ( see match )
+		if ( ++word.refs == 2 )
+			language.version++;
+		return it->second;
+	}
+
+	Uint32 id;
+	if ( !language.freeIds.empty() ) {
+		id = language.freeIds.back();
+		language.freeIds.pop_back();
+	} else {
+		id = language.words.size();
+		language.words.emplace_back();
+	}
+
+	Word& word = language.words[id];
+	word.text = text;
+	word.mask = FuzzyMatcher::mask( text );
+	word.refs = 1;
+	language.ids[text] = id;
+	language.version++;
+	return id;
+}
+
+void WordIndex::removeWord( Language& language, Uint32 id ) {
+	Word& word = language.words[id];
+	if ( --word.refs == 1 ) {
+		language.version++;
+	} else if ( word.refs == 0 ) {
+		language.ids.erase( word.text );
+		word = Word{};
+		language.freeIds.push_back( id );
+		language.version++;
+	}
+}
+
+void WordIndex::removeLines( Document& document, Int64 start, Int64 end ) {
+	auto it = mLanguages.find( document.language );
+	if ( it == mLanguages.end() )
+		return;
+	for ( Int64 i = start; i < end; i++ ) {
+		for ( const auto& id : document.lines[i] )
+			removeWord( *it->second, id );
+	}
+}
+
+void WordIndex::setDocumentLanguage( Document& document, const std::string& language ) {
+	auto& to = mLanguages[language];
+	if ( !to )
+		to = std::make_unique<Language>();
+
+	if ( document.language == language )
+		return;
+
+	auto from = mLanguages.find( document.language );
+	if ( from != mLanguages.end() ) {
+		for ( auto& line : document.lines ) {
+			for ( auto& id : line ) {
+				Uint32 newId = addWord( *to, from->second->words[id].text );
+				removeWord( *from->second, id );
+				id = newId;
+			}
+		}
+	}
+
+	document.language = language;
+}
+
+} // namespace ecode
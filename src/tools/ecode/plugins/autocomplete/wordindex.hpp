@@ -0,0 +1,175 @@
+#ifndef ECODE_WORDINDEX_HPP
+#define ECODE_WORDINDEX_HPP
+
+#include "../../fuzzymatcher.hpp"
+#include <eepp/config.hpp>
+#include <eepp/core/containers.hpp>
+#include <eepp/system/mutex.hpp>
+#include <eepp/ui/doc/textdocument.hpp>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace EE;
+using namespace EE::System;
+using namespace EE::UI::Doc;
+
+namespace ecode {
+
+/** Index of the words of a set of documents, grouped by the language of the documents.
+ * Each document keeps the words of every line, and only the lines modified since the last update
+ * are tokenized again ( the modified lines are tracked listening the document changes ). Each
+ * word counts its occurrences in the documents of the language, it's removed from the index when
+ * the last occurrence is removed. */
+class WordIndex {
+  public:
+	struct Match {
+		std::string text;
+		int score;
+		Uint32 refs;
+	};
+
+	/** The lines of a document modified since the previous update */
+	struct Changes {
+		TextDocument* doc{ nullptr };
+		Uint64 serial{ 0 };
+		std::string language;
+		/* the lines [start, start + removed) are replaced by "lines" */
+		Int64 start{ 0 };
+		Int64 removed{ 0 };
+		std::vector<std::string> lines;
+		/* every line is replaced */
+		bool reset{ false };
+
+		bool empty() const { return doc == nullptr; }
+	};
+
+	/** @param wordPattern The LuaPattern that matches a word
+	 * @param minWordLength The words shorter than this ( in bytes ) are not indexed */
+	explicit WordIndex( const std::string& wordPattern, size_t minWordLength = 3 );
+
+	~WordIndex();
+
+	/** Starts tracking the changes of the document, its words are indexed with the next update */
+	void addDocument( TextDocument* doc );
+
+	void removeDocument( TextDocument* doc );
+
+	bool hasDocument( TextDocument* doc ) const;
+
+	/** @return True if the document was modified since the previous update and the changes of the
+	 * previous update were already applied */
+	bool isDirty( TextDocument* doc ) const;
+
+	/** Copies the lines modified since the previous update. It must be called from the thread
+	 * that modifies the document, the copy can then be applied from any thread. */
+	Changes collectChanges( TextDocument* doc );
+
+	/** Tokenizes the modified lines and updates the words of the document */
+	void apply( Changes&& changes );
+
+	bool hasLanguage( const std::string& language ) const;
+
+	/** @return The words of the language that match the query with a positive score ( see
+	 * String::fuzzyMatch ), sorted by score and by occurrences. A word equal to the query that
+	 * only occurs once is skipped, since that occurrence is usually the word being typed. */
+	std::vector<Match> match( const std::string& language, const std::string& query,
+							  size_t max );
+
+	/** @return The indexed words of the language and its occurrences, sorted by word */
+	std::vector<std::pair<std::string, Uint32>> getWords( const std::string& language ) const;
+
+	const std::string& getWordPattern() const;
+
+	/** Changes the word pattern, every document is indexed again with the next update */
+	void setWordPattern( const std::string& wordPattern );
+
+	static constexpr size_t MAX_LINE_LENGTH = EE_1KB * 10;
+
+  protected:
+	class Client : public TextDocument::Client {
+	  public:
+		explicit Client( TextDocument* doc ) : mDoc( doc ) {}
+
+		virtual void onDocumentLoaded( TextDocument* ) { invalidate(); }
+		virtual void onDocumentTextChanged( const DocumentContentChange& ) {}
+		virtual void onDocumentUndoRedo( const TextDocument::UndoRedo& ) {}
+		virtual void onDocumentCursorChange( const TextPosition& ) {}
+		virtual void onDocumentSelectionChange( const TextRange& ) {}
+		virtual void onDocumentLineCountChange( const size_t&, const size_t& ) {}
+		virtual void onDocumentLineChanged( const Int64& lineIndex );
+		virtual void onDocumentSaved( TextDocument* ) {}
+		virtual void onDocumentClosed( TextDocument* );
+		virtual void onDocumentDirtyOnFileSystem( TextDocument* ) {}
+		virtual void onDocumentMoved( TextDocument* ) {}
+		virtual void onDocumentReloaded( TextDocument* ) { invalidate(); }
+		virtual void onDocumentReset( TextDocument* ) { invalidate(); }
+
+		void invalidate();
+
+		bool isClosed() const;
+
+		bool isModified() const;
+
+		/** Returns and clears the modified lines: the first "first" lines and the last "last"
+		 * lines of the document were not modified, unless reset is set */
+		void takeChanges( Int64& first, Int64& last, bool& reset );
+
+	  protected:
+		TextDocument* mDoc{ nullptr };
+		mutable Mutex mMutex;
+		/* the first "mFirst" lines and the last "mLast" lines weren't modified */
+		Int64 mFirst{ std::numeric_limits<Int64>::max() };
+		Int64 mLast{ std::numeric_limits<Int64>::max() };
+		bool mReset{ true };
+		bool mClosed{ false };
+	};
+
+	struct Word {
+		std::string text;
+		Uint64 mask{ 0 };
+		Uint32 refs{ 0 };
+	};
+
+	struct Language {
+		UnorderedMap<std::string, Uint32> ids;
+		std::vector<Word> words;
+		std::vector<Uint32> freeIds;
+		/* changes every time a word is added or removed */
+		Uint64 version{ 1 };
+		FuzzyMatcher matcher;
+	};
+
+	struct Document {
+		std::unique_ptr<Client> client;
+		Uint64 serial{ 0 };
+		std::string language;
+		/* the ids of the words of each line */
+		std::vector<std::vector<Uint32>> lines;
+		/* collected changes not applied yet */
+		bool pending{ false };
+	};
+
+	mutable Mutex mMutex;
+	std::string mWordPattern;
+	size_t mMinWordLength;
+	Uint64 mLastSerial{ 0 };
+	UnorderedMap<TextDocument*, Document> mDocuments;
+	UnorderedMap<std::string, std::unique_ptr<Language>> mLanguages;
+
+	std::vector<std::vector<std::string>> tokenize( const std::vector<std::string>& lines,
+													const std::string& wordPattern ) const;
+
+	Uint32 addWord( Language& language, const std::string& word );
+
+	void removeWord( Language& language, Uint32 id );
+
+	void removeLines( Document& document, Int64 start, Int64 end );
+
+	void setDocumentLanguage( Document& document, const std::string& language );
+};
+
+} // namespace ecode
+
+#endif // ECODE_WORDINDEX_HPP
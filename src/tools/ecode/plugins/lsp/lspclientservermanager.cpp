@@ -419,14 +419,16 @@ void LSPClientServerManager::sendSymbolReferenceBroadcast( const std::vector<LSP
 		}
 	}
 
-	ProjectSearch::Result result;
+	auto result = std::make_shared<ProjectSearch::Result>();
 	for ( auto& r : res ) {
 		if ( !r.second.results.empty() )
-			result.emplace_back( std::move( r.second ) );
+			result->emplace_back( std::move( r.second ) );
 	}
 
-	mPluginManager->sendBroadcast( PluginMessageType::SymbolReference,
-								   PluginMessageFormat::ProjectSearchResult, &result );
+	// Building the search model of the result doesn't need to hold the server response thread
+	mPluginManager->sendBroadcastAsync( nullptr, PluginMessageType::SymbolReference,
+										PluginMessageFormat::ProjectSearchResult,
+										std::move( result ) );
 }
 
 void LSPClientServerManager::getSymbolReferences( std::shared_ptr<TextDocument> doc ) {
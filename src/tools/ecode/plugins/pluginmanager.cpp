@@ -1,6 +1,7 @@
 #include "pluginmanager.hpp"
 #include "../filesystemlistener.hpp"
 #include "plugin.hpp"
+#include "pluginmessagebus.hpp"
 #include <eepp/system/filesystem.hpp>
 #include <eepp/system/md5.hpp>
 #include <eepp/ui/uicheckbox.hpp>
@@ -19,10 +20,12 @@ PluginManager::PluginManager( const std::string& resourcesPath, const std::strin
 	mConfigPath( configPath ),
 	mThreadPool( pool ),
 	mPluginContext( context ),
+	mMessageBus( std::make_unique<PluginMessageBus>( pool ) ),
 	mLoadFileFn( loadFileCb ) {}
 
 PluginManager::~PluginManager() {
 	mClosing = true;
+	mMessageBus->close();
 	for ( auto& plugin : mPlugins ) {
 		Log::debug( "PluginManager: unloading plugin %s", plugin.second->getTitle() );
 		eeDelete( plugin.second );
@@ -69,10 +72,7 @@ bool PluginManager::setEnabled( const std::string& id, bool enable, bool sync )
 	if ( !enable && plugin != nullptr ) {
 		Log::debug( "PluginManager: unloading plugin %s", mDefinitions[id].name );
 		mThreadPool->run( [plugin]() { eeDelete( plugin ); } );
-		{
-			Lock l( mSubscribedPluginsMutex );
-			mSubscribedPlugins.erase( id );
-		}
+		mMessageBus->unsubscribe( id );
 		mPlugins.erase( id );
 	}
 	return false;
@@ -169,36 +169,14 @@ PluginRequestHandle PluginManager::sendRequest( PluginMessageType type, PluginMe
 												const void* data ) {
 	if ( mClosing )
 		return PluginRequestHandle::empty();
-	SubscribedPlugins subscribedPlugins;
-	{
-		Lock l( mSubscribedPluginsMutex );
-		subscribedPlugins = mSubscribedPlugins;
-	}
-	for ( const auto& plugin : subscribedPlugins ) {
-		auto handle = plugin.second( { type, format, data } );
-		if ( !handle.isEmpty() )
-			return handle;
-	}
-	return PluginRequestHandle::empty();
+	return mMessageBus->publish( "", { type, format, data }, true );
 }
 
 PluginRequestHandle PluginManager::sendRequest( Plugin* pluginWho, PluginMessageType type,
 												PluginMessageFormat format, const void* data ) {
 	if ( mClosing )
 		return PluginRequestHandle::empty();
-	SubscribedPlugins subscribedPlugins;
-	{
-		Lock l( mSubscribedPluginsMutex );
-		subscribedPlugins = mSubscribedPlugins;
-	}
-	for ( const auto& plugin : subscribedPlugins ) {
-		if ( pluginWho->getId() != plugin.first ) {
-			auto handle = plugin.second( { type, format, data } );
-			if ( !handle.isEmpty() )
-				return handle;
-		}
-	}
-	return PluginRequestHandle::empty();
+	return mMessageBus->publish( pluginWho->getId(), { type, format, data }, true );
 }
 
 void PluginManager::sendResponse( Plugin* pluginWho, PluginMessageType type,
@@ -206,48 +184,53 @@ void PluginManager::sendResponse( Plugin* pluginWho, PluginMessageType type,
 								  const PluginIDType& responseID ) {
 	if ( mClosing )
 		return;
-	SubscribedPlugins subscribedPlugins;
-	{
-		Lock l( mSubscribedPluginsMutex );
-		subscribedPlugins = mSubscribedPlugins;
-	}
-	for ( const auto& plugin : subscribedPlugins )
-		if ( pluginWho->getId() != plugin.first )
-			plugin.second( { type, format, data, responseID } );
+	mMessageBus->publish( pluginWho->getId(), { type, format, data, responseID }, false );
 }
 
 void PluginManager::sendBroadcast( Plugin* pluginWho, PluginMessageType type,
 								   PluginMessageFormat format, const void* data ) {
 	if ( mClosing )
 		return;
-	SubscribedPlugins subscribedPlugins;
-	{
-		Lock l( mSubscribedPluginsMutex );
-		subscribedPlugins = mSubscribedPlugins;
-	}
-	for ( const auto& plugin : subscribedPlugins )
-		if ( nullptr == pluginWho || pluginWho->getId() != plugin.first )
-			plugin.second( { type, format, data, -1 } );
+	mMessageBus->publish( pluginWho ? pluginWho->getId() : "", { type, format, data, -1 }, false );
+}
+
+void PluginManager::sendBroadcastAsync( Plugin* pluginWho, PluginMessageType type,
+										PluginMessageFormat format,
+										std::shared_ptr<const void> data ) {
+	if ( mClosing )
+		return;
+	mMessageBus->publishAsync( pluginWho ? pluginWho->getId() : "", type, format,
+							   std::move( data ) );
 }
 
 void PluginManager::subscribeMessages(
 	const std::string& uniqueComponentId,
 	std::function<PluginRequestHandle( const PluginMessage& )> cb ) {
-	{
-		Lock l( mSubscribedPluginsMutex );
-		mSubscribedPlugins[uniqueComponentId] = cb;
-	}
-	if ( !mWorkspaceFolder.empty() ) {
+	subscribeMessages( uniqueComponentId, {}, std::move( cb ) );
+}
+
+void PluginManager::subscribeMessages(
+	const std::string& uniqueComponentId, const std::vector<PluginMessageType>& types,
+	std::function<PluginRequestHandle( const PluginMessage& )> cb ) {
+	mMessageBus->subscribe( uniqueComponentId, types, cb );
+	if ( !mWorkspaceFolder.empty() &&
+		 PluginMessageBus::isSubscribedTo( types, PluginMessageType::WorkspaceFolderChanged ) ) {
 		json data{ { "folder", mWorkspaceFolder } };
 		cb( { PluginMessageType::WorkspaceFolderChanged, PluginMessageFormat::JSON, &data } );
 	}
 }
 
 void PluginManager::unsubscribeMessages( const std::string& uniqueComponentId ) {
-	if ( !mClosing ) {
-		Lock l( mSubscribedPluginsMutex );
-		mSubscribedPlugins.erase( uniqueComponentId );
-	}
+	if ( !mClosing )
+		mMessageBus->unsubscribe( uniqueComponentId );
+}
+
+PluginMessageStats PluginManager::getMessageStats( PluginMessageType type ) const {
+	return mMessageBus->getStats( type );
+}
+
+void PluginManager::resetMessageStats() {
+	mMessageBus->resetStats();
 }
 
 const PluginManager::OnLoadFileCb& PluginManager::getLoadFileFn() const {
@@ -264,6 +247,12 @@ void PluginManager::setPluginReloadEnabled( bool pluginReloadEnabled ) {
 
 void PluginManager::subscribeMessages(
 	Plugin* plugin, std::function<PluginRequestHandle( const PluginMessage& )> cb ) {
+	subscribeMessages( plugin, {}, std::move( cb ) );
+}
+
+void PluginManager::subscribeMessages(
+	Plugin* plugin, const std::vector<PluginMessageType>& types,
+	std::function<PluginRequestHandle( const PluginMessage& )> cb ) {
 	if ( plugin && !mWorkspaceFolder.empty() ) {
 		std::string projectsPath( mConfigPath + "projects" + FileSystem::getOSSlash() );
 		MD5::Result hash = MD5::fromString( mWorkspaceFolder );
@@ -272,7 +261,7 @@ void PluginManager::subscribeMessages(
 											 FileSystem::getOSSlash() );
 		plugin->onLoadProject( mWorkspaceFolder, projectPluginsStatePath );
 	}
-	subscribeMessages( plugin->getId(), cb );
+	subscribeMessages( plugin->getId(), types, std::move( cb ) );
 }
 
 void PluginManager::unsubscribeMessages( Plugin* plugin ) {
@@ -311,10 +300,11 @@ void PluginManager::subscribeFileSystemListener() {
 		return;
 
 	mFileSystemListenerCb =
-		mFileSystemListener->addListener( [this]( const FileEvent& ev, const FileInfo& file ) {
+		mFileSystemListener->addBatchListener( [this]( const FileSystemChangeSet& changeSet ) {
 			Lock l( mPluginsFSSubsMutex );
-			for ( Plugin* plugin : mPluginsFSSubs )
-				plugin->onFileSystemEvent( ev, file );
+			for ( const auto& change : changeSet.changes )
+				for ( Plugin* plugin : mPluginsFSSubs )
+					plugin->onFileSystemEvent( change.event, change.file );
 		} );
 }
 
@@ -327,13 +317,7 @@ void PluginManager::sendBroadcast( const PluginMessageType& notification,
 								   const PluginMessageFormat& format, void* data ) {
 	if ( mClosing )
 		return;
-	SubscribedPlugins subscribedPlugins;
-	{
-		Lock l( mSubscribedPluginsMutex );
-		subscribedPlugins = mSubscribedPlugins;
-	}
-	for ( const auto& plugin : subscribedPlugins )
-		plugin.second( { notification, format, data, -1 } );
+	mMessageBus->publish( "", { notification, format, data, -1 }, false );
 }
 
 bool PluginManager::hasDefinition( const std::string& id ) {
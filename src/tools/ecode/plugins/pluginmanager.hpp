@@ -29,6 +29,7 @@ class PluginManager;
 class Plugin;
 class FileSystemListener;
 class ProjectBuildManager;
+class PluginMessageBus;
 
 typedef std::function<Plugin*( PluginManager* pluginManager )> PluginCreatorFn;
 
@@ -230,6 +231,12 @@ struct PluginInmediateResponse {
 	nlohmann::json data;
 };
 
+struct PluginMessageStats {
+	Uint64 messages{ 0 };	///< Messages of the type sent
+	Uint64 deliveries{ 0 }; ///< Subscribers called with them
+	Time time;				///< Time spent delivering them
+};
+
 class PluginRequestHandle {
   public:
 	static PluginRequestHandle broadcast() { return PluginRequestHandle( -1 ); }
@@ -340,16 +347,35 @@ class PluginManager {
 	void sendBroadcast( const PluginMessageType& notification, const PluginMessageFormat& format,
 						void* data );
 
+	/** Sends the broadcast from the thread pool, without waiting for the subscribers. The data is
+	 * kept alive until every subscriber received it. */
+	void sendBroadcastAsync( Plugin* pluginWho, PluginMessageType type, PluginMessageFormat format,
+							 std::shared_ptr<const void> data );
+
+	/** Subscribes to every message type */
 	void subscribeMessages( Plugin* plugin,
 							std::function<PluginRequestHandle( const PluginMessage& )> cb );
 
+	/** Subscribes only to the message types listed, the other types aren't delivered */
+	void subscribeMessages( Plugin* plugin, const std::vector<PluginMessageType>& types,
+							std::function<PluginRequestHandle( const PluginMessage& )> cb );
+
 	void unsubscribeMessages( Plugin* plugin );
 
 	void subscribeMessages( const std::string& uniqueComponentId,
 							std::function<PluginRequestHandle( const PluginMessage& )> cb );
 
+	void subscribeMessages( const std::string& uniqueComponentId,
+							const std::vector<PluginMessageType>& types,
+							std::function<PluginRequestHandle( const PluginMessage& )> cb );
+
 	void unsubscribeMessages( const std::string& uniqueComponentId );
 
+	/** @return The number of messages of a type sent, and the cost of delivering them */
+	PluginMessageStats getMessageStats( PluginMessageType type ) const;
+
+	void resetMessageStats();
+
 	FileSystemListener* getFileSystemListener() const { return mFileSystemListener; };
 
 	const OnLoadFileCb& getLoadFileFn() const;
@@ -369,8 +395,6 @@ class PluginManager {
 	void forEachPlugin( std::function<void( Plugin* )> fn );
 
   protected:
-	using SubscribedPlugins =
-		std::map<std::string, std::function<PluginRequestHandle( const PluginMessage& )>>;
 	friend class App;
 	std::string mResourcesPath;
 	std::string mPluginsPath;
@@ -384,9 +408,8 @@ class PluginManager {
 	UISplitter* mMainSplitter{ nullptr };
 	FileSystemListener* mFileSystemListener{ nullptr };
 	PluginContextProvider* mPluginContext{ nullptr };
-	Mutex mSubscribedPluginsMutex;
 	Mutex mPluginsFSSubsMutex;
-	SubscribedPlugins mSubscribedPlugins;
+	std::unique_ptr<PluginMessageBus> mMessageBus;
 	OnLoadFileCb mLoadFileFn;
 	Uint64 mFileSystemListenerCb{ 0 };
 	UnorderedSet<Plugin*> mPluginsFSSubs;
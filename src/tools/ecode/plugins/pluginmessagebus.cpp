@@ -0,0 +1,130 @@
+#include "pluginmessagebus.hpp"
+#include <algorithm>
+
+namespace ecode {
+
+PluginMessageBus::PluginMessageBus( std::shared_ptr<ThreadPool> pool ) :
+	mPool( std::move( pool ) ) {}
+
+PluginMessageBus::~PluginMessageBus() {
+	close();
+}
+
+bool PluginMessageBus::isSubscribedTo( const std::vector<PluginMessageType>& types,
+									   PluginMessageType type ) {
+	return types.empty() || std::find( types.begin(), types.end(), type ) != types.end();
+}
+
+void PluginMessageBus::subscribe( const std::string& id,
+								  const std::vector<PluginMessageType>& types, Callback cb ) {
+	auto subscriber = std::make_shared<Subscriber>();
+	subscriber->id = id;
+	subscriber->types = types;
+	subscriber->cb = std::move( cb );
+	setSubscriber( id, std::move( subscriber ) );
+}
+
+void PluginMessageBus::unsubscribe( const std::string& id ) {
+	setSubscriber( id, nullptr );
+}
+
+PluginRequestHandle PluginMessageBus::publish( const std::string& skipId,
+											   const PluginMessage& msg, bool untilHandled ) {
+	if ( mClosed )
+		return PluginRequestHandle::empty();
+
+	auto subscriptions = getSubscriptions();
+	auto& counters = mCounters[static_cast<size_t>( msg.type )];
+	PluginRequestHandle handle;
+	Uint64 deliveries = 0;
+	Clock clock;
+
+	for ( const auto& subscriber : subscriptions->byType[static_cast<size_t>( msg.type )] ) {
+		if ( !skipId.empty() && subscriber->id == skipId )
+			continue;
+		deliveries++;
+		handle = subscriber->cb( msg );
+		if ( untilHandled && !handle.isEmpty() )
+			break;
+	}
+
+	counters.messages++;
+	counters.deliveries += deliveries;
+	counters.microseconds += clock.getElapsedTime().asMicroseconds();
+	return untilHandled && !handle.isEmpty() ? handle : PluginRequestHandle::empty();
+}
+
+void PluginMessageBus::publishAsync( const std::string& skipId, PluginMessageType type,
+									 PluginMessageFormat format,
+									 std::shared_ptr<const void> data ) {
+	{
+		std::lock_guard<std::mutex> lock( mAsyncMutex );
+		if ( mClosed )
+			return;
+		mAsyncPending++;
+	}
+
+	mPool->run( [this, skipId, type, format, data] {
+		// The subscribers are the ones at the moment of the delivery, someone could have
+		// unsubscribed meanwhile
+		publish( skipId, { type, format, data.get(), -1 }, false );
+
+		std::lock_guard<std::mutex> lock( mAsyncMutex );
+		if ( --mAsyncPending == 0 )
+			mAsyncDone.notify_all();
+	} );
+}
+
+void PluginMessageBus::close() {
+	std::unique_lock<std::mutex> lock( mAsyncMutex );
+	mClosed = true;
+	mAsyncDone.wait( lock, [this] { return mAsyncPending == 0; } );
+}
+
+bool PluginMessageBus::isClosed() const {
+	return mClosed;
+}
+
+PluginMessageStats PluginMessageBus::getStats( PluginMessageType type ) const {
+	const auto& counters = mCounters[static_cast<size_t>( type )];
+	PluginMessageStats stats;
+	stats.messages = counters.messages;
+	stats.deliveries = counters.deliveries;
+	stats.time = Microseconds( counters.microseconds );
+	return stats;
+}
+
+void PluginMessageBus::resetStats() {
+	for ( auto& counters : mCounters ) {
+		counters.messages = 0;
+		counters.deliveries = 0;
+		counters.microseconds = 0;
+	}
+}
+
+std::shared_ptr<const PluginMessageBus::Subscriptions> PluginMessageBus::getSubscriptions() const {
+	return std::atomic_load( &mSubscriptions );
+}
+
+void PluginMessageBus::setSubscriber( const std::string& id,
+									  std::shared_ptr<const Subscriber> subscriber ) {
+	std::lock_guard<std::mutex> lock( mSubscriptionsMutex );
+	auto subscriptions = std::make_shared<Subscriptions>();
+	subscriptions->subscribers = getSubscriptions()->subscribers;
+	if ( subscriber )
+		subscriptions->subscribers[id] = std::move( subscriber );
+	else
+		subscriptions->subscribers.erase( id );
+
+	for ( const auto& sub : subscriptions->subscribers ) {
+		for ( size_t type = 0; type < MessageTypeCount; type++ ) {
+			if ( isSubscribedTo( sub.second->types, static_cast<PluginMessageType>( type ) ) )
+				subscriptions->byType[type].push_back( sub.second );
+		}
+	}
+
+	std::atomic_store( &mSubscriptions,
+					   std::shared_ptr<const Subscriptions>( std::move( subscriptions ) ) );
+}
+
+} // namespace ecode
@@ -0,0 +1,95 @@
+#ifndef ECODE_PLUGINMESSAGEBUS_HPP
+#define ECODE_PLUGINMESSAGEBUS_HPP
+
+#include "pluginmanager.hpp"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ecode {
+
+/** Delivers the plugin messages to the subscribers of their type.
+ * The subscribers are kept in a snapshot indexed by message type that is never modified once
+ * published: subscribing or unsubscribing publishes a new copy, so the messages are sent without
+ * locking. The broadcasts can also be delivered from the thread pool, and the messages sent of
+ * each type are counted with the time spent delivering them. */
+class PluginMessageBus {
+  public:
+	using Callback = std::function<PluginRequestHandle( const PluginMessage& )>;
+
+	explicit PluginMessageBus( std::shared_ptr<ThreadPool> pool );
+
+	~PluginMessageBus();
+
+	/** Subscribes to the message types listed, or to every type if there's none */
+	void subscribe( const std::string& id, const std::vector<PluginMessageType>& types,
+					Callback cb );
+
+	void unsubscribe( const std::string& id );
+
+	/** Sends the message to the subscribers of its type, except to skipId.
+	 * @param untilHandled Stops at the first subscriber that returns a handle, and returns it */
+	PluginRequestHandle publish( const std::string& skipId, const PluginMessage& msg,
+								 bool untilHandled );
+
+	/** Sends the broadcast from the thread pool, without waiting for the subscribers. The data is
+	 * kept alive until every subscriber received it. */
+	void publishAsync( const std::string& skipId, PluginMessageType type,
+					   PluginMessageFormat format, std::shared_ptr<const void> data );
+
+	/** Stops delivering the messages, and waits for the broadcasts being delivered */
+	void close();
+
+	bool isClosed() const;
+
+	/** @return The number of messages of a type sent, and the cost of delivering them */
+	PluginMessageStats getStats( PluginMessageType type ) const;
+
+	void resetStats();
+
+	static bool isSubscribedTo( const std::vector<PluginMessageType>& types,
+								PluginMessageType type );
+
+  protected:
+	static constexpr size_t MessageTypeCount =
+		static_cast<size_t>( PluginMessageType::Undefined ) + 1;
+
+	struct Subscriber {
+		std::string id;
+		std::vector<PluginMessageType> types; // Empty when subscribed to every type
+		Callback cb;
+	};
+
+	struct Subscriptions {
+		std::map<std::string, std::shared_ptr<const Subscriber>> subscribers;
+		std::array<std::vector<std::shared_ptr<const Subscriber>>, MessageTypeCount> byType;
+	};
+
+	struct MessageCounters {
+		std::atomic<Uint64> messages{ 0 };
+		std::atomic<Uint64> deliveries{ 0 };
+		std::atomic<Int64> microseconds{ 0 };
+	};
+
+	std::shared_ptr<ThreadPool> mPool;
+	std::mutex mSubscriptionsMutex;
+	std::shared_ptr<const Subscriptions> mSubscriptions{ std::make_shared<Subscriptions>() };
+	std::array<MessageCounters, MessageTypeCount> mCounters;
+	std::atomic<bool> mClosed{ false };
+	std::mutex mAsyncMutex;
+	std::condition_variable mAsyncDone;
+	size_t mAsyncPending{ 0 };
+
+	std::shared_ptr<const Subscriptions> getSubscriptions() const;
+
+	void setSubscriber( const std::string& id, std::shared_ptr<const Subscriber> subscriber );
+};
+
+} // namespace ecode
+
+#endif // ECODE_PLUGINMESSAGEBUS_HPP
@@ -1,4 +1,5 @@
 #include "projectdirectorytree.hpp"
+#include "projectscanner.hpp"
 #include <algorithm>
 #include <eepp/system/filesystem.hpp>
 #include <limits>
@@ -6,6 +7,7 @@
 namespace ecode {
 
 #define PRJ_ALLOWED_PATH ".ecode/.prjallowed"
+#define PRJ_SCAN_PROGRESS_INTERVAL_MS ( 250 )
 
 ProjectDirectoryTree::ProjectDirectoryTree(
 	const std::string& path, std::shared_ptr<ThreadPool> threadPool, PluginManager* pluginManager,
@@ -17,6 +19,7 @@ ProjectDirectoryTree::ProjectDirectoryTree(
 	mIgnoreHidden( true ),
 	mClosing( false ),
 	mIgnoreMatcher( path ),
+	mFuzzyMatcher( threadPool ),
 	mPluginManager( pluginManager ),
 	mLoadFileFromPathOrFocusFn( std::move( loadFileFromPathOrFocusFn ) ) {
 	FileSystem::dirAddSlashAtEnd( mPath );
@@ -29,7 +32,7 @@ ProjectDirectoryTree::~ProjectDirectoryTree() {
 	Lock rl( mMatchingMutex );
 	if ( mRunning ) {
 		mRunning = false;
-		Lock l( mFilesMutex );
+		Lock l( mScanMutex );
 	}
 	{
 		Lock l( mDoneMutex );
@@ -38,57 +41,34 @@ ProjectDirectoryTree::~ProjectDirectoryTree() {
 
 void ProjectDirectoryTree::scan( const ProjectDirectoryTree::ScanCompleteEvent& scanComplete,
 								 const std::vector<std::string>& acceptedPatterns,
-								 const bool& ignoreHidden ) {
+								 const bool& ignoreHidden,
+								 const ProjectDirectoryTree::ScanProgressEvent& scanProgress ) {
 #if EE_PLATFORM != EE_PLATFORM_EMSCRIPTEN || defined( __EMSCRIPTEN_PTHREADS__ )
 	mPool->run(
-		[this, acceptedPatterns = std::move( acceptedPatterns ), ignoreHidden] {
+		[this, acceptedPatterns = std::move( acceptedPatterns ), ignoreHidden, scanProgress] {
 #endif
-			Lock l( mFilesMutex );
+			Lock l( mScanMutex );
 			mRunning = true;
 			mIgnoreHidden = ignoreHidden;
-			{
-				Lock ld( mDirectoriesMutex );
-				mDirectories.push_back( mPath );
-			}
+			mScanProgress = scanProgress;
 
 			if ( !mAllowedMatcher && FileSystem::fileExists( mPath + PRJ_ALLOWED_PATH ) )
 				mAllowedMatcher =
 					std::make_unique<GitIgnoreMatcher>( mPath, PRJ_ALLOWED_PATH, false );
 
 			if ( !acceptedPatterns.empty() ) {
-				std::vector<std::string> files;
-				std::vector<std::string> names;
 				mAcceptedPatterns.clear();
 				mAcceptedPatterns.reserve( acceptedPatterns.size() );
 				for ( const auto& strPattern : acceptedPatterns )
 					mAcceptedPatterns.emplace_back( std::string{ strPattern } );
-				std::set<std::string> info;
-				getDirectoryFiles( files, names, mPath, info, false, mIgnoreMatcher,
-								   mAllowedMatcher.get() );
-				size_t namesCount = names.size();
-				bool found;
-				for ( size_t i = 0; i < namesCount; i++ ) {
-					found = false;
-					for ( const auto& pattern : mAcceptedPatterns ) {
-						if ( pattern.matches( names[i] ) ) {
-							found = true;
-							break;
-						}
-					}
-					if ( found ) {
-						mFiles.emplace_back( std::move( files[i] ) );
-						mNames.emplace_back( std::move( names[i] ) );
-					}
-				}
-			} else {
-				std::set<std::string> info;
-				getDirectoryFiles( mFiles, mNames, mPath, info, ignoreHidden, mIgnoreMatcher,
-								   mAllowedMatcher.get() );
 			}
+
+			getDirectoryFiles( mPath, mIgnoreMatcher.getMatchers(), false );
+			mScanProgress = nullptr;
 			mIsReady = true;
 			if ( mPluginManager ) {
 				mPluginManager->subscribeMessages(
-					"ProjectDirectoryTree",
+					"ProjectDirectoryTree", { PluginMessageType::FindAndOpenClosestURI },
 					[this]( const PluginMessage& msg ) -> PluginRequestHandle {
 						return processMessage( msg );
 					} );
@@ -113,23 +93,27 @@ std::shared_ptr<FileListModel>
 ProjectDirectoryTree::fuzzyMatchTree( const std::vector<std::string>& matches, const size_t& max,
 									  const std::string& basePath ) const {
 	Lock rl( mMatchingMutex );
-	std::multimap<int, int, std::greater<int>> matchesMap;
-	std::vector<std::string> files;
-	std::vector<std::string> names;
+	Lock l( mFilesMutex );
+	std::vector<FuzzyMatcher::Match> matchesList;
+	/* the best results of all the queries are among the best results of each query */
+	FuzzyMatcher matcher( mPool );
 	for ( const auto& match : matches ) {
-		for ( size_t i = 0; i < mNames.size(); i++ ) {
-			int matchName = String::fuzzyMatch( mNames[i], match );
-			int matchPath = String::fuzzyMatch( mFiles[i], match );
-			matchesMap.insert( { std::max( matchName, matchPath ), i } );
-		}
+		auto res( matcher.match( match, mFiles.size(), max, fuzzyScoreFn(), fuzzyMaskFn() ) );
+		matchesList.insert( matchesList.end(), res.begin(), res.end() );
 	}
-	for ( auto& res : matchesMap ) {
-		if ( names.size() < max ) {
-			names.emplace_back( mNames[res.second] );
-			files.emplace_back( mFiles[res.second] );
-		} else {
+	std::sort( matchesList.begin(), matchesList.end(), []( const auto& a, const auto& b ) {
+		return a.score > b.score || ( a.score == b.score && a.index < b.index );
+	} );
+	std::vector<std::string> files;
+	std::vector<std::string> names;
+	UnorderedSet<size_t> added;
+	for ( const auto& res : matchesList ) {
+		if ( names.size() >= max )
 			break;
-		}
+		if ( !added.insert( res.index ).second )
+			continue;
+		names.emplace_back( mNames[res.index] );
+		files.emplace_back( mFiles[res.index] );
 	}
 	auto model = std::make_shared<FileListModel>( std::move( files ), std::move( names ) );
 	model->setBasePath( basePath );
@@ -140,31 +124,36 @@ std::shared_ptr<FileListModel>
 ProjectDirectoryTree::fuzzyMatchTree( const std::string& match, const size_t& max,
 									  const std::string& basePath ) const {
 	Lock rl( mMatchingMutex );
-	std::multimap<int, int, std::greater<int>> matchesMap;
+	Lock l( mFilesMutex );
 	std::vector<std::string> files;
 	std::vector<std::string> names;
-	for ( size_t i = 0; i < mNames.size(); i++ ) {
-		int matchName = String::fuzzyMatch( mNames[i], match );
-		int matchPath = String::fuzzyMatch( mFiles[i], match );
-		matchesMap.insert( { std::max( matchName, matchPath ), i } );
-	}
-	for ( auto& res : matchesMap ) {
-		if ( names.size() < max ) {
-			names.emplace_back( mNames[res.second] );
-			files.emplace_back( mFiles[res.second] );
-		} else {
-			break;
-		}
+	for ( const auto& res : mFuzzyMatcher.match( match, mFiles.size(), max, fuzzyScoreFn(),
+												 fuzzyMaskFn(), mFilesVersion ) ) {
+		names.emplace_back( mNames[res.index] );
+		files.emplace_back( mFiles[res.index] );
 	}
 	auto model = std::make_shared<FileListModel>( std::move( files ), std::move( names ) );
 	model->setBasePath( basePath );
 	return model;
 }
 
+FuzzyMatcher::ScoreFn ProjectDirectoryTree::fuzzyScoreFn() const {
+	return [this]( size_t index, const std::string& query ) {
+		return std::max( String::fuzzyMatch( mNames[index], query ),
+						 String::fuzzyMatch( mFiles[index], query ) );
+	};
+}
+
+FuzzyMatcher::MaskFn ProjectDirectoryTree::fuzzyMaskFn() const {
+	/* the file name is part of the path */
+	return [this]( size_t index ) { return FuzzyMatcher::mask( mFiles[index] ); };
+}
+
 std::shared_ptr<FileListModel>
 ProjectDirectoryTree::matchTree( const std::string& match, const size_t& max,
 								 const std::string& basePath ) const {
 	Lock rl( mMatchingMutex );
+	Lock l( mFilesMutex );
 	std::vector<std::string> files;
 	std::vector<std::string> names;
 	std::string lowerMatch( String::toLower( match ) );
@@ -185,6 +174,7 @@ std::shared_ptr<FileListModel>
 ProjectDirectoryTree::globMatchTree( const std::string& match, const size_t& max,
 									 const std::string& basePath ) const {
 	Lock rl( mMatchingMutex );
+	Lock l( mFilesMutex );
 	std::vector<std::string> files;
 	std::vector<std::string> names;
 	for ( size_t i = 0; i < mNames.size(); i++ ) {
@@ -230,6 +220,7 @@ std::shared_ptr<FileListModel>
 ProjectDirectoryTree::asModel( const size_t& max, const std::vector<CommandInfo>& prependCommands,
 							   const std::string& basePath,
 							   const std::vector<std::string>& skipExtensions ) const {
+	Lock l( mFilesMutex );
 	size_t namesSize = mNames.size();
 	size_t rmax = eemin( namesSize, max );
 	std::vector<std::string> files;
@@ -318,65 +309,69 @@ bool ProjectDirectoryTree::isDirInTree( const std::string& dirTree ) const {
 	Lock l( mDirectoriesMutex );
 	std::string dir( FileSystem::fileRemoveFileName( dirTree ) );
 	FileSystem::dirAddSlashAtEnd( dir );
-	return std::find( mDirectories.begin(), mDirectories.end(), dir ) != mDirectories.end();
+	return mDirectoriesSet.find( dir ) != mDirectoriesSet.end();
+}
+
+void ProjectDirectoryTree::getDirectoryFiles( const std::string& directory,
+											  const std::vector<IgnoreMatcher*>& ignoreMatchers,
+											  bool readIgnoreFile ) {
+	ProjectScanner scanner(
+		mPool,
+		[this]( std::vector<std::string>& files, std::vector<std::string>& names ) {
+			addFiles( files, names );
+		},
+		[this]( const std::string& dir ) { addDirectory( dir ); } );
+
+	std::vector<std::string> acceptedPatterns;
+	acceptedPatterns.reserve( mAcceptedPatterns.size() );
+	for ( const auto& pattern : mAcceptedPatterns )
+		acceptedPatterns.emplace_back( pattern.getPattern() );
+
+	scanner.setAcceptedPatterns( acceptedPatterns );
+	scanner.setAllowedMatcher( mAllowedMatcher.get() );
+	scanner.setShouldAbort( [this] { return mClosing.load(); } );
+	scanner.scan( directory, ignoreMatchers, readIgnoreFile );
 }
 
-void ProjectDirectoryTree::getDirectoryFiles(
-	std::vector<std::string>& files, std::vector<std::string>& names, std::string directory,
-	std::set<std::string> currentDirs, const bool& ignoreHidden,
-	IgnoreMatcherManager& ignoreMatcher, GitIgnoreMatcher* allowedMatcher ) {
-	if ( !mRunning )
+void ProjectDirectoryTree::addFiles( std::vector<std::string>& files,
+									 std::vector<std::string>& names ) {
+	size_t filesCount;
+	{
+		Lock l( mFilesMutex );
+		mFiles.insert( mFiles.end(), std::make_move_iterator( files.begin() ),
+					   std::make_move_iterator( files.end() ) );
+		mNames.insert( mNames.end(), std::make_move_iterator( names.begin() ),
+					   std::make_move_iterator( names.end() ) );
+		filesCount = mFiles.size();
+		mFilesVersion++;
+	}
+
+	if ( !mScanProgress )
 		return;
-	currentDirs.insert( directory );
-	std::vector<std::string> pathFiles =
-		FileSystem::filesGetInPath( directory, false, false, false );
-	for ( auto& file : pathFiles ) {
-		std::string fullpath( directory + file );
-		if ( ignoreMatcher.foundMatch() && ignoreMatcher.match( directory, file ) ) {
-			if ( !allowedMatcher )
-				continue;
-			std::string localPath;
-			if ( String::startsWith( directory, allowedMatcher->getPath() ) )
-				localPath = directory.substr( allowedMatcher->getPath().size() );
-			if ( !allowedMatcher->match( localPath + file ) )
-				continue;
-		}
-		if ( FileSystem::isDirectory( fullpath ) ) {
-			fullpath += FileSystem::getOSSlash();
-			FileInfo dirInfo( fullpath, true );
-			if ( dirInfo.isLink() ) {
-				fullpath = dirInfo.linksTo();
-				FileSystem::dirAddSlashAtEnd( fullpath );
-				if ( currentDirs.find( fullpath ) == currentDirs.end() )
-					continue;
-				{
-					Lock ld( mDirectoriesMutex );
-					if ( std::find( mDirectories.begin(), mDirectories.end(), fullpath ) !=
-						 mDirectories.end() )
-						continue;
-					mDirectories.push_back( fullpath );
-				}
-			} else {
-				Lock ld( mDirectoriesMutex );
-				mDirectories.push_back( fullpath );
-			}
-			IgnoreMatcherManager dirMatcher( fullpath );
-			IgnoreMatcher* childMatch = nullptr;
-			if ( dirMatcher.foundMatch() ) {
-				childMatch = dirMatcher.popMatcher( 0 );
-				ignoreMatcher.addChild( childMatch );
-			}
-			getDirectoryFiles( files, names, fullpath, currentDirs, ignoreHidden, ignoreMatcher,
-							   allowedMatcher );
-			if ( childMatch ) {
-				ignoreMatcher.removeChild( childMatch );
-				eeSAFE_DELETE( childMatch );
-			}
-		} else {
-			files.emplace_back( fullpath );
-			names.emplace_back( file );
-		}
+
+	{
+		Lock l( mProgressMutex );
+		if ( mProgressClock.getElapsedTime() < Milliseconds( PRJ_SCAN_PROGRESS_INTERVAL_MS ) )
+			return;
+		mProgressClock.restart();
 	}
+
+	mScanProgress( *this, filesCount );
+}
+
+void ProjectDirectoryTree::addDirectory( const std::string& directory ) {
+	Lock l( mDirectoriesMutex );
+	if ( mDirectoriesSet.insert( directory ).second )
+		mDirectories.push_back( directory );
+}
+
+void ProjectDirectoryTree::removeDirectory( const std::string& directory ) {
+	Lock l( mDirectoriesMutex );
+	if ( mDirectoriesSet.erase( directory ) == 0 )
+		return;
+	auto it = std::find( mDirectories.begin(), mDirectories.end(), directory );
+	if ( it != mDirectories.end() )
+		mDirectories.erase( it );
 }
 
 void ProjectDirectoryTree::onChange( const ProjectDirectoryTree::Action& action,
@@ -421,6 +416,7 @@ void ProjectDirectoryTree::tryAddFile( const FileInfo& file ) {
 			if ( !exists ) {
 				mFiles.emplace_back( file.getFilepath() );
 				mNames.emplace_back( file.getFileName() );
+				mFilesVersion++;
 			}
 		}
 	}
@@ -432,33 +428,14 @@ void ProjectDirectoryTree::addFile( const FileInfo& file ) {
 			return;
 		if ( mIgnoreHidden && file.isHidden() )
 			return;
-		Lock l( mFilesMutex );
-		std::vector<std::string> files;
-		std::vector<std::string> names;
-		std::vector<LuaPattern> patterns;
-		std::set<std::string> info;
-		if ( !mAcceptedPatterns.empty() ) {
-			getDirectoryFiles( files, names, mPath, info, false, mIgnoreMatcher,
-							   mAllowedMatcher.get() );
-			size_t namesCount = names.size();
-			bool found;
-			for ( size_t i = 0; i < namesCount; i++ ) {
-				found = false;
-				for ( auto& pattern : patterns ) {
-					if ( pattern.matches( names[i] ) ) {
-						found = true;
-						break;
-					}
-				}
-				if ( found ) {
-					mFiles.emplace_back( std::move( files[i] ) );
-					mNames.emplace_back( std::move( names[i] ) );
-				}
-			}
-		} else {
-			getDirectoryFiles( mFiles, mNames, mPath, info, false, mIgnoreMatcher,
-							   mAllowedMatcher.get() );
-		}
+		std::string dir( file.getFilepath() );
+		FileSystem::dirAddSlashAtEnd( dir );
+		IgnoreMatcherManager matcher( getIgnoreMatcherFromPath( dir ) );
+		std::vector<IgnoreMatcher*> matchers( matcher.getMatchers() );
+		/* the matcher of the directory itself is read by the scanner */
+		if ( !matchers.empty() && matchers.back()->getPath() == dir )
+			matchers.pop_back();
+		getDirectoryFiles( dir, matchers, true );
 	} else {
 		tryAddFile( file );
 	}
@@ -490,13 +467,9 @@ void ProjectDirectoryTree::moveFile( const FileInfo& file, const std::string& ol
 		}
 		mFiles = std::move( files );
 		mNames = std::move( names );
-		{
-			Lock ld( mDirectoriesMutex );
-			auto wasDirIt = std::find( mDirectories.begin(), mDirectories.end(), oldDir );
-			if ( wasDirIt != mDirectories.end() )
-				mDirectories.erase( wasDirIt );
-			mDirectories.emplace_back( std::move( dir ) );
-		}
+		mFilesVersion++;
+		removeDirectory( oldDir );
+		addDirectory( dir );
 	} else {
 		std::string dir( file.getDirectoryPath() );
 		FileSystem::dirAddSlashAtEnd( dir );
@@ -511,6 +484,7 @@ void ProjectDirectoryTree::moveFile( const FileInfo& file, const std::string& ol
 				mFiles.erase( mFiles.begin() + index );
 				mNames.erase( mNames.begin() + index );
 			}
+			mFilesVersion++;
 		} else {
 			tryAddFile( file );
 		}
@@ -524,8 +498,7 @@ void ProjectDirectoryTree::removeFile( const FileInfo& file ) {
 	bool wasDir = false;
 	{
 		Lock ld( mDirectoriesMutex );
-		auto wasDirIt = std::find( mDirectories.begin(), mDirectories.end(), removedDir );
-		wasDir = wasDirIt != mDirectories.end();
+		wasDir = mDirectoriesSet.find( removedDir ) != mDirectoriesSet.end();
 	}
 
 	if ( wasDir ) {
@@ -544,16 +517,17 @@ void ProjectDirectoryTree::removeFile( const FileInfo& file ) {
 			Lock l( mFilesMutex );
 			mFiles = std::move( files );
 			mNames = std::move( names );
+			mFilesVersion++;
 		}
 
-		Lock ld2( mDirectoriesMutex );
-		mDirectories.erase( std::find( mDirectories.begin(), mDirectories.end(), removedDir ) );
+		removeDirectory( removedDir );
 	} else {
 		size_t index = findFileIndex( file.getFilepath() );
 		if ( index != std::string::npos ) {
 			Lock l( mFilesMutex );
 			mFiles.erase( mFiles.begin() + index );
 			mNames.erase( mNames.begin() + index );
+			mFilesVersion++;
 		}
 	}
 }
@@ -562,23 +536,29 @@ IgnoreMatcherManager ProjectDirectoryTree::getIgnoreMatcherFromPath( const std::
 	std::string dir( FileSystem::fileRemoveFileName( path ) );
 	FileSystem::dirAddSlashAtEnd( dir );
 	IgnoreMatcherManager curMatcher( dir );
-	IgnoreMatcherManager matcher( curMatcher.findRepositoryRootPath() );
-	if ( !matcher.foundMatch() ) {
-		if ( curMatcher.foundMatch() )
-			return curMatcher;
-		return matcher;
+	std::string rootPath( curMatcher.findRepositoryRootPath() );
+	if ( rootPath.empty() || rootPath == dir )
+		return curMatcher;
+	IgnoreMatcherManager matcher( rootPath );
+	/* the matchers are ordered from the repository root to the directory of the path, the
+	 * innermost ignore file takes precedence */
+	std::vector<std::string> dirs;
+	std::string tmpdir( dir );
+	std::string ltmpdir;
+	while ( ltmpdir != tmpdir && tmpdir.size() > rootPath.size() ) {
+		dirs.emplace_back( tmpdir );
+		ltmpdir = tmpdir;
+		tmpdir = FileSystem::removeLastFolderFromPath( tmpdir );
 	}
-	std::string prevDir( dir );
-	if ( prevDir != matcher.getRootPath() && prevDir.size() > matcher.getRootPath().size() ) {
-		std::string tmpdir( FileSystem::removeLastFolderFromPath( dir ) );
-		std::string ltmpdir;
-		while ( ltmpdir != tmpdir && tmpdir != matcher.getRootPath() ) {
-			IgnoreMatcherManager tmpMatcher( tmpdir );
-			if ( tmpMatcher.foundMatch() )
-				matcher.addChild( tmpMatcher.popMatcher( 0 ) );
-			ltmpdir = tmpdir;
-			tmpdir = FileSystem::removeLastFolderFromPath( tmpdir );
+	for ( auto it = dirs.rbegin(); it != dirs.rend(); ++it ) {
+		if ( *it == dir ) {
+			if ( curMatcher.foundMatch() )
+				matcher.addChild( curMatcher.popMatcher( 0 ) );
+			continue;
 		}
+		IgnoreMatcherManager tmpMatcher( *it );
+		if ( tmpMatcher.foundMatch() )
+			matcher.addChild( tmpMatcher.popMatcher( 0 ) );
 	}
 	return matcher;
 }
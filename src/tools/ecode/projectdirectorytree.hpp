@@ -1,9 +1,12 @@
 #ifndef ECODE_PROJECTDIRECTORYTREE_HPP
 #define ECODE_PROJECTDIRECTORYTREE_HPP
 
+#include "fuzzymatcher.hpp"
 #include "ignorematcher.hpp"
 #include "plugins/pluginmanager.hpp"
+#include <eepp/core/containers.hpp>
 #include <eepp/scene/scenemanager.hpp>
+#include <eepp/system/clock.hpp>
 #include <eepp/system/luapattern.hpp>
 #include <eepp/system/mutex.hpp>
 #include <eepp/system/threadpool.hpp>
@@ -11,8 +14,8 @@
 #include <eepp/ui/uiiconthememanager.hpp>
 #include <eepp/ui/uiscenenode.hpp>
 #include <functional>
+#include <atomic>
 #include <memory>
-#include <set>
 #include <string>
 
 using namespace EE;
@@ -103,6 +106,10 @@ class ProjectDirectoryTree {
 	};
 
 	typedef std::function<void( ProjectDirectoryTree& dirTree )> ScanCompleteEvent;
+	/** Reported periodically while scanning, from the scanning threads, with the number of files
+	 * found so far ( the files found are available as soon as they're reported ). */
+	typedef std::function<void( ProjectDirectoryTree& dirTree, size_t filesCount )>
+		ScanProgressEvent;
 	typedef std::function<void( std::shared_ptr<FileListModel> )> MatchResultCb;
 
 	ProjectDirectoryTree(
@@ -114,7 +121,7 @@ class ProjectDirectoryTree {
 
 	void scan( const ScanCompleteEvent& scanComplete,
 			   const std::vector<std::string>& acceptedPatterns = {},
-			   const bool& ignoreHidden = true );
+			   const bool& ignoreHidden = true, const ScanProgressEvent& scanProgress = {} );
 
 	std::shared_ptr<FileListModel> fuzzyMatchTree( const std::vector<std::string>& matches,
 												   const size_t& max,
@@ -173,24 +180,37 @@ class ProjectDirectoryTree {
 	std::vector<std::string> mFiles;
 	std::vector<std::string> mNames;
 	std::vector<std::string> mDirectories;
+	UnorderedSet<std::string> mDirectoriesSet;
 	std::vector<LuaPatternStorage> mAcceptedPatterns;
 	std::unique_ptr<GitIgnoreMatcher> mAllowedMatcher;
 	bool mRunning;
 	bool mIsReady;
 	bool mIgnoreHidden;
-	bool mClosing;
+	std::atomic<bool> mClosing;
 	mutable Mutex mFilesMutex;
 	mutable Mutex mDirectoriesMutex;
 	mutable Mutex mMatchingMutex;
 	Mutex mDoneMutex;
+	Mutex mScanMutex;
+	Mutex mProgressMutex;
+	Clock mProgressClock;
+	ScanProgressEvent mScanProgress;
 	IgnoreMatcherManager mIgnoreMatcher;
+	/* incremented every time the files list changes, identifies the list for mFuzzyMatcher */
+	Uint64 mFilesVersion{ 1 };
+	mutable FuzzyMatcher mFuzzyMatcher;
 	PluginManager* mPluginManager{ nullptr };
 	std::function<void( const std::string& )> mLoadFileFromPathOrFocusFn;
 
-	void getDirectoryFiles( std::vector<std::string>& files, std::vector<std::string>& names,
-							std::string directory, std::set<std::string> currentDirs,
-							const bool& ignoreHidden, IgnoreMatcherManager& ignoreMatcher,
-							GitIgnoreMatcher* allowedMatcher );
+	void getDirectoryFiles( const std::string& directory,
+							const std::vector<IgnoreMatcher*>& ignoreMatchers,
+							bool readIgnoreFile );
+
+	void addFiles( std::vector<std::string>& files, std::vector<std::string>& names );
+
+	void addDirectory( const std::string& directory );
+
+	void removeDirectory( const std::string& directory );
 
 	void addFile( const FileInfo& file );
 
@@ -204,6 +224,10 @@ class ProjectDirectoryTree {
 
 	size_t findFileIndex( const std::string& path );
 
+	FuzzyMatcher::ScoreFn fuzzyScoreFn() const;
+
+	FuzzyMatcher::MaskFn fuzzyMaskFn() const;
+
 	PluginRequestHandle processMessage( const PluginMessage& msg );
 };
 
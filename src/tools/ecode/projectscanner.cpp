@@ -0,0 +1,281 @@
+#include "projectscanner.hpp"
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <eepp/core/containers.hpp>
+#include <eepp/system/filesystem.hpp>
+#include <eepp/system/luapattern.hpp>
+#include <mutex>
+
+namespace ecode {
+
+/* The helper tasks can start after the scan ended and the scanner was destroyed, so everything they
+ * use is copied into the state they share */
+struct ProjectScanner::State {
+	std::shared_ptr<ThreadPool> pool;
+	FilesFoundCb filesFoundCb;
+	DirectoryFoundCb directoryFoundCb;
+	std::vector<std::string> acceptedPatterns;
+	GitIgnoreMatcher* allowedMatcher{ nullptr };
+	std::function<bool()> shouldAbort;
+	size_t maxHelpers{ 0 };
+	size_t batchSize{ 0 };
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::deque<Directory> pending;
+	UnorderedSet<std::string> visited;
+	/* the matchers of the ignore files found, alive until the scan ends */
+	std::vector<std::unique_ptr<IgnoreMatcher>> ignoreMatchers;
+	size_t active{ 0 };	 /* directories being scanned */
+	size_t helpers{ 0 }; /* helper tasks queued or running */
+	size_t running{ 0 }; /* helper tasks running */
+	bool finished{ false };
+};
+
+/* Buffers of each scanning thread, reused for every directory */
+struct ProjectScanner::Worker {
+	std::vector<LuaPatternStorage> patterns;
+	std::vector<std::pair<std::string, FileSystem::EntryType>> entries;
+	std::vector<std::string> files;
+	std::vector<std::string> names;
+	std::vector<Directory> subDirs;
+};
+
+ProjectScanner::ProjectScanner( std::shared_ptr<ThreadPool> threadPool, FilesFoundCb filesFoundCb,
+								DirectoryFoundCb directoryFoundCb ) :
+	mPool( std::move( threadPool ) ),
+	mFilesFoundCb( std::move( filesFoundCb ) ),
+	mDirectoryFoundCb( std::move( directoryFoundCb ) ),
+	mMaxHelpers( mPool ? mPool->numThreads() : 0 ) {}
+
+void ProjectScanner::setAcceptedPatterns( const std::vector<std::string>& acceptedPatterns ) {
+	mAcceptedPatterns = acceptedPatterns;
+}
+
+void ProjectScanner::setAllowedMatcher( GitIgnoreMatcher* allowedMatcher ) {
+	mAllowedMatcher = allowedMatcher;
+}
+
+void ProjectScanner::setShouldAbort( std::function<bool()> shouldAbort ) {
+	mShouldAbort = std::move( shouldAbort );
+}
+
+void ProjectScanner::setMaxHelpers( size_t maxHelpers ) {
+	mMaxHelpers = mPool ? maxHelpers : 0;
+}
+
+void ProjectScanner::setBatchSize( size_t batchSize ) {
+	mBatchSize = eemax<size_t>( 1, batchSize );
+}
+
+void ProjectScanner::scan( std::string directory,
+						   const std::vector<IgnoreMatcher*>& ignoreMatchers,
+						   bool readIgnoreFile ) {
+	FileSystem::dirAddSlashAtEnd( directory );
+	auto state = std::make_shared<State>();
+	state->pool = mPool;
+	state->filesFoundCb = mFilesFoundCb;
+	state->directoryFoundCb = mDirectoryFoundCb;
+	state->acceptedPatterns = mAcceptedPatterns;
+	state->allowedMatcher = mAllowedMatcher;
+	state->shouldAbort = mShouldAbort;
+	state->maxHelpers = mMaxHelpers;
+	state->batchSize = mBatchSize;
+
+	if ( !markVisited( *state, directory ) )
+		return;
+
+	state->pending.push_back(
+		{ std::move( directory ), std::make_shared<const IgnoreMatchers>( ignoreMatchers ),
+		  readIgnoreFile } );
+
+	work( state, false );
+}
+
+void ProjectScanner::work( const std::shared_ptr<State>& state, bool isHelper ) {
+	std::unique_lock<std::mutex> lock( state->mutex );
+
+	if ( isHelper ) {
+		/* the scan ended before the helper task started */
+		if ( state->finished ) {
+			state->helpers--;
+			return;
+		}
+		state->running++;
+	}
+
+	lock.unlock();
+
+	Worker worker;
+	worker.patterns.reserve( state->acceptedPatterns.size() );
+	for ( const auto& pattern : state->acceptedPatterns )
+		worker.patterns.emplace_back( pattern );
+
+	lock.lock();
+
+	while ( true ) {
+		if ( !state->pending.empty() && state->shouldAbort && state->shouldAbort() )
+			state->pending.clear();
+
+		if ( state->pending.empty() ) {
+			/* the helpers leave as soon as there's nothing to do, the thread that started the scan
+			 * waits until every directory has been scanned */
+			if ( isHelper || ( state->active == 0 && state->running == 0 ) )
+				break;
+			state->cond.wait( lock );
+			continue;
+		}
+
+		/* depth first, keeps the queue of pending directories small */
+		Directory dir( std::move( state->pending.back() ) );
+		state->pending.pop_back();
+		state->active++;
+		lock.unlock();
+
+		scanDirectory( *state, worker, dir );
+
+		if ( worker.files.size() >= state->batchSize )
+			flush( *state, worker );
+
+		lock.lock();
+		state->active--;
+
+		for ( auto& subDir : worker.subDirs )
+			state->pending.emplace_back( std::move( subDir ) );
+		worker.subDirs.clear();
+
+		spawnHelpers( state );
+
+		/* wakes the thread waiting for new directories or for the scan to end */
+		state->cond.notify_all();
+	}
+
+	/* set before the last flush, the helpers that start from now on leave without scanning */
+	if ( !isHelper )
+		state->finished = true;
+
+	lock.unlock();
+	flush( *state, worker );
+
+	if ( isHelper ) {
+		lock.lock();
+		state->running--;
+		state->helpers--;
+		state->cond.notify_all();
+	}
+}
+
+void ProjectScanner::spawnHelpers( const std::shared_ptr<State>& state ) {
+	/* one helper per pending directory beyond the first one, up to the maximum */
+	while ( state->helpers < state->maxHelpers && state->pending.size() > state->helpers + 1 ) {
+		state->helpers++;
+		state->pool->run( [state] { work( state, true ); } );
+	}
+}
+
+bool ProjectScanner::markVisited( State& state, const std::string& directory ) {
+	/* the same directory can be reached through a symbolic link to any of its parents */
+	std::string realPath( FileSystem::getRealPath( directory ) );
+	{
+		std::lock_guard<std::mutex> lock( state.mutex );
+		if ( !state.visited.insert( realPath.empty() ? directory : realPath ).second )
+			return false;
+	}
+	if ( state.directoryFoundCb )
+		state.directoryFoundCb( directory );
+	return true;
+}
+
+void ProjectScanner::flush( State& state, Worker& worker ) {
+	if ( worker.files.empty() )
+		return;
+	state.filesFoundCb( worker.files, worker.names );
+	worker.files.clear();
+	worker.names.clear();
+}
+
+void ProjectScanner::scanDirectory( State& state, Worker& worker, Directory& dir ) {
+	bool hasIgnoreFile = false;
+
+	worker.entries.clear();
+	FileSystem::filesEntriesGetInPath(
+		dir.path, [&]( const char* name, FileSystem::EntryType type ) {
+			if ( dir.readIgnoreFile && type != FileSystem::EntryType::Directory &&
+				 strcmp( name, ".gitignore" ) == 0 )
+				hasIgnoreFile = true;
+			worker.entries.emplace_back( name, type );
+		} );
+
+	std::shared_ptr<const IgnoreMatchers> ignoreMatchers( dir.ignoreMatchers );
+
+	if ( hasIgnoreFile ) {
+		auto matcher = std::make_unique<GitIgnoreMatcher>( dir.path );
+		if ( matcher->matcherReady() ) {
+			auto matchers = std::make_shared<IgnoreMatchers>( *ignoreMatchers );
+			matchers->push_back( matcher.get() );
+			ignoreMatchers = std::move( matchers );
+			std::lock_guard<std::mutex> lock( state.mutex );
+			state.ignoreMatchers.emplace_back( std::move( matcher ) );
+		}
+	}
+
+	for ( auto& entry : worker.entries ) {
+		const std::string& name = entry.first;
+		std::string fullpath( dir.path + name );
+		std::string linkTarget;
+		bool isDirectory = entry.second == FileSystem::EntryType::Directory;
+
+		/* only the links and the entries of unknown type are stat'ed */
+		if ( entry.second == FileSystem::EntryType::Link ||
+			 entry.second == FileSystem::EntryType::Unknown ) {
+			FileInfo info( fullpath, true );
+			if ( info.isLink() ) {
+				isDirectory = FileSystem::isDirectory( fullpath );
+				if ( isDirectory )
+					linkTarget = info.linksTo();
+			} else {
+				isDirectory = info.isDirectory();
+			}
+		}
+
+		/* ignored directories are never scanned */
+		if ( !ignoreMatchers->empty() &&
+			 IgnoreMatcherManager::match( *ignoreMatchers, fullpath, isDirectory ) ) {
+			if ( !state.allowedMatcher ||
+				 !String::startsWith( fullpath, state.allowedMatcher->getPath() ) )
+				continue;
+			std::string_view localPath( fullpath );
+			localPath.remove_prefix( state.allowedMatcher->getPath().size() );
+			if ( state.allowedMatcher->match( localPath, isDirectory ) !=
+				 IgnoreMatcher::Result::Ignored )
+				continue;
+		}
+
+		if ( !linkTarget.empty() )
+			fullpath = std::move( linkTarget );
+
+		if ( isDirectory ) {
+			FileSystem::dirAddSlashAtEnd( fullpath );
+			if ( markVisited( state, fullpath ) )
+				worker.subDirs.push_back( { std::move( fullpath ), ignoreMatchers, true } );
+			continue;
+		}
+
+		if ( !worker.patterns.empty() ) {
+			bool found = false;
+			for ( auto& pattern : worker.patterns ) {
+				if ( pattern.matches( name ) ) {
+					found = true;
+					break;
+				}
+			}
+			if ( !found )
+				continue;
+		}
+
+		worker.files.emplace_back( std::move( fullpath ) );
+		worker.names.emplace_back( name );
+	}
+}
+
+} // namespace ecode
@@ -0,0 +1,97 @@
+#ifndef ECODE_PROJECTSCANNER_HPP
+#define ECODE_PROJECTSCANNER_HPP
+
+#include "ignorematcher.hpp"
+#include <eepp/system/threadpool.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace EE;
+using namespace EE::System;
+
+namespace ecode {
+
+/** Scans a project directory tree spreading its sub directories across a thread pool.
+ * The type of each entry is taken from the directory listing when the file system reports it, so
+ * regular files and directories are never stat'ed. Symbolic links to directories are followed once,
+ * the real path of every directory visited is kept to avoid cycles and duplicated sub trees. */
+class ProjectScanner {
+  public:
+	/** Receives a batch of files found ( their full paths and file names ). It's called from the
+	 * scanning threads, the strings can be moved out of the vectors. */
+	typedef std::function<void( std::vector<std::string>& files, std::vector<std::string>& names )>
+		FilesFoundCb;
+
+	/** Receives each directory found ( the real path if it's a symbolic link ), from the scanning
+	 * threads. */
+	typedef std::function<void( const std::string& directory )> DirectoryFoundCb;
+
+	/** @param threadPool The pool where the sub directories are scanned, if null the tree is
+	 * scanned only by the thread calling scan. */
+	ProjectScanner( std::shared_ptr<ThreadPool> threadPool, FilesFoundCb filesFoundCb,
+					DirectoryFoundCb directoryFoundCb = {} );
+
+	/** Lua patterns that the file names must match to be reported ( all files are reported if
+	 * empty ). */
+	void setAcceptedPatterns( const std::vector<std::string>& acceptedPatterns );
+
+	/** Files ignored by the ignore matchers are still reported if this matcher matches them. */
+	void setAllowedMatcher( GitIgnoreMatcher* allowedMatcher );
+
+	/** Checked before scanning each directory, the scan is stopped once it returns true. */
+	void setShouldAbort( std::function<bool()> shouldAbort );
+
+	/** Maximum number of thread pool tasks used besides the thread calling scan ( by default the
+	 * number of threads of the pool ). */
+	void setMaxHelpers( size_t maxHelpers );
+
+	/** Minimum number of files reported by each FilesFoundCb call, except for the last ones. */
+	void setBatchSize( size_t batchSize );
+
+	/** Scans the directory tree, the calling thread takes part in the scan and the function returns
+	 * once the whole tree has been scanned.
+	 * @param ignoreMatchers The ignore matchers that apply to the directory, they must be valid
+	 * until scan returns.
+	 * @param readIgnoreFile If the .gitignore file of the directory itself must be read ( usually
+	 * false for the project root since its matcher is already in ignoreMatchers ). */
+	void scan( std::string directory, const std::vector<IgnoreMatcher*>& ignoreMatchers,
+			   bool readIgnoreFile = true );
+
+  protected:
+	typedef std::vector<IgnoreMatcher*> IgnoreMatchers;
+
+	struct Directory {
+		std::string path;
+		/* shared by all the sub directories of a directory without an ignore file */
+		std::shared_ptr<const IgnoreMatchers> ignoreMatchers;
+		bool readIgnoreFile{ true };
+	};
+
+	struct State;
+	struct Worker;
+
+	std::shared_ptr<ThreadPool> mPool;
+	FilesFoundCb mFilesFoundCb;
+	DirectoryFoundCb mDirectoryFoundCb;
+	std::vector<std::string> mAcceptedPatterns;
+	GitIgnoreMatcher* mAllowedMatcher{ nullptr };
+	std::function<bool()> mShouldAbort;
+	size_t mMaxHelpers;
+	size_t mBatchSize{ 1024 };
+
+	static void work( const std::shared_ptr<State>& state, bool isHelper );
+
+	static void spawnHelpers( const std::shared_ptr<State>& state );
+
+	static void scanDirectory( State& state, Worker& worker, Directory& dir );
+
+	static bool markVisited( State& state, const std::string& directory );
+
+	static void flush( State& state, Worker& worker );
+};
+
+} // namespace ecode
+
+#endif // ECODE_PROJECTSCANNER_HPP
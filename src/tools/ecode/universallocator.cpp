@@ -1,5 +1,6 @@
 #include "universallocator.hpp"
 #include "ecode.hpp"
+#include "fuzzymatcher.hpp"
 #include "pathhelper.hpp"
 #include "settingsmenu.hpp"
 
@@ -91,19 +92,18 @@ LSPSymbolInformationList fuzzyMatchTextDocumentSymbol( const LSPSymbolInformatio
 													   const std::string& query,
 													   const size_t& limit ) {
 	LSPSymbolInformationList nl;
-	std::map<int, LSPSymbolInformation, std::greater<int>> matchesMap;
-
-	for ( const auto& l : list ) {
-		int matchName = String::fuzzyMatch( l.name, query );
-		matchesMap.insert( { matchName, l } );
-	}
-
-	while ( matchesMap.size() > limit )
-		matchesMap.erase( std::prev( matchesMap.end() ) );
-
-	for ( auto& m : matchesMap ) {
-		m.second.score = m.first;
-		nl.emplace_back( std::move( m.second ) );
+	FuzzyMatcher matcher;
+	auto matches = matcher.match(
+		query, list.size(), limit,
+		[&list]( size_t index, const std::string& pattern ) {
+			return String::fuzzyMatch( list[index].name, pattern );
+		},
+		[&list]( size_t index ) { return FuzzyMatcher::mask( list[index].name ); } );
+
+	nl.reserve( matches.size() );
+	for ( const auto& m : matches ) {
+		nl.emplace_back( list[m.index] );
+		nl.back().score = m.score;
 	}
 	return nl;
 }
@@ -322,7 +322,9 @@ UniversalLocator::UniversalLocator( UICodeEditorSplitter* editorSplitter, UIScen
 		  } } );
 
 	mApp->getPluginManager()->subscribeMessages(
-		"universallocator", [this]( const PluginMessage& msg ) -> PluginRequestHandle {
+		"universallocator",
+		{ PluginMessageType::WorkspaceSymbol, PluginMessageType::TextDocumentFlattenSymbol },
+		[this]( const PluginMessage& msg ) -> PluginRequestHandle {
 			return processResponse( msg );
 		} );
 }
@@ -1,5 +1,7 @@
+#include <args/args.hxx>
 #include <eepp/graphics/fonttruetype.hpp>
 #include <eepp/maps/mapeditor/mapeditor.hpp>
+#include <eepp/maps/tilemapchunks.hpp>
 #include <eepp/scene/scenemanager.hpp>
 #include <eepp/ui/uimessagebox.hpp>
 #include <eepp/ui/uiscenenode.hpp>
@@ -8,6 +10,7 @@
 #include <eepp/window/engine.hpp>
 #include <eepp/window/input.hpp>
 #include <eepp/window/window.hpp>
+#include <iostream>
 
 using namespace EE;
 using namespace EE::Graphics;
@@ -75,7 +78,55 @@ void mainLoop() {
 	}
 }
 
-EE_MAIN_FUNC int main( int, char*[] ) {
+static int convertMap( const std::string& srcPath, const std::string& dstPath, Uint32 chunkSize ) {
+	IOStreamFile src( srcPath );
+	IOStreamFile dst( dstPath, "wb" );
+
+	if ( !src.isOpen() || !dst.isOpen() ) {
+		std::cerr << "Couldn't open the map files." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if ( !TileMapChunks::convert( src, dst, chunkSize ) ) {
+		std::cerr << "Couldn't convert \"" << srcPath << "\" to the chunked map format."
+				  << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	args::ArgumentParser parser( "eepp - Map Editor" );
+	args::HelpFlag help( parser, "help", "Display this help menu", { 'h', "help" } );
+	args::ValueFlag<std::string> convertPath(
+		parser, "map-path", "Converts a map to the chunked map format and exits.",
+		{ "convert-chunked" }, "", args::Options::Single );
+	args::ValueFlag<std::string> outputPath(
+		parser, "output-path", "Chunked map output path ( used with --convert-chunked ).",
+		{ 'o', "output" }, "", args::Options::Single );
+	args::ValueFlag<Uint32> chunkSize( parser, "chunk-size", "Chunk width and height in tiles.",
+									   { "chunk-size" }, EE_MAP_DEFAULT_CHUNK_SIZE,
+									   args::Options::Single );
+
+	try {
+		parser.ParseCLI( argc, argv );
+	} catch ( const args::Help& ) {
+		std::cout << parser;
+		return EXIT_SUCCESS;
+	} catch ( const args::ParseError& e ) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << parser;
+		return EXIT_FAILURE;
+	}
+
+	if ( !convertPath.Get().empty() ) {
+		return convertMap( convertPath.Get(),
+						   outputPath.Get().empty() ? convertPath.Get() + ".chunked.eem"
+													: outputPath.Get(),
+						   eemax<Uint32>( 1, chunkSize.Get() ) );
+	}
+
 	DisplayManager* displayManager = Engine::instance()->getDisplayManager();
 	displayManager->enableScreenSaver();
 	displayManager->enableMouseFocusClickThrough();